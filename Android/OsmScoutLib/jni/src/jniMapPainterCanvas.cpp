@@ -697,7 +697,7 @@ namespace osmscout {
     if (!area.clippings.empty())
     {
       // Clip areas within the area
-      for (std::list<PolyData>::const_iterator c=area.clippings.begin();
+      for (std::vector<PolyData>::const_iterator c=area.clippings.begin();
           c!=area.clippings.end(); c++)
       {
         const PolyData& clipData=*c;
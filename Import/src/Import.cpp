@@ -124,6 +124,7 @@ void DumpHelp(osmscout::ImportParameter& parameter)
   std::cout << " --wayDataCacheSize <number>          way data cache size (default: " << parameter.GetWayDataCacheSize() << ")" << std::endl;
 
   std::cout << " --routeNodeBlockSize <number>        number of route nodes resolved in block (default: " << parameter.GetRouteNodeBlockSize() << ")" << std::endl;
+  std::cout << " --srtmDirectory <directory>          directory with SRTM hgt files for route path elevation (default: none)" << std::endl;
   std::cout << " --langOrder <#|lang1[,#|lang2]..>    language order when parsing lang[:language] and place_name[:language] tags" << std::endl
             << "                                      # is the default language (no :language) (default: #)" << std::endl;
   std::cout << " --altLangOrder <#|lang1[,#|lang2]..> same as --langOrder for a second alternate language (default: none)" << std::endl;
@@ -677,6 +678,19 @@ int main(int argc, char* argv[])
         parameterError=true;
       }
     }
+    else if (strcmp(argv[i],"--srtmDirectory")==0) {
+      std::string srtmDirectory;
+
+      if (ParseStringArgument(argc,
+                              argv,
+                              i,
+                              srtmDirectory)) {
+        parameter.SetSRTMDirectory(srtmDirectory);
+      }
+      else {
+        parameterError=true;
+      }
+    }
     else if (strcmp(argv[i],"--langOrder")==0) {
         std::vector<std::string> langOrder;
         
@@ -792,6 +806,8 @@ int main(int argc, char* argv[])
 
   progress.Info(std::string("RouteNodeBlockSize: ")+
                 osmscout::NumberToString(parameter.GetRouteNodeBlockSize()));
+  progress.Info(std::string("SRTMDirectory: ")+
+                (parameter.GetSRTMDirectory().empty() ? "none" : parameter.GetSRTMDirectory()));
 
   osmscout::Importer importer(parameter);
 
@@ -17,11 +17,18 @@
   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
 
+#include <algorithm>
 #include <cstdlib>
+#include <iomanip>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
 #include <vector>
 
 #include <osmscout/util/Cache.h>
+#include <osmscout/util/ConcurrentCache.h>
 #include <osmscout/util/FileScanner.h>
 #include <osmscout/util/StopClock.h>
 
@@ -30,6 +37,8 @@
   * cache insertion
   * cache hit
   * cache miss
+  * concurrent access from multiple threads (Cache with a global mutex
+    compared to ConcurrentCache)
 */
 
 /**
@@ -170,9 +179,155 @@ void TestData()
   std::cout << "Copy time: "  << copyTimer << std::endl;
 }
 
-int main(int /*argc*/, char* /*argv*/[])
+static const size_t concurrentCacheSize=100000;
+static const size_t concurrentKeyRange=4*concurrentCacheSize;
+static const size_t concurrentOperations=2000000;
+
+typedef std::shared_ptr<Data>                             DataRef;
+typedef osmscout::Cache<osmscout::Id,DataRef>             LockedCache;
+typedef osmscout::ConcurrentCache<osmscout::Id,DataRef>   ShardedCache;
+
+/**
+ * Generate a sequence of keys, where a small fraction of the keys is
+ * requested most of the time (roughly like tiles or objects in the
+ * visible area of a map).
+ */
+static void GenerateKeys(size_t seed,
+                         std::vector<osmscout::Id>& keys)
+{
+  std::mt19937                          generator(seed);
+  std::exponential_distribution<double> distribution(5.0/concurrentKeyRange);
+
+  keys.resize(concurrentOperations);
+
+  for (auto& key : keys) {
+    key=std::min((size_t)distribution(generator),concurrentKeyRange-1);
+  }
+}
+
+/**
+ * Lookup the given keys, loading missing values into the cache
+ */
+static void AccessLockedCache(LockedCache& cache,
+                              std::mutex& mutex,
+                              const std::vector<osmscout::Id>& keys)
+{
+  for (auto key : keys) {
+    DataRef value;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      LockedCache::CacheRef       entry;
+
+      if (cache.GetEntry(key,entry)) {
+        value=entry->value;
+      }
+    }
+
+    if (!value) {
+      value=std::make_shared<Data>();
+      value->value=key;
+
+      std::lock_guard<std::mutex> lock(mutex);
+
+      cache.SetEntry(LockedCache::CacheEntry(key,value));
+    }
+  }
+}
+
+static void AccessShardedCache(ShardedCache& cache,
+                               const std::vector<osmscout::Id>& keys)
+{
+  for (auto key : keys) {
+    DataRef value;
+
+    if (!cache.GetEntry(key,value)) {
+      value=std::make_shared<Data>();
+      value->value=key;
+
+      cache.SetEntry(key,value);
+    }
+  }
+}
+
+static void PrintResult(const char* name,
+                        size_t threadCount,
+                        const osmscout::StopClock& timer,
+                        size_t hits,
+                        size_t misses)
 {
+  double operations=(double)threadCount*concurrentOperations;
+
+  std::cout << name << " " << threadCount << " thread(s): " << std::fixed << std::setprecision(2);
+  std::cout << operations/(timer.GetMilliseconds()/1000.0)/1000000.0 << " M lookups/sec, hit rate ";
+  std::cout << std::setprecision(1) << 100.0*hits/(hits+misses) << "%" << std::endl;
+}
+
+void TestConcurrentAccess(size_t maxThreadCount)
+{
+  std::cout << "*** Concurrent access ***" << std::endl;
+
+  for (size_t threadCount=1; threadCount<=maxThreadCount; threadCount*=2) {
+    std::vector<std::vector<osmscout::Id> > keys(threadCount);
+
+    for (size_t t=0; t<threadCount; t++) {
+      GenerateKeys(t,keys[t]);
+    }
+
+    {
+      LockedCache              cache(concurrentCacheSize);
+      std::mutex               mutex;
+      std::vector<std::thread> threads;
+      osmscout::StopClock      timer;
+
+      for (size_t t=0; t<threadCount; t++) {
+        threads.push_back(std::thread(AccessLockedCache,
+                                      std::ref(cache),
+                                      std::ref(mutex),
+                                      std::cref(keys[t])));
+      }
+
+      for (auto& thread : threads) {
+        thread.join();
+      }
+
+      timer.Stop();
+
+      PrintResult("Cache + mutex  ",threadCount,timer,cache.GetHits(),cache.GetMisses());
+    }
+
+    {
+      ShardedCache             cache(concurrentCacheSize);
+      std::vector<std::thread> threads;
+      osmscout::StopClock      timer;
+
+      for (size_t t=0; t<threadCount; t++) {
+        threads.push_back(std::thread(AccessShardedCache,
+                                      std::ref(cache),
+                                      std::cref(keys[t])));
+      }
+
+      for (auto& thread : threads) {
+        thread.join();
+      }
+
+      timer.Stop();
+
+      PrintResult("ConcurrentCache",threadCount,timer,cache.GetHits(),cache.GetMisses());
+    }
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  size_t maxThreadCount=std::max(1u,std::thread::hardware_concurrency());
+
+  if (argc>1) {
+    maxThreadCount=std::max(1,atoi(argv[1]));
+  }
+
   TestData();
+  TestConcurrentAccess(maxThreadCount);
 
   return 0;
 }
@@ -0,0 +1,305 @@
+/*
+  MapMatchingPerformance - a test program for libosmscout
+  Copyright (C) 2016  Tim Teulings
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <map>
+#include <random>
+#include <vector>
+
+#include <osmscout/Database.h>
+#include <osmscout/MapMatchingService.h>
+#include <osmscout/RoutingService.h>
+
+#include <osmscout/system/Math.h>
+
+#include <osmscout/util/Geometry.h>
+#include <osmscout/util/StopClock.h>
+
+/**
+  Generate synthetic GPS traces by calculating car routes between random
+  points of the database and sampling the route every TRACE_SAMPLE_DISTANCE
+  meters with gaussian noise. The traces are then fed point by point through
+  a MapMatcher and the number of points matched per second is reported,
+  first with an empty tile cache of the MapMatchingService and then with
+  all tiles cached.
+
+  Call: MapMatchingPerformance <database directory> [<trace count> [<noise in meters>]]
+*/
+
+static const double TRACE_SAMPLE_DISTANCE=10.0;
+
+static void GetCarSpeedTable(std::map<std::string,double>& map)
+{
+  map["highway_motorway"]=110.0;
+  map["highway_motorway_trunk"]=100.0;
+  map["highway_motorway_primary"]=70.0;
+  map["highway_motorway_link"]=60.0;
+  map["highway_motorway_junction"]=60.0;
+  map["highway_trunk"]=100.0;
+  map["highway_trunk_link"]=60.0;
+  map["highway_primary"]=70.0;
+  map["highway_primary_link"]=60.0;
+  map["highway_secondary"]=60.0;
+  map["highway_secondary_link"]=50.0;
+  map["highway_tertiary_link"]=55.0;
+  map["highway_tertiary"]=55.0;
+  map["highway_unclassified"]=50.0;
+  map["highway_road"]=50.0;
+  map["highway_residential"]=40.0;
+  map["highway_roundabout"]=40.0;
+  map["highway_living_street"]=10.0;
+  map["highway_service"]=30.0;
+}
+
+/**
+ * Sample the route every TRACE_SAMPLE_DISTANCE meters and add gaussian
+ * noise with the given standard deviation in meters
+ */
+static void SampleRoute(const std::list<osmscout::Point>& route,
+                        double noise,
+                        std::mt19937& generator,
+                        std::vector<osmscout::GeoCoord>& trace)
+{
+  std::normal_distribution<double> distribution(0.0,noise);
+  const osmscout::Point*           last=NULL;
+  double                           position=0.0;
+
+  for (const auto& point : route) {
+    if (last==NULL) {
+      last=&point;
+      continue;
+    }
+
+    osmscout::GeoCoord from=last->GetCoord();
+    osmscout::GeoCoord to=point.GetCoord();
+    double             length=osmscout::GetEllipsoidalDistance(from,to)*1000.0;
+
+    while (position<length) {
+      double fraction=position/length;
+      double lat=from.GetLat()+fraction*(to.GetLat()-from.GetLat());
+      double lon=from.GetLon()+fraction*(to.GetLon()-from.GetLon());
+
+      // Roughly 111 km per degree
+      lat+=distribution(generator)/111195.0;
+      lon+=distribution(generator)/(111195.0*cos(lat*M_PI/180.0));
+
+      trace.push_back(osmscout::GeoCoord(lat,lon));
+
+      position+=TRACE_SAMPLE_DISTANCE;
+    }
+
+    position-=length;
+    last=&point;
+  }
+}
+
+static bool GenerateTraces(osmscout::DatabaseRef& database,
+                           const osmscout::RoutingProfile& profile,
+                           size_t traceCount,
+                           double noise,
+                           std::vector<std::vector<osmscout::GeoCoord>>& traces)
+{
+  osmscout::RouterParameter routerParameter;
+  osmscout::RoutingService  router(database,
+                                   routerParameter,
+                                   osmscout::RoutingService::DEFAULT_FILENAME_BASE);
+  osmscout::GeoBox          boundingBox;
+
+  if (!router.Open()) {
+    std::cerr << "Cannot open routing database" << std::endl;
+    return false;
+  }
+
+  if (!database->GetBoundingBox(boundingBox)) {
+    std::cerr << "Cannot get bounding box of database" << std::endl;
+    return false;
+  }
+
+  std::mt19937                           generator(1);
+  std::uniform_real_distribution<double> latDistribution(boundingBox.GetMinLat(),boundingBox.GetMaxLat());
+  std::uniform_real_distribution<double> lonDistribution(boundingBox.GetMinLon(),boundingBox.GetMaxLon());
+  size_t                                 attempts=0;
+
+  while (traces.size()<traceCount &&
+         attempts<traceCount*10) {
+    osmscout::ObjectFileRef    startObject;
+    size_t                     startNodeIndex;
+    osmscout::ObjectFileRef    targetObject;
+    size_t                     targetNodeIndex;
+    osmscout::RouteData        data;
+    std::list<osmscout::Point> points;
+
+    attempts++;
+
+    if (!router.GetClosestRoutableNode(latDistribution(generator),
+                                       lonDistribution(generator),
+                                       osmscout::vehicleCar,
+                                       1000,
+                                       startObject,
+                                       startNodeIndex) ||
+        startObject.Invalid()) {
+      continue;
+    }
+
+    if (!router.GetClosestRoutableNode(latDistribution(generator),
+                                       lonDistribution(generator),
+                                       osmscout::vehicleCar,
+                                       1000,
+                                       targetObject,
+                                       targetNodeIndex) ||
+        targetObject.Invalid()) {
+      continue;
+    }
+
+    if (!router.CalculateRoute(profile,
+                               startObject,
+                               startNodeIndex,
+                               targetObject,
+                               targetNodeIndex,
+                               data) ||
+        data.IsEmpty() ||
+        !router.TransformRouteDataToPoints(data,points)) {
+      continue;
+    }
+
+    std::vector<osmscout::GeoCoord> trace;
+
+    SampleRoute(points,
+                noise,
+                generator,
+                trace);
+
+    if (trace.size()>=2) {
+      traces.push_back(trace);
+    }
+  }
+
+  router.Close();
+
+  return !traces.empty();
+}
+
+/**
+ * Feed all traces point by point through a MapMatcher and return the number
+ * of matched points
+ */
+static size_t MatchTraces(const osmscout::MapMatchingService& service,
+                          const osmscout::RoutingProfile& profile,
+                          const std::vector<std::vector<osmscout::GeoCoord>>& traces,
+                          double& seconds)
+{
+  size_t              matchedCount=0;
+  osmscout::StopClock timer;
+
+  for (const auto& trace : traces) {
+    osmscout::MapMatcher matcher(service,
+                                 profile,
+                                 [&matchedCount](const std::vector<osmscout::MapMatchingService::MatchedPoint>& points,
+                                                 const osmscout::RouteData& /*route*/) {
+                                   for (const auto& point : points) {
+                                     if (point.matched) {
+                                       matchedCount++;
+                                     }
+                                   }
+                                 });
+
+    for (const auto& coord : trace) {
+      matcher.AddPoint(coord);
+    }
+
+    matcher.Finish();
+  }
+
+  timer.Stop();
+
+  seconds=timer.GetMilliseconds()/1000.0;
+
+  return matchedCount;
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc<2) {
+    std::cerr << "MapMatchingPerformance <database directory> [<trace count> [<noise in meters>]]" << std::endl;
+    return 1;
+  }
+
+  size_t traceCount=argc>2 ? (size_t)atol(argv[2]) : 50;
+  double noise=argc>3 ? atof(argv[3]) : 5.0;
+
+  osmscout::DatabaseParameter databaseParameter;
+  osmscout::DatabaseRef       database=std::make_shared<osmscout::Database>(databaseParameter);
+
+  if (!database->Open(argv[1])) {
+    std::cerr << "Cannot open database" << std::endl;
+    return 1;
+  }
+
+  osmscout::FastestPathRoutingProfile profile(database->GetTypeConfig());
+  std::map<std::string,double>        carSpeedTable;
+
+  GetCarSpeedTable(carSpeedTable);
+  profile.ParametrizeForCar(*database->GetTypeConfig(),
+                            carSpeedTable,
+                            160.0);
+
+  std::vector<std::vector<osmscout::GeoCoord>> traces;
+
+  if (!GenerateTraces(database,
+                      profile,
+                      traceCount,
+                      noise,
+                      traces)) {
+    std::cerr << "Cannot generate traces" << std::endl;
+    return 1;
+  }
+
+  size_t pointCount=0;
+
+  for (const auto& trace : traces) {
+    pointCount+=trace.size();
+  }
+
+  std::cout << "Matching " << traces.size() << " traces with " << pointCount << " points, ";
+  std::cout << "sampled every " << TRACE_SAMPLE_DISTANCE << " m with " << noise << " m noise..." << std::endl;
+
+  osmscout::MapMatchingParameter matchingParameter;
+  osmscout::MapMatchingService   service(database,
+                                         matchingParameter);
+
+  for (const char* pass : {"cold tile cache","warm tile cache"}) {
+    double seconds;
+    size_t matchedCount=MatchTraces(service,
+                                    profile,
+                                    traces,
+                                    seconds);
+
+    std::cout << pass << ": " << std::fixed << std::setprecision(0);
+    std::cout << pointCount/seconds << " points/sec, ";
+    std::cout << matchedCount << "/" << pointCount << " matched" << std::endl;
+  }
+
+  database->Close();
+
+  return 0;
+}
@@ -0,0 +1,200 @@
+/*
+  ProjectionPerformance - a test program for libosmscout
+  Copyright (C) 2016  Tim Teulings
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <osmscout/util/Projection.h>
+#include <osmscout/util/StopClock.h>
+#include <osmscout/util/Tiling.h>
+#include <osmscout/util/Transformation.h>
+
+/**
+  Transform a number of ways with random nodes around the projection center
+  using the per point virtual GeoToPixel() call and the different batch kernels
+  and compare the resulting runtime and precision.
+*/
+
+#define WAY_COUNT   10000
+#define NODE_COUNT  100
+#define ITERATIONS  20
+
+static void GenerateWays(const osmscout::Projection& projection,
+                         std::vector<std::vector<osmscout::Point> >& ways)
+{
+  osmscout::GeoBox boundingBox;
+
+  projection.GetDimensions(boundingBox);
+
+  ways.resize(WAY_COUNT);
+
+  for (auto& way : ways) {
+    way.resize(NODE_COUNT);
+
+    for (auto& node : way) {
+      // Some nodes are outside of the visible area, like in real data
+      double lat=boundingBox.GetMinLat()+(boundingBox.GetMaxLat()-boundingBox.GetMinLat())*(1.5*rand()/RAND_MAX-0.25);
+      double lon=boundingBox.GetMinLon()+(boundingBox.GetMaxLon()-boundingBox.GetMinLon())*(1.5*rand()/RAND_MAX-0.25);
+
+      node.Set(0,osmscout::GeoCoord(lat,lon));
+    }
+  }
+}
+
+static void TransformSingle(const osmscout::Projection& projection,
+                            const std::vector<std::vector<osmscout::Point> >& ways,
+                            std::vector<osmscout::TransPolygon::TransPoint>& points)
+{
+  size_t pos=0;
+
+  for (const auto& way : ways) {
+    for (const auto& node : way) {
+      projection.GeoToPixel(node.GetLon(),
+                            node.GetLat(),
+                            points[pos].x,
+                            points[pos].y);
+      points[pos].draw=true;
+      pos++;
+    }
+  }
+}
+
+static void TransformBatch(const osmscout::Projection& projection,
+                           const std::vector<std::vector<osmscout::Point> >& ways,
+                           std::vector<osmscout::TransPolygon::TransPoint>& points)
+{
+  size_t pos=0;
+
+  for (const auto& way : ways) {
+    double xMin,yMin,xMax,yMax;
+
+    projection.BatchGeoToPixel(way.data(),
+                               way.size(),
+                               &points[pos].x,
+                               &points[pos].y,
+                               sizeof(osmscout::TransPolygon::TransPoint),
+                               xMin,yMin,
+                               xMax,yMax);
+    pos+=way.size();
+  }
+}
+
+static double MaxDeviation(const std::vector<osmscout::TransPolygon::TransPoint>& a,
+                           const std::vector<osmscout::TransPolygon::TransPoint>& b)
+{
+  double deviation=0.0;
+
+  for (size_t i=0; i<a.size(); i++) {
+    deviation=std::max(deviation,std::fabs(a[i].x-b[i].x));
+    deviation=std::max(deviation,std::fabs(a[i].y-b[i].y));
+  }
+
+  return deviation;
+}
+
+template<class F>
+static void Measure(const std::string& name,
+                    F function,
+                    const std::vector<osmscout::TransPolygon::TransPoint>& reference,
+                    std::vector<osmscout::TransPolygon::TransPoint>& points)
+{
+  osmscout::StopClock timer;
+
+  for (size_t i=0; i<ITERATIONS; i++) {
+    function();
+  }
+
+  timer.Stop();
+
+  std::cout << name << ": " << timer.ResultString() << " sec, max. deviation " << MaxDeviation(reference,points) << " pixel" << std::endl;
+}
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+  osmscout::MercatorProjection                    projection;
+  std::vector<std::vector<osmscout::Point> >      ways;
+  std::vector<osmscout::TransPolygon::TransPoint> reference(WAY_COUNT*NODE_COUNT);
+  std::vector<osmscout::TransPolygon::TransPoint> points(WAY_COUNT*NODE_COUNT);
+
+  projection.Set(7.45,51.53,
+                 osmscout::Magnification(osmscout::Magnification::magVeryClose),
+                 96.0,
+                 1920,1080);
+
+  GenerateWays(projection,ways);
+
+  std::cout << "Transforming " << WAY_COUNT*NODE_COUNT*ITERATIONS << " coordinates..." << std::endl;
+
+  TransformSingle(projection,ways,reference);
+
+  Measure("GeoToPixel",
+          [&]() {
+            TransformSingle(projection,ways,points);
+          },
+          reference,
+          points);
+
+  projection.SetBatchKernel(osmscout::MercatorProjection::kernelScalar);
+
+  Measure("BatchGeoToPixel (scalar)",
+          [&]() {
+            TransformBatch(projection,ways,points);
+          },
+          reference,
+          points);
+
+  if (osmscout::MercatorProjection::IsBatchKernelSupported(osmscout::MercatorProjection::kernelAVX2)) {
+    projection.SetBatchKernel(osmscout::MercatorProjection::kernelAVX2);
+
+    Measure("BatchGeoToPixel (AVX2)",
+            [&]() {
+              TransformBatch(projection,ways,points);
+            },
+            reference,
+            points);
+  }
+  else {
+    std::cout << "BatchGeoToPixel (AVX2): not supported" << std::endl;
+  }
+
+#ifdef OSMSCOUT_HAVE_SSE2
+  // The TileProjection uses the SSE2 based BatchTransformer
+  osmscout::TileProjection tileProjection;
+
+  tileProjection.Set(osmscout::LonToTileX(7.45,osmscout::Magnification(osmscout::Magnification::magVeryClose)),
+                     osmscout::LatToTileY(51.53,osmscout::Magnification(osmscout::Magnification::magVeryClose)),
+                     osmscout::Magnification(osmscout::Magnification::magVeryClose),
+                     96.0,
+                     1920,1080);
+
+  TransformSingle(tileProjection,ways,reference);
+
+  Measure("BatchGeoToPixel (TileProjection, SSE2)",
+          [&]() {
+            TransformBatch(tileProjection,ways,points);
+          },
+          reference,
+          points);
+#else
+  std::cout << "BatchGeoToPixel (TileProjection, SSE2): not supported" << std::endl;
+#endif
+
+  return 0;
+}
@@ -17,24 +17,430 @@
   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
 
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <vector>
 
 #include <osmscout/Way.h>
 
+#include <osmscout/util/File.h>
 #include <osmscout/util/FileScanner.h>
+#include <osmscout/util/FileWriter.h>
 #include <osmscout/util/StopClock.h>
 
 /**
-  Sequentially read the ways.dat file in the current directory first using
-  FileReader and then using FileScanner and compare execution time.
+  Write ways with random nodes using the different delta encodings and measure
+  the decoding speed of the different coordinate delta decoders in vertices/sec.
+
+  Then measure random reads of values from a file (as done by DataFile for
+  files, that are not memory mapped), using fseek()/fread() with different
+  stdio buffer sizes and using FileScanner::ReadAt() of merged ranges. If
+  available (Linux), the number of read system calls is reported, too.
+
+  Afterwards sequentially read the ways.dat file in the current directory using
+  FileScanner and measure execution time.
 
   Call this program repeately to avoid different timing because of OS file caching.
 */
 
+#define GEOMETRY_WAY_COUNT  10000
+#define GEOMETRY_NODE_COUNT 200
+#define GEOMETRY_ITERATIONS 10
+
+#define RANDOM_FILE_SIZE    (64*1024*1024)
+#define RANDOM_READ_COUNT   5000
+#define RANDOM_VALUE_SIZE   256
+#define RANDOM_MAX_GAP      (16*1024)
+
+static const char* geometryFilename="geometry.dat";
+static const char* randomFilename="random.dat";
+
+struct Decoder
+{
+  osmscout::FileScanner::DeltaDecoder decoder;
+  const char*                         name;
+};
+
+static const Decoder decoders[]={
+  {osmscout::FileScanner::decoderScalar,"scalar"},
+  {osmscout::FileScanner::decoderSSE4,  "SSE4.1"},
+  {osmscout::FileScanner::decoderAVX2,  "AVX2"}
+};
+
+/**
+ * Generate ways as random walk, with a step size of up to maxDelta in units
+ * of the file encoding. The step size selects the delta encoding used.
+ */
+static void GenerateWays(int32_t maxDelta,
+                         std::vector<std::vector<osmscout::Point> >& ways)
+{
+  ways.resize(GEOMETRY_WAY_COUNT);
+
+  for (auto& way : ways) {
+    double lat=51.53;
+    double lon=7.45;
+
+    way.resize(GEOMETRY_NODE_COUNT);
+
+    for (auto& node : way) {
+      node.Set(0,osmscout::GeoCoord(lat,lon));
+
+      lat+=(rand()%(2*maxDelta+1)-maxDelta)/osmscout::latConversionFactor;
+      lon+=(rand()%(2*maxDelta+1)-maxDelta)/osmscout::lonConversionFactor;
+    }
+  }
+}
+
+static bool ReadWays(osmscout::FileScanner::DeltaDecoder decoder,
+                     std::vector<std::vector<osmscout::Point> >& ways,
+                     double& seconds)
+{
+  osmscout::FileScanner scanner;
+
+  try {
+    scanner.Open(geometryFilename,osmscout::FileScanner::Sequential,true);
+    scanner.SetDeltaDecoder(decoder);
+
+    osmscout::StopClock timer;
+
+    for (size_t i=0; i<GEOMETRY_ITERATIONS; i++) {
+      scanner.GotoBegin();
+
+      for (auto& way : ways) {
+        scanner.Read(way,false);
+      }
+    }
+
+    timer.Stop();
+
+    seconds=timer.GetMilliseconds()/1000.0;
+
+    scanner.Close();
+  }
+  catch (osmscout::IOException& e) {
+    std::cerr << e.GetDescription() << std::endl;
+    scanner.CloseFailsafe();
+    return false;
+  }
+
+  return true;
+}
+
+static bool MeasureDeltaDecoders(int32_t maxDelta,
+                                 const std::string& encoding)
+{
+  std::vector<std::vector<osmscout::Point> > ways;
+  osmscout::FileWriter                       writer;
+
+  GenerateWays(maxDelta,ways);
+
+  try {
+    writer.Open(geometryFilename);
+
+    for (const auto& way : ways) {
+      writer.Write(way,false);
+    }
+
+    writer.Close();
+  }
+  catch (osmscout::IOException& e) {
+    std::cerr << e.GetDescription() << std::endl;
+    writer.CloseFailsafe();
+    return false;
+  }
+
+  std::vector<std::vector<osmscout::Point> > reference(GEOMETRY_WAY_COUNT);
+  double                                     seconds;
+
+  if (!ReadWays(osmscout::FileScanner::decoderScalar,
+                reference,
+                seconds)) {
+    return false;
+  }
+
+  for (const auto& decoder : decoders) {
+    if (!osmscout::FileScanner::IsDeltaDecoderSupported(decoder.decoder)) {
+      std::cout << encoding << " " << decoder.name << ": not supported" << std::endl;
+      continue;
+    }
+
+    std::vector<std::vector<osmscout::Point> > result(GEOMETRY_WAY_COUNT);
+
+    if (!ReadWays(decoder.decoder,
+                  result,
+                  seconds)) {
+      return false;
+    }
+
+    size_t differences=0;
+
+    for (size_t w=0; w<result.size(); w++) {
+      for (size_t n=0; n<result[w].size(); n++) {
+        if (!result[w][n].IsIdentical(reference[w][n])) {
+          differences++;
+        }
+      }
+    }
+
+    double vertices=(double)GEOMETRY_WAY_COUNT*GEOMETRY_NODE_COUNT*GEOMETRY_ITERATIONS;
+
+    std::cout << encoding << " " << decoder.name << ": " << std::fixed << std::setprecision(1);
+    std::cout << vertices/seconds/1000000.0 << " M vertices/sec, " << differences << " difference(s)" << std::endl;
+  }
+
+  return true;
+}
+
+/**
+ * Return the number of read system calls of the process so far or -1, if
+ * not available
+ */
+static long GetReadCalls()
+{
+  std::ifstream stream("/proc/self/io");
+  std::string   key;
+  long          value;
+
+  while (stream >> key >> value) {
+    if (key=="syscr:") {
+      return value;
+    }
+  }
+
+  return -1;
+}
+
+/**
+ * Return the number of read system calls since the given count as returned
+ * by GetReadCalls() or -1, if not available
+ */
+static long GetReadCallsSince(long readCalls)
+{
+  long currentReadCalls=GetReadCalls();
+
+  if (readCalls<0 ||
+      currentReadCalls<0) {
+    return -1;
+  }
+
+  // Reading /proc/self/io itself is counted, too
+  return currentReadCalls-readCalls-1;
+}
+
+static void PrintResult(const std::string& name,
+                        double seconds,
+                        long readCalls)
+{
+  std::cout << name << ": " << std::fixed << std::setprecision(0) << RANDOM_READ_COUNT/seconds << " values/sec";
+
+  if (readCalls>=0) {
+    std::cout << ", " << readCalls << " read calls";
+  }
+
+  std::cout << std::endl;
+}
+
+/**
+ * Read a value of RANDOM_VALUE_SIZE bytes at each offset using fseek() and
+ * fread() with the given stdio buffer size (0 for the default buffer)
+ */
+static bool ReadRandomStdio(const std::vector<osmscout::FileOffset>& offsets,
+                            size_t bufferSize,
+                            double& seconds,
+                            long& readCalls)
+{
+  std::FILE         *file=std::fopen(randomFilename,"rb");
+  std::vector<char> value(RANDOM_VALUE_SIZE);
+
+  if (file==NULL) {
+    std::cerr << "Cannot open file '" << randomFilename << "'" << std::endl;
+    return false;
+  }
+
+  if (bufferSize>0 &&
+      std::setvbuf(file,NULL,_IOFBF,bufferSize)!=0) {
+    std::cerr << "Cannot set buffer size " << bufferSize << std::endl;
+    std::fclose(file);
+    return false;
+  }
+
+  readCalls=GetReadCalls();
+
+  osmscout::StopClock timer;
+
+  for (const auto offset : offsets) {
+    if (std::fseek(file,(long)offset,SEEK_SET)!=0 ||
+        std::fread(value.data(),1,value.size(),file)!=value.size()) {
+      std::cerr << "Cannot read value at offset " << offset << std::endl;
+      std::fclose(file);
+      return false;
+    }
+  }
+
+  timer.Stop();
+
+  readCalls=GetReadCallsSince(readCalls);
+  seconds=timer.GetMilliseconds()/1000.0;
+
+  std::fclose(file);
+
+  return true;
+}
+
+/**
+ * Merge the offsets into ranges (like DataFile does) and read each range
+ * using FileScanner::ReadAt()
+ */
+static bool ReadRandomRanges(const std::vector<osmscout::FileOffset>& offsets,
+                             size_t& rangeCount,
+                             double& seconds,
+                             long& readCalls)
+{
+  osmscout::FileScanner scanner;
+  std::vector<char>     buffer;
+
+  try {
+    scanner.Open(randomFilename,osmscout::FileScanner::LowMemRandom,false);
+
+    readCalls=GetReadCalls();
+
+    osmscout::StopClock timer;
+    size_t              i=0;
+
+    rangeCount=0;
+
+    while (i<offsets.size()) {
+      osmscout::FileOffset start=offsets[i];
+      osmscout::FileOffset end=start+RANDOM_VALUE_SIZE;
+
+      while (i<offsets.size() &&
+             offsets[i]<=end+RANDOM_MAX_GAP) {
+        end=std::max(end,offsets[i]+RANDOM_VALUE_SIZE);
+        i++;
+      }
+
+      buffer.resize((size_t)(end-start));
+      scanner.ReadAt(start,buffer.data(),buffer.size());
+      rangeCount++;
+    }
+
+    timer.Stop();
+
+    readCalls=GetReadCallsSince(readCalls);
+    seconds=timer.GetMilliseconds()/1000.0;
+
+    scanner.Close();
+  }
+  catch (osmscout::IOException& e) {
+    std::cerr << e.GetDescription() << std::endl;
+    scanner.CloseFailsafe();
+    return false;
+  }
+
+  return true;
+}
+
+static bool MeasureRandomReads()
+{
+  osmscout::FileWriter writer;
+
+  try {
+    std::vector<char> block(1024*1024);
+
+    for (auto& byte : block) {
+      byte=(char)(rand()%256);
+    }
+
+    writer.Open(randomFilename);
+
+    for (size_t i=0; i<RANDOM_FILE_SIZE/block.size(); i++) {
+      writer.Write(block.data(),block.size());
+    }
+
+    writer.Close();
+  }
+  catch (osmscout::IOException& e) {
+    std::cerr << e.GetDescription() << std::endl;
+    writer.CloseFailsafe();
+    return false;
+  }
+
+  // Sorted, like the offsets of a batch read
+  std::vector<osmscout::FileOffset> offsets(RANDOM_READ_COUNT);
+
+  for (auto& offset : offsets) {
+    offset=(osmscout::FileOffset)(((double)rand()/RAND_MAX)*(RANDOM_FILE_SIZE-RANDOM_VALUE_SIZE));
+  }
+
+  std::sort(offsets.begin(),offsets.end());
+
+  std::cout << "Reading " << RANDOM_READ_COUNT << " values of " << RANDOM_VALUE_SIZE << " bytes at sorted random offsets..." << std::endl;
+
+  for (size_t bufferSize : {0,16*1024,64*1024,256*1024}) {
+    double seconds;
+    long   readCalls;
+
+    if (!ReadRandomStdio(offsets,
+                         bufferSize,
+                         seconds,
+                         readCalls)) {
+      return false;
+    }
+
+    if (bufferSize==0) {
+      PrintResult("fseek/fread, default buffer",
+                  seconds,
+                  readCalls);
+    }
+    else {
+      PrintResult("fseek/fread, "+std::to_string(bufferSize/1024)+" KiB buffer",
+                  seconds,
+                  readCalls);
+    }
+  }
+
+  size_t rangeCount;
+  double seconds;
+  long   readCalls;
+
+  if (!ReadRandomRanges(offsets,
+                        rangeCount,
+                        seconds,
+                        readCalls)) {
+    return false;
+  }
+
+  PrintResult("ReadAt() of "+std::to_string(rangeCount)+" merged ranges",
+              seconds,
+              readCalls);
+
+  osmscout::RemoveFile(randomFilename);
+
+  return true;
+}
+
 int main(int /*argc*/, char* /*argv*/[])
 {
   std::string           wayFilename="ways.dat";
 
+  std::cout << "Decoding " << GEOMETRY_WAY_COUNT*GEOMETRY_NODE_COUNT*GEOMETRY_ITERATIONS << " vertices per encoding..." << std::endl;
+
+  if (!MeasureDeltaDecoders(100,"8 bit deltas") ||
+      !MeasureDeltaDecoders(30000,"16 bit deltas") ||
+      !MeasureDeltaDecoders(200000,"24 bit deltas")) {
+    return 1;
+  }
+
+  osmscout::RemoveFile(geometryFilename);
+
+  if (!MeasureRandomReads()) {
+    return 1;
+  }
+
   osmscout::StopClock   scannerTimer;
 
   osmscout::TypeConfig  typeConfig;
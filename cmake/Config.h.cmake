@@ -81,6 +81,11 @@
 #cmakedefine HAVE_POSIX_MADVISE 1
 #endif
 
+/* Define to 1 if you have the `pread' function. */
+#ifndef HAVE_PREAD
+#cmakedefine HAVE_PREAD 1
+#endif
+
 /* Support SSE (Streaming SIMD Extensions) instructions */
 #ifndef HAVE_SSE
 #cmakedefine HAVE_SSE 1
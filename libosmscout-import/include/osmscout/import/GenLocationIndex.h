@@ -20,7 +20,9 @@
   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
 */
 
+#include <map>
 #include <memory>
+#include <set>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -30,6 +32,8 @@
 
 #include <osmscout/ObjectRef.h>
 
+#include <osmscout/util/GeoBox.h>
+
 #include <osmscout/import/Import.h>
 
 namespace osmscout {
@@ -37,6 +41,37 @@ namespace osmscout {
   class LocationIndexGenerator : public ImportModule
   {
   private:
+    /**
+     * Posting lists of the token index, mapping a name token to the
+     * offsets of the index entries containing it
+     */
+    typedef std::map<uint32_t,std::vector<FileOffset> > TokenPostingMap;
+
+    /**
+     * Region entry of the reverse lookup index
+     */
+    struct ReverseRegion
+    {
+      FileOffset regionOffset;   //!< Offset of the region in the index file
+      uint32_t   depth;          //!< Depth of the region in the region tree
+      GeoBox     boundingBox;    //!< Bounding box of the region
+      FileOffset polygonsOffset; //!< Offset of the region polygons in the reverse index file
+    };
+
+    /**
+     * Address or POI entry of the reverse lookup index
+     */
+    struct ReverseEntry
+    {
+      ObjectFileRef object;         //!< The address or POI object
+      FileOffset    regionOffset;   //!< Offset of the region in the index file
+      FileOffset    locationOffset; //!< Offset of the location of an address, 0 for POIs
+      FileOffset    entryOffset;    //!< Offset of the address or POI entry in the index file
+      GeoBox        boundingBox;    //!< Bounding box of the object
+    };
+
+    typedef std::map<uint64_t,std::vector<ReverseEntry> > ReverseCellMap;
+
     /**
      * An area can contain an number of location nodes. Since they do not have
      * their own area we define the node name as an alias for the containing
@@ -53,8 +88,10 @@ namespace osmscout {
      */
     struct RegionPOI
     {
-      ObjectFileRef object; //!< Object
-      std::string   name;   //!< Name of the POI
+      ObjectFileRef object;      //!< Object
+      std::string   name;        //!< Name of the POI
+      GeoBox        boundingBox; //!< Bounding box of the object
+      FileOffset    poiOffset;   //!< Offset of the POI entry in the index file
 
       bool operator<(const RegionPOI& other) const
       {
@@ -64,8 +101,10 @@ namespace osmscout {
 
     struct RegionAddress
     {
-      ObjectFileRef object; //!< Object with the given address
-      std::string   name;   //!< The house number
+      ObjectFileRef object;        //!< Object with the given address
+      std::string   name;          //!< The house number
+      GeoBox        boundingBox;   //!< Bounding box of the object
+      FileOffset    addressOffset; //!< Offset of the address entry in the index file
 
       bool operator<(const RegionAddress& other) const
       {
@@ -75,6 +114,7 @@ namespace osmscout {
 
     struct RegionLocation
     {
+      FileOffset               locationOffset; //!< Offset of the location entry in the index file
       FileOffset               addressOffset; //!< Offset of place where the address list offset is stored
       std::list<ObjectFileRef> objects;       //!< Objects that represent this location
       std::list<RegionAddress> addresses;     //!< Addresses at this location
@@ -351,11 +391,13 @@ namespace osmscout {
                                 const FileOffset& fileOffset,
                                 const std::string& location,
                                 const std::string& address,
+                                const GeoCoord& coord,
                                 bool& added);
 
     void AddPOINodeToRegion(Region& region,
                             const FileOffset& fileOffset,
                             const std::string& name,
+                            const GeoCoord& coord,
                             bool& added);
 
     bool IndexAddressNodes(const TypeConfig& typeConfig,
@@ -387,6 +429,41 @@ namespace osmscout {
     void WriteAddressData(FileWriter& writer,
                           Region& root);
 
+    void AddNameTokens(const std::string& name,
+                       std::set<uint32_t>& tokens);
+
+    void AddTokenPostings(const std::set<uint32_t>& tokens,
+                          FileOffset offset,
+                          TokenPostingMap& postings);
+
+    void CollectRegionTokens(const Region& region,
+                             TokenPostingMap& regionTokens,
+                             TokenPostingMap& regionLocationTokens,
+                             TokenPostingMap& locationAddressTokens);
+
+    FileOffset WriteTokenSection(FileWriter& writer,
+                                 TokenPostingMap& postings);
+
+    void WriteTokenIndex(FileWriter& writer,
+                         const Region& root);
+
+    void WriteReverseRegionPolygons(FileWriter& writer,
+                                    const Region& region,
+                                    uint32_t depth,
+                                    std::list<ReverseRegion>& reverseRegions);
+
+    void AddReverseEntry(const ReverseEntry& entry,
+                         ReverseCellMap& cells);
+
+    void CollectReverseEntries(const Region& region,
+                               ReverseCellMap& cells);
+
+    void WriteReverseEntry(FileWriter& writer,
+                           const ReverseEntry& entry);
+
+    void WriteReverseIndex(FileWriter& writer,
+                           const Region& root);
+
   public:
     void GetDescription(const ImportParameter& parameter,
                         ImportModuleDescription& description) const;
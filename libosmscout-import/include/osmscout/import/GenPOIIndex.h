@@ -0,0 +1,86 @@
+#ifndef OSMSCOUT_IMPORT_GENPOIINDEX_H
+#define OSMSCOUT_IMPORT_GENPOIINDEX_H
+
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2016  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <vector>
+
+#include <osmscout/ObjectRef.h>
+
+#include <osmscout/util/FileWriter.h>
+#include <osmscout/util/GeoBox.h>
+
+#include <osmscout/import/Import.h>
+
+namespace osmscout {
+
+  /**
+   * Generates the POI index, a packed R-tree per POI type,
+   * bulk loaded using Sort-Tile-Recursive packing
+   */
+  class POIIndexGenerator : public ImportModule
+  {
+  private:
+    /**
+     * Entry of a node of the R-tree, either an object (leaf nodes)
+     * or a child node
+     */
+    struct TreeEntry
+    {
+      GeoBox        boundingBox;
+      FileOffset    childOffset;
+      ObjectFileRef object;
+    };
+
+    typedef std::vector<TreeEntry> TreeEntryList;
+
+  private:
+    bool ScanNodes(const TypeConfigRef& typeConfig,
+                   const ImportParameter& parameter,
+                   Progress& progress,
+                   std::vector<TreeEntryList>& typeEntries);
+
+    bool ScanWays(const TypeConfigRef& typeConfig,
+                  const ImportParameter& parameter,
+                  Progress& progress,
+                  std::vector<TreeEntryList>& typeEntries);
+
+    bool ScanAreas(const TypeConfigRef& typeConfig,
+                   const ImportParameter& parameter,
+                   Progress& progress,
+                   std::vector<TreeEntryList>& typeEntries);
+
+    void SortTileRecursive(TreeEntryList& entries);
+
+    FileOffset WriteTree(FileWriter& writer,
+                         TreeEntryList& entries,
+                         GeoBox& boundingBox);
+
+  public:
+    void GetDescription(const ImportParameter& parameter,
+                        ImportModuleDescription& description) const;
+
+    bool Import(const TypeConfigRef& typeConfig,
+                const ImportParameter& parameter,
+                Progress& progress);
+  };
+}
+
+#endif
@@ -27,6 +27,7 @@
 
 #include <osmscout/NumericIndex.h>
 #include <osmscout/RouteNode.h>
+#include <osmscout/SRTM.h>
 #include <osmscout/TurnRestriction.h>
 
 #include <osmscout/Types.h>
@@ -76,6 +77,7 @@ namespace osmscout {
     AccessRestrictedFeatureValueReader *accessRestrictedReader;
     MaxSpeedFeatureValueReader         *maxSpeedReader;
     GradeFeatureValueReader            *gradeReader;
+    SRTM                               *srtm;        //!< Source of elevation data, NULL if elevation should not be calculated
 
   private:
     bool IsAccessRestricted(const FeatureValueBuffer& buffer) const;
@@ -209,6 +211,7 @@ namespace osmscout {
      */
     void CalculateAreaPaths(RouteNode& routeNode,
                             const Area& area,
+                            const std::vector<int>& heights,
                             uint16_t objectVariantIndex,
                             FileOffset routeNodeOffset,
                             const NodeIdObjectsMap& nodeObjectsMap,
@@ -220,6 +223,7 @@ namespace osmscout {
      */
     void CalculateCircularWayPaths(RouteNode& routeNode,
                                    const Way& way,
+                                   const std::vector<int>& heights,
                                    uint16_t objectVariantIndex,
                                    FileOffset routeNodeOffset,
                                    const NodeIdObjectsMap& nodeObjectsMap,
@@ -231,12 +235,24 @@ namespace osmscout {
      */
     void CalculateWayPaths(RouteNode& routeNode,
                            const Way& way,
+                           const std::vector<int>& heights,
                            uint16_t objectVariantIndex,
                            FileOffset routeNodeOffset,
                            const NodeIdObjectsMap& nodeObjectsMap,
                            const NodeIdOffsetMap& nodeIdOffsetMap,
                            PendingRouteNodeOffsetsMap& pendingOffsetsMap);
 
+    /**
+     * Calculate the ascent and descent of a path from the heights of the nodes of the way
+     * or area, walking from node "from" to node "to" in the given direction, wrapping around
+     * at the end for circular ways and areas. If no heights are given, both are set to 0.
+     */
+    void CalculatePathElevation(RouteNode::Path& path,
+                                const std::vector<int>& heights,
+                                size_t from,
+                                size_t to,
+                                bool forward) const;
+
     /**
      * Adds the result of the turn restriction evaluation to the route node.
      */
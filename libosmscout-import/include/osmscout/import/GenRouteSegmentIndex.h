@@ -0,0 +1,94 @@
+#ifndef OSMSCOUT_IMPORT_GENROUTESEGMENTINDEX_H
+#define OSMSCOUT_IMPORT_GENROUTESEGMENTINDEX_H
+
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2016  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <vector>
+
+#include <osmscout/GeoCoord.h>
+#include <osmscout/ObjectRef.h>
+#include <osmscout/Point.h>
+
+#include <osmscout/util/FileWriter.h>
+#include <osmscout/util/GeoBox.h>
+
+#include <osmscout/import/Import.h>
+
+namespace osmscout {
+
+  /**
+   * Generates the route segment index, a packed R-tree per vehicle of
+   * the segments of all routable ways and areas, bulk loaded using
+   * Sort-Tile-Recursive packing
+   */
+  class RouteSegmentIndexGenerator : public ImportModule
+  {
+  private:
+    /**
+     * Entry of a node of the R-tree, either a segment (leaf nodes)
+     * or a child node
+     */
+    struct TreeEntry
+    {
+      GeoBox        boundingBox;
+      FileOffset    childOffset;
+      ObjectFileRef object;
+      uint32_t      fromNodeIndex;
+      uint32_t      toNodeIndex;
+      GeoCoord      from;
+      GeoCoord      to;
+    };
+
+    typedef std::vector<TreeEntry> TreeEntryList;
+
+  private:
+    void AddSegments(const TypeInfoRef& type,
+                     const ObjectFileRef& object,
+                     const std::vector<Point>& nodes,
+                     bool closed,
+                     std::vector<TreeEntryList>& vehicleEntries);
+
+    bool ScanWays(const TypeConfigRef& typeConfig,
+                  const ImportParameter& parameter,
+                  Progress& progress,
+                  std::vector<TreeEntryList>& vehicleEntries);
+
+    bool ScanAreas(const TypeConfigRef& typeConfig,
+                   const ImportParameter& parameter,
+                   Progress& progress,
+                   std::vector<TreeEntryList>& vehicleEntries);
+
+    void SortTileRecursive(TreeEntryList& entries);
+
+    FileOffset WriteTree(FileWriter& writer,
+                         TreeEntryList& entries,
+                         GeoBox& boundingBox);
+
+  public:
+    void GetDescription(const ImportParameter& parameter,
+                        ImportModuleDescription& description) const;
+
+    bool Import(const TypeConfigRef& typeConfig,
+                const ImportParameter& parameter,
+                Progress& progress);
+  };
+}
+
+#endif
@@ -20,8 +20,12 @@
  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
  */
 
+#include <set>
+#include <vector>
+
 #include <osmscout/Types.h>
 #include <osmscout/ObjectRef.h>
+#include <osmscout/TypeFeatures.h>
 
 #include <osmscout/import/Import.h>
 
@@ -31,6 +35,17 @@ namespace osmscout
 {
   class TextIndexGenerator : public ImportModule
   {
+  private:
+    /**
+     * Keys of one trie together with the data stored beside the trie
+     */
+    struct TextKeyset
+    {
+      marisa::Keyset       keyset;
+      std::vector<uint8_t> importance; //!< Importance of each key, in insertion order
+      std::set<char>       alphabet;   //!< Bytes used in the texts of the keys
+    };
+
   public:
     TextIndexGenerator();
 
@@ -57,16 +72,32 @@ namespace osmscout
                               Progress &progress,
                               const TypeConfig &typeConfig);
 
+    bool WriteImportance(const ImportParameter &parameter,
+                         Progress &progress,
+                         const std::vector<std::vector<uint8_t> >& importances);
+
+    TextKeyset& GetKeyset(const TypeInfoRef& typeInfo);
+
+    static uint8_t GetImportance(const TypeInfoRef& typeInfo,
+                                 const RefType reftype,
+                                 const AdminLevelFeatureValue* adminLevelValue);
+
+    void AddKey(TextKeyset& keyset,
+                const std::string &text,
+                const FileOffset offset,
+                const RefType reftype,
+                uint8_t importance);
+
     bool BuildKeyStr(const std::string &text,
                      const FileOffset offset,
                      const RefType reftype,
                      std::string &keyString) const;
 
     // keysets used to store text data and generate tries
-    marisa::Keyset  keysetPoi;
-    marisa::Keyset  keysetLocation;
-    marisa::Keyset  keysetRegion;
-    marisa::Keyset  keysetOther;
+    TextKeyset      keysetPoi;
+    TextKeyset      keysetLocation;
+    TextKeyset      keysetRegion;
+    TextKeyset      keysetOther;
 
     uint8_t         offsetSizeBytes;  //! size in bytes of FileOffsets stored in the tries
   };
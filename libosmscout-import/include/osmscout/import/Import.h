@@ -141,6 +141,7 @@ namespace osmscout {
     TransPolygon::OptimizeMethod optimizationWayMethod;    //<! what method to use to optimize ways
 
     size_t                       routeNodeBlockSize;       //<! Number of route nodes loaded during import until ways get resolved
+    std::string                  srtmDirectory;            //<! Directory containing SRTM hgt files for the elevation of route paths, empty for none
 
     bool                         assumeLand;               //<! During sea/land detection,we either trust coastlines only or make some
                                                            //<! assumptions which tiles are sea and which are land.
@@ -208,6 +209,7 @@ namespace osmscout {
     TransPolygon::OptimizeMethod GetOptimizationWayMethod() const;
 
     size_t GetRouteNodeBlockSize() const;
+    std::string GetSRTMDirectory() const;
 
     bool GetAssumeLand() const;
       
@@ -274,6 +276,7 @@ namespace osmscout {
     void SetOptimizationWayMethod(TransPolygon::OptimizeMethod optimizationWayMethod);
 
     void SetRouteNodeBlockSize(size_t blockSize);
+    void SetSRTMDirectory(const std::string& srtmDirectory);
 
     void SetAssumeLand(bool assumeLand);
 
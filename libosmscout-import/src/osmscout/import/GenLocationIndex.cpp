@@ -19,6 +19,7 @@
 
 #include <osmscout/import/GenLocationIndex.h>
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <limits>
@@ -1072,6 +1073,8 @@ namespace osmscout {
 
     regionAddress.name=address;
     regionAddress.object.Set(fileOffset,refArea);
+    regionAddress.boundingBox.Set(GeoCoord(minlat,minlon),
+                                  GeoCoord(maxlat,maxlon));
 
     loc->second.addresses.push_back(regionAddress);
 
@@ -1114,6 +1117,8 @@ namespace osmscout {
 
     poi.name=name;
     poi.object.Set(fileOffset,refArea);
+    poi.boundingBox.Set(GeoCoord(minlat,minlon),
+                        GeoCoord(maxlat,maxlon));
 
     region.pois.push_back(poi);
 
@@ -1297,6 +1302,8 @@ namespace osmscout {
 
       regionAddress.name=address;
       regionAddress.object.Set(fileOffset,refWay);
+      regionAddress.boundingBox.Set(GeoCoord(minlat,minlon),
+                                    GeoCoord(maxlat,maxlon));
 
       loc->second.addresses.push_back(regionAddress);
 
@@ -1358,6 +1365,8 @@ namespace osmscout {
 
     poi.name=name;
     poi.object.Set(fileOffset,refWay);
+    poi.boundingBox.Set(GeoCoord(minlat,minlon),
+                        GeoCoord(maxlat,maxlon));
 
     region.pois.push_back(poi);
 
@@ -1494,6 +1503,7 @@ namespace osmscout {
                                                       const FileOffset& fileOffset,
                                                       const std::string& location,
                                                       const std::string& address,
+                                                      const GeoCoord& coord,
                                                       bool& added)
   {
     std::map<std::string,RegionLocation>::iterator loc=region.locations.find(location);
@@ -1513,6 +1523,8 @@ namespace osmscout {
 
     regionAddress.name=address;
     regionAddress.object.Set(fileOffset,refNode);
+    regionAddress.boundingBox.Set(coord,
+                                  coord);
 
     loc->second.addresses.push_back(regionAddress);
 
@@ -1522,12 +1534,15 @@ namespace osmscout {
   void LocationIndexGenerator::AddPOINodeToRegion(Region& region,
                                                   const FileOffset& fileOffset,
                                                   const std::string& name,
+                                                  const GeoCoord& coord,
                                                   bool& added)
   {
     RegionPOI poi;
 
     poi.name=name;
     poi.object.Set(fileOffset,refNode);
+    poi.boundingBox.Set(coord,
+                        coord);
 
     region.pois.push_back(poi);
 
@@ -1600,6 +1615,7 @@ namespace osmscout {
                                  fileOffset,
                                  location,
                                  address,
+                                 coord,
                                  added);
           if (added) {
             addressFound++;
@@ -1612,6 +1628,7 @@ namespace osmscout {
           AddPOINodeToRegion(*region,
                              fileOffset,
                              name,
+                             coord,
                              added);
           if (added) {
             poiFound++;
@@ -1731,7 +1748,9 @@ namespace osmscout {
 
     ObjectFileRefStreamWriter objectFileRefWriter(writer);
 
-    for (const auto& poi : region.pois) {
+    for (auto& poi : region.pois) {
+      poi.poiOffset=writer.GetPos();
+
       writer.Write(poi.name);
 
       objectFileRefWriter.Write(poi.object);
@@ -1741,6 +1760,8 @@ namespace osmscout {
     for (auto& location : region.locations) {
       location.second.objects.sort(ObjectFileRefByFileOffsetComparator());
 
+      location.second.locationOffset=writer.GetPos();
+
       writer.Write(location.first);
       writer.WriteNumber((uint32_t)location.second.objects.size()); // Number of objects
 
@@ -1794,7 +1815,9 @@ namespace osmscout {
 
         ObjectFileRefStreamWriter objectFileRefWriter(writer);
 
-        for (const auto& address : location.second.addresses) {
+        for (auto& address : location.second.addresses) {
+          address.addressOffset=writer.GetPos();
+
           writer.Write(address.name);
 
           objectFileRefWriter.Write(address.object);
@@ -1817,6 +1840,366 @@ namespace osmscout {
     }
   }
 
+  void LocationIndexGenerator::AddNameTokens(const std::string& name,
+                                             std::set<uint32_t>& tokens)
+  {
+    std::string           normalizedName(name);
+    std::vector<uint32_t> nameTokens;
+
+    TolowerUmlaut(normalizedName);
+
+    LocationIndex::GetNameTokens(normalizedName,
+                                 nameTokens);
+
+    tokens.insert(nameTokens.begin(),
+                  nameTokens.end());
+  }
+
+  void LocationIndexGenerator::AddTokenPostings(const std::set<uint32_t>& tokens,
+                                                FileOffset offset,
+                                                TokenPostingMap& postings)
+  {
+    for (const auto token : tokens) {
+      postings[token].push_back(offset);
+    }
+  }
+
+  void LocationIndexGenerator::CollectRegionTokens(const Region& region,
+                                                   TokenPostingMap& regionTokens,
+                                                   TokenPostingMap& regionLocationTokens,
+                                                   TokenPostingMap& locationAddressTokens)
+  {
+    std::set<uint32_t> tokens;
+
+    AddNameTokens(region.name,
+                  tokens);
+
+    for (const auto& alias : region.aliases) {
+      AddNameTokens(alias.name,
+                    tokens);
+    }
+
+    AddTokenPostings(tokens,
+                     region.indexOffset,
+                     regionTokens);
+
+    tokens.clear();
+
+    for (const auto& poi : region.pois) {
+      AddNameTokens(poi.name,
+                    tokens);
+    }
+
+    for (const auto& location : region.locations) {
+      AddNameTokens(location.first,
+                    tokens);
+    }
+
+    AddTokenPostings(tokens,
+                     region.indexOffset,
+                     regionLocationTokens);
+
+    for (const auto& location : region.locations) {
+      tokens.clear();
+
+      for (const auto& address : location.second.addresses) {
+        AddNameTokens(address.name,
+                      tokens);
+      }
+
+      AddTokenPostings(tokens,
+                       location.second.locationOffset,
+                       locationAddressTokens);
+    }
+
+    for (const auto& childRegion : region.regions) {
+      CollectRegionTokens(*childRegion,
+                          regionTokens,
+                          regionLocationTokens,
+                          locationAddressTokens);
+    }
+  }
+
+  /**
+   * Write the posting lists (delta encoded) of one token index section followed
+   * by its dictionary. Returns the offset of the dictionary.
+   */
+  FileOffset LocationIndexGenerator::WriteTokenSection(FileWriter& writer,
+                                                       TokenPostingMap& postings)
+  {
+    std::vector<FileOffset> listOffsets;
+
+    listOffsets.reserve(postings.size());
+
+    for (auto& posting : postings) {
+      FileOffset lastOffset=0;
+
+      std::sort(posting.second.begin(),
+                posting.second.end());
+
+      posting.second.erase(std::unique(posting.second.begin(),
+                                       posting.second.end()),
+                           posting.second.end());
+
+      listOffsets.push_back(writer.GetPos());
+
+      for (const auto offset : posting.second) {
+        writer.WriteNumber((uint64_t)(offset-lastOffset));
+        lastOffset=offset;
+      }
+    }
+
+    FileOffset dictionaryOffset=writer.GetPos();
+    uint32_t   lastToken=0;
+    size_t     listIndex=0;
+
+    writer.WriteNumber((uint32_t)postings.size());
+
+    for (const auto& posting : postings) {
+      writer.WriteNumber(posting.first-lastToken);
+      writer.WriteNumber((uint32_t)posting.second.size());
+      writer.WriteFileOffset(listOffsets[listIndex]);
+
+      lastToken=posting.first;
+      listIndex++;
+    }
+
+    return dictionaryOffset;
+  }
+
+  /**
+   * Write the token index. For each section it maps tokens of the normalized
+   * names to the offsets of all entries in the location index containing the token:
+   * - Tokens of region names and aliases to regions
+   * - Tokens of POI and location names to the region they are in
+   * - Tokens of address names to the location they belong to
+   *
+   * Must be called after the location index has been written, since it
+   * references offsets in this file.
+   */
+  void LocationIndexGenerator::WriteTokenIndex(FileWriter& writer,
+                                               const Region& rootRegion)
+  {
+    TokenPostingMap postings[3];
+
+    for (const auto& childRegion : rootRegion.regions) {
+      CollectRegionTokens(*childRegion,
+                          postings[LocationIndex::regionTokenSection],
+                          postings[LocationIndex::regionLocationTokenSection],
+                          postings[LocationIndex::locationAddressTokenSection]);
+    }
+
+    FileOffset dictionaryOffsetsOffset=writer.GetPos();
+    FileOffset dictionaryOffsets[3];
+
+    for (size_t s=0; s<3; s++) {
+      writer.WriteFileOffset(0);
+    }
+
+    for (size_t s=0; s<3; s++) {
+      dictionaryOffsets[s]=WriteTokenSection(writer,
+                                             postings[s]);
+    }
+
+    writer.SetPos(dictionaryOffsetsOffset);
+
+    for (size_t s=0; s<3; s++) {
+      writer.WriteFileOffset(dictionaryOffsets[s]);
+    }
+  }
+
+  void LocationIndexGenerator::WriteReverseRegionPolygons(FileWriter& writer,
+                                                          const Region& region,
+                                                          uint32_t depth,
+                                                          std::list<ReverseRegion>& reverseRegions)
+  {
+    ReverseRegion reverseRegion;
+
+    reverseRegion.regionOffset=region.indexOffset;
+    reverseRegion.depth=depth;
+    reverseRegion.boundingBox.Set(GeoCoord(region.minlat,region.minlon),
+                                  GeoCoord(region.maxlat,region.maxlon));
+    reverseRegion.polygonsOffset=writer.GetPos();
+
+    writer.WriteNumber((uint32_t)region.areas.size());
+
+    for (const auto& area : region.areas) {
+      std::vector<Point> nodes;
+
+      nodes.reserve(area.size());
+
+      for (const auto& coord : area) {
+        nodes.push_back(Point(0,coord));
+      }
+
+      writer.Write(nodes,
+                   false);
+    }
+
+    reverseRegions.push_back(reverseRegion);
+
+    for (const auto& childRegion : region.regions) {
+      WriteReverseRegionPolygons(writer,
+                                 *childRegion,
+                                 depth+1,
+                                 reverseRegions);
+    }
+  }
+
+  /**
+   * Add the entry to all cells its bounding box overlaps
+   */
+  void LocationIndexGenerator::AddReverseEntry(const ReverseEntry& entry,
+                                               ReverseCellMap& cells)
+  {
+    uint32_t minX=(uint32_t)((entry.boundingBox.GetMinLon()+180.0)*LocationIndex::REVERSE_CELLS_PER_DEGREE);
+    uint32_t maxX=(uint32_t)((entry.boundingBox.GetMaxLon()+180.0)*LocationIndex::REVERSE_CELLS_PER_DEGREE);
+    uint32_t minY=(uint32_t)((entry.boundingBox.GetMinLat()+90.0)*LocationIndex::REVERSE_CELLS_PER_DEGREE);
+    uint32_t maxY=(uint32_t)((entry.boundingBox.GetMaxLat()+90.0)*LocationIndex::REVERSE_CELLS_PER_DEGREE);
+
+    for (uint32_t y=minY; y<=maxY; y++) {
+      for (uint32_t x=minX; x<=maxX; x++) {
+        cells[LocationIndex::GetReverseCellId(x,y)].push_back(entry);
+      }
+    }
+  }
+
+  void LocationIndexGenerator::CollectReverseEntries(const Region& region,
+                                                     ReverseCellMap& cells)
+  {
+    for (const auto& poi : region.pois) {
+      if (!poi.boundingBox.IsValid()) {
+        continue;
+      }
+
+      ReverseEntry entry;
+
+      entry.object=poi.object;
+      entry.regionOffset=region.indexOffset;
+      entry.locationOffset=0;
+      entry.entryOffset=poi.poiOffset;
+      entry.boundingBox=poi.boundingBox;
+
+      AddReverseEntry(entry,
+                      cells);
+    }
+
+    for (const auto& location : region.locations) {
+      for (const auto& address : location.second.addresses) {
+        if (!address.boundingBox.IsValid()) {
+          continue;
+        }
+
+        ReverseEntry entry;
+
+        entry.object=address.object;
+        entry.regionOffset=region.indexOffset;
+        entry.locationOffset=location.second.locationOffset;
+        entry.entryOffset=address.addressOffset;
+        entry.boundingBox=address.boundingBox;
+
+        AddReverseEntry(entry,
+                        cells);
+      }
+    }
+
+    for (const auto& childRegion : region.regions) {
+      CollectReverseEntries(*childRegion,
+                            cells);
+    }
+  }
+
+  void LocationIndexGenerator::WriteReverseEntry(FileWriter& writer,
+                                                 const ReverseEntry& entry)
+  {
+    writer.Write((uint8_t)entry.object.GetType());
+    writer.WriteFileOffset(entry.object.GetFileOffset());
+    writer.WriteFileOffset(entry.regionOffset);
+    writer.WriteFileOffset(entry.locationOffset);
+    writer.WriteFileOffset(entry.entryOffset);
+    writer.WriteCoord(entry.boundingBox.GetMinCoord());
+    writer.WriteCoord(entry.boundingBox.GetMaxCoord());
+  }
+
+  /**
+   * Write the reverse lookup index. It holds
+   * - the polygons of all regions together with a table of their
+   *   bounding boxes and depth in the region tree and
+   * - all addresses and POIs with their bounding box, stored in a
+   *   grid of cells with a size of 1/REVERSE_CELLS_PER_DEGREE degree.
+   *
+   * Must be called after the location index has been written, since it
+   * references offsets in this file.
+   */
+  void LocationIndexGenerator::WriteReverseIndex(FileWriter& writer,
+                                                 const Region& rootRegion)
+  {
+    std::list<ReverseRegion> reverseRegions;
+    ReverseCellMap           cells;
+    std::vector<FileOffset>  cellOffsets;
+    FileOffset               tableOffsetsOffset=writer.GetPos();
+    FileOffset               regionTableOffset;
+    FileOffset               cellTableOffset;
+
+    writer.WriteFileOffset(0);
+    writer.WriteFileOffset(0);
+
+    for (const auto& childRegion : rootRegion.regions) {
+      WriteReverseRegionPolygons(writer,
+                                 *childRegion,
+                                 0,
+                                 reverseRegions);
+    }
+
+    for (const auto& childRegion : rootRegion.regions) {
+      CollectReverseEntries(*childRegion,
+                            cells);
+    }
+
+    cellOffsets.reserve(cells.size());
+
+    for (const auto& cell : cells) {
+      cellOffsets.push_back(writer.GetPos());
+
+      for (const auto& entry : cell.second) {
+        WriteReverseEntry(writer,
+                          entry);
+      }
+    }
+
+    regionTableOffset=writer.GetPos();
+
+    writer.WriteNumber((uint32_t)reverseRegions.size());
+
+    for (const auto& reverseRegion : reverseRegions) {
+      writer.WriteFileOffset(reverseRegion.regionOffset);
+      writer.WriteNumber(reverseRegion.depth);
+      writer.WriteCoord(reverseRegion.boundingBox.GetMinCoord());
+      writer.WriteCoord(reverseRegion.boundingBox.GetMaxCoord());
+      writer.WriteFileOffset(reverseRegion.polygonsOffset);
+    }
+
+    cellTableOffset=writer.GetPos();
+
+    uint64_t lastCellId=0;
+    size_t   cellIndex=0;
+
+    writer.WriteNumber((uint32_t)cells.size());
+
+    for (const auto& cell : cells) {
+      writer.WriteNumber(cell.first-lastCellId);
+      writer.WriteNumber((uint32_t)cell.second.size());
+      writer.WriteFileOffset(cellOffsets[cellIndex]);
+
+      lastCellId=cell.first;
+      cellIndex++;
+    }
+
+    writer.SetPos(tableOffsetsOffset);
+    writer.WriteFileOffset(regionTableOffset);
+    writer.WriteFileOffset(cellTableOffset);
+  }
+
   void LocationIndexGenerator::GetDescription(const ImportParameter& /*parameter*/,
                                               ImportModuleDescription& description) const
   {
@@ -1832,6 +2215,8 @@ namespace osmscout {
     description.AddRequiredFile(AreaAreaIndexGenerator::AREAADDRESS_DAT);
 
     description.AddProvidedFile(LocationIndex::FILENAME_LOCATION_IDX);
+    description.AddProvidedFile(LocationIndex::FILENAME_LOCATION_TOKEN_IDX);
+    description.AddProvidedFile(LocationIndex::FILENAME_LOCATION_REVERSE_IDX);
   }
 
   bool LocationIndexGenerator::Import(const TypeConfigRef& typeConfig,
@@ -2067,6 +2452,26 @@ namespace osmscout {
                        *rootRegion);
 
       writer.Close();
+
+      progress.SetAction(std::string("Write '")+LocationIndex::FILENAME_LOCATION_TOKEN_IDX+"'");
+
+      writer.Open(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                  LocationIndex::FILENAME_LOCATION_TOKEN_IDX));
+
+      WriteTokenIndex(writer,
+                      *rootRegion);
+
+      writer.Close();
+
+      progress.SetAction(std::string("Write '")+LocationIndex::FILENAME_LOCATION_REVERSE_IDX+"'");
+
+      writer.Open(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                  LocationIndex::FILENAME_LOCATION_REVERSE_IDX));
+
+      WriteReverseIndex(writer,
+                        *rootRegion);
+
+      writer.Close();
     }
     catch (IOException& e) {
       progress.Error(e.GetDescription())                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                                              ;
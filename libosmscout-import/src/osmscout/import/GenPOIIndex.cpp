@@ -0,0 +1,384 @@
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2016  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <osmscout/import/GenPOIIndex.h>
+
+#include <algorithm>
+
+#include <osmscout/Area.h>
+#include <osmscout/Node.h>
+#include <osmscout/Way.h>
+
+#include <osmscout/AreaDataFile.h>
+#include <osmscout/NodeDataFile.h>
+#include <osmscout/POIIndex.h>
+#include <osmscout/WayDataFile.h>
+
+#include <osmscout/system/Math.h>
+
+#include <osmscout/util/File.h>
+#include <osmscout/util/FileScanner.h>
+#include <osmscout/util/String.h>
+
+namespace osmscout {
+
+  void POIIndexGenerator::GetDescription(const ImportParameter& /*parameter*/,
+                                         ImportModuleDescription& description) const
+  {
+    description.SetName("POIIndexGenerator");
+    description.SetDescription("Generate spatial index of POIs");
+
+    description.AddRequiredFile(NodeDataFile::NODES_DAT);
+    description.AddRequiredFile(WayDataFile::WAYS_DAT);
+    description.AddRequiredFile(AreaDataFile::AREAS_DAT);
+
+    description.AddProvidedFile(POIIndex::POI_IDX);
+  }
+
+  bool POIIndexGenerator::ScanNodes(const TypeConfigRef& typeConfig,
+                                    const ImportParameter& parameter,
+                                    Progress& progress,
+                                    std::vector<TreeEntryList>& typeEntries)
+  {
+    FileScanner scanner;
+    uint32_t    nodeCount;
+
+    try {
+      scanner.Open(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                   NodeDataFile::NODES_DAT),
+                   FileScanner::Sequential,
+                   true);
+
+      scanner.Read(nodeCount);
+
+      for (uint32_t n=1; n<=nodeCount; n++) {
+        progress.SetProgress(n,nodeCount);
+
+        Node node;
+
+        node.Read(*typeConfig,
+                  scanner);
+
+        if (!node.GetType()->GetIndexAsPOI()) {
+          continue;
+        }
+
+        TreeEntry entry;
+
+        entry.boundingBox.Set(node.GetCoords(),
+                              node.GetCoords());
+        entry.childOffset=0;
+        entry.object.Set(node.GetFileOffset(),
+                         refNode);
+
+        typeEntries[node.GetType()->GetIndex()].push_back(entry);
+      }
+
+      scanner.Close();
+    }
+    catch (IOException& e) {
+      progress.Error(e.GetDescription());
+      scanner.CloseFailsafe();
+      return false;
+    }
+
+    return true;
+  }
+
+  bool POIIndexGenerator::ScanWays(const TypeConfigRef& typeConfig,
+                                   const ImportParameter& parameter,
+                                   Progress& progress,
+                                   std::vector<TreeEntryList>& typeEntries)
+  {
+    FileScanner scanner;
+    uint32_t    wayCount;
+
+    try {
+      scanner.Open(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                   WayDataFile::WAYS_DAT),
+                   FileScanner::Sequential,
+                   parameter.GetWayDataMemoryMaped());
+
+      scanner.Read(wayCount);
+
+      for (uint32_t w=1; w<=wayCount; w++) {
+        progress.SetProgress(w,wayCount);
+
+        Way way;
+
+        way.Read(*typeConfig,
+                 scanner);
+
+        if (!way.GetType()->GetIndexAsPOI()) {
+          continue;
+        }
+
+        TreeEntry entry;
+
+        way.GetBoundingBox(entry.boundingBox);
+        entry.childOffset=0;
+        entry.object.Set(way.GetFileOffset(),
+                         refWay);
+
+        typeEntries[way.GetType()->GetIndex()].push_back(entry);
+      }
+
+      scanner.Close();
+    }
+    catch (IOException& e) {
+      progress.Error(e.GetDescription());
+      scanner.CloseFailsafe();
+      return false;
+    }
+
+    return true;
+  }
+
+  bool POIIndexGenerator::ScanAreas(const TypeConfigRef& typeConfig,
+                                    const ImportParameter& parameter,
+                                    Progress& progress,
+                                    std::vector<TreeEntryList>& typeEntries)
+  {
+    FileScanner scanner;
+    uint32_t    areaCount;
+
+    try {
+      scanner.Open(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                   AreaDataFile::AREAS_DAT),
+                   FileScanner::Sequential,
+                   parameter.GetAreaDataMemoryMaped());
+
+      scanner.Read(areaCount);
+
+      for (uint32_t a=1; a<=areaCount; a++) {
+        progress.SetProgress(a,areaCount);
+
+        Area area;
+
+        area.Read(*typeConfig,
+                  scanner);
+
+        if (!area.GetType()->GetIndexAsPOI()) {
+          continue;
+        }
+
+        TreeEntry entry;
+
+        area.GetBoundingBox(entry.boundingBox);
+        entry.childOffset=0;
+        entry.object.Set(area.GetFileOffset(),
+                         refArea);
+
+        typeEntries[area.GetType()->GetIndex()].push_back(entry);
+      }
+
+      scanner.Close();
+    }
+    catch (IOException& e) {
+      progress.Error(e.GetDescription());
+      scanner.CloseFailsafe();
+      return false;
+    }
+
+    return true;
+  }
+
+  /**
+   * Sort the entries using Sort-Tile-Recursive ordering, so that consecutive
+   * runs of POIIndex::NODE_SIZE entries form spatially compact nodes: The
+   * entries are sorted by longitude and cut into vertical slices, each slice
+   * is then sorted by latitude.
+   */
+  void POIIndexGenerator::SortTileRecursive(TreeEntryList& entries)
+  {
+    size_t nodeCount=(entries.size()+POIIndex::NODE_SIZE-1)/POIIndex::NODE_SIZE;
+    size_t sliceCount=(size_t)ceil(sqrt((double)nodeCount));
+    size_t sliceSize=sliceCount*POIIndex::NODE_SIZE;
+
+    std::sort(entries.begin(),
+              entries.end(),
+              [](const TreeEntry& a, const TreeEntry& b) {
+                return a.boundingBox.GetMinLon()+a.boundingBox.GetMaxLon()<
+                       b.boundingBox.GetMinLon()+b.boundingBox.GetMaxLon();
+              });
+
+    for (size_t start=0; start<entries.size(); start+=sliceSize) {
+      std::sort(entries.begin()+start,
+                entries.begin()+std::min(start+sliceSize,entries.size()),
+                [](const TreeEntry& a, const TreeEntry& b) {
+                  return a.boundingBox.GetMinLat()+a.boundingBox.GetMaxLat()<
+                         b.boundingBox.GetMinLat()+b.boundingBox.GetMaxLat();
+                });
+    }
+  }
+
+  /**
+   * Write the R-tree for the given (leaf) entries bottom up and return the
+   * offset of the root node. The bounding box of all entries is returned, too.
+   *
+   * @throws IOException
+   */
+  FileOffset POIIndexGenerator::WriteTree(FileWriter& writer,
+                                          TreeEntryList& entries,
+                                          GeoBox& boundingBox)
+  {
+    bool leaf=true;
+
+    while (true) {
+      TreeEntryList parents;
+
+      SortTileRecursive(entries);
+
+      for (size_t start=0; start<entries.size(); start+=POIIndex::NODE_SIZE) {
+        size_t    end=std::min(start+POIIndex::NODE_SIZE,entries.size());
+        TreeEntry parent;
+
+        parent.childOffset=writer.GetPos();
+        parent.boundingBox=entries[start].boundingBox;
+
+        writer.Write(leaf);
+        writer.WriteNumber((uint32_t)(end-start));
+
+        for (size_t i=start; i<end; i++) {
+          writer.WriteCoord(entries[i].boundingBox.GetMinCoord());
+          writer.WriteCoord(entries[i].boundingBox.GetMaxCoord());
+
+          if (leaf) {
+            writer.Write(entries[i].object);
+          }
+          else {
+            writer.WriteFileOffset(entries[i].childOffset);
+          }
+
+          parent.boundingBox.Include(entries[i].boundingBox);
+        }
+
+        parents.push_back(parent);
+      }
+
+      if (parents.size()==1) {
+        boundingBox=parents.front().boundingBox;
+
+        return parents.front().childOffset;
+      }
+
+      entries.swap(parents);
+      leaf=false;
+    }
+  }
+
+  bool POIIndexGenerator::Import(const TypeConfigRef& typeConfig,
+                                 const ImportParameter& parameter,
+                                 Progress& progress)
+  {
+    std::vector<TreeEntryList> typeEntries(typeConfig->GetTypeCount());
+
+    progress.SetAction("Scanning nodes");
+
+    if (!ScanNodes(typeConfig,
+                   parameter,
+                   progress,
+                   typeEntries)) {
+      return false;
+    }
+
+    progress.SetAction("Scanning ways");
+
+    if (!ScanWays(typeConfig,
+                  parameter,
+                  progress,
+                  typeEntries)) {
+      return false;
+    }
+
+    progress.SetAction("Scanning areas");
+
+    if (!ScanAreas(typeConfig,
+                   parameter,
+                   progress,
+                   typeEntries)) {
+      return false;
+    }
+
+    progress.SetAction("Writing POI index");
+
+    FileWriter writer;
+
+    try {
+      writer.Open(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                  POIIndex::POI_IDX));
+
+      FileOffset typeTableOffsetOffset=writer.GetPos();
+      uint32_t   typeCount=0;
+
+      writer.WriteFileOffset(0);
+
+      std::vector<FileOffset> rootOffsets(typeEntries.size(),0);
+      std::vector<uint32_t>   entryCounts(typeEntries.size(),0);
+      std::vector<GeoBox>     boundingBoxes(typeEntries.size());
+
+      for (size_t i=0; i<typeEntries.size(); i++) {
+        if (typeEntries[i].empty()) {
+          continue;
+        }
+
+        progress.Info("Type "+typeConfig->GetTypeInfo(i)->GetName()+": "+
+                      NumberToString(typeEntries[i].size())+" POI(s)");
+
+        entryCounts[i]=(uint32_t)typeEntries[i].size();
+        rootOffsets[i]=WriteTree(writer,
+                                 typeEntries[i],
+                                 boundingBoxes[i]);
+
+        // Free memory early
+        TreeEntryList().swap(typeEntries[i]);
+
+        typeCount++;
+      }
+
+      FileOffset typeTableOffset=writer.GetPos();
+
+      writer.WriteNumber(typeCount);
+
+      for (size_t i=0; i<rootOffsets.size(); i++) {
+        if (rootOffsets[i]==0) {
+          continue;
+        }
+
+        writer.WriteNumber((TypeId)i);
+        writer.WriteFileOffset(rootOffsets[i]);
+        writer.WriteNumber(entryCounts[i]);
+        writer.WriteCoord(boundingBoxes[i].GetMinCoord());
+        writer.WriteCoord(boundingBoxes[i].GetMaxCoord());
+      }
+
+      writer.SetPos(typeTableOffsetOffset);
+      writer.WriteFileOffset(typeTableOffset);
+
+      writer.Close();
+    }
+    catch (IOException& e) {
+      progress.Error(e.GetDescription());
+      writer.CloseFailsafe();
+      return false;
+    }
+
+    return true;
+  }
+}
@@ -20,6 +20,8 @@
 #include <osmscout/import/GenRouteDat.h>
 
 #include <algorithm>
+#include <limits>
+#include <memory>
 
 #include <osmscout/ObjectRef.h>
 
@@ -41,6 +43,7 @@
 namespace osmscout {
 
   RouteDataGenerator::RouteDataGenerator()
+  : srtm(NULL)
   {
     // no code
   }
@@ -1049,6 +1052,7 @@ namespace osmscout {
 
   void RouteDataGenerator::CalculateAreaPaths(RouteNode& routeNode,
                                               const Area& area,
+                                              const std::vector<int>& heights,
                                               uint16_t objectVariantIndex,
                                               FileOffset routeNodeOffset,
                                               const NodeIdObjectsMap& nodeObjectsMap,
@@ -1122,6 +1126,12 @@ namespace osmscout {
       path.flags=CopyFlags(ring);
       path.distance=distance;
 
+      CalculatePathElevation(path,
+                             heights,
+                             currentNode,
+                             nextNode,
+                             true);
+
       routeNode.paths.push_back(path);
     }
 
@@ -1181,12 +1191,19 @@ namespace osmscout {
       path.flags=CopyFlags(ring);
       path.distance=distance;
 
+      CalculatePathElevation(path,
+                             heights,
+                             currentNode,
+                             prevNode,
+                             false);
+
       routeNode.paths.push_back(path);
     }
   }
 
   void RouteDataGenerator::CalculateCircularWayPaths(RouteNode& routeNode,
                                                      const Way& way,
+                                                     const std::vector<int>& heights,
                                                      uint16_t objectVariantIndex,
                                                      FileOffset routeNodeOffset,
                                                      const NodeIdObjectsMap& nodeObjectsMap,
@@ -1259,6 +1276,12 @@ namespace osmscout {
         path.flags=CopyFlagsForward(way);
         path.distance=distance;
 
+        CalculatePathElevation(path,
+                               heights,
+                               currentNode,
+                               nextNode,
+                               true);
+
         routeNode.paths.push_back(path);
       }
     }
@@ -1318,6 +1341,12 @@ namespace osmscout {
         path.flags=CopyFlagsBackward(way);
         path.distance=distance;
 
+        CalculatePathElevation(path,
+                               heights,
+                               currentNode,
+                               prevNode,
+                               false);
+
         routeNode.paths.push_back(path);
       }
     }
@@ -1325,6 +1354,7 @@ namespace osmscout {
 
   void RouteDataGenerator::CalculateWayPaths(RouteNode& routeNode,
                                              const Way& way,
+                                             const std::vector<int>& heights,
                                              uint16_t objectVariantIndex,
                                              FileOffset routeNodeOffset,
                                              const NodeIdObjectsMap& nodeObjectsMap,
@@ -1379,6 +1409,12 @@ namespace osmscout {
                                                   way.nodes[d+1].GetLat());
             }
 
+            CalculatePathElevation(path,
+                                   heights,
+                                   i,
+                                   j,
+                                   false);
+
             routeNode.paths.push_back(path);
           }
         }
@@ -1430,6 +1466,12 @@ namespace osmscout {
                                                   way.nodes[d+1].GetLat());
             }
 
+            CalculatePathElevation(path,
+                                   heights,
+                                   i,
+                                   j,
+                                   true);
+
             routeNode.paths.push_back(path);
           }
         }
@@ -1437,6 +1479,52 @@ namespace osmscout {
     }
   }
 
+  void RouteDataGenerator::CalculatePathElevation(RouteNode::Path& path,
+                                                  const std::vector<int>& heights,
+                                                  size_t from,
+                                                  size_t to,
+                                                  bool forward) const
+  {
+    uint32_t ascent=0;
+    uint32_t descent=0;
+
+    if (!heights.empty()) {
+      size_t current=from;
+      int    lastHeight=SRTM::nodata;
+
+      while (true) {
+        int height=heights[current];
+
+        if (height!=SRTM::nodata) {
+          if (lastHeight!=SRTM::nodata) {
+            if (height>lastHeight) {
+              ascent+=height-lastHeight;
+            }
+            else {
+              descent+=lastHeight-height;
+            }
+          }
+
+          lastHeight=height;
+        }
+
+        if (current==to) {
+          break;
+        }
+
+        if (forward) {
+          current=(current+1)%heights.size();
+        }
+        else {
+          current=(current+heights.size()-1)%heights.size();
+        }
+      }
+    }
+
+    path.ascent=(uint16_t)std::min(ascent,(uint32_t)std::numeric_limits<uint16_t>::max());
+    path.descent=(uint16_t)std::min(descent,(uint32_t)std::numeric_limits<uint16_t>::max());
+  }
+
   void RouteDataGenerator::FillRoutePathExcludes(RouteNode& routeNode,
                                                  const std::list<ObjectFileRef>& objects,
                                                  const ViaTurnRestrictionMap& restrictions)
@@ -1705,6 +1793,24 @@ namespace osmscout {
 
         areaOffsets.clear();
 
+        // Heights of the nodes of all loaded ways and areas
+        std::unordered_map<FileOffset,std::vector<int> > waysHeights;
+        std::unordered_map<FileOffset,std::vector<int> > areasHeights;
+
+        if (srtm!=NULL) {
+          progress.Info("Calculating elevation of ways and areas");
+
+          for (const auto& entry : waysMap) {
+            srtm->heightsAtPoints(entry.second->nodes,
+                                  waysHeights[entry.first]);
+          }
+
+          for (const auto& entry : areasMap) {
+            srtm->heightsAtPoints(entry.second->rings.front().nodes,
+                                  areasHeights[entry.first]);
+          }
+        }
+
         progress.Info("Storing route nodes");
 
         for (size_t b=0; b<blockCount; b++) {
@@ -1775,6 +1881,7 @@ namespace osmscout {
                 // Circular way routing (similar to current area routing, but respecting isOneway())
                 CalculateCircularWayPaths(routeNode,
                                           *way,
+                                          waysHeights[ref.GetFileOffset()],
                                           objectVariantIndex,
                                           routeNodeOffset,
                                           nodeObjectsMap,
@@ -1785,6 +1892,7 @@ namespace osmscout {
                 // Normal way routing
                 CalculateWayPaths(routeNode,
                                   *way,
+                                  waysHeights[ref.GetFileOffset()],
                                   objectVariantIndex,
                                   routeNodeOffset,
                                   nodeObjectsMap,
@@ -1816,6 +1924,7 @@ namespace osmscout {
 
               CalculateAreaPaths(routeNode,
                                  *area,
+                                 areasHeights[ref.GetFileOffset()],
                                  objectVariantIndex,
                                  routeNodeOffset,
                                  nodeObjectsMap,
@@ -1913,6 +2022,15 @@ namespace osmscout {
     this->maxSpeedReader=&maxSpeedReader;
     this->gradeReader=&gradeReader;
 
+    std::unique_ptr<SRTM> srtm;
+
+    if (!parameter.GetSRTMDirectory().empty()) {
+      progress.Info("Using SRTM elevation data from '"+parameter.GetSRTMDirectory()+"'");
+      srtm.reset(new SRTM(parameter.GetSRTMDirectory()));
+    }
+
+    this->srtm=srtm.get();
+
     //
     // Handling of restriction relations
     //
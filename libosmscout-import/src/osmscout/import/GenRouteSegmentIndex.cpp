@@ -0,0 +1,373 @@
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2016  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <osmscout/import/GenRouteSegmentIndex.h>
+
+#include <algorithm>
+
+#include <osmscout/Area.h>
+#include <osmscout/Way.h>
+
+#include <osmscout/AreaDataFile.h>
+#include <osmscout/RouteSegmentIndex.h>
+#include <osmscout/WayDataFile.h>
+
+#include <osmscout/system/Math.h>
+
+#include <osmscout/util/File.h>
+#include <osmscout/util/FileScanner.h>
+#include <osmscout/util/String.h>
+
+namespace osmscout {
+
+  static const Vehicle vehicles[] = {vehicleFoot,
+                                     vehicleBicycle,
+                                     vehicleCar};
+
+  static const size_t vehicleCount=sizeof(vehicles)/sizeof(vehicles[0]);
+
+  void RouteSegmentIndexGenerator::GetDescription(const ImportParameter& /*parameter*/,
+                                                  ImportModuleDescription& description) const
+  {
+    description.SetName("RouteSegmentIndexGenerator");
+    description.SetDescription("Generate spatial index of routable segments");
+
+    description.AddRequiredFile(WayDataFile::WAYS_DAT);
+    description.AddRequiredFile(AreaDataFile::AREAS_DAT);
+
+    description.AddProvidedFile(RouteSegmentIndex::ROUTESEGMENT_IDX);
+  }
+
+  /**
+   * Add the segments of the given object to the entries of all vehicles
+   * that can route on the type of the object. Objects without any routing
+   * node (node with id) are skipped.
+   */
+  void RouteSegmentIndexGenerator::AddSegments(const TypeInfoRef& type,
+                                               const ObjectFileRef& object,
+                                               const std::vector<Point>& nodes,
+                                               bool closed,
+                                               std::vector<TreeEntryList>& vehicleEntries)
+  {
+    if (nodes.size()<2 ||
+        !type->CanRoute()) {
+      return;
+    }
+
+    bool hasNodeWithId=false;
+
+    for (const auto& node : nodes) {
+      if (node.IsRelevant()) {
+        hasNodeWithId=true;
+        break;
+      }
+    }
+
+    if (!hasNodeWithId) {
+      return;
+    }
+
+    size_t segmentCount=closed ? nodes.size() : nodes.size()-1;
+
+    for (size_t v=0; v<vehicleCount; v++) {
+      if (!type->CanRoute(vehicles[v])) {
+        continue;
+      }
+
+      for (size_t i=0; i<segmentCount; i++) {
+        size_t    next=(i+1)%nodes.size();
+        TreeEntry entry;
+
+        entry.from=nodes[i].GetCoord();
+        entry.to=nodes[next].GetCoord();
+        entry.boundingBox.Set(entry.from,
+                              entry.to);
+        entry.childOffset=0;
+        entry.object=object;
+        entry.fromNodeIndex=(uint32_t)i;
+        entry.toNodeIndex=(uint32_t)next;
+
+        vehicleEntries[v].push_back(entry);
+      }
+    }
+  }
+
+  bool RouteSegmentIndexGenerator::ScanWays(const TypeConfigRef& typeConfig,
+                                            const ImportParameter& parameter,
+                                            Progress& progress,
+                                            std::vector<TreeEntryList>& vehicleEntries)
+  {
+    FileScanner scanner;
+    uint32_t    wayCount;
+
+    try {
+      scanner.Open(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                   WayDataFile::WAYS_DAT),
+                   FileScanner::Sequential,
+                   parameter.GetWayDataMemoryMaped());
+
+      scanner.Read(wayCount);
+
+      for (uint32_t w=1; w<=wayCount; w++) {
+        progress.SetProgress(w,wayCount);
+
+        Way way;
+
+        way.Read(*typeConfig,
+                 scanner);
+
+        AddSegments(way.GetType(),
+                    ObjectFileRef(way.GetFileOffset(),
+                                  refWay),
+                    way.nodes,
+                    false,
+                    vehicleEntries);
+      }
+
+      scanner.Close();
+    }
+    catch (IOException& e) {
+      progress.Error(e.GetDescription());
+      scanner.CloseFailsafe();
+      return false;
+    }
+
+    return true;
+  }
+
+  bool RouteSegmentIndexGenerator::ScanAreas(const TypeConfigRef& typeConfig,
+                                             const ImportParameter& parameter,
+                                             Progress& progress,
+                                             std::vector<TreeEntryList>& vehicleEntries)
+  {
+    FileScanner scanner;
+    uint32_t    areaCount;
+
+    try {
+      scanner.Open(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                   AreaDataFile::AREAS_DAT),
+                   FileScanner::Sequential,
+                   parameter.GetAreaDataMemoryMaped());
+
+      scanner.Read(areaCount);
+
+      for (uint32_t a=1; a<=areaCount; a++) {
+        progress.SetProgress(a,areaCount);
+
+        Area area;
+
+        area.Read(*typeConfig,
+                  scanner);
+
+        // The router only uses the outer ring of routable areas
+        AddSegments(area.GetType(),
+                    ObjectFileRef(area.GetFileOffset(),
+                                  refArea),
+                    area.rings[0].nodes,
+                    true,
+                    vehicleEntries);
+      }
+
+      scanner.Close();
+    }
+    catch (IOException& e) {
+      progress.Error(e.GetDescription());
+      scanner.CloseFailsafe();
+      return false;
+    }
+
+    return true;
+  }
+
+  /**
+   * Sort the entries using Sort-Tile-Recursive ordering, so that consecutive
+   * runs of RouteSegmentIndex::NODE_SIZE entries form spatially compact nodes.
+   */
+  void RouteSegmentIndexGenerator::SortTileRecursive(TreeEntryList& entries)
+  {
+    size_t nodeCount=(entries.size()+RouteSegmentIndex::NODE_SIZE-1)/RouteSegmentIndex::NODE_SIZE;
+    size_t sliceCount=(size_t)ceil(sqrt((double)nodeCount));
+    size_t sliceSize=sliceCount*RouteSegmentIndex::NODE_SIZE;
+
+    std::sort(entries.begin(),
+              entries.end(),
+              [](const TreeEntry& a, const TreeEntry& b) {
+                return a.boundingBox.GetMinLon()+a.boundingBox.GetMaxLon()<
+                       b.boundingBox.GetMinLon()+b.boundingBox.GetMaxLon();
+              });
+
+    for (size_t start=0; start<entries.size(); start+=sliceSize) {
+      std::sort(entries.begin()+start,
+                entries.begin()+std::min(start+sliceSize,entries.size()),
+                [](const TreeEntry& a, const TreeEntry& b) {
+                  return a.boundingBox.GetMinLat()+a.boundingBox.GetMaxLat()<
+                         b.boundingBox.GetMinLat()+b.boundingBox.GetMaxLat();
+                });
+    }
+  }
+
+  /**
+   * Write the R-tree for the given (leaf) entries bottom up and return the
+   * offset of the root node. The bounding box of all entries is returned, too.
+   *
+   * @throws IOException
+   */
+  FileOffset RouteSegmentIndexGenerator::WriteTree(FileWriter& writer,
+                                                   TreeEntryList& entries,
+                                                   GeoBox& boundingBox)
+  {
+    bool leaf=true;
+
+    while (true) {
+      TreeEntryList parents;
+
+      SortTileRecursive(entries);
+
+      for (size_t start=0; start<entries.size(); start+=RouteSegmentIndex::NODE_SIZE) {
+        size_t    end=std::min(start+RouteSegmentIndex::NODE_SIZE,entries.size());
+        TreeEntry parent;
+
+        parent.childOffset=writer.GetPos();
+        parent.boundingBox=entries[start].boundingBox;
+
+        writer.Write(leaf);
+        writer.WriteNumber((uint32_t)(end-start));
+
+        for (size_t i=start; i<end; i++) {
+          if (leaf) {
+            // The bounding box of a segment is implicitly given by its nodes
+            writer.WriteCoord(entries[i].from);
+            writer.WriteCoord(entries[i].to);
+            writer.Write(entries[i].object);
+            writer.WriteNumber(entries[i].fromNodeIndex);
+            writer.WriteNumber(entries[i].toNodeIndex);
+          }
+          else {
+            writer.WriteCoord(entries[i].boundingBox.GetMinCoord());
+            writer.WriteCoord(entries[i].boundingBox.GetMaxCoord());
+            writer.WriteFileOffset(entries[i].childOffset);
+          }
+
+          parent.boundingBox.Include(entries[i].boundingBox);
+        }
+
+        parents.push_back(parent);
+      }
+
+      if (parents.size()==1) {
+        boundingBox=parents.front().boundingBox;
+
+        return parents.front().childOffset;
+      }
+
+      entries.swap(parents);
+      leaf=false;
+    }
+  }
+
+  bool RouteSegmentIndexGenerator::Import(const TypeConfigRef& typeConfig,
+                                          const ImportParameter& parameter,
+                                          Progress& progress)
+  {
+    std::vector<TreeEntryList> vehicleEntries(vehicleCount);
+
+    progress.SetAction("Scanning ways");
+
+    if (!ScanWays(typeConfig,
+                  parameter,
+                  progress,
+                  vehicleEntries)) {
+      return false;
+    }
+
+    progress.SetAction("Scanning areas");
+
+    if (!ScanAreas(typeConfig,
+                   parameter,
+                   progress,
+                   vehicleEntries)) {
+      return false;
+    }
+
+    progress.SetAction("Writing route segment index");
+
+    FileWriter writer;
+
+    try {
+      writer.Open(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                  RouteSegmentIndex::ROUTESEGMENT_IDX));
+
+      FileOffset vehicleTableOffsetOffset=writer.GetPos();
+
+      writer.WriteFileOffset(0);
+
+      std::vector<FileOffset> rootOffsets(vehicleCount,0);
+      std::vector<uint32_t>   segmentCounts(vehicleCount,0);
+      std::vector<GeoBox>     boundingBoxes(vehicleCount);
+      uint32_t                indexCount=0;
+
+      for (size_t v=0; v<vehicleCount; v++) {
+        if (vehicleEntries[v].empty()) {
+          continue;
+        }
+
+        progress.Info("Vehicle "+NumberToString((size_t)vehicles[v])+": "+
+                      NumberToString(vehicleEntries[v].size())+" segment(s)");
+
+        segmentCounts[v]=(uint32_t)vehicleEntries[v].size();
+        rootOffsets[v]=WriteTree(writer,
+                                 vehicleEntries[v],
+                                 boundingBoxes[v]);
+
+        // Free memory early
+        TreeEntryList().swap(vehicleEntries[v]);
+
+        indexCount++;
+      }
+
+      FileOffset vehicleTableOffset=writer.GetPos();
+
+      writer.WriteNumber(indexCount);
+
+      for (size_t v=0; v<vehicleCount; v++) {
+        if (rootOffsets[v]==0) {
+          continue;
+        }
+
+        writer.Write((uint8_t)vehicles[v]);
+        writer.WriteFileOffset(rootOffsets[v]);
+        writer.WriteNumber(segmentCounts[v]);
+        writer.WriteCoord(boundingBoxes[v].GetMinCoord());
+        writer.WriteCoord(boundingBoxes[v].GetMaxCoord());
+      }
+
+      writer.SetPos(vehicleTableOffsetOffset);
+      writer.WriteFileOffset(vehicleTableOffset);
+
+      writer.Close();
+    }
+    catch (IOException& e) {
+      progress.Error(e.GetDescription());
+      writer.CloseFailsafe();
+      return false;
+    }
+
+    return true;
+  }
+}
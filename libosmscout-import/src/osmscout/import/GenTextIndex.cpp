@@ -63,6 +63,7 @@ namespace osmscout
     description.AddProvidedOptionalFile(TextSearchIndex::TEXT_LOC_DAT);
     description.AddProvidedOptionalFile(TextSearchIndex::TEXT_REGION_DAT);
     description.AddProvidedOptionalFile(TextSearchIndex::TEXT_OTHER_DAT);
+    description.AddProvidedOptionalFile(TextSearchIndex::TEXT_IMPORTANCE_DAT);
   }
 
   bool TextIndexGenerator::Import(const TypeConfigRef& typeConfig,
@@ -103,7 +104,7 @@ namespace osmscout
     offsetSizeBytesStr+=NumberToString(offsetSizeBytes);
 
     // build and save tries
-    std::vector<marisa::Keyset*> keysets;
+    std::vector<TextKeyset*> keysets;
     keysets.push_back(&keysetPoi);
     keysets.push_back(&keysetLocation);
     keysets.push_back(&keysetRegion);
@@ -122,14 +123,32 @@ namespace osmscout
     trieFiles.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
                                         TextSearchIndex::TEXT_OTHER_DAT));
 
+    // importance of the keys of each trie, indexed by key id
+    std::vector<std::vector<uint8_t> > importances(keysets.size());
+
     for(size_t i=0; i < keysets.size(); i++) {
+      marisa::Keyset& keyset=keysets[i]->keyset;
+
       // add sz_offset to the keyset
-      keysets[i]->push_back(offsetSizeBytesStr.c_str(),
-                            offsetSizeBytesStr.length());
+      keyset.push_back(offsetSizeBytesStr.c_str(),
+                       offsetSizeBytesStr.length());
+      keysets[i]->importance.push_back(0);
+
+      // add the alphabet to the keyset, we use
+      // the ASCII control character 0x05: ENQ
+      // to denote the start of the alphabet key
+      std::string alphabetStr;
+      alphabetStr.push_back(5);
+      alphabetStr.append(keysets[i]->alphabet.begin(),
+                         keysets[i]->alphabet.end());
+
+      keyset.push_back(alphabetStr.c_str(),
+                       alphabetStr.length());
+      keysets[i]->importance.push_back(0);
 
       marisa::Trie trie;
       try {
-        trie.build(*(keysets[i]),
+        trie.build(keyset,
                    MARISA_DEFAULT_NUM_TRIES |
                    MARISA_BINARY_TAIL |
                    MARISA_LABEL_ORDER |
@@ -142,6 +161,16 @@ namespace osmscout
         return false;
       }
 
+      // After building, the keyset contains the id of each key,
+      // identical keys share the same id
+      importances[i].resize(trie.num_keys(),0);
+
+      for(size_t k=0; k < keyset.size(); k++) {
+        uint8_t& importance=importances[i][keyset[k].id()];
+
+        importance=std::max(importance,keysets[i]->importance[k]);
+      }
+
       try {
         trie.save(trieFiles[i].c_str());
       }
@@ -153,6 +182,12 @@ namespace osmscout
       }
     }
 
+    if (!WriteImportance(parameter,
+                         progress,
+                         importances)) {
+      return false;
+    }
+
     return true;
   }
 
@@ -221,8 +256,9 @@ namespace osmscout
   {
     progress.SetAction("Getting node text data");
 
-    NameFeatureValueReader    nameReader(typeConfig);
-    NameAltFeatureValueReader nameAltReader(typeConfig);
+    NameFeatureValueReader       nameReader(typeConfig);
+    NameAltFeatureValueReader    nameAltReader(typeConfig);
+    AdminLevelFeatureValueReader adminLevelReader(typeConfig);
 
     // Open nodes.dat
     std::string nodesDataFile=
@@ -257,44 +293,27 @@ namespace osmscout
             continue;
           }
 
-          // Save name attributes of this node
+          // Save name attributes of this object
           // in the right keyset
           TypeInfoRef typeInfo=node.GetType();
-          marisa::Keyset * keyset;
-          if(typeInfo->GetIndexAsPOI()) {
-            keyset = &keysetPoi;
-          }
-          else if(typeInfo->GetIndexAsLocation()) {
-            keyset = &keysetLocation;
-          }
-          else if(typeInfo->GetIndexAsRegion()) {
-            keyset = &keysetRegion;
-          }
-          else {
-            keyset = &keysetOther;
-          }
+          TextKeyset& keyset=GetKeyset(typeInfo);
+          uint8_t     importance=GetImportance(typeInfo,
+                                               refNode,
+                                               adminLevelReader.GetValue(node.GetFeatureValueBuffer()));
 
           if(nameValue!=NULL) {
-            std::string keyString;
-            if(BuildKeyStr(nameValue->GetName(),
-                           node.GetFileOffset(),
-                           refNode,
-                           keyString))
-            {
-              keyset->push_back(keyString.c_str(),
-                                keyString.length());
-            }
+            AddKey(keyset,
+                   nameValue->GetName(),
+                   node.GetFileOffset(),
+                   refNode,
+                   importance);
           }
           if(nameAltValue!=NULL) {
-            std::string keyString;
-            if(BuildKeyStr(nameAltValue->GetNameAlt(),
-                           node.GetFileOffset(),
-                           refNode,
-                           keyString))
-            {
-              keyset->push_back(keyString.c_str(),
-                                keyString.length());
-            }
+            AddKey(keyset,
+                   nameAltValue->GetNameAlt(),
+                   node.GetFileOffset(),
+                   refNode,
+                   importance);
           }
         }
       }
@@ -315,9 +334,10 @@ namespace osmscout
   {
     progress.SetAction("Getting way text data");
 
-    NameFeatureValueReader    nameReader(typeConfig);
-    NameAltFeatureValueReader nameAltReader(typeConfig);
-    RefFeatureValueReader     refReader(typeConfig);
+    NameFeatureValueReader       nameReader(typeConfig);
+    NameAltFeatureValueReader    nameAltReader(typeConfig);
+    AdminLevelFeatureValueReader adminLevelReader(typeConfig);
+    RefFeatureValueReader        refReader(typeConfig);
 
     // Open ways.dat
     std::string waysDataFile=
@@ -357,58 +377,36 @@ namespace osmscout
           continue;
         }
 
-        // Save name attributes of this node
+        // Save name attributes of this object
         // in the right keyset
         TypeInfoRef typeInfo=way.GetType();
-        marisa::Keyset * keyset;
-
-        if(typeInfo->GetIndexAsPOI()) {
-          keyset = &keysetPoi;
-        }
-        else if(typeInfo->GetIndexAsLocation()) {
-          keyset = &keysetLocation;
-        }
-        else if(typeInfo->GetIndexAsRegion()) {
-          keyset = &keysetRegion;
-        }
-        else {
-          keyset = &keysetOther;
-        }
+        TextKeyset& keyset=GetKeyset(typeInfo);
+        uint8_t     importance=GetImportance(typeInfo,
+                                             refWay,
+                                             adminLevelReader.GetValue(way.GetFeatureValueBuffer()));
 
         if(nameValue!=NULL) {
-          std::string keyString;
-          if(BuildKeyStr(nameValue->GetName(),
-                         way.GetFileOffset(),
-                         refWay,
-                         keyString))
-          {
-            keyset->push_back(keyString.c_str(),
-                              keyString.length());
-          }
+          AddKey(keyset,
+                 nameValue->GetName(),
+                 way.GetFileOffset(),
+                 refWay,
+                 importance);
         }
 
         if(nameAltValue!=NULL) {
-          std::string keyString;
-          if(BuildKeyStr(nameAltValue->GetNameAlt(),
-                         way.GetFileOffset(),
-                         refWay,
-                         keyString))
-          {
-            keyset->push_back(keyString.c_str(),
-                              keyString.length());
-          }
+          AddKey(keyset,
+                 nameAltValue->GetNameAlt(),
+                 way.GetFileOffset(),
+                 refWay,
+                 importance);
         }
 
         if(refValue!=NULL) {
-          std::string keyString;
-          if(BuildKeyStr(refValue->GetRef(),
-                         way.GetFileOffset(),
-                         refWay,
-                         keyString))
-          {
-            keyset->push_back(keyString.c_str(),
-                              keyString.length());
-          }
+          AddKey(keyset,
+                 refValue->GetRef(),
+                 way.GetFileOffset(),
+                 refWay,
+                 importance);
         }
       }
 
@@ -426,8 +424,9 @@ namespace osmscout
                                                 Progress &progress,
                                                 const TypeConfig &typeConfig)
   {
-    NameFeatureValueReader    nameReader(typeConfig);
-    NameAltFeatureValueReader nameAltReader(typeConfig);
+    NameFeatureValueReader       nameReader(typeConfig);
+    NameAltFeatureValueReader    nameAltReader(typeConfig);
+    AdminLevelFeatureValueReader adminLevelReader(typeConfig);
 
     progress.SetAction("Getting area text data");
 
@@ -470,43 +469,27 @@ namespace osmscout
             continue;
           }
 
-          TypeInfoRef    areaTypeInfo=area.rings[r].GetType();
-          marisa::Keyset *keyset;
-
-          if(areaTypeInfo->GetIndexAsPOI()) {
-            keyset = &keysetPoi;
-          }
-          else if(areaTypeInfo->GetIndexAsLocation()) {
-            keyset = &keysetLocation;
-          }
-          else if(areaTypeInfo->GetIndexAsRegion()) {
-            keyset = &keysetRegion;
-          }
-          else {
-            keyset = &keysetOther;
-          }
+          // Save name attributes of this object
+          // in the right keyset
+          TypeInfoRef areaTypeInfo=area.rings[r].GetType();
+          TextKeyset& keyset=GetKeyset(areaTypeInfo);
+          uint8_t     importance=GetImportance(areaTypeInfo,
+                                               refArea,
+                                               adminLevelReader.GetValue(area.rings[r].GetFeatureValueBuffer()));
 
           if (nameValue!=NULL) {
-            std::string keyString;
-            if(BuildKeyStr(nameValue->GetName(),
-                           area.GetFileOffset(),
-                           refArea,
-                           keyString))
-            {
-              keyset->push_back(keyString.c_str(),
-                                keyString.length());
-            }
+            AddKey(keyset,
+                   nameValue->GetName(),
+                   area.GetFileOffset(),
+                   refArea,
+                   importance);
           }
           if (nameAltValue!=NULL) {
-            std::string keyString;
-            if(BuildKeyStr(nameAltValue->GetNameAlt(),
-                           area.GetFileOffset(),
-                           refArea,
-                           keyString))
-            {
-              keyset->push_back(keyString.c_str(),
-                                keyString.length());
-            }
+            AddKey(keyset,
+                   nameAltValue->GetNameAlt(),
+                   area.GetFileOffset(),
+                   refArea,
+                   importance);
           }
         }
       }
@@ -521,6 +504,118 @@ namespace osmscout
     return true;
   }
 
+  bool TextIndexGenerator::WriteImportance(const ImportParameter &parameter,
+                                           Progress &progress,
+                                           const std::vector<std::vector<uint8_t> >& importances)
+  {
+    progress.SetAction("Writing importance of text data");
+
+    FileWriter writer;
+
+    try {
+      writer.Open(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                  TextSearchIndex::TEXT_IMPORTANCE_DAT));
+
+      for (const auto& importance : importances) {
+        writer.Write((uint32_t)importance.size());
+        writer.Write((const char*)importance.data(),
+                     importance.size());
+      }
+
+      writer.Close();
+    }
+    catch (IOException& e) {
+      progress.Error(e.GetDescription());
+      writer.CloseFailsafe();
+      return false;
+    }
+
+    return true;
+  }
+
+  TextIndexGenerator::TextKeyset& TextIndexGenerator::GetKeyset(const TypeInfoRef& typeInfo)
+  {
+    if(typeInfo->GetIndexAsPOI()) {
+      return keysetPoi;
+    }
+    else if(typeInfo->GetIndexAsLocation()) {
+      return keysetLocation;
+    }
+    else if(typeInfo->GetIndexAsRegion()) {
+      return keysetRegion;
+    }
+    else {
+      return keysetOther;
+    }
+  }
+
+  /**
+   * Returns the importance of an object, which is used for ranking
+   * fuzzy search results. Regions are more important than locations,
+   * which are more important than POIs. Regions with a lower admin level
+   * and objects with a larger geometry get a small bonus.
+   */
+  uint8_t TextIndexGenerator::GetImportance(const TypeInfoRef& typeInfo,
+                                            const RefType reftype,
+                                            const AdminLevelFeatureValue* adminLevelValue)
+  {
+    uint8_t importance;
+
+    if(typeInfo->GetIndexAsPOI()) {
+      importance=64;
+    }
+    else if(typeInfo->GetIndexAsLocation()) {
+      importance=128;
+    }
+    else if(typeInfo->GetIndexAsRegion()) {
+      importance=192;
+    }
+    else {
+      importance=0;
+    }
+
+    if(adminLevelValue!=NULL &&
+       adminLevelValue->GetAdminLevel()<12) {
+      importance+=(12-adminLevelValue->GetAdminLevel())*4;
+    }
+
+    if(reftype==refArea) {
+      importance+=8;
+    }
+    else if(reftype==refWay) {
+      importance+=4;
+    }
+
+    return importance;
+  }
+
+  void TextIndexGenerator::AddKey(TextKeyset& keyset,
+                                  const std::string &text,
+                                  const FileOffset offset,
+                                  const RefType reftype,
+                                  uint8_t importance)
+  {
+    std::string keyString;
+
+    if(!BuildKeyStr(text,
+                    offset,
+                    reftype,
+                    keyString)) {
+      return;
+    }
+
+    keyset.keyset.push_back(keyString.c_str(),
+                            keyString.length());
+    keyset.importance.push_back(importance);
+
+    for(const char c : text) {
+      // Control characters are reserved for special keys
+      if((unsigned char)c>=0x20) {
+        keyset.alphabet.insert(c);
+      }
+    }
+  }
+
   bool TextIndexGenerator::BuildKeyStr(const std::string &text,
                                        const FileOffset offset,
                                        const RefType reftype,
@@ -63,6 +63,8 @@
 #include <osmscout/import/GenLocationIndex.h>
 #include <osmscout/import/GenOptimizeAreaWayIds.h>
 #include <osmscout/import/GenWaterIndex.h>
+#include <osmscout/import/GenPOIIndex.h>
+#include <osmscout/import/GenRouteSegmentIndex.h>
 
 #include <osmscout/import/GenOptimizeAreasLowZoom.h>
 #include <osmscout/import/GenOptimizeWaysLowZoom.h>
@@ -83,9 +85,9 @@ namespace osmscout {
 
   static const size_t defaultStartStep=1;
 #if defined(OSMSCOUT_IMPORT_HAVE_LIB_MARISA)
-  static const size_t defaultEndStep=24;
+  static const size_t defaultEndStep=26;
 #else
-  static const size_t defaultEndStep=23;
+  static const size_t defaultEndStep=25;
 #endif
 
   ImportParameter::Router::Router(uint8_t vehicleMask,
@@ -340,6 +342,11 @@ namespace osmscout {
     return routeNodeBlockSize;
   }
 
+  std::string ImportParameter::GetSRTMDirectory() const
+  {
+    return srtmDirectory;
+  }
+
   bool ImportParameter::GetAssumeLand() const
   {
     return assumeLand;
@@ -565,6 +572,11 @@ namespace osmscout {
     this->routeNodeBlockSize=blockSize;
   }
 
+  void ImportParameter::SetSRTMDirectory(const std::string& srtmDirectory)
+  {
+    this->srtmDirectory=srtmDirectory;
+  }
+
   void ImportParameter::SetAssumeLand(bool assumeLand)
   {
     this->assumeLand=assumeLand;
@@ -758,8 +770,14 @@ namespace osmscout {
     /* 23 */
     modules.push_back(std::make_shared<IntersectionIndexGenerator>());
 
-#if defined(OSMSCOUT_IMPORT_HAVE_LIB_MARISA)
     /* 24 */
+    modules.push_back(std::make_shared<POIIndexGenerator>());
+
+    /* 25 */
+    modules.push_back(std::make_shared<RouteSegmentIndexGenerator>());
+
+#if defined(OSMSCOUT_IMPORT_HAVE_LIB_MARISA)
+    /* 26 */
     modules.push_back(std::make_shared<TextIndexGenerator>());
 #endif
   }
@@ -690,7 +690,7 @@ namespace osmscout {
     rasterizer->add_path(path);
 
     if (!area.clippings.empty()) {
-      for (std::list<PolyData>::const_iterator c=area.clippings.begin();
+      for (std::vector<PolyData>::const_iterator c=area.clippings.begin();
           c!=area.clippings.end();
           c++) {
         const PolyData    &data=*c;
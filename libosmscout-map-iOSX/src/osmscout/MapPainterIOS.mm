@@ -854,7 +854,7 @@ namespace osmscout {
                                 coordBuffer->buffer[area.transStart].GetY());
         
         if (!area.clippings.empty()) {
-            for (std::list<PolyData>::const_iterator c=area.clippings.begin();
+            for (std::vector<PolyData>::const_iterator c=area.clippings.begin();
                  c!=area.clippings.end();
                  c++) {
                 const PolyData& data=*c;
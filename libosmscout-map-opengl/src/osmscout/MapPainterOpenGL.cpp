@@ -231,7 +231,7 @@ namespace osmscout {
 
       if (!area.clippings.empty()) {
         // Clip areas within the area by using CAIRO_FILL_RULE_EVEN_ODD
-        for (std::list<PolyData>::const_iterator c=area.clippings.begin();
+        for (std::vector<PolyData>::const_iterator c=area.clippings.begin();
             c!=area.clippings.end();
             c++) {
           const PolyData& data=*c;
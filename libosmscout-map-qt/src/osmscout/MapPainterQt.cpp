@@ -846,7 +846,7 @@ namespace osmscout {
     path.closeSubpath();
 
     if (!area.clippings.empty()) {
-      for (std::list<PolyData>::const_iterator c=area.clippings.begin();
+      for (std::vector<PolyData>::const_iterator c=area.clippings.begin();
           c!=area.clippings.end();
           c++) {
         const PolyData& data=*c;
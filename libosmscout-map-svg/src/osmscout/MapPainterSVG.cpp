@@ -551,7 +551,7 @@ namespace osmscout {
     }
     stream << " Z";
 
-    for (std::list<PolyData>::const_iterator c=area.clippings.begin();
+    for (std::vector<PolyData>::const_iterator c=area.clippings.begin();
         c!=area.clippings.end();
         c++) {
       const PolyData    &data=*c;
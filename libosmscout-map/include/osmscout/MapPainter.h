@@ -21,7 +21,9 @@
 */
 
 #include <list>
+#include <memory>
 #include <string>
+#include <unordered_map>
 
 #include <osmscout/private/MapImportExport.h>
 
@@ -164,7 +166,7 @@ namespace osmscout {
       GeoBox                   boundingBox;     //!< Bounding box of the area
       size_t                   transStart;      //!< Start of coordinates in transformation buffer
       size_t                   transEnd;        //!< End of coordinates in transformation buffer
-      std::list<PolyData>      clippings;       //!< Clipping polygons to be used during drawing of this area
+      std::vector<PolyData>    clippings;       //!< Clipping polygons to be used during drawing of this area
     };
 
     struct OSMSCOUT_MAP_API LabelData
@@ -194,27 +196,98 @@ namespace osmscout {
       IconStyleRef iconStyle;  //!< The icon style for a icon or symbol
     };
 
+  private:
+    /**
+     * Scratch data of one chunk of the (optionally parallel) prepare phase.
+     * The first chunk transforms directly into the coordinate buffer of the
+     * painter, all other chunks transform into their own local buffer, which
+     * gets appended to the painter buffer after all chunks have finished.
+     */
+    struct PrepareChunk
+    {
+      TransBuffer                  *transBuffer;      //!< Transformation buffer to use for this chunk
+      CoordBufferImpl<Vertex2D>    *localBuffer;      //!< Chunk local coordinate buffer (NULL for the first chunk)
+      std::unique_ptr<TransBuffer> localTransBuffer;  //!< Owner of the chunk local transformation buffer
+      std::vector<LineStyleRef>    lineStyles;        //!< Temporary storage for StyleConfig return value
+      std::vector<PolyData>        ringData;          //!< Temporary storage for the transformed rings of an area
+      std::vector<AreaData>        areaData;
+      std::vector<WayData>         wayData;
+      std::vector<WayPathData>     wayPathData;
+      size_t                       areasSegments;
+      size_t                       waysSegments;
+    };
+
+    /**
+     * All labels placed in one label layer (normal labels or overlays) plus a
+     * uniform grid over their bounding boxes and an index of shield labels by their
+     * text. The indexes allow finding conflicting labels during label placement
+     * without visiting all already placed labels.
+     *
+     * Labels that get removed in favour of a label with higher priority are only
+     * flagged as removed, since the indexes reference labels by their position.
+     * Compact() finally drops all removed labels.
+     */
+    struct LabelLayer
+    {
+      std::vector<LabelData>           labels;      //!< Placed labels (in order of placement)
+      std::vector<bool>                removed;     //!< Labels removed in favour of other labels
+      std::vector<size_t>              visited;     //!< Query stamp per label, to return labels spanning multiple cells only once
+      std::vector<std::vector<size_t>> cells;       //!< Labels overlapping the given cell
+      std::unordered_map<std::string,std::vector<size_t>> shieldTexts; //!< Shield labels by text
+      std::vector<size_t>              marked;      //!< Labels currently marked during conflict resolution
+      std::vector<size_t>              candidates;  //!< Result of the last Query()
+      size_t                           queryStamp;
+      double                           cellSize;
+      size_t                           xCount;
+      size_t                           yCount;
+
+      LabelLayer();
+
+      void Reset(double width,
+                 double height);
+      void GetCellRange(double x1, double x2,
+                        double y1, double y2,
+                        size_t& cx1, size_t& cx2,
+                        size_t& cy1, size_t& cy2) const;
+      void Query(double x1, double x2,
+                 double y1, double y2);
+      void Add(LabelData&& label);
+      void Compact();
+    };
+
   private:
     CoordBuffer                  *coordBuffer;      //!< Reference to the coordinate buffer
 
     double                       errorTolerancePixel;
 
-    std::list<AreaData>          areaData;
-    std::list<WayData>           wayData;
-    std::list<WayPathData>       wayPathData;
+    /**
+      Per frame draw queues. The vectors are cleared but not freed between
+      frames, so after the first frames no further allocation for the queues
+      themselves is required.
+     */
+    //@{
+    std::vector<AreaData>        areaData;
+    std::vector<WayData>         wayData;
+    std::vector<WayPathData>     wayPathData;
+
+    std::vector<size_t>          sortOrder;        //!< Scratch buffer for sorting draw queues
+    std::vector<AreaData>        areaSortBuffer;   //!< Scratch buffer for sorting areaData
+    std::vector<WayData>         waySortBuffer;    //!< Scratch buffer for sorting wayData
+    //@}
 
     /**
       Temporary data structures for intelligent label positioning
       */
     //@{
-    std::list<LabelData>         labels;
-    std::list<LabelData>         overlayLabels;
+    LabelLayer                   labels;
+    LabelLayer                   overlayLabels;
     std::vector<ScanCell>        wayScanlines;
     std::vector<LabelLayoutData> labelLayoutData;
     //@}
 
     std::vector<TextStyleRef>    textStyles;     //!< Temporary storage for StyleConfig return value
-    std::vector<LineStyleRef>    lineStyles;     //!< Temporary storage for StyleConfig return value
+
+    std::vector<std::unique_ptr<PrepareChunk>> prepareChunks; //!< Scratch data for the prepare phase, reused between calls
 
     /**
       Statistics counter
@@ -306,27 +379,38 @@ namespace osmscout {
      Label placement routines
      */
     //@{
-    void ClearLabelMarks(std::list<LabelData>& labels);
-    void RemoveMarkedLabels(std::list<LabelData>& labels);
+    void ClearLabelMarks(LabelLayer& labels);
+    void RemoveMarkedLabels(LabelLayer& labels);
     bool MarkAllInBoundingBox(double bx1,
                               double bx2,
                               double by1,
                               double by2,
                               const LabelStyle& style,
-                              std::list<LabelData>& labels);
+                              LabelLayer& labels);
     bool MarkCloseLabelsWithSameText(double bx1,
                                      double bx2,
                                      double by1,
                                      double by2,
                                      const LabelStyle& style,
                                      const std::string& text,
-                                     std::list<LabelData>& labels);
+                                     LabelLayer& labels);
     //@}
 
     /**
       Private draw algorithm implementation routines.
      */
     //@{
+    size_t InitializePrepareChunks(const MapParameter& parameter,
+                                   size_t objectCount);
+
+    void MergePrepareChunks(size_t chunkCount);
+
+    void PrepareArea(const StyleConfig& styleConfig,
+                     const Projection& projection,
+                     const MapParameter& parameter,
+                     const AreaRef& area,
+                     PrepareChunk& chunk);
+
     void PrepareAreas(const StyleConfig& styleConfig,
                       const Projection& projection,
                       const MapParameter& parameter,
@@ -335,9 +419,8 @@ namespace osmscout {
     void PrepareWaySegment(const StyleConfig& styleConfig,
                            const Projection& projection,
                            const MapParameter& parameter,
-                           const ObjectFileRef& ref,
-                           const FeatureValueBuffer& buffer,
-                           const std::vector<Point>& nodes);
+                           const Way& way,
+                           PrepareChunk& chunk);
 
     void PrepareWays(const StyleConfig& styleConfig,
                      const Projection& projection,
@@ -419,11 +502,11 @@ namespace osmscout {
      */
     //@{
     bool IsVisibleArea(const Projection& projection,
-                       const std::vector<Point>& nodes,
+                       const GeoBox& boundingBox,
                        double pixelOffset) const;
 
     bool IsVisibleWay(const Projection& projection,
-                      const std::vector<Point>& nodes,
+                      const GeoBox& boundingBox,
                       double pixelOffset) const;
 
     void Transform(const Projection& projection,
@@ -444,12 +527,12 @@ namespace osmscout {
     }
     //@}
 
-    inline const std::list<WayData>& GetWayData() const
+    inline const std::vector<WayData>& GetWayData() const
     {
       return wayData;
     }
 
-    inline const std::list<AreaData>& GetAreaData() const
+    inline const std::vector<AreaData>& GetAreaData() const
     {
       return areaData;
     }
@@ -65,6 +65,8 @@ namespace osmscout {
 
     bool                         showAltLanguage;           //!< if true, display alternative language (needs support by style sheet and import)
 
+    size_t                       prepareThreadCount;        //!< Maximum number of threads used for preparing areas and ways for drawing (default 1)
+
     BreakerRef                   breaker;                   //!< Breaker to abort processing on external request
 
   public:
@@ -101,6 +103,8 @@ namespace osmscout {
 
     void SetShowAltLanguage(bool showAltLanguage);
 
+    void SetPrepareThreadCount(size_t prepareThreadCount);
+
     void SetBreaker(const BreakerRef& breaker);
 
 
@@ -209,6 +213,11 @@ namespace osmscout {
       return showAltLanguage;
     }
 
+    inline size_t GetPrepareThreadCount() const
+    {
+      return prepareThreadCount;
+    }
+
     bool IsAborted() const
     {
       if (breaker) {
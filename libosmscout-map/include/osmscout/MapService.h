@@ -20,6 +20,7 @@
   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
 */
 
+#include <condition_variable>
 #include <list>
 #include <memory>
 #include <thread>
@@ -34,6 +35,7 @@
 #include <osmscout/StyleConfig.h>
 
 #include <osmscout/util/Breaker.h>
+#include <osmscout/util/Cache.h>
 #include <osmscout/util/GeoBox.h>
 #include <osmscout/util/StopClock.h>
 #include <osmscout/util/WorkQueue.h>
@@ -53,6 +55,8 @@ namespace osmscout {
     bool          useLowZoomOptimization;
     BreakerRef    breaker;
     bool          useMultithreading;
+    bool          useCompactGeometry;
+    bool          useMemoryArena;
 
   public:
     AreaSearchParameter();
@@ -63,6 +67,10 @@ namespace osmscout {
 
     void SetUseMultithreading(bool useMultithreading);
 
+    void SetUseCompactGeometry(bool useCompactGeometry);
+
+    void SetUseMemoryArena(bool useMemoryArena);
+
     void SetBreaker(const BreakerRef& breaker);
 
     unsigned long GetMaximumAreaLevel() const;
@@ -71,6 +79,10 @@ namespace osmscout {
 
     bool GetUseMultithreading() const;
 
+    bool GetUseCompactGeometry() const;
+
+    bool GetUseMemoryArena() const;
+
     bool IsAborted() const;
   };
 
@@ -99,7 +111,23 @@ namespace osmscout {
 
     typedef std::shared_ptr<TypeDefinition> TypeDefinitionRef;
 
+    typedef Cache<uint64_t,std::list<GroundTile> > GroundTileCache;
+
+    /**
+     * Parameters of a call to PrefetchTileData()
+     */
+    struct PrefetchRequest
+    {
+      AreaSearchParameter parameter;
+      StyleConfigRef      styleConfig;
+      Magnification       magnification;
+      GeoBox              boundingBox;
+      bool                loadTileData;
+    };
+
   public:
+    static const size_t DEFAULT_GROUND_TILE_CACHE_SIZE = 64; //!< Default number of cached ground tile blocks
+
     typedef size_t                              CallbackId;
     typedef std::function<void(const TileRef&)> TileStateCallback;
 
@@ -129,6 +157,19 @@ namespace osmscout {
     std::map<CallbackId,TileStateCallback> tileStateCallbacks;
     mutable std::mutex           callbackMutex;        //<! Mutex to protect callback (de)registering
 
+    mutable std::mutex           groundTileMutex;      //!< Mutex to protect the ground tile cache
+    mutable GroundTileCache      groundTileCache;      //!< Merged ground tiles per water index block
+    mutable WaterIndexRef        groundTileIndex;      //!< Water index the ground tile cache was filled from
+
+    mutable std::mutex              prefetchMutex;        //!< Mutex to protect the prefetch state
+    mutable std::condition_variable prefetchCondition;    //!< Signals new prefetch requests and the end of foreground work
+    mutable PrefetchRequest         prefetchRequest;      //!< Latest prefetch request, if pending
+    mutable bool                    prefetchPending;      //!< The prefetch request is waiting for execution
+    bool                            prefetchStop;         //!< Signals the prefetch worker to stop
+    mutable size_t                  foregroundRequests;   //!< Number of running foreground requests
+    mutable size_t                  workerTasks;          //!< Number of queued or running tasks of the worker threads
+    BreakerRef                      prefetchBreaker;      //!< Aborts the running prefetch request
+    std::thread                     prefetchWorkerThread; //!< Worker executing prefetch requests
 
   private:
     TypeDefinitionRef GetTypeDefinition(const AreaSearchParameter& parameter,
@@ -168,6 +209,7 @@ namespace osmscout {
     void WayLowZoomWorkerLoop();
     void AreaWorkerLoop();
     void AreaLowZoomWorkerLoop();
+    void PrefetchWorkerLoop();
 
     std::future<bool> PushNodeTask(const AreaSearchParameter& parameter,
                                    const TypeInfoSet& nodeTypes,
@@ -199,6 +241,13 @@ namespace osmscout {
 
     void NotifyTileStateCallbacks(const TileRef& tile) const;
 
+    void BeginForegroundRequest() const;
+    void EndForegroundRequest() const;
+    void BeginWorkerTask() const;
+    void EndWorkerTask() const;
+
+    bool PrefetchData(const PrefetchRequest& request) const;
+
     bool LoadMissingTileDataInternal(const AreaSearchParameter& parameter,
                                      const StyleConfig& styleConfig,
                                      std::list<TileRef>& tiles,
@@ -212,6 +261,9 @@ namespace osmscout {
 
     void FlushTileCache();
 
+    void SetGroundTileCacheSize(size_t cacheSize);
+    void FlushGroundTileCache();
+
     void LookupTiles(const Magnification& magnification,
                      const GeoBox& boundingBox,
                      std::list<TileRef>& tiles) const;
@@ -229,6 +281,12 @@ namespace osmscout {
                                   const StyleConfig& styleConfig,
                                   std::list<TileRef>& tiles) const;
 
+    void PrefetchTileData(const AreaSearchParameter& parameter,
+                          const StyleConfigRef& styleConfig,
+                          const Magnification& magnification,
+                          const GeoBox& boundingBox,
+                          bool loadTileData=false) const;
+
     void ConvertTilesToMapData(std::list<TileRef>& tiles,
                                MapData& data) const;
 
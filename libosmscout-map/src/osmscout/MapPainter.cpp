@@ -19,6 +19,9 @@
 
 #include <osmscout/MapPainter.h>
 
+#include <algorithm>
+#include <future>
+#include <iterator>
 #include <limits>
 
 #include <osmscout/system/Math.h>
@@ -32,6 +35,12 @@
 
 namespace osmscout {
 
+  /**
+   * Minimum number of objects per chunk in the prepare phase. Splitting into smaller
+   * chunks does not pay off the thread handling overhead.
+   */
+  static const size_t prepareChunkMinSize=500;
+
   /**
    * Return if a > b, a should be drawn before b
    */
@@ -62,6 +71,51 @@ namespace osmscout {
     }
   }
 
+  /**
+   * Sort the given vector in a stable way. Instead of moving the (large) elements
+   * around during sorting, only the index vector gets sorted (using the original
+   * index as tie breaker). Afterwards the elements are moved in sorted order
+   * into the scratch vector, which is then swapped with the data vector.
+   *
+   * All given vectors keep their capacity, so no allocation takes place
+   * once they have grown to the size required for a frame.
+   */
+  template<class T, class Less>
+  static void StableSortByIndex(std::vector<T>& data,
+                                std::vector<T>& scratch,
+                                std::vector<size_t>& order,
+                                Less less)
+  {
+    order.resize(data.size());
+
+    for (size_t i=0; i<order.size(); i++) {
+      order[i]=i;
+    }
+
+    std::sort(order.begin(),
+              order.end(),
+              [&data,&less](size_t a, size_t b) {
+                if (less(data[a],data[b])) {
+                  return true;
+                }
+                else if (less(data[b],data[a])) {
+                  return false;
+                }
+
+                return a<b;
+              });
+
+    scratch.clear();
+    scratch.reserve(data.size());
+
+    for (size_t idx : order) {
+      scratch.push_back(std::move(data[idx]));
+    }
+
+    data.swap(scratch);
+    scratch.clear();
+  }
+
   /**
    * Sort labels for the same object by position
    */
@@ -167,7 +221,7 @@ namespace osmscout {
       DataStatistic& entry=statistics[way->GetType()];
 
       entry.wayCount++;
-      entry.coordCount+=way->nodes.size();
+      entry.coordCount+=way->GetNodeCount();
 
       PathShieldStyleRef shieldStyle;
       PathTextStyleRef   pathTextStyle;
@@ -192,7 +246,7 @@ namespace osmscout {
       DataStatistic& entry=statistics[way->GetType()];
 
       entry.wayCount++;
-      entry.coordCount+=way->nodes.size();
+      entry.coordCount+=way->GetNodeCount();
 
       PathShieldStyleRef shieldStyle;
       PathTextStyleRef   pathTextStyle;
@@ -219,7 +273,7 @@ namespace osmscout {
       entry.areaCount++;
 
       for (const auto& ring : area->rings) {
-        entry.coordCount+=ring.nodes.size();
+        entry.coordCount+=ring.GetNodeCount();
 
         if (ring.IsMasterRing()) {
           IconStyleRef iconStyle;
@@ -248,7 +302,7 @@ namespace osmscout {
       entry.areaCount++;
 
       for (const auto& ring : area->rings) {
-        entry.coordCount+=ring.nodes.size();
+        entry.coordCount+=ring.GetNodeCount();
 
         if (ring.IsMasterRing()) {
           IconStyleRef iconStyle;
@@ -294,25 +348,13 @@ namespace osmscout {
   }
 
   bool MapPainter::IsVisibleArea(const Projection& projection,
-                                 const std::vector<Point>& nodes,
+                                 const GeoBox& boundingBox,
                                  double pixelOffset) const
   {
-    if (nodes.empty()) {
-      return false;
-    }
-
-    // Bounding box
-    double lonMin=nodes[0].GetLon();
-    double lonMax=lonMin;
-    double latMin=nodes[0].GetLat();
-    double latMax=latMin;
-
-    for (size_t i=1; i<nodes.size(); i++) {
-      lonMin=std::min(lonMin,nodes[i].GetLon());
-      lonMax=std::max(lonMax,nodes[i].GetLon());
-      latMin=std::min(latMin,nodes[i].GetLat());
-      latMax=std::max(latMax,nodes[i].GetLat());
-    }
+    double lonMin=boundingBox.GetMinLon();
+    double lonMax=boundingBox.GetMaxLon();
+    double latMin=boundingBox.GetMinLat();
+    double latMax=boundingBox.GetMaxLat();
 
     double x1;
     double x2;
@@ -352,25 +394,13 @@ namespace osmscout {
   }
 
   bool MapPainter::IsVisibleWay(const Projection& projection,
-                                const std::vector<Point>& nodes,
+                                const GeoBox& boundingBox,
                                 double pixelOffset) const
   {
-    if (nodes.empty()) {
-      return false;
-    }
-
-    // Bounding box
-    double lonMin=nodes[0].GetLon();
-    double lonMax=lonMin;
-    double latMin=nodes[0].GetLat();
-    double latMax=latMin;
-
-    for (size_t i=1; i<nodes.size(); i++) {
-      lonMin=std::min(lonMin,nodes[i].GetLon());
-      lonMax=std::max(lonMax,nodes[i].GetLon());
-      latMin=std::min(latMin,nodes[i].GetLat());
-      latMax=std::max(latMax,nodes[i].GetLat());
-    }
+    double lonMin=boundingBox.GetMinLon();
+    double lonMax=boundingBox.GetMaxLon();
+    double latMin=boundingBox.GetMinLat();
+    double latMax=boundingBox.GetMaxLat();
 
     double x1;
     double x2;
@@ -404,25 +434,176 @@ namespace osmscout {
              yMax<0);
   }
 
-  void MapPainter::ClearLabelMarks(std::list<LabelData>& labels)
+  /**
+   * Size of a cell of the label collision grid in pixel.
+   */
+  static const double labelCellSize=64.0;
+
+  MapPainter::LabelLayer::LabelLayer()
+  : queryStamp(0),
+    cellSize(labelCellSize),
+    xCount(1),
+    yCount(1)
+  {
+    // no code
+  }
+
+  void MapPainter::LabelLayer::Reset(double width,
+                                     double height)
   {
-    for (auto& label : labels) {
-      label.mark=false;
+    labels.clear();
+    removed.clear();
+    visited.clear();
+    shieldTexts.clear();
+    marked.clear();
+    candidates.clear();
+    queryStamp=0;
+
+    xCount=std::max((size_t)1,(size_t)ceil(width/cellSize));
+    yCount=std::max((size_t)1,(size_t)ceil(height/cellSize));
+
+    cells.resize(xCount*yCount);
+
+    for (auto& cell : cells) {
+      cell.clear();
     }
   }
 
-  void MapPainter::RemoveMarkedLabels(std::list<LabelData>& labels)
+  static inline size_t GetLabelCell(double value,
+                                    double cellSize,
+                                    size_t cellCount)
   {
-    std::list<LabelData>::iterator label=labels.begin();
+    double cell=floor(value/cellSize);
 
-    while (label!=labels.end()) {
-      if (label->mark) {
-        label=labels.erase(label);
+    // Labels outside the visible area are assigned to the border cells
+    if (!(cell>0.0)) {
+      return 0;
+    }
+
+    if (cell>=(double)(cellCount-1)) {
+      return cellCount-1;
+    }
+
+    return (size_t)cell;
+  }
+
+  void MapPainter::LabelLayer::GetCellRange(double x1, double x2,
+                                            double y1, double y2,
+                                            size_t& cx1, size_t& cx2,
+                                            size_t& cy1, size_t& cy2) const
+  {
+    cx1=GetLabelCell(x1,cellSize,xCount);
+    cx2=GetLabelCell(x2,cellSize,xCount);
+    cy1=GetLabelCell(y1,cellSize,yCount);
+    cy2=GetLabelCell(y2,cellSize,yCount);
+  }
+
+  /**
+   * Collect all (not removed) labels in cells overlapping the given box into
+   * candidates. Every label is returned only once, even if it spans multiple cells.
+   */
+  void MapPainter::LabelLayer::Query(double x1, double x2,
+                                     double y1, double y2)
+  {
+    size_t cx1,cx2,cy1,cy2;
+
+    GetCellRange(x1,x2,y1,y2,
+                 cx1,cx2,cy1,cy2);
+
+    candidates.clear();
+    queryStamp++;
+
+    for (size_t cy=cy1; cy<=cy2; cy++) {
+      for (size_t cx=cx1; cx<=cx2; cx++) {
+        for (size_t index : cells[cy*xCount+cx]) {
+          if (removed[index] ||
+              visited[index]==queryStamp) {
+            continue;
+          }
+
+          visited[index]=queryStamp;
+          candidates.push_back(index);
+        }
       }
-      else {
-        ++label;
+    }
+  }
+
+  void MapPainter::LabelLayer::Add(LabelData&& label)
+  {
+    size_t index=labels.size();
+    size_t cx1,cx2,cy1,cy2;
+
+    GetCellRange(label.bx1,label.bx2,label.by1,label.by2,
+                 cx1,cx2,cy1,cy2);
+
+    for (size_t cy=cy1; cy<=cy2; cy++) {
+      for (size_t cx=cx1; cx<=cx2; cx++) {
+        cells[cy*xCount+cx].push_back(index);
       }
     }
+
+    if (dynamic_cast<const ShieldStyle*>(label.style.get())!=NULL) {
+      shieldTexts[label.text].push_back(index);
+    }
+
+    labels.push_back(std::move(label));
+    removed.push_back(false);
+    visited.push_back(0);
+  }
+
+  /**
+   * Drop all removed labels, keeping the order of the remaining labels, and
+   * rebuild the indexes.
+   */
+  void MapPainter::LabelLayer::Compact()
+  {
+    if (std::find(removed.begin(),removed.end(),true)==removed.end()) {
+      return;
+    }
+
+    std::vector<LabelData> remaining;
+
+    remaining.reserve(labels.size());
+
+    for (size_t i=0; i<labels.size(); i++) {
+      if (!removed[i]) {
+        remaining.push_back(std::move(labels[i]));
+      }
+    }
+
+    labels.clear();
+    removed.clear();
+    visited.clear();
+    shieldTexts.clear();
+    marked.clear();
+    candidates.clear();
+
+    for (auto& cell : cells) {
+      cell.clear();
+    }
+
+    for (auto& label : remaining) {
+      Add(std::move(label));
+    }
+  }
+
+  void MapPainter::ClearLabelMarks(LabelLayer& labels)
+  {
+    for (size_t index : labels.marked) {
+      labels.labels[index].mark=false;
+    }
+
+    labels.marked.clear();
+  }
+
+  void MapPainter::RemoveMarkedLabels(LabelLayer& labels)
+  {
+    for (size_t index : labels.marked) {
+      labels.labels[index].mark=false;
+      labels.removed[index]=true;
+    }
+
+    labels.marked.clear();
   }
 
   bool MapPainter::MarkAllInBoundingBox(double bx1,
@@ -430,9 +611,19 @@ namespace osmscout {
                                         double by1,
                                         double by2,
                                         const LabelStyle& style,
-                                        std::list<LabelData>& labels)
+                                        LabelLayer& labels)
   {
-    for (auto& label : labels) {
+    // Only labels in cells within the maximum label space can intersect
+    double maxLabelSpace=std::max(labelSpace,shieldLabelSpace);
+
+    labels.Query(bx1-maxLabelSpace,
+                 bx2+maxLabelSpace,
+                 by1-maxLabelSpace,
+                 by2+maxLabelSpace);
+
+    for (size_t index : labels.candidates) {
+      LabelData& label=labels.labels[index];
+
       // We only look at labels, that are not already marked.
       if (label.mark) {
         continue;
@@ -467,6 +658,7 @@ namespace osmscout {
         }
 
         label.mark=true;
+        labels.marked.push_back(index);
       }
     }
 
@@ -479,32 +671,40 @@ namespace osmscout {
                                                double by2,
                                                const LabelStyle& style,
                                                const std::string& text,
-                                               std::list<LabelData>& labels)
+                                               LabelLayer& labels)
   {
-    for (auto & label : labels) {
-      if (label.mark) {
+    if (dynamic_cast<const ShieldStyle*>(&style)==NULL) {
+      return true;
+    }
+
+    auto entry=labels.shieldTexts.find(text);
+
+    if (entry==labels.shieldTexts.end()) {
+      return true;
+    }
+
+    for (size_t index : entry->second) {
+      const LabelData& label=labels.labels[index];
+
+      if (labels.removed[index] ||
+          label.mark) {
         continue;
       }
 
-      if (dynamic_cast<const ShieldStyle*>(&style)!=NULL &&
-          dynamic_cast<const ShieldStyle*>(label.style.get())!=NULL) {
-        double hx1=bx1-sameLabelSpace;
-        double hx2=bx2+sameLabelSpace;
-        double hy1=by1-sameLabelSpace;
-        double hy2=by2+sameLabelSpace;
-
-        if (!(hx1>label.bx2 ||
-              hx2<label.bx1 ||
-              hy1>label.by2 ||
-              hy2<label.by1)) {
-          if (text==label.text) {
-            // TODO: It may be possible that the labels belong to the same "thing".
-            // perhaps we should not just draw one or the other, but also change
-            // final position of the label (but this would require more complex
-            // collision handling and perhaps processing labels in different order)?
-            return false;
-          }
-        }
+      double hx1=bx1-sameLabelSpace;
+      double hx2=bx2+sameLabelSpace;
+      double hy1=by1-sameLabelSpace;
+      double hy2=by2+sameLabelSpace;
+
+      if (!(hx1>label.bx2 ||
+            hx2<label.bx1 ||
+            hy1>label.by2 ||
+            hy2<label.by1)) {
+        // TODO: It may be possible that the labels belong to the same "thing".
+        // perhaps we should not just draw one or the other, but also change
+        // final position of the label (but this would require more complex
+        // collision handling and perhaps processing labels in different order)?
+        return false;
       }
     }
 
@@ -639,8 +839,8 @@ namespace osmscout {
 
       GeoCoord minCoord(tile->yAbs*tile->cellHeight-90.0,
                         tile->xAbs*tile->cellWidth-180.0);
-      GeoCoord maxCoord(minCoord.GetLat()+tile->cellHeight,
-                        minCoord.GetLon()+tile->cellWidth);
+      GeoCoord maxCoord(minCoord.GetLat()+tile->height*tile->cellHeight,
+                        minCoord.GetLon()+tile->width*tile->cellWidth);
 
       areaData.boundingBox.Set(minCoord,maxCoord);
 
@@ -813,7 +1013,7 @@ namespace osmscout {
       labelData.style=debugLabel;
       labelData.text=label;
 
-      labels.push_back(labelData);
+      labels.Add(std::move(labelData));
 
       drawnLabels.insert(Coord(x,y));
 #endif
@@ -1022,10 +1222,10 @@ namespace osmscout {
     label.text=text;
 
     if (overlay) {
-      overlayLabels.push_back(label);
+      overlayLabels.Add(std::move(label));
     }
     else {
-      labels.push_back(label);
+      labels.Add(std::move(label));
     }
 
     return true;
@@ -1362,7 +1562,7 @@ namespace osmscout {
                                       const MapParameter& parameter,
                                       const MapData& /*data*/)
   {
-    for (std::list<WayPathData>::const_iterator way=wayPathData.begin();
+    for (std::vector<WayPathData>::const_iterator way=wayPathData.begin();
         way!=wayPathData.end();
         way++)
     {
@@ -1459,11 +1659,14 @@ namespace osmscout {
                               const Projection& projection,
                               const MapParameter& parameter)
   {
+    labels.Compact();
+    overlayLabels.Compact();
+
     //
     // Draw normal
     //
 
-    for (const auto& label : labels) {
+    for (const auto& label : labels.labels) {
       DrawLabel(projection,
                 parameter,
                 label);
@@ -1474,7 +1677,7 @@ namespace osmscout {
     // Draw overlays
     //
 
-    for (const auto& label : overlayLabels) {
+    for (const auto& label : overlayLabels.labels) {
       DrawLabel(projection,
                 parameter,
                 label);
@@ -1623,129 +1826,305 @@ namespace osmscout {
     }
   }
 
-  void MapPainter::PrepareAreas(const StyleConfig& styleConfig,
-                                const Projection& projection,
-                                const MapParameter& parameter,
-                                const MapData& data)
+  /**
+   * Calculate the number of chunks to use for the prepare phase of the given
+   * number of objects and make sure, that the scratch data for each chunk exists
+   * and is reset.
+   */
+  size_t MapPainter::InitializePrepareChunks(const MapParameter& parameter,
+                                             size_t objectCount)
   {
-    areaData.clear();
+    size_t chunkCount=std::max((size_t)1,
+                               std::min(parameter.GetPrepareThreadCount(),
+                                        objectCount/prepareChunkMinSize));
 
-    //Areas
-    for (const auto& area : data.areas) {
-      std::vector<PolyData> data(area->rings.size());
+    while (prepareChunks.size()<chunkCount) {
+      std::unique_ptr<PrepareChunk> chunk(new PrepareChunk());
 
-      for (size_t i=0; i<area->rings.size(); i++) {
-        // The master ring does not have any nodes, skipping...
-        if (area->rings[i].IsMasterRing()) {
-          continue;
+      if (prepareChunks.empty()) {
+        chunk->transBuffer=&transBuffer;
+        chunk->localBuffer=NULL;
+      }
+      else {
+        chunk->localBuffer=new CoordBufferImpl<Vertex2D>();
+        chunk->localTransBuffer.reset(new TransBuffer(chunk->localBuffer));
+        chunk->transBuffer=chunk->localTransBuffer.get();
+      }
+
+      prepareChunks.push_back(std::move(chunk));
+    }
+
+    for (size_t c=0; c<chunkCount; c++) {
+      PrepareChunk& chunk=*prepareChunks[c];
+
+      if (chunk.localBuffer!=NULL) {
+        chunk.localBuffer->Reset();
+      }
+
+      chunk.areaData.clear();
+      chunk.wayData.clear();
+      chunk.wayPathData.clear();
+      chunk.areasSegments=0;
+      chunk.waysSegments=0;
+    }
+
+    return chunkCount;
+  }
+
+  /**
+   * Append the result of all chunks (in chunk order) to the painter data structures.
+   * The coordinates of chunk local buffers are copied to the end of the painter
+   * buffer and all buffer indexes are adjusted accordingly. Since chunks
+   * are merged in order, the result is identical to a sequential preparation.
+   */
+  void MapPainter::MergePrepareChunks(size_t chunkCount)
+  {
+    for (size_t c=0; c<chunkCount; c++) {
+      PrepareChunk& chunk=*prepareChunks[c];
+      size_t        offset=0;
+
+      if (chunk.localBuffer!=NULL) {
+        offset=coordBuffer->GetLength();
+
+        for (size_t i=0; i<chunk.localBuffer->GetLength(); i++) {
+          coordBuffer->PushCoord(chunk.localBuffer->buffer[i].GetX(),
+                                 chunk.localBuffer->buffer[i].GetY());
+        }
+      }
+
+      if (offset!=0) {
+        for (auto& area : chunk.areaData) {
+          area.transStart+=offset;
+          area.transEnd+=offset;
+
+          for (auto& clipping : area.clippings) {
+            clipping.transStart+=offset;
+            clipping.transEnd+=offset;
+          }
         }
 
-        transBuffer.TransformArea(projection,
-                                  parameter.GetOptimizeAreaNodes(),
-                                  area->rings[i].nodes,
-                                  data[i].transStart,data[i].transEnd,
-                                  errorTolerancePixel);
+        for (auto& way : chunk.wayData) {
+          way.transStart+=offset;
+          way.transEnd+=offset;
+        }
+
+        for (auto& path : chunk.wayPathData) {
+          path.transStart+=offset;
+          path.transEnd+=offset;
+        }
       }
 
-      size_t ringId=Area::outerRingId;
-      bool foundRing=true;
+      areaData.insert(areaData.end(),
+                      std::make_move_iterator(chunk.areaData.begin()),
+                      std::make_move_iterator(chunk.areaData.end()));
+      wayData.insert(wayData.end(),
+                     std::make_move_iterator(chunk.wayData.begin()),
+                     std::make_move_iterator(chunk.wayData.end()));
+      wayPathData.insert(wayPathData.end(),
+                         chunk.wayPathData.begin(),
+                         chunk.wayPathData.end());
+
+      chunk.areaData.clear();
+      chunk.wayData.clear();
+      chunk.wayPathData.clear();
 
-      while (foundRing) {
-        foundRing=false;
+      areasSegments+=chunk.areasSegments;
+      waysSegments+=chunk.waysSegments;
+    }
+  }
 
-        for (size_t i=0; i<area->rings.size(); i++) {
-          const Area::Ring& ring=area->rings[i];
+  void MapPainter::PrepareArea(const StyleConfig& styleConfig,
+                               const Projection& projection,
+                               const MapParameter& parameter,
+                               const AreaRef& area,
+                               PrepareChunk& chunk)
+  {
+    std::vector<PolyData>& data=chunk.ringData;
 
-          if (ring.GetRing()==ringId) {
-            TypeInfoRef  type;
-            FillStyleRef fillStyle;
+    data.resize(area->rings.size());
 
-            if (ring.IsOuterRing()) {
-              type=area->GetType();
-            }
-            else if (!ring.GetType()->GetIgnore()) {
-              type=ring.GetType();
-            }
-            else {
-              continue;
-            }
+    for (size_t i=0; i<area->rings.size(); i++) {
+      // The master ring does not have any nodes, skipping...
+      if (area->rings[i].IsMasterRing()) {
+        continue;
+      }
 
-            styleConfig.GetAreaFillStyle(type,
-                                         ring.GetFeatureValueBuffer(),
-                                         projection,
-                                         fillStyle);
+      if (area->rings[i].IsCompact()) {
+        chunk.transBuffer->TransformArea(projection,
+                                         parameter.GetOptimizeAreaNodes(),
+                                         area->rings[i].compactNodes,
+                                         data[i].transStart,data[i].transEnd,
+                                         errorTolerancePixel);
+      }
+      else {
+        chunk.transBuffer->TransformArea(projection,
+                                         parameter.GetOptimizeAreaNodes(),
+                                         area->rings[i].nodes,
+                                         data[i].transStart,data[i].transEnd,
+                                         errorTolerancePixel);
+      }
+    }
 
-            if (!fillStyle) {
-              continue;
-            }
+    size_t ringId=Area::outerRingId;
+    bool foundRing=true;
 
-            foundRing=true;
+    while (foundRing) {
+      foundRing=false;
 
-            if (!IsVisibleArea(projection,
-                               ring.nodes,
-                               fillStyle->GetBorderWidth()/2)) {
-              continue;
-            }
+      for (size_t i=0; i<area->rings.size(); i++) {
+        const Area::Ring& ring=area->rings[i];
 
-            AreaData a;
-
-            // Collect possible clippings. We only take into account inner rings of the next level
-            // that do not have a type and thus act as a clipping region. If a inner ring has a type,
-            // we currently assume that it does not have alpha and paints over its region and clipping is
-            // not required.
-            // Since we know that rings a created deep first, we only take into account direct followers
-            // in the list with ring+1.
-            size_t j=i+1;
-            while (j<area->rings.size() &&
-                   area->rings[j].GetRing()==ringId+1 &&
-                   area->rings[j].GetType()->GetIgnore()) {
-              a.clippings.push_back(data[j]);
-
-              j++;
-            }
+        if (ring.GetRing()==ringId) {
+          TypeInfoRef  type;
+          FillStyleRef fillStyle;
+
+          if (ring.IsOuterRing()) {
+            type=area->GetType();
+          }
+          else if (!ring.GetType()->GetIgnore()) {
+            type=ring.GetType();
+          }
+          else {
+            continue;
+          }
+
+          styleConfig.GetAreaFillStyle(type,
+                                       ring.GetFeatureValueBuffer(),
+                                       projection,
+                                       fillStyle);
+
+          if (!fillStyle) {
+            continue;
+          }
+
+          foundRing=true;
 
-            a.ref=ObjectFileRef(area->GetFileOffset(),refArea);
-            a.type=type;
-            a.buffer=&ring.GetFeatureValueBuffer();
-            a.fillStyle=fillStyle;
-            a.transStart=data[i].transStart;
-            a.transEnd=data[i].transEnd;
+          if (ring.GetNodeCount()==0) {
+            continue;
+          }
+
+          GeoBox ringBoundingBox;
 
-            ring.GetBoundingBox(a.boundingBox);
+          ring.GetBoundingBox(ringBoundingBox);
 
-            areaData.push_back(a);
+          if (!IsVisibleArea(projection,
+                             ringBoundingBox,
+                             fillStyle->GetBorderWidth()/2)) {
+            continue;
+          }
 
-            areasSegments++;
+          AreaData a;
+
+          // Collect possible clippings. We only take into account inner rings of the next level
+          // that do not have a type and thus act as a clipping region. If a inner ring has a type,
+          // we currently assume that it does not have alpha and paints over its region and clipping is
+          // not required.
+          // Since we know that rings a created deep first, we only take into account direct followers
+          // in the list with ring+1.
+          size_t j=i+1;
+          while (j<area->rings.size() &&
+                 area->rings[j].GetRing()==ringId+1 &&
+                 area->rings[j].GetType()->GetIgnore()) {
+            a.clippings.push_back(data[j]);
+
+            j++;
           }
+
+          a.ref=ObjectFileRef(area->GetFileOffset(),refArea);
+          a.type=type;
+          a.buffer=&ring.GetFeatureValueBuffer();
+          a.fillStyle=fillStyle;
+          a.transStart=data[i].transStart;
+          a.transEnd=data[i].transEnd;
+
+          ring.GetBoundingBox(a.boundingBox);
+
+          chunk.areaData.push_back(a);
+
+          chunk.areasSegments++;
         }
+      }
+
+      ringId++;
+    }
+  }
 
-        ringId++;
+  void MapPainter::PrepareAreas(const StyleConfig& styleConfig,
+                                const Projection& projection,
+                                const MapParameter& parameter,
+                                const MapData& data)
+  {
+    areaData.clear();
+
+    size_t chunkCount=InitializePrepareChunks(parameter,
+                                              data.areas.size());
+    size_t chunkSize=(data.areas.size()+chunkCount-1)/chunkCount;
+
+    auto prepareChunk=[&](size_t c) {
+      size_t start=c*chunkSize;
+      size_t end=std::min(start+chunkSize,data.areas.size());
+
+      for (size_t a=start; a<end; a++) {
+        PrepareArea(styleConfig,
+                    projection,
+                    parameter,
+                    data.areas[a],
+                    *prepareChunks[c]);
       }
+    };
+
+    std::vector<std::future<void>> results;
+
+    results.reserve(chunkCount);
+
+    for (size_t c=1; c<chunkCount; c++) {
+      results.push_back(std::async(std::launch::async,
+                                   prepareChunk,
+                                   c));
     }
 
-    areaData.sort(AreaSorter);
+    // The first chunk is processed by the calling thread
+    prepareChunk(0);
+
+    for (auto& result : results) {
+      result.get();
+    }
+
+    MergePrepareChunks(chunkCount);
+
+    StableSortByIndex(areaData,
+                      areaSortBuffer,
+                      sortOrder,
+                      AreaSorter);
   }
 
   void MapPainter::PrepareWaySegment(const StyleConfig& styleConfig,
                                      const Projection& projection,
                                      const MapParameter& parameter,
-                                     const ObjectFileRef& ref,
-                                     const FeatureValueBuffer& buffer,
-                                     const std::vector<Point>& nodes)
+                                     const Way& way,
+                                     PrepareChunk& chunk)
   {
+    const FeatureValueBuffer& buffer=way.GetFeatureValueBuffer();
+    ObjectFileRef             ref(way.GetFileOffset(),refWay);
+
     styleConfig.GetWayLineStyles(buffer,
                                  projection,
-                                 lineStyles);
+                                 chunk.lineStyles);
 
-    if (lineStyles.empty()) {
+    if (chunk.lineStyles.empty() ||
+        way.GetNodeCount()==0) {
       return;
     }
 
+    GeoBox boundingBox;
+
+    way.GetBoundingBox(boundingBox);
+
     bool   transformed=false;
     size_t transStart=0; // Make the compiler happy
     size_t transEnd=0;   // Make the compiler happy
 
-    for (const auto& lineStyle : lineStyles) {
+    for (const auto& lineStyle : chunk.lineStyles) {
       double       lineWidth=0.0;
       double       lineOffset=0.0;
 
@@ -1786,18 +2165,28 @@ namespace osmscout {
       data.lineWidth=lineWidth;
 
       if (!IsVisibleWay(projection,
-                        nodes,
+                        boundingBox,
                         lineWidth/2)) {
         continue;
       }
 
       if (!transformed) {
-        transBuffer.TransformWay(projection,
-                                 parameter.GetOptimizeWayNodes(),
-                                 nodes,
-                                 transStart,
-                                 transEnd,
-                                 errorTolerancePixel);
+        if (way.IsCompact()) {
+          chunk.transBuffer->TransformWay(projection,
+                                          parameter.GetOptimizeWayNodes(),
+                                          way.compactNodes,
+                                          transStart,
+                                          transEnd,
+                                          errorTolerancePixel);
+        }
+        else {
+          chunk.transBuffer->TransformWay(projection,
+                                          parameter.GetOptimizeWayNodes(),
+                                          way.nodes,
+                                          transStart,
+                                          transEnd,
+                                          errorTolerancePixel);
+        }
 
         WayPathData pathData;
 
@@ -1806,7 +2195,7 @@ namespace osmscout {
         pathData.transStart=transStart;
         pathData.transEnd=transEnd;
 
-        wayPathData.push_back(pathData);
+        chunk.wayPathData.push_back(pathData);
 
         transformed=true;
       }
@@ -1815,8 +2204,8 @@ namespace osmscout {
       data.buffer=&buffer;
       data.lineStyle=lineStyle;
       data.wayPriority=styleConfig.GetWayPrio(buffer.GetType());
-      data.startIsClosed=nodes[0].GetSerial()==0;
-      data.endIsClosed=nodes[nodes.size()-1].GetSerial()==0;
+      data.startIsClosed=way.GetSerial(0)==0;
+      data.endIsClosed=way.GetSerial(way.GetNodeCount()-1)==0;
 
       LayerFeatureValue *layerValue=layerReader.GetValue(buffer);
 
@@ -1825,18 +2214,18 @@ namespace osmscout {
       }
 
       if (lineOffset!=0.0) {
-        coordBuffer->GenerateParallelWay(transStart,transEnd,
-                                         lineOffset,
-                                         data.transStart,
-                                         data.transEnd);
+        chunk.transBuffer->buffer->GenerateParallelWay(transStart,transEnd,
+                                                       lineOffset,
+                                                       data.transStart,
+                                                       data.transEnd);
       }
       else {
         data.transStart=transStart;
         data.transEnd=transEnd;
       }
 
-      waysSegments++;
-      wayData.push_back(data);
+      chunk.waysSegments++;
+      chunk.wayData.push_back(data);
     }
   }
 
@@ -1848,25 +2237,59 @@ namespace osmscout {
     wayData.clear();
     wayPathData.clear();
 
-    for (const auto& way : data.ways) {
-      PrepareWaySegment(styleConfig,
-                        projection,
-                        parameter,
-                        ObjectFileRef(way->GetFileOffset(),refWay),
-                        way->GetFeatureValueBuffer(),
-                        way->nodes);
+    size_t chunkCount=InitializePrepareChunks(parameter,
+                                              data.ways.size());
+    size_t chunkSize=(data.ways.size()+chunkCount-1)/chunkCount;
+
+    auto prepareChunk=[&](size_t c) {
+      size_t start=c*chunkSize;
+      size_t end=std::min(start+chunkSize,data.ways.size());
+
+      for (size_t w=start; w<end; w++) {
+        const WayRef& way=data.ways[w];
+
+        PrepareWaySegment(styleConfig,
+                          projection,
+                          parameter,
+                          *way,
+                          *prepareChunks[c]);
+      }
+
+      // The manually added ways are appended to the last chunk to keep the original order
+      if (c==chunkCount-1) {
+        for (const auto& way : data.poiWays) {
+          PrepareWaySegment(styleConfig,
+                            projection,
+                            parameter,
+                            *way,
+                            *prepareChunks[c]);
+        }
+      }
+    };
+
+    std::vector<std::future<void>> results;
+
+    results.reserve(chunkCount);
+
+    for (size_t c=1; c<chunkCount; c++) {
+      results.push_back(std::async(std::launch::async,
+                                   prepareChunk,
+                                   c));
     }
 
-    for (const auto& way : data.poiWays) {
-      PrepareWaySegment(styleConfig,
-                        projection,
-                        parameter,
-                        ObjectFileRef(way->GetFileOffset(),refWay),
-                        way->GetFeatureValueBuffer(),
-                        way->nodes);
+    // The first chunk is processed by the calling thread
+    prepareChunk(0);
+
+    for (auto& result : results) {
+      result.get();
     }
 
-    wayData.sort();
+    MergePrepareChunks(chunkCount);
+
+    StableSortByIndex(wayData,
+                      waySortBuffer,
+                      sortOrder,
+                      std::less<WayData>());
   }
 
   void MapPainter::GetLabelFrame(const LabelStyle& style,
@@ -1919,8 +2342,10 @@ namespace osmscout {
 
     labelsDrawn=0;
 
-    labels.clear();
-    overlayLabels.clear();
+    labels.Reset(projection.GetWidth(),
+                 projection.GetHeight());
+    overlayLabels.Reset(projection.GetWidth(),
+                        projection.GetHeight());
 
     transBuffer.Reset();
 
@@ -2160,7 +2585,7 @@ namespace osmscout {
           << nodesTimer << "/" << poisTimer << " (sec)";
 
       log.Info()
-          << "Labels: " << labels.size() << "/" << overlayLabels.size() << "/" << labelsDrawn << " (pcs) "
+          << "Labels: " << labels.labels.size() << "/" << overlayLabels.labels.size() << "/" << labelsDrawn << " (pcs) "
           << labelsTimer << " (sec)";
     }
 
@@ -19,6 +19,8 @@
 
 #include <osmscout/MapParameter.h>
 
+#include <algorithm>
+
 namespace osmscout {
 
   MapParameter::MapParameter()
@@ -40,7 +42,8 @@ namespace osmscout {
     renderSeaLand(false),
     debugData(false),
     debugPerformance(false),
-    showAltLanguage(false)
+    showAltLanguage(false),
+    prepareThreadCount(1)
   {
     // no code
   }
@@ -150,6 +153,18 @@ namespace osmscout {
     debugPerformance=debug;
   }
 
+  /**
+   * Set the maximum number of threads used during the preparation of areas and ways
+   * (projection, style lookup and visibility checks). The prepared data and thus the
+   * drawing result is identical to the sequential preparation.
+   *
+   * A value of 1 (the default) prepares all data in the calling thread.
+   */
+  void MapParameter::SetPrepareThreadCount(size_t prepareThreadCount)
+  {
+    this->prepareThreadCount=std::max((size_t)1,prepareThreadCount);
+  }
+
   void MapParameter::SetBreaker(const BreakerRef& breaker)
   {
     this->breaker=breaker;
@@ -33,7 +33,9 @@ namespace osmscout {
   AreaSearchParameter::AreaSearchParameter()
   : maxAreaLevel(4),
     useLowZoomOptimization(true),
-    useMultithreading(false)
+    useMultithreading(false),
+    useCompactGeometry(false),
+    useMemoryArena(false)
   {
     // no code
   }
@@ -53,6 +55,36 @@ namespace osmscout {
     this->useMultithreading=useMultithreading;
   }
 
+  /**
+   * If set, ways and areas are stored in the tile cache using the compact
+   * fixed-point node representation (see Way::Compact() and Area::Compact()),
+   * reducing the memory used by their nodes to about a third.
+   *
+   * Objects of compact ways and areas do not have their nodes vector filled, the
+   * nodes must be accessed using compactNodes or the accessor methods.
+   */
+  void AreaSearchParameter::SetUseCompactGeometry(bool useCompactGeometry)
+  {
+    this->useCompactGeometry=useCompactGeometry;
+  }
+
+  /**
+   * If set, the ways and areas loaded for a tile (and their feature values)
+   * are allocated from a MemoryArena created for the load, instead of
+   * allocating each object separately on the heap. The memory is released
+   * in one go, when the last object of the load is released, which is
+   * normally when the tile is evicted from the cache.
+   *
+   * Note that the arena is released as a whole: tiles prefilled from the data
+   * of other cached tiles (see TiledDataCache::PrefillDataFromCache()) share the
+   * objects, so a tile's complete arena is kept alive for as long as any other
+   * tile references one of its objects.
+   */
+  void AreaSearchParameter::SetUseMemoryArena(bool useMemoryArena)
+  {
+    this->useMemoryArena=useMemoryArena;
+  }
+
   void AreaSearchParameter::SetBreaker(const BreakerRef& breaker)
   {
     this->breaker=breaker;
@@ -73,6 +105,16 @@ namespace osmscout {
     return useMultithreading;
   }
 
+  bool AreaSearchParameter::GetUseCompactGeometry() const
+  {
+    return useCompactGeometry;
+  }
+
+  bool AreaSearchParameter::GetUseMemoryArena() const
+  {
+    return useMemoryArena;
+  }
+
   bool AreaSearchParameter::IsAborted() const
   {
     if (breaker) {
@@ -83,6 +125,40 @@ namespace osmscout {
     }
   }
 
+  /**
+   * Compact the given ways. If the way data file caches its values, the
+   * loaded ways may be shared with other users of the database and are
+   * replaced by compact copies instead of being modified.
+   */
+  static void CompactWays(const WayDataFile& wayDataFile,
+                          std::vector<WayRef>& ways)
+  {
+    for (auto& way : ways) {
+      if (wayDataFile.HasCache()) {
+        way=std::make_shared<Way>(*way);
+      }
+
+      way->Compact();
+    }
+  }
+
+  /**
+   * Compact the given areas. If the area data file caches its values, the
+   * loaded areas may be shared with other users of the database and are
+   * replaced by compact copies instead of being modified.
+   */
+  static void CompactAreas(const AreaDataFile& areaDataFile,
+                           std::vector<AreaRef>& areas)
+  {
+    for (auto& area : areas) {
+      if (areaDataFile.HasCache()) {
+        area=std::make_shared<Area>(*area);
+      }
+
+      area->Compact();
+    }
+  }
+
   MapService::MapService(const DatabaseRef& database)
    : database(database),
      cache(25),
@@ -91,13 +167,32 @@ namespace osmscout {
      wayLowZoomWorkerThread(&MapService::WayLowZoomWorkerLoop,this),
      areaWorkerThread(&MapService::AreaWorkerLoop,this),
      areaLowZoomWorkerThread(&MapService::AreaLowZoomWorkerLoop,this),
-     nextCallbackId(0)
+     nextCallbackId(0),
+     groundTileCache(DEFAULT_GROUND_TILE_CACHE_SIZE),
+     prefetchPending(false),
+     prefetchStop(false),
+     foregroundRequests(0),
+     workerTasks(0),
+     prefetchBreaker(std::make_shared<ThreadedBreaker>()),
+     prefetchWorkerThread(&MapService::PrefetchWorkerLoop,this)
   {
     // no code
   }
 
   MapService::~MapService()
   {
+    // The prefetch worker may wait for tasks of the other workers, so it has
+    // to be stopped first
+    {
+      std::lock_guard<std::mutex> lock(prefetchMutex);
+
+      prefetchStop=true;
+      prefetchBreaker->Break();
+    }
+
+    prefetchCondition.notify_all();
+    prefetchWorkerThread.join();
+
     nodeWorkerQueue.Stop();
     wayWorkerQueue.Stop();
     wayLowZoomWorkerQueue.Stop();
@@ -128,6 +223,28 @@ namespace osmscout {
     cache.CleanupCache();
   }
 
+  /**
+   * Set the maximum number of water index blocks, for which the merged
+   * ground tiles are cached.
+   */
+  void MapService::SetGroundTileCacheSize(size_t cacheSize)
+  {
+    std::lock_guard<std::mutex> lock(groundTileMutex);
+
+    groundTileCache.SetMaxSize(cacheSize);
+  }
+
+  /**
+   * Drop all cached ground tiles.
+   */
+  void MapService::FlushGroundTileCache()
+  {
+    std::lock_guard<std::mutex> lock(groundTileMutex);
+
+    groundTileCache.Flush();
+    groundTileIndex.reset();
+  }
+
   MapService::TypeDefinitionRef MapService::GetTypeDefinition(const AreaSearchParameter& parameter,
                                                               const StyleConfig& styleConfig,
                                                               const Magnification& magnification) const
@@ -299,6 +416,12 @@ namespace osmscout {
         return false;
       }
 
+      if (parameter.GetUseCompactGeometry()) {
+        for (auto& area : areas) {
+          area->Compact();
+        }
+      }
+
       tile->GetOptimizedAreaData().SetData(loadedAreaTypes,std::move(areas));
     }
 
@@ -362,9 +485,29 @@ namespace osmscout {
           return false;
         }
 
+        AreaDataFileRef      areaDataFile=database->GetAreaDataFile();
         std::vector<AreaRef> areas;
+        MemoryArenaRef       arena;
+
+        if (!areaDataFile) {
+          log.Error() << "Area data file not available!";
+          return false;
+        }
+
+        // Compact copies of the areas would not use the arena
+        if (parameter.GetUseMemoryArena() &&
+            !(parameter.GetUseCompactGeometry() && areaDataFile->HasCache())) {
+          arena=std::make_shared<MemoryArena>();
+        }
 
+        // The cells of the index are larger than the requested area, so skip
+        // areas not intersecting it before reading their rings
         if (!database->GetAreasByBlockSpans(spans,
+                                            [&requestedAreaTypes,&boundingBox](const ObjectHeader& header) {
+                                              return requestedAreaTypes.IsSet(header.type) &&
+                                                     boundingBox.Intersects(header.boundingBox);
+                                            },
+                                            arena,
                                             areas)) {
           log.Error() << "Error reading areas in area!";
           return false;
@@ -374,6 +517,11 @@ namespace osmscout {
           return false;
         }
 
+        if (parameter.GetUseCompactGeometry()) {
+          CompactAreas(*areaDataFile,
+                       areas);
+        }
+
         tile->GetAreaData().SetData(loadedAreaTypes,std::move(areas));
       }
     }
@@ -433,6 +581,12 @@ namespace osmscout {
         return false;
       }
 
+      if (parameter.GetUseCompactGeometry()) {
+        for (auto& way : ways) {
+          way->Compact();
+        }
+      }
+
       tile->GetOptimizedWayData().SetData(loadedWayTypes,std::move(ways));
     }
 
@@ -492,9 +646,29 @@ namespace osmscout {
           return false;
         }
 
+        WayDataFileRef      wayDataFile=database->GetWayDataFile();
         std::vector<WayRef> ways;
+        MemoryArenaRef      arena;
+
+        if (!wayDataFile) {
+          log.Error() << "Way data file not available!";
+          return false;
+        }
 
+        // Compact copies of the ways would not use the arena
+        if (parameter.GetUseMemoryArena() &&
+            !(parameter.GetUseCompactGeometry() && wayDataFile->HasCache())) {
+          arena=std::make_shared<MemoryArena>();
+        }
+
+        // The cells of the index are larger than the requested area, so skip
+        // ways not intersecting it before reading their nodes
         if (!database->GetWaysByOffset(offsets,
+                                       [&requestedWayTypes,&boundingBox](const ObjectHeader& header) {
+                                         return requestedWayTypes.IsSet(header.type) &&
+                                                boundingBox.Intersects(header.boundingBox);
+                                       },
+                                       arena,
                                        ways)) {
           log.Error() << "Error reading ways in area!";
           return false;
@@ -504,6 +678,11 @@ namespace osmscout {
           return false;
         }
 
+        if (parameter.GetUseCompactGeometry()) {
+          CompactWays(*wayDataFile,
+                      ways);
+        }
+
         tile->GetWayData().SetData(loadedWayTypes,std::move(ways));
       }
     }
@@ -521,6 +700,7 @@ namespace osmscout {
 
     while (nodeWorkerQueue.PopTask(task)) {
       task();
+      EndWorkerTask();
     }
   }
 
@@ -530,6 +710,7 @@ namespace osmscout {
 
     while (wayWorkerQueue.PopTask(task)) {
       task();
+      EndWorkerTask();
     }
   }
 
@@ -539,6 +720,7 @@ namespace osmscout {
 
     while (wayLowZoomWorkerQueue.PopTask(task)) {
       task();
+      EndWorkerTask();
     }
   }
 
@@ -548,6 +730,7 @@ namespace osmscout {
 
     while (areaWorkerQueue.PopTask(task)) {
       task();
+      EndWorkerTask();
     }
   }
 
@@ -557,6 +740,7 @@ namespace osmscout {
 
     while (areaLowZoomWorkerQueue.PopTask(task)) {
       task();
+      EndWorkerTask();
     }
   }
 
@@ -569,6 +753,7 @@ namespace osmscout {
 
     std::future<bool> future=task.get_future();
 
+    BeginWorkerTask();
     nodeWorkerQueue.PushTask(task);
 
     return future;
@@ -584,6 +769,7 @@ namespace osmscout {
 
     std::future<bool> future=task.get_future();
 
+    BeginWorkerTask();
     areaLowZoomWorkerQueue.PushTask(task);
 
     return future;
@@ -599,6 +785,7 @@ namespace osmscout {
 
     std::future<bool> future=task.get_future();
 
+    BeginWorkerTask();
     areaWorkerQueue.PushTask(task);
 
     return future;
@@ -615,6 +802,7 @@ namespace osmscout {
 
     std::future<bool> future=task.get_future();
 
+    BeginWorkerTask();
     wayLowZoomWorkerQueue.PushTask(task);
 
     return future;
@@ -630,6 +818,7 @@ namespace osmscout {
 
     std::future<bool> future=task.get_future();
 
+    BeginWorkerTask();
     wayWorkerQueue.PushTask(task);
 
     return future;
@@ -840,7 +1029,13 @@ namespace osmscout {
                                        const StyleConfig& styleConfig,
                                        std::list<TileRef>& tiles) const
   {
-    return LoadMissingTileDataInternal(parameter,styleConfig,tiles,false);
+    BeginForegroundRequest();
+
+    bool result=LoadMissingTileDataInternal(parameter,styleConfig,tiles,false);
+
+    EndForegroundRequest();
+
+    return result;
   }
 
   /**
@@ -855,6 +1050,8 @@ namespace osmscout {
                                             const StyleConfig& styleConfig,
                                             std::list<TileRef>& tiles) const
   {
+    BeginForegroundRequest();
+
     auto result=std::async(std::launch::async,
                            &MapService::LoadMissingTileDataInternal,this,
                            std::ref(parameter),
@@ -862,8 +1059,228 @@ namespace osmscout {
                            std::ref(tiles),
                            true);
 
-    return result.get();
+    bool success=result.get();
     //return LoadMissingTileData(parameter,styleConfig,tiles,true);
+
+    EndForegroundRequest();
+
+    return success;
+  }
+
+  /**
+   * Mark the start of a request of the client. A running prefetch request is
+   * aborted and no new prefetch request is started until the request has
+   * finished (see EndForegroundRequest()).
+   */
+  void MapService::BeginForegroundRequest() const
+  {
+    std::lock_guard<std::mutex> lock(prefetchMutex);
+
+    foregroundRequests++;
+    prefetchBreaker->Break();
+  }
+
+  /**
+   * Mark the end of a request of the client started by
+   * BeginForegroundRequest().
+   */
+  void MapService::EndForegroundRequest() const
+  {
+    {
+      std::lock_guard<std::mutex> lock(prefetchMutex);
+
+      assert(foregroundRequests>0);
+
+      foregroundRequests--;
+    }
+
+    prefetchCondition.notify_all();
+  }
+
+  /**
+   * Mark a task pushed to one of the worker queues. LoadMissingTileDataAsync()
+   * returns before its tasks have been executed, so the prefetch worker
+   * also has to wait for the worker tasks (see EndWorkerTask()).
+   */
+  void MapService::BeginWorkerTask() const
+  {
+    std::lock_guard<std::mutex> lock(prefetchMutex);
+
+    workerTasks++;
+  }
+
+  /**
+   * Mark the completion of a task started by BeginWorkerTask().
+   */
+  void MapService::EndWorkerTask() const
+  {
+    {
+      std::lock_guard<std::mutex> lock(prefetchMutex);
+
+      assert(workerTasks>0);
+
+      workerTasks--;
+    }
+
+    prefetchCondition.notify_all();
+  }
+
+  /**
+   * Prefetch the data for the given region, as requested via
+   * PrefetchTileData(). Returns false on error or if the request was
+   * aborted.
+   */
+  bool MapService::PrefetchData(const PrefetchRequest& request) const
+  {
+    AreaSearchParameter parameter(request.parameter);
+
+    parameter.SetBreaker(prefetchBreaker);
+
+    if (request.loadTileData) {
+      std::list<TileRef> tiles;
+
+      {
+        std::lock_guard<std::mutex> lock(stateMutex);
+
+        cache.GetTilesForBoundingBox(request.magnification,
+                                     request.boundingBox,
+                                     tiles);
+      }
+
+      return LoadMissingTileDataInternal(parameter,
+                                         *request.styleConfig,
+                                         tiles,
+                                         false);
+    }
+
+    TypeDefinitionRef typeDefinition=GetTypeDefinition(parameter,
+                                                       *request.styleConfig,
+                                                       request.magnification);
+    AreaNodeIndexRef  areaNodeIndex=database->GetAreaNodeIndex();
+    AreaAreaIndexRef  areaAreaIndex=database->GetAreaAreaIndex();
+    AreaWayIndexRef   areaWayIndex=database->GetAreaWayIndex();
+
+    if (!typeDefinition ||
+        !areaNodeIndex ||
+        !areaAreaIndex ||
+        !areaWayIndex) {
+      return false;
+    }
+
+    // The index lookups load the relevant index pages, the data itself is
+    // only prefetched by the operating system
+    std::vector<FileOffset>    offsets;
+    std::vector<DataBlockSpan> spans;
+    TypeInfoSet                loadedTypes;
+
+    if (parameter.IsAborted() ||
+        !areaNodeIndex->GetOffsets(request.boundingBox,
+                                   typeDefinition->nodeTypes,
+                                   offsets,
+                                   loadedTypes) ||
+        !database->PrefetchNodesByOffset(offsets)) {
+      return false;
+    }
+
+    if (parameter.IsAborted() ||
+        !areaAreaIndex->GetAreasInArea(*database->GetTypeConfig(),
+                                       request.boundingBox,
+                                       request.magnification.GetLevel()+
+                                       parameter.GetMaximumAreaLevel(),
+                                       typeDefinition->areaTypes,
+                                       spans,
+                                       loadedTypes) ||
+        !database->PrefetchAreasByBlockSpans(spans)) {
+      return false;
+    }
+
+    offsets.clear();
+
+    if (parameter.IsAborted() ||
+        !areaWayIndex->GetOffsets(request.boundingBox,
+                                  typeDefinition->wayTypes,
+                                  offsets,
+                                  loadedTypes) ||
+        !database->PrefetchWaysByOffset(offsets)) {
+      return false;
+    }
+
+    return !parameter.IsAborted();
+  }
+
+  void MapService::PrefetchWorkerLoop()
+  {
+    while (true) {
+      PrefetchRequest request;
+
+      {
+        std::unique_lock<std::mutex> lock(prefetchMutex);
+
+        prefetchCondition.wait(lock,[this] {
+          return prefetchStop ||
+                 (prefetchPending && foregroundRequests==0 && workerTasks==0);
+        });
+
+        if (prefetchStop) {
+          return;
+        }
+
+        request=prefetchRequest;
+        prefetchPending=false;
+        prefetchRequest=PrefetchRequest();
+
+        prefetchBreaker->Reset();
+      }
+
+      if (!PrefetchData(request) &&
+          prefetchBreaker->IsAborted()) {
+        // Pre-empted by a foreground request, so try again afterwards if
+        // there is no newer request
+        std::lock_guard<std::mutex> lock(prefetchMutex);
+
+        if (!prefetchPending &&
+            !prefetchStop) {
+          prefetchRequest=request;
+          prefetchPending=true;
+        }
+      }
+    }
+  }
+
+  /**
+   * Prefetch the data for the given region and magnification in the
+   * background, e.g. for the region the user is expected to pan to next.
+   *
+   * By default the index lookups are executed and the operating system is
+   * advised to load the relevant parts of the data files, so that a later
+   * LoadMissingTileData() does not block on I/O. If loadTileData is true,
+   * the data is loaded into the tile cache instead.
+   *
+   * Only the latest request is kept, it replaces a request that has not
+   * been executed yet. Requests of the client, that load data
+   * (LoadMissingTileData(), LoadMissingTileDataAsync()), abort a running
+   * prefetch request; it is restarted after the request and all its worker
+   * tasks have finished. The breaker of the given
+   * parameter is not used.
+   */
+  void MapService::PrefetchTileData(const AreaSearchParameter& parameter,
+                                    const StyleConfigRef& styleConfig,
+                                    const Magnification& magnification,
+                                    const GeoBox& boundingBox,
+                                    bool loadTileData) const
+  {
+    {
+      std::lock_guard<std::mutex> lock(prefetchMutex);
+
+      prefetchRequest.parameter=parameter;
+      prefetchRequest.styleConfig=styleConfig;
+      prefetchRequest.magnification=magnification;
+      prefetchRequest.boundingBox=boundingBox;
+      prefetchRequest.loadTileData=loadTileData;
+      prefetchPending=true;
+    }
+
+    prefetchCondition.notify_all();
   }
 
   /**
@@ -971,6 +1388,11 @@ namespace osmscout {
   /**
    * Return all ground tiles for the given area and the given magnification.
    *
+   * Full cell ground tiles of the same type are merged into bigger rectangles.
+   * The tiles are loaded in blocks of cells, the merged tiles of the blocks are
+   * cached, so that following calls for the same region (e.g. for the next frame)
+   * do not have to access the water index again.
+   *
    * \note The returned ground tiles may result in a bigger area than given.
    *
    * @param boundingBox
@@ -988,17 +1410,44 @@ namespace osmscout {
   {
     WaterIndexRef waterIndex=database->GetWaterIndex();
 
+    tiles.clear();
+
     if (!waterIndex) {
       return false;
     }
 
-    StopClock timer;
+    StopClock                        timer;
+    std::vector<WaterIndex::BlockId> blocks;
 
-    if (!waterIndex->GetRegions(boundingBox,
-                                magnification,
-                                tiles)) {
-      log.Error() << "Error reading ground tiles in area!";
-      return false;
+    waterIndex->GetBlocks(boundingBox,
+                          magnification,
+                          blocks);
+
+    std::lock_guard<std::mutex> lock(groundTileMutex);
+
+    if (groundTileIndex!=waterIndex) {
+      groundTileCache.Flush();
+      groundTileIndex=waterIndex;
+    }
+
+    for (const auto& block : blocks) {
+      GroundTileCache::CacheRef entry;
+
+      if (!groundTileCache.GetEntry(block.GetKey(),entry)) {
+        GroundTileCache::CacheEntry newEntry(block.GetKey());
+
+        if (!waterIndex->GetBlockRegions(block,
+                                         newEntry.value)) {
+          log.Error() << "Error reading ground tiles in area!";
+          return false;
+        }
+
+        entry=groundTileCache.SetEntry(newEntry);
+      }
+
+      tiles.insert(tiles.end(),
+                   entry->value.begin(),
+                   entry->value.end());
     }
 
     timer.Stop();
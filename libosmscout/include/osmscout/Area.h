@@ -22,7 +22,9 @@
 
 #include <memory>
 
+#include <osmscout/CompactPoints.h>
 #include <osmscout/GeoCoord.h>
+#include <osmscout/ObjectHeader.h>
 #include <osmscout/Point.h>
 
 #include <osmscout/TypeConfig.h>
@@ -50,7 +52,8 @@ namespace osmscout {
       uint8_t               ring;               //!< The ring hierarchy number (0...n)
 
     public:
-      std::vector<Point>    nodes;              //!< The array of coordinates
+      std::vector<Point>    nodes;              //!< The array of coordinates, empty if the ring is compact
+      CompactPoints         compactNodes;       //!< Compact array of coordinates, only filled if the ring is compact
 
     public:
       inline Ring()
@@ -111,29 +114,43 @@ namespace osmscout {
         return ring;
       }
 
+      /**
+       * Return true, if the nodes of the ring are stored in compactNodes
+       * instead of nodes (see Area::Compact()).
+       */
+      inline bool IsCompact() const
+      {
+        return !compactNodes.empty();
+      }
+
+      inline size_t GetNodeCount() const
+      {
+        return IsCompact() ? compactNodes.size() : nodes.size();
+      }
+
       inline Id GetSerial(size_t index) const
       {
-        return nodes[index].GetSerial();
+        return IsCompact() ? compactNodes.GetSerial(index) : nodes[index].GetSerial();
       }
 
       inline Id GetId(size_t index) const
       {
-        return nodes[index].GetId();
+        return IsCompact() ? compactNodes.GetId(index) : nodes[index].GetId();
       }
 
       inline Id GetFrontId() const
       {
-        return nodes.front().GetId();
+        return GetId(0);
       }
 
       inline Id GetBackId() const
       {
-        return nodes.back().GetId();
+        return GetId(GetNodeCount()-1);
       }
 
-      inline const GeoCoord& GetCoord(size_t index) const
+      inline GeoCoord GetCoord(size_t index) const
       {
-        return nodes[index].GetCoord();
+        return IsCompact() ? compactNodes.GetCoord(index) : nodes[index].GetCoord();
       }
 
       bool GetCenter(GeoCoord& center) const;
@@ -167,7 +184,12 @@ namespace osmscout {
 
       inline void SetSerial(size_t index, uint8_t serial)
       {
-        nodes[index].SetSerial(serial);
+        if (IsCompact()) {
+          compactNodes.SetSerial(index,serial);
+        }
+        else {
+          nodes[index].SetSerial(serial);
+        }
       }
 
       friend class Area;
@@ -175,17 +197,33 @@ namespace osmscout {
 
   private:
     FileOffset        fileOffset;
+    MemoryArena       *arena;     //!< Arena for the feature values of the rings, only used while reading
 
   public:
     std::vector<Ring> rings;
 
+  private:
+    void ReadData(const TypeConfig& typeConfig,
+                  const TypeInfoRef& type,
+                  FileScanner& scanner);
+
   public:
     inline Area()
-    : fileOffset(0)
+    : fileOffset(0),
+      arena(NULL)
     {
       // no code
     }
 
+    /**
+     * Take the memory for the feature values of the rings from the given
+     * arena, see FeatureValueBuffer::SetArena(). Must be called before reading.
+     */
+    inline void SetArena(MemoryArena* arena)
+    {
+      this->arena=arena;
+    }
+
     inline FileOffset GetFileOffset() const
     {
       return fileOffset;
@@ -205,12 +243,29 @@ namespace osmscout {
 
     void GetBoundingBox(GeoBox& boundingBox) const;
 
+    void Compact();
+    void Expand();
+
+    /**
+     * Read the header of an area as written by Write().
+     */
+    static void ReadHeader(const TypeConfig& typeConfig,
+                           FileScanner& scanner,
+                           ObjectHeader& header);
+
     /**
      * Read the area as written by Write().
      */
     void Read(const TypeConfig& typeConfig,
               FileScanner& scanner);
 
+    /**
+     * Read the area with the given header as returned by ReadHeader().
+     */
+    void Read(const TypeConfig& typeConfig,
+              const ObjectHeader& header,
+              FileScanner& scanner);
+
     /**
      * Read the area as written by WriteImport().
      */
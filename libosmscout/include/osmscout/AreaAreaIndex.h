@@ -131,6 +131,8 @@ namespace osmscout {
     void Close();
     bool Open(const std::string& path);
 
+    bool WarmUp() const;
+
     inline bool IsOpen() const
     {
       return scanner.IsOpen();
@@ -36,6 +36,9 @@ namespace osmscout {
     static const char* AREAS_DAT;
     static const char* AREAS_IDMAP;
 
+  protected:
+    size_t GetValueMemory(const Area& area) const;
+
   public:
     AreaDataFile();
   };
@@ -0,0 +1,131 @@
+#ifndef OSMSCOUT_COMPACTPOINTS_H
+#define OSMSCOUT_COMPACTPOINTS_H
+
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2016  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <vector>
+
+#include <osmscout/GeoCoord.h>
+#include <osmscout/Point.h>
+#include <osmscout/Types.h>
+
+#include <osmscout/util/GeoBox.h>
+
+namespace osmscout {
+
+  /**
+   * \ingroup Geometry
+   *
+   * Compact in-memory representation of a list of points.
+   *
+   * Coordinates are stored as 32 bit fixed-point values using the same
+   * conversion as the data files (see latConversionFactor and
+   * lonConversionFactor), latitude and longitude values in separate arrays
+   * (structure of arrays). Serials are stored in a third array, which stays
+   * empty as long as all serials are 0.
+   *
+   * Compared to std::vector<Point> (24 bytes per point) a point only requires
+   * 8 bytes (9 bytes if serials are set). Since the file format uses the
+   * same resolution, converting points read from file into the compact
+   * representation and back is lossless.
+   *
+   * Geo coordinates are only calculated on access.
+   */
+  class OSMSCOUT_API CompactPoints
+  {
+  private:
+    std::vector<uint32_t> lats;    //!< Fixed-point latitude values
+    std::vector<uint32_t> lons;    //!< Fixed-point longitude values
+    std::vector<uint8_t>  serials; //!< Serials of the points, empty if all serials are 0
+
+  public:
+    inline size_t size() const
+    {
+      return lats.size();
+    }
+
+    inline bool empty() const
+    {
+      return lats.empty();
+    }
+
+    void clear();
+
+    void Set(const std::vector<Point>& points);
+    void Get(std::vector<Point>& points) const;
+    void GetPoints(size_t start,
+                   size_t count,
+                   Point* points) const;
+
+    inline double GetLat(size_t index) const
+    {
+      return lats[index]/latConversionFactor-90.0;
+    }
+
+    inline double GetLon(size_t index) const
+    {
+      return lons[index]/lonConversionFactor-180.0;
+    }
+
+    inline GeoCoord GetCoord(size_t index) const
+    {
+      return GeoCoord(GetLat(index),
+                      GetLon(index));
+    }
+
+    inline uint8_t GetSerial(size_t index) const
+    {
+      return serials.empty() ? 0 : serials[index];
+    }
+
+    inline Point GetPoint(size_t index) const
+    {
+      return Point(GetSerial(index),
+                   GetCoord(index));
+    }
+
+    Id GetId(size_t index) const;
+
+    void SetSerial(size_t index,
+                   uint8_t serial);
+
+    void GetBoundingBox(GeoBox& boundingBox) const;
+
+    /**
+     * Return the fixed-point latitude values
+     */
+    inline const uint32_t* GetLatData() const
+    {
+      return lats.data();
+    }
+
+    /**
+     * Return the fixed-point longitude values
+     */
+    inline const uint32_t* GetLonData() const
+    {
+      return lons.data();
+    }
+
+    size_t GetMemoryUsage() const;
+  };
+}
+
+#endif
@@ -20,6 +20,7 @@
   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
 */
 
+#include <algorithm>
 #include <memory>
 #include <mutex>
 #include <set>
@@ -27,10 +28,13 @@
 #include <vector>
 
 #include <osmscout/NumericIndex.h>
+#include <osmscout/ObjectHeader.h>
 
 #include <osmscout/util/Cache.h>
+#include <osmscout/util/ConcurrentCache.h>
 #include <osmscout/util/FileScanner.h>
 #include <osmscout/util/Logger.h>
+#include <osmscout/util/MemoryArena.h>
 
 namespace osmscout {
 
@@ -73,6 +77,33 @@ namespace osmscout {
   public:
     typedef std::shared_ptr<N> ValueType;
 
+  private:
+    typedef ConcurrentCache<FileOffset,ValueType> ValueCache;
+
+    /**
+     * Range of the data file read into memory with a single read, values
+     * are decoded from it using a FileScanner on the memory
+     */
+    struct ReadBuffer
+    {
+      FileOffset        offset;  //!< Offset of the range in the data file
+      FileOffset        end;     //!< Offset directly behind the range
+      std::vector<char> data;    //!< Content of the range
+      FileScanner       scanner; //!< Scanner on the content, positions are file offsets
+
+      inline ReadBuffer()
+      : offset(0),
+        end(0)
+      {
+        // no code
+      }
+
+      inline ~ReadBuffer()
+      {
+        scanner.CloseFailsafe();
+      }
+    };
+
   private:
     std::string         datafile;        //!< Basename part of the data file name
     std::string         datafilename;    //!< complete filename for data file
@@ -81,10 +112,29 @@ namespace osmscout {
 
     mutable std::mutex  accessMutex;     //!< Mutex to secure multi-thread access
 
+    std::unique_ptr<ValueCache> cache;   //!< Cache of already read values by file offset, if enabled
+
   protected:
     TypeConfigRef       typeConfig;
 
+  protected:
+    virtual size_t GetValueMemory(const N& value) const;
+
   private:
+    bool GetCachedValue(FileOffset offset,
+                        ValueType& value) const;
+    void CacheValue(FileOffset offset,
+                    const ValueType& value) const;
+    bool GetValue(FileOffset offset,
+                  ValueType& value) const;
+
+    void PrefetchRanges(std::vector<std::pair<FileOffset,FileOffset>>& ranges) const;
+
+    void FillBuffer(ReadBuffer& buffer,
+                    FileOffset offset,
+                    FileOffset size,
+                    FileOffset readSize) const;
+
     bool ReadData(const TypeConfig& typeConfig,
                   FileScanner& scanner,
                   N& data) const;
@@ -92,6 +142,32 @@ namespace osmscout {
                   FileScanner& scanner,
                   FileOffset offset,
                   N& data) const;
+    bool ReadData(const TypeConfig& typeConfig,
+                  FileScanner& scanner,
+                  const ObjectHeaderFilter& filter,
+                  const MemoryArenaRef& arena,
+                  ObjectHeader& header,
+                  ValueType& data) const;
+    void ReadValue(const TypeConfig& typeConfig,
+                   FileScanner& scanner,
+                   const ObjectHeader& header,
+                   const MemoryArenaRef& arena,
+                   ValueType& data) const;
+
+    template<typename IteratorIn>
+    bool GetByOffset(IteratorIn begin,
+                     IteratorIn end,
+                     size_t size,
+                     std::vector<ValueType>& data) const;
+
+    bool GetByOffsetBuffered(const std::vector<FileOffset>& offsets,
+                             const ObjectHeaderFilter& filter,
+                             const MemoryArenaRef& arena,
+                             std::vector<ValueType>& data) const;
+    bool GetByBlockSpansBuffered(const std::vector<DataBlockSpan>& spans,
+                                 const ObjectHeaderFilter& filter,
+                                 const MemoryArenaRef& arena,
+                                 std::vector<ValueType>& data) const;
 
   public:
     DataFile(const std::string& datafile);
@@ -104,6 +180,17 @@ namespace osmscout {
     virtual bool IsOpen() const;
     virtual bool Close();
 
+    void SetCacheMemory(size_t maxMemory);
+
+    /**
+     * Return true, if values read by offset are cached (and thus shared
+     * with other callers)
+     */
+    inline bool HasCache() const
+    {
+      return (bool)cache;
+    }
+
     bool GetByOffset(const std::vector<FileOffset>& offsets,
                      std::vector<ValueType>& data) const;
     bool GetByOffset(const std::list<FileOffset>& offsets,
@@ -121,6 +208,20 @@ namespace osmscout {
                         std::vector<ValueType>& data) const;
     bool GetByBlockSpans(const std::vector<DataBlockSpan>& spans,
                          std::vector<ValueType>& data) const;
+
+    bool GetByOffset(const std::vector<FileOffset>& offsets,
+                     const ObjectHeaderFilter& filter,
+                     const MemoryArenaRef& arena,
+                     std::vector<ValueType>& data) const;
+    bool GetByBlockSpans(const std::vector<DataBlockSpan>& spans,
+                         const ObjectHeaderFilter& filter,
+                         const MemoryArenaRef& arena,
+                         std::vector<ValueType>& data) const;
+
+    void Prefetch(const std::vector<FileOffset>& offsets) const;
+    void Prefetch(const std::vector<DataBlockSpan>& spans) const;
+
+    void DumpStatistics() const;
   };
 
   template <class N>
@@ -187,6 +288,164 @@ namespace osmscout {
     return true;
   }
 
+  /**
+   * Read the header of the data value at the current position of the stream
+   * and only if the given filter accepts the header, the complete data value.
+   * Else data is set to NULL and the stream is left behind the header, the
+   * next value starts at header.nextOffset.
+   *
+   * If an arena is given, the value (including its control block) and its
+   * feature values are allocated from the arena. The arena is referenced by
+   * the value and thus released together with the last value allocated
+   * from it. Such values are not stored in the cache.
+   *
+   * Only supported for data types offering ReadHeader() (ways and areas).
+   *
+   * Method is not thread-safe.
+   */
+  template <class N>
+  bool DataFile<N>::ReadData(const TypeConfig& typeConfig,
+                             FileScanner& scanner,
+                             const ObjectHeaderFilter& filter,
+                             const MemoryArenaRef& arena,
+                             ObjectHeader& header,
+                             ValueType& data) const
+  {
+    try {
+      N::ReadHeader(typeConfig,
+                    scanner,
+                    header);
+
+      if (!filter(header)) {
+        data=NULL;
+
+        return true;
+      }
+
+      if (GetCachedValue(header.fileOffset,
+                         data)) {
+        return true;
+      }
+
+      ReadValue(typeConfig,
+                scanner,
+                header,
+                arena,
+                data);
+    }
+    catch (IOException& e) {
+      log.Error() << e.GetDescription();
+      return false;
+    }
+
+    return true;
+  }
+
+  /**
+   * Read the complete data value with the given header (as returned by
+   * N::ReadHeader()) and store it in the cache.
+   *
+   * If an arena is given, the value (including its control block) and its
+   * feature values are allocated from the arena and the value is not stored
+   * in the cache.
+   *
+   * Method is not thread-safe.
+   *
+   * @throws IOException
+   */
+  template <class N>
+  void DataFile<N>::ReadValue(const TypeConfig& typeConfig,
+                              FileScanner& scanner,
+                              const ObjectHeader& header,
+                              const MemoryArenaRef& arena,
+                              ValueType& data) const
+  {
+    if (arena) {
+      data=std::allocate_shared<N>(ArenaAllocator<N>(arena));
+      data->SetArena(arena.get());
+    }
+    else {
+      data=std::make_shared<N>();
+    }
+
+    data->Read(typeConfig,
+               header,
+               scanner);
+
+    // Values allocated from an arena would keep the complete arena alive
+    if (!arena) {
+      CacheValue(header.fileOffset,
+                 data);
+    }
+  }
+
+  /**
+   * Return the (estimated) memory used by the given value, used for limiting
+   * the memory of the cache. The default implementation returns the size of
+   * the value itself, derived classes should add the memory allocated by
+   * the value.
+   */
+  template <class N>
+  size_t DataFile<N>::GetValueMemory(const N& /*value*/) const
+  {
+    return sizeof(N);
+  }
+
+  /**
+   * Return the value at the given offset from the cache.
+   *
+   * Method is thread-safe.
+   */
+  template <class N>
+  bool DataFile<N>::GetCachedValue(FileOffset offset,
+                                   ValueType& value) const
+  {
+    return cache &&
+           cache->GetEntry(offset,value);
+  }
+
+  /**
+   * Store the value read from the given offset in the cache.
+   *
+   * Method is thread-safe.
+   */
+  template <class N>
+  void DataFile<N>::CacheValue(FileOffset offset,
+                               const ValueType& value) const
+  {
+    if (cache) {
+      cache->SetEntry(offset,value);
+    }
+  }
+
+  /**
+   * Return the value at the given offset, either from the cache or by
+   * reading it from the file (storing it in the cache).
+   *
+   * Method is thread-safe.
+   */
+  template <class N>
+  bool DataFile<N>::GetValue(FileOffset offset,
+                             ValueType& value) const
+  {
+    if (GetCachedValue(offset,value)) {
+      return true;
+    }
+
+    value=std::make_shared<N>();
+
+    if (!ReadData(*typeConfig,
+                  scanner,
+                  offset,
+                  *value)) {
+      return false;
+    }
+
+    CacheValue(offset,value);
+
+    return true;
+  }
+
   /**
    * Open the index file.
    *
@@ -236,6 +495,10 @@ namespace osmscout {
   {
     typeConfig=NULL;
 
+    if (cache) {
+      cache->Flush();
+    }
+
     try  {
       if (scanner.IsOpen()) {
         scanner.Close();
@@ -251,30 +514,86 @@ namespace osmscout {
   }
 
   /**
-   * Read data values from the given file offsets.
+   * Enable caching of values read by offset, limited to the given (estimated)
+   * memory in bytes. A value of 0 disables the cache. Values in the cache
+   * are shared with the callers, they must not be modified.
+   *
+   * Method is not thread-safe, it must be called before values are read.
+   */
+  template <class N>
+  void DataFile<N>::SetCacheMemory(size_t maxMemory)
+  {
+    if (maxMemory==0) {
+      cache.reset();
+      return;
+    }
+
+    cache.reset(new ValueCache(maxMemory,
+                               [this](const ValueType& value) {
+                                 return sizeof(value)+GetValueMemory(*value);
+                               }));
+  }
+
+  /**
+   * Read data values from the given file offsets. Values not in the cache
+   * are announced to the operating system in advance, if the data file is
+   * not memory mapped, so that they can be loaded concurrently instead of
+   * one read blocking after the other.
    *
    * Method is thread-safe.
    */
   template <class N>
-  bool DataFile<N>::GetByOffset(const std::vector<FileOffset>& offsets,
+  template<typename IteratorIn>
+  bool DataFile<N>::GetByOffset(IteratorIn begin,
+                                IteratorIn end,
+                                size_t size,
                                 std::vector<ValueType>& data) const
   {
-    data.reserve(data.size()+offsets.size());
+    size_t                  start=data.size();
+    std::vector<FileOffset> missingOffsets;
 
-    for (const auto& offset : offsets) {
-      ValueType value=std::make_shared<N>();
+    data.reserve(start+size);
 
-      if (!ReadData(*typeConfig,
-                    scanner,
-                    offset,
-                    *value)) {
-        log.Error() << "Error while reading data from offset " << offset << " of file " << datafilename << "!";
-        return false;
+    for (IteratorIn offset=begin; offset!=end; ++offset) {
+      ValueType value;
+
+      if (!GetCachedValue(*offset,
+                          value)) {
+        missingOffsets.push_back(*offset);
       }
 
       data.push_back(value);
     }
 
+    if (missingOffsets.size()>1 &&
+        !scanner.IsMemoryMapped()) {
+      Prefetch(missingOffsets);
+    }
+
+    size_t idx=start;
+
+    for (IteratorIn offset=begin; offset!=end; ++offset) {
+      if (!data[idx]) {
+        ValueType value=std::make_shared<N>();
+
+        if (!ReadData(*typeConfig,
+                      scanner,
+                      *offset,
+                      *value)) {
+          log.Error() << "Error while reading data from offset " << *offset << " of file " << datafilename << "!";
+          data.resize(start);
+          return false;
+        }
+
+        CacheValue(*offset,
+                   value);
+
+        data[idx]=value;
+      }
+
+      idx++;
+    }
+
     return true;
   }
 
@@ -284,27 +603,28 @@ namespace osmscout {
    * Method is thread-safe.
    */
   template <class N>
-  bool DataFile<N>::GetByOffset(const std::list<FileOffset>& offsets,
+  bool DataFile<N>::GetByOffset(const std::vector<FileOffset>& offsets,
                                 std::vector<ValueType>& data) const
   {
-    data.reserve(data.size()+offsets.size());
-
-    for (const auto& offset : offsets) {
-      ValueType value=std::make_shared<N>();
-
-      if (!ReadData(*typeConfig,
-                    scanner,
-                    offset,
-                    *value)) {
-        log.Error() << "Error while reading data from offset " << offset << " of file " << datafilename << "!";
-        // TODO: Remove broken entry from cache
-        return false;
-      }
-
-      data.push_back(value);
-    }
+    return GetByOffset(offsets.begin(),
+                       offsets.end(),
+                       offsets.size(),
+                       data);
+  }
 
-    return true;
+  /**
+   * Read data values from the given file offsets.
+   *
+   * Method is thread-safe.
+   */
+  template <class N>
+  bool DataFile<N>::GetByOffset(const std::list<FileOffset>& offsets,
+                                std::vector<ValueType>& data) const
+  {
+    return GetByOffset(offsets.begin(),
+                       offsets.end(),
+                       offsets.size(),
+                       data);
   }
 
   /**
@@ -316,24 +636,10 @@ namespace osmscout {
   bool DataFile<N>::GetByOffset(const std::set<FileOffset>& offsets,
                                 std::vector<ValueType>& data) const
   {
-    data.reserve(data.size()+offsets.size());
-
-    for (const auto& offset : offsets) {
-      ValueType value=std::make_shared<N>();
-
-      if (!ReadData(*typeConfig,
-                    scanner,
-                    offset,
-                    *value)) {
-        log.Error() << "Error while reading data from offset " << offset << " of file " << datafilename << "!";
-        // TODO: Remove broken entry from cache
-        return false;
-      }
-
-      data.push_back(value);
-    }
-
-    return true;
+    return GetByOffset(offsets.begin(),
+                       offsets.end(),
+                       offsets.size(),
+                       data);
   }
 
   /**
@@ -367,12 +673,10 @@ namespace osmscout {
   bool DataFile<N>::GetByOffset(const FileOffset& offset,
                                 ValueType& entry) const
   {
-    ValueType value=std::make_shared<N>();
+    ValueType value;
 
-    if (!ReadData(*typeConfig,
-                  scanner,
-                  offset,
-                  *value)) {
+    if (!GetValue(offset,
+                  value)) {
       log.Error() << "Error while reading data from offset " << offset << " of file " << datafilename << "!";
       // TODO: Remove broken entry from cache
       return false;
@@ -441,6 +745,10 @@ namespace osmscout {
 
     data.reserve(data.size()+overallCount);
 
+    if (!scanner.IsMemoryMapped()) {
+      Prefetch(spans);
+    }
+
     try {
       for (const auto& span : spans) {
         if (span.count==0) {
@@ -474,6 +782,562 @@ namespace osmscout {
     return true;
   }
 
+  /**
+   * Read data values from the given file offsets. Only values accepted by
+   * the given filter are read completely and returned, for all other values
+   * only the header is read. If arena is set, the values are allocated from
+   * the arena.
+   *
+   * If the data file is not memory mapped, the values are read in batches
+   * (see GetByOffsetBuffered()).
+   *
+   * Method is thread-safe.
+   */
+  template <class N>
+  bool DataFile<N>::GetByOffset(const std::vector<FileOffset>& offsets,
+                                const ObjectHeaderFilter& filter,
+                                const MemoryArenaRef& arena,
+                                std::vector<ValueType>& data) const
+  {
+    if (!scanner.IsMemoryMapped()) {
+      return GetByOffsetBuffered(offsets,
+                                 filter,
+                                 arena,
+                                 data);
+    }
+
+    ObjectHeader header;
+
+    data.reserve(data.size()+offsets.size());
+
+    for (const auto& offset : offsets) {
+      ValueType value;
+
+      {
+        std::lock_guard<std::mutex> lock(accessMutex);
+
+        try {
+          scanner.SetPos(offset);
+        }
+        catch (IOException& e) {
+          log.Error() << e.GetDescription();
+          return false;
+        }
+
+        if (!ReadData(*typeConfig,
+                      scanner,
+                      filter,
+                      arena,
+                      header,
+                      value)) {
+          log.Error() << "Error while reading data from offset " << offset << " of file " << datafilename << "!";
+          return false;
+        }
+      }
+
+      if (value) {
+        data.push_back(value);
+      }
+    }
+
+    return true;
+  }
+
+  /**
+   * Read data values from the given DataBlockSpans. Only values accepted by
+   * the given filter are read completely and returned, for all other values
+   * only the header is read. If arena is set, the values are allocated from
+   * the arena.
+   *
+   * If the data file is not memory mapped, the values are read in batches
+   * (see GetByBlockSpansBuffered()).
+   *
+   * Method is thread-safe.
+   */
+  template <class N>
+  bool DataFile<N>::GetByBlockSpans(const std::vector<DataBlockSpan>& spans,
+                                    const ObjectHeaderFilter& filter,
+                                    const MemoryArenaRef& arena,
+                                    std::vector<ValueType>& data) const
+  {
+    if (!scanner.IsMemoryMapped()) {
+      return GetByBlockSpansBuffered(spans,
+                                     filter,
+                                     arena,
+                                     data);
+    }
+
+    ObjectHeader header;
+
+    try {
+      for (const auto& span : spans) {
+        if (span.count==0) {
+          continue;
+        }
+
+        std::lock_guard<std::mutex> lock(accessMutex);
+
+        scanner.SetPos(span.startOffset);
+
+        for (uint32_t i=1; i<=span.count; i++) {
+          ValueType value;
+
+          if (i>1 &&
+              scanner.GetPos()!=header.nextOffset) {
+            // Skip the data of the previous, rejected value
+            scanner.SetPos(header.nextOffset);
+          }
+
+          if (!ReadData(*typeConfig,
+                        scanner,
+                        filter,
+                        arena,
+                        header,
+                        value)) {
+            log.Error() << "Error while reading data #" << i << " starting from offset " << span.startOffset <<
+            " of file " << datafilename << "!";
+            return false;
+          }
+
+          if (value) {
+            data.push_back(value);
+          }
+        }
+      }
+    }
+    catch (IOException& e) {
+      log.Error() << e.GetDescription();
+      return false;
+    }
+
+    return true;
+  }
+
+  /**
+   * Make sure, that the given range of the data file (clipped to the end of
+   * the file) is in the buffer. If it is not, the buffer is refilled with
+   * a single read of at least readSize bytes starting at offset.
+   *
+   * Method is thread-safe.
+   *
+   * @throws IOException
+   */
+  template <class N>
+  void DataFile<N>::FillBuffer(ReadBuffer& buffer,
+                               FileOffset offset,
+                               FileOffset size,
+                               FileOffset readSize) const
+  {
+    FileOffset fileSize=scanner.GetSize();
+
+    if (offset>=fileSize) {
+      throw IOException(datafilename,"Cannot read data at offset "+NumberToString(offset),"Offset beyond file end");
+    }
+
+    size=std::min(size,fileSize-offset);
+
+    if (offset>=buffer.offset &&
+        offset+size<=buffer.end) {
+      return;
+    }
+
+    readSize=std::min(std::max(size,readSize),fileSize-offset);
+
+    buffer.scanner.CloseFailsafe();
+    buffer.data.resize((size_t)readSize);
+
+    {
+      std::lock_guard<std::mutex> lock(accessMutex);
+
+      scanner.ReadAt(offset,
+                     buffer.data.data(),
+                     (size_t)readSize);
+    }
+
+    buffer.scanner.Open(datafilename,
+                        offset,
+                        buffer.data.data(),
+                        (size_t)readSize);
+
+    buffer.offset=offset;
+    buffer.end=offset+readSize;
+  }
+
+  /**
+   * Variant of GetByOffset() with filter for data files, that are not
+   * memory mapped. Instead of positioning the file and reading each value
+   * on its own, the offsets are sorted and merged into ranges, each range
+   * is read into memory with one read and the values are decoded from
+   * there. The operating system is told about all ranges in advance, so
+   * that it can load them concurrently.
+   *
+   * The size of a value is only known after reading its header, so the
+   * ranges are estimated. Values not completely contained in their range
+   * are read separately. For values in the cache only their header is
+   * required.
+   *
+   * Method is thread-safe.
+   */
+  template <class N>
+  bool DataFile<N>::GetByOffsetBuffered(const std::vector<FileOffset>& offsets,
+                                        const ObjectHeaderFilter& filter,
+                                        const MemoryArenaRef& arena,
+                                        std::vector<ValueType>& data) const
+  {
+    // Ranges with a smaller gap are merged, since reading the gap is cheaper
+    // than an additional request
+    const FileOffset maxGap=16*1024;
+    const FileOffset valueSize=4096;
+    const FileOffset headerSize=256;
+
+    std::vector<size_t>    order(offsets.size());
+    std::vector<ValueType> values(offsets.size());
+
+    for (size_t i=0; i<order.size(); i++) {
+      order[i]=i;
+    }
+
+    std::sort(order.begin(),
+              order.end(),
+              [&offsets](size_t a, size_t b) {
+                return offsets[a]<offsets[b];
+              });
+
+    // Values in the cache are not read again, but their header is
+    // required for the filter
+    for (size_t i=0; i<offsets.size(); i++) {
+      GetCachedValue(offsets[i],
+                     values[i]);
+    }
+
+    // Ranges (start, end) and the index (in order) behind the last value of
+    // each range
+    std::vector<std::pair<FileOffset,FileOffset>> ranges;
+    std::vector<size_t>                           rangeEnds;
+
+    for (size_t i=0; i<order.size(); i++) {
+      FileOffset offset=offsets[order[i]];
+      FileOffset end=offset+(values[order[i]] ? headerSize : valueSize);
+
+      if (ranges.empty() ||
+          offset>ranges.back().second+maxGap) {
+        ranges.push_back(std::make_pair(offset,end));
+        rangeEnds.push_back(i+1);
+      }
+      else {
+        ranges.back().second=std::max(ranges.back().second,end);
+        rangeEnds.back()=i+1;
+      }
+    }
+
+    if (ranges.size()>1) {
+      for (const auto& range : ranges) {
+        scanner.Prefetch(range.first,
+                         range.second-range.first);
+      }
+    }
+
+    ReadBuffer   buffer;
+    ObjectHeader header;
+    size_t       i=0;
+
+    try {
+      for (size_t r=0; r<ranges.size(); r++) {
+        FileOffset rangeEnd=ranges[r].second;
+
+        for (; i<rangeEnds[r]; i++) {
+          FileOffset offset=offsets[order[i]];
+          ValueType& value=values[order[i]];
+
+          FillBuffer(buffer,
+                     offset,
+                     headerSize,
+                     rangeEnd-offset);
+
+          buffer.scanner.SetPos(offset);
+
+          N::ReadHeader(*typeConfig,
+                        buffer.scanner,
+                        header);
+
+          if (!filter(header)) {
+            value=NULL;
+            continue;
+          }
+
+          if (value) {
+            continue;
+          }
+
+          FillBuffer(buffer,
+                     offset,
+                     header.nextOffset-offset,
+                     rangeEnd-offset);
+
+          ReadValue(*typeConfig,
+                    buffer.scanner,
+                    header,
+                    arena,
+                    value);
+        }
+      }
+    }
+    catch (IOException& e) {
+      log.Error() << e.GetDescription();
+      log.Error() << "Error while reading data from offset " << offsets[order[i]] << " of file " << datafilename << "!";
+      return false;
+    }
+
+    data.reserve(data.size()+values.size());
+
+    for (const auto& value : values) {
+      if (value) {
+        data.push_back(value);
+      }
+    }
+
+    return true;
+  }
+
+  /**
+   * Variant of GetByBlockSpans() with filter for data files, that are not
+   * memory mapped. The spans are sorted and merged into ranges, each range
+   * is read into memory with one read and the values are decoded from
+   * there (see GetByOffsetBuffered()). The size of a span is estimated from
+   * the number of values in it, values behind the estimated range are read
+   * with additional reads.
+   *
+   * Method is thread-safe.
+   */
+  template <class N>
+  bool DataFile<N>::GetByBlockSpansBuffered(const std::vector<DataBlockSpan>& spans,
+                                            const ObjectHeaderFilter& filter,
+                                            const MemoryArenaRef& arena,
+                                            std::vector<ValueType>& data) const
+  {
+    // Ranges with a smaller gap are merged, since reading the gap is cheaper
+    // than an additional request
+    const FileOffset maxGap=16*1024;
+    const FileOffset averageValueSize=512;
+    const FileOffset headerSize=256;
+
+    std::vector<size_t>                 order;
+    std::vector<std::vector<ValueType>> values(spans.size());
+
+    for (size_t i=0; i<spans.size(); i++) {
+      if (spans[i].count>0) {
+        order.push_back(i);
+      }
+    }
+
+    std::sort(order.begin(),
+              order.end(),
+              [&spans](size_t a, size_t b) {
+                return spans[a].startOffset<spans[b].startOffset;
+              });
+
+    // Ranges (start, end) and the index (in order) behind the last span of
+    // each range
+    std::vector<std::pair<FileOffset,FileOffset>> ranges;
+    std::vector<size_t>                           rangeEnds;
+
+    for (size_t i=0; i<order.size(); i++) {
+      const DataBlockSpan& span=spans[order[i]];
+      FileOffset           end=span.startOffset+span.count*averageValueSize;
+
+      if (ranges.empty() ||
+          span.startOffset>ranges.back().second+maxGap) {
+        ranges.push_back(std::make_pair(span.startOffset,end));
+        rangeEnds.push_back(i+1);
+      }
+      else {
+        ranges.back().second=std::max(ranges.back().second,end);
+        rangeEnds.back()=i+1;
+      }
+    }
+
+    if (ranges.size()>1) {
+      for (const auto& range : ranges) {
+        scanner.Prefetch(range.first,
+                         range.second-range.first);
+      }
+    }
+
+    ReadBuffer   buffer;
+    ObjectHeader header;
+    size_t       i=0;
+
+    try {
+      for (size_t r=0; r<ranges.size(); r++) {
+        FileOffset rangeEnd=ranges[r].second;
+
+        for (; i<rangeEnds[r]; i++) {
+          const DataBlockSpan&    span=spans[order[i]];
+          std::vector<ValueType>& spanValues=values[order[i]];
+          FileOffset              offset=span.startOffset;
+
+          for (uint32_t v=0; v<span.count; v++) {
+            // Read up to the end of the range, at least the estimated size of
+            // the remaining values of the span
+            FileOffset readSize=std::max(offset<rangeEnd ? rangeEnd-offset : 0,
+                                         (span.count-v)*averageValueSize);
+            ValueType  value;
+
+            FillBuffer(buffer,
+                       offset,
+                       headerSize,
+                       readSize);
+
+            buffer.scanner.SetPos(offset);
+
+            N::ReadHeader(*typeConfig,
+                          buffer.scanner,
+                          header);
+
+            if (filter(header) &&
+                !GetCachedValue(header.fileOffset,
+                                value)) {
+              FillBuffer(buffer,
+                         offset,
+                         header.nextOffset-offset,
+                         readSize);
+
+              ReadValue(*typeConfig,
+                        buffer.scanner,
+                        header,
+                        arena,
+                        value);
+            }
+
+            if (value) {
+              spanValues.push_back(value);
+            }
+
+            offset=header.nextOffset;
+          }
+        }
+      }
+    }
+    catch (IOException& e) {
+      log.Error() << e.GetDescription();
+      log.Error() << "Error while reading data starting from offset " << spans[order[i]].startOffset << " of file " << datafilename << "!";
+      return false;
+    }
+
+    for (const auto& spanValues : values) {
+      data.insert(data.end(),
+                  spanValues.begin(),
+                  spanValues.end());
+    }
+
+    return true;
+  }
+
+  /**
+   * Advise the operating system to load the given ranges (pairs of offset
+   * and size) of the data file in the background. Ranges that overlap or
+   * are close to each other are merged to reduce the number of system
+   * calls.
+   */
+  template <class N>
+  void DataFile<N>::PrefetchRanges(std::vector<std::pair<FileOffset,FileOffset>>& ranges) const
+  {
+    // Ranges with a smaller gap are merged, since reading the gap is cheaper
+    // than an additional request
+    const FileOffset maxGap=16*1024;
+
+    if (ranges.empty()) {
+      return;
+    }
+
+    std::sort(ranges.begin(),ranges.end());
+
+    FileOffset start=ranges.front().first;
+    FileOffset end=start+ranges.front().second;
+
+    for (const auto& range : ranges) {
+      if (range.first>end+maxGap) {
+        scanner.Prefetch(start,end-start);
+
+        start=range.first;
+        end=range.first+range.second;
+      }
+      else {
+        end=std::max(end,range.first+range.second);
+      }
+    }
+
+    scanner.Prefetch(start,end-start);
+  }
+
+  /**
+   * Advise the operating system to load the data values at the given file
+   * offsets in the background, so that a following GetByOffset() call does
+   * not block on I/O. Since the size of the values is not known, the first
+   * bytes of each value are prefetched, the rest is left to the read-ahead
+   * of the operating system.
+   *
+   * Method is thread-safe.
+   */
+  template <class N>
+  void DataFile<N>::Prefetch(const std::vector<FileOffset>& offsets) const
+  {
+    const FileOffset valueSize=4096;
+
+    std::vector<std::pair<FileOffset,FileOffset>> ranges;
+
+    ranges.reserve(offsets.size());
+
+    for (const auto offset : offsets) {
+      ranges.push_back(std::make_pair(offset,valueSize));
+    }
+
+    PrefetchRanges(ranges);
+  }
+
+  /**
+   * Advise the operating system to load the data values of the given spans
+   * in the background, so that a following GetByBlockSpans() call does not
+   * block on I/O. The size of a span is estimated from the number of values
+   * in it.
+   *
+   * Method is thread-safe.
+   */
+  template <class N>
+  void DataFile<N>::Prefetch(const std::vector<DataBlockSpan>& spans) const
+  {
+    const FileOffset averageValueSize=512;
+
+    std::vector<std::pair<FileOffset,FileOffset>> ranges;
+
+    ranges.reserve(spans.size());
+
+    for (const auto& span : spans) {
+      ranges.push_back(std::make_pair(span.startOffset,
+                                      span.count*averageValueSize));
+    }
+
+    PrefetchRanges(ranges);
+  }
+
+  /**
+   * Dump statistics of the cache (if active) to the log.
+   *
+   * Method is thread-safe.
+   */
+  template <class N>
+  void DataFile<N>::DumpStatistics() const
+  {
+    if (!cache) {
+      return;
+    }
+
+    log.Info() << "DataFile " << datafile << " cache entries " << cache->GetEntryCount() <<
+    ", memory " << cache->GetSize() << "/" << cache->GetMaxSize() <<
+    ", hits " << cache->GetHits() << ", misses " << cache->GetMisses() <<
+    ", evictions " << cache->GetEvictions();
+  }
+
   /**
    * \ingroup Database
    *
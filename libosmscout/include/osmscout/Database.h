@@ -46,6 +46,8 @@
 
 // Location index
 #include <osmscout/LocationIndex.h>
+#include <osmscout/POIIndex.h>
+#include <osmscout/RouteSegmentIndex.h>
 
 // Water index
 #include <osmscout/WaterIndex.h>
@@ -71,12 +73,19 @@ namespace osmscout {
 
     The following attributes are currently available:
     * cache sizes.
+    * eager opening of all data files and indexes in Open().
+    * maximum size of index files locked into memory.
     */
   class OSMSCOUT_API DatabaseParameter
   {
   private:
     unsigned long areaAreaIndexCacheSize;
     unsigned long areaNodeIndexCacheSize;
+    size_t        nodeDataCacheMemory;
+    size_t        wayDataCacheMemory;
+    size_t        areaDataCacheMemory;
+    bool          eagerOpen;
+    size_t        maxLockedIndexSize;
 
   public:
     DatabaseParameter();
@@ -84,8 +93,22 @@ namespace osmscout {
     void SetAreaAreaIndexCacheSize(unsigned long areaAreaIndexCacheSize);
     void SetAreaNodeIndexCacheSize(unsigned long areaNodeIndexCacheSize);
 
+    void SetNodeDataCacheMemory(size_t nodeDataCacheMemory);
+    void SetWayDataCacheMemory(size_t wayDataCacheMemory);
+    void SetAreaDataCacheMemory(size_t areaDataCacheMemory);
+
+    void SetEagerOpen(bool eagerOpen);
+    void SetMaxLockedIndexSize(size_t maxLockedIndexSize);
+
     unsigned long GetAreaAreaIndexCacheSize() const;
     unsigned long GetAreaNodeIndexCacheSize() const;
+
+    size_t GetNodeDataCacheMemory() const;
+    size_t GetWayDataCacheMemory() const;
+    size_t GetAreaDataCacheMemory() const;
+
+    bool GetEagerOpen() const;
+    size_t GetMaxLockedIndexSize() const;
   };
 
   /**
@@ -135,12 +158,24 @@ namespace osmscout {
     mutable WaterIndexRef           waterIndex;           //!< Index of land/sea tiles
     mutable std::mutex              waterIndexMutex;      //!< Mutex to make lazy initialisation of water index thread-safe
 
+    mutable POIIndexRef             poiIndex;             //!< Spatial index of POIs by type
+    mutable std::mutex              poiIndexMutex;        //!< Mutex to make lazy initialisation of POI index thread-safe
+
+    mutable RouteSegmentIndexRef    routeSegmentIndex;    //!< Spatial index of routable segments by vehicle
+    mutable std::mutex              routeSegmentIndexMutex; //!< Mutex to make lazy initialisation of route segment index thread-safe
+
     mutable OptimizeAreasLowZoomRef optimizeAreasLowZoom; //!< Optimized data for low zoom situations
     mutable std::mutex              optimizeAreasMutex;   //!< Mutex to make lazy initialisation of optimized areas index thread-safe
 
     mutable OptimizeWaysLowZoomRef  optimizeWaysLowZoom;  //!< Optimized data for low zoom situations
     mutable std::mutex              optimizeWaysMutex;    //!< Mutex to make lazy initialisation of optimized ways index thread-safe
 
+    mutable std::vector<std::shared_ptr<FileScanner>> lockedIndexes; //!< Index files locked into memory
+    mutable std::mutex              lockedIndexesMutex;   //!< Mutex to make locking of index files thread-safe
+
+  private:
+    void LockIndexes() const;
+
   public:
     Database(const DatabaseParameter& parameter);
     virtual ~Database();
@@ -149,6 +184,8 @@ namespace osmscout {
     bool IsOpen() const;
     void Close();
 
+    bool WarmUp() const;
+
     std::string GetPath() const;
     TypeConfigRef GetTypeConfig() const;
 
@@ -164,6 +201,10 @@ namespace osmscout {
 
     WaterIndexRef GetWaterIndex() const;
 
+    POIIndexRef GetPOIIndex() const;
+
+    RouteSegmentIndexRef GetRouteSegmentIndex() const;
+
     OptimizeAreasLowZoomRef GetOptimizeAreasLowZoom() const;
     OptimizeWaysLowZoomRef GetOptimizeWaysLowZoom() const;
 
@@ -194,6 +235,10 @@ namespace osmscout {
                              std::vector<AreaRef>& area) const;
     bool GetAreasByBlockSpans(const std::vector<DataBlockSpan>& spans,
                               std::vector<AreaRef>& areas) const;
+    bool GetAreasByBlockSpans(const std::vector<DataBlockSpan>& spans,
+                              const ObjectHeaderFilter& filter,
+                              const MemoryArenaRef& arena,
+                              std::vector<AreaRef>& areas) const;
 
 
     bool GetWayByOffset(const FileOffset& offset,
@@ -206,6 +251,14 @@ namespace osmscout {
                          std::vector<WayRef>& ways) const;
     bool GetWaysByOffset(const std::set<FileOffset>& offsets,
                          std::unordered_map<FileOffset,WayRef>& dataMap) const;
+    bool GetWaysByOffset(const std::vector<FileOffset>& offsets,
+                         const ObjectHeaderFilter& filter,
+                         const MemoryArenaRef& arena,
+                         std::vector<WayRef>& ways) const;
+
+    bool PrefetchNodesByOffset(const std::vector<FileOffset>& offsets) const;
+    bool PrefetchAreasByBlockSpans(const std::vector<DataBlockSpan>& spans) const;
+    bool PrefetchWaysByOffset(const std::vector<FileOffset>& offsets) const;
 
     void DumpStatistics();
   };
@@ -213,6 +266,45 @@ namespace osmscout {
   //! Reference counted reference to an Database instance
   typedef std::shared_ptr<Database> DatabaseRef;
 
+  /**
+   * \ingroup Database
+   *
+   * Handle to the current version of a database, that allows to switch to
+   * a new version (e.g. a new import in another directory) while the
+   * database is in use.
+   *
+   * GetDatabase() returns a snapshot of the current version. Open() opens
+   * the new version and loads its data files and indexes (see
+   * Database::WarmUp()) without blocking users of the current version.
+   * Only then the new version is published. Queries still running on an
+   * older snapshot continue to use its files; an old version is closed
+   * and freed as soon as the last reference to it is dropped.
+   *
+   * Services and configurations derived from a snapshot (MapService with
+   * its tile cache, RoutingService, StyleConfig for its TypeConfig) are
+   * bound to that version and have to be recreated for a new one. Clients
+   * can detect a new version by comparing the result of GetDatabase() with
+   * the database their services were created for.
+   */
+  class OSMSCOUT_API DatabaseHandle
+  {
+  private:
+    DatabaseParameter parameter;   //!< Parameter for all versions of the database
+    DatabaseRef       database;    //!< Current version, only accessed via std::atomic_load()/std::atomic_store()
+    std::mutex        openMutex;   //!< Serializes calls to Open() and Close()
+
+  public:
+    explicit DatabaseHandle(const DatabaseParameter& parameter);
+
+    bool Open(const std::string& path);
+    void Close();
+
+    DatabaseRef GetDatabase() const;
+  };
+
+  //! Reference counted reference to a DatabaseHandle instance
+  typedef std::shared_ptr<DatabaseHandle> DatabaseHandleRef;
+
   /**
    * \defgroup Service High level services
    *
@@ -40,6 +40,10 @@ namespace osmscout {
    *
    * The polygon can consist (partly) of a coastline (Coord.coast=true) or
    * of cell boundary lines (Coord.cell=false).
+   *
+   * Full cell tiles of the same type may be merged into one rectangular tile,
+   * that covers width x height cells starting at the cell (xAbs,yAbs).
+   * Tiles with coords always cover exactly one cell.
    */
   struct OSMSCOUT_API GroundTile
   {
@@ -92,15 +96,21 @@ namespace osmscout {
     size_t             yRel;
     double             cellWidth;
     double             cellHeight;
+    size_t             width;      //!< Number of cells covered in horizontal direction
+    size_t             height;     //!< Number of cells covered in vertical direction
     std::vector<Coord> coords;
 
     inline GroundTile()
+    : width(1),
+      height(1)
     {
       // no code
     }
 
     inline GroundTile(Type type)
-    : type(type)
+    : type(type),
+      width(1),
+      height(1)
     {
       // no code
     }
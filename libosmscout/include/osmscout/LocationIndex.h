@@ -24,11 +24,13 @@
 #include <memory>
 #include <set>
 #include <unordered_set>
+#include <vector>
 
 #include <osmscout/Location.h>
 #include <osmscout/TypeConfig.h>
 
 #include <osmscout/util/FileScanner.h>
+#include <osmscout/util/GeoBox.h>
 
 namespace osmscout {
 
@@ -46,20 +48,123 @@ namespace osmscout {
   {
   public:
     static const char* const FILENAME_LOCATION_IDX;
+    static const char* const FILENAME_LOCATION_TOKEN_IDX;
+    static const char* const FILENAME_LOCATION_REVERSE_IDX;
+
+    /**
+     * Number of cells per degree of the address and POI grid of the
+     * reverse lookup index
+     */
+    static const uint32_t REVERSE_CELLS_PER_DEGREE;
+
+    /**
+     * Number of bytes of a token in the token index. Names are split into
+     * all overlapping byte sequences of this length.
+     */
+    static const size_t TOKEN_LENGTH;
+
+    /**
+     * The sections of the (optional) token index. Each section maps
+     * a name token to a sorted posting list of file offsets into the
+     * location index.
+     */
+    enum TokenSection {
+      regionTokenSection          = 0, //!< Tokens of region names and aliases, posting lists hold region offsets
+      regionLocationTokenSection  = 1, //!< Tokens of POI and location names, posting lists hold the offsets of the region they are in
+      locationAddressTokenSection = 2  //!< Tokens of address names, posting lists hold the offsets of the location they belong to
+    };
+
+    /**
+     * Address or POI entry of the reverse lookup index
+     */
+    struct OSMSCOUT_API ReverseIndexEntry
+    {
+      ObjectFileRef object;         //!< The address or POI object
+      FileOffset    regionOffset;   //!< Offset of the region the object is in
+      FileOffset    locationOffset; //!< Offset of the location of an address, 0 for POIs
+      FileOffset    entryOffset;    //!< Offset of the address or POI entry
+      GeoBox        boundingBox;    //!< Bounding box of the object
+
+      inline bool IsAddress() const
+      {
+        return locationOffset!=0;
+      }
+    };
 
   private:
-    std::string                     path;
-    mutable uint8_t                 bytesForNodeFileOffset;
-    mutable uint8_t                 bytesForAreaFileOffset;
-    mutable uint8_t                 bytesForWayFileOffset;
-    std::unordered_set<std::string> regionIgnoreTokens;
-    std::unordered_set<std::string> locationIgnoreTokens;
-    FileOffset                      indexOffset;
+    /**
+     * Region entry of the reverse lookup index
+     */
+    struct ReverseRegionEntry
+    {
+      FileOffset regionOffset;   //!< Offset of the region
+      uint32_t   depth;          //!< Depth of the region in the region tree
+      GeoBox     boundingBox;    //!< Bounding box of the region
+      FileOffset polygonsOffset; //!< Offset of the region polygons in the reverse index file
+    };
+
+    /**
+     * Non-empty cell of the address and POI grid of the reverse lookup index
+     */
+    struct ReverseCellEntry
+    {
+      uint64_t   cellId;       //!< Id of the cell, see GetReverseCellId()
+      uint32_t   count;        //!< Number of entries in the cell
+      FileOffset entryOffset;  //!< Offset of the first entry in the reverse index file
+
+      inline bool operator<(const ReverseCellEntry& other) const
+      {
+        return cellId<other.cellId;
+      }
+    };
+
+    /**
+     * Entry in the dictionary of a token index section
+     */
+    struct TokenEntry
+    {
+      uint32_t   token;      //!< The token
+      uint32_t   count;      //!< Number of entries in the posting list
+      FileOffset listOffset; //!< Offset of the posting list in the token index file
+
+      inline bool operator<(const TokenEntry& other) const
+      {
+        return token<other.token;
+      }
+    };
+
+  private:
+    std::string                       path;
+    mutable uint8_t                   bytesForNodeFileOffset;
+    mutable uint8_t                   bytesForAreaFileOffset;
+    mutable uint8_t                   bytesForWayFileOffset;
+    std::unordered_set<std::string>   regionIgnoreTokens;
+    std::unordered_set<std::string>   locationIgnoreTokens;
+    FileOffset                        indexOffset;
+    bool                              hasTokenIndex;
+    std::vector<TokenEntry>           tokenIndex[3];
+    bool                              hasReverseIndex;
+    std::vector<ReverseRegionEntry>   reverseRegions;
+    std::vector<ReverseCellEntry>     reverseCells;
+    GeoBox                            reverseRegionBox;        //!< Bounding box of all regions
+    double                            reverseRegionCellWidth;
+    double                            reverseRegionCellHeight;
+    std::vector<std::vector<size_t> > reverseRegionGrid;       //!< Regions overlapping each cell of the region grid
+    FileScanner                       reverseScanner;          //!< Scanner of the reverse lookup index, kept open and shared by lookups
 
   private:
     void Read(FileScanner& scanner,
               ObjectFileRef& object) const;
 
+    bool LoadTokenIndex();
+    bool LoadReverseIndex();
+
+    void LoadLocation(FileScanner& scanner,
+                      Location& location) const;
+
+    void ReadReverseIndexEntry(FileScanner& scanner,
+                               ReverseIndexEntry& entry) const;
+
     bool LoadAdminRegion(FileScanner& scanner,
                          AdminRegion& region) const;
 
@@ -113,6 +218,78 @@ namespace osmscout {
     bool ResolveAdminRegionHierachie(const AdminRegionRef& region,
                                      std::map<FileOffset,AdminRegionRef>& refs) const;
 
+    static void GetNameTokens(const std::string& normalizedName,
+                              std::vector<uint32_t>& tokens);
+
+    /**
+     * Return true, if the token index is available and can answer
+     * substring queries for the given pattern
+     */
+    bool CanUseTokenIndex(const std::string& pattern) const;
+
+    /**
+     * Return the sorted list of offsets of all entries of the given section,
+     * which possibly contain the given pattern as (case insensitive) substring.
+     * The result is a superset of the actual matches, the caller must still
+     * check the names.
+     */
+    bool GetTokenCandidates(TokenSection section,
+                            const std::string& pattern,
+                            std::vector<FileOffset>& offsets) const;
+
+    /**
+     * Visit the regions at the given (sorted) region offsets, children of the
+     * regions are not visited
+     */
+    bool VisitAdminRegions(const std::vector<FileOffset>& regionOffsets,
+                           AdminRegionVisitor& visitor) const;
+
+    /**
+     * Visit all locations within the given admin region and its sub regions, but
+     * only for the regions, that are part of the given (sorted) region offsets
+     */
+    bool VisitAdminRegionLocations(const AdminRegion& region,
+                                   const std::vector<FileOffset>& regionOffsets,
+                                   LocationVisitor& visitor) const;
+
+    /**
+     * Return the id of the cell of the address and POI grid of the
+     * reverse lookup index
+     */
+    static inline uint64_t GetReverseCellId(uint32_t x,
+                                            uint32_t y)
+    {
+      return ((uint64_t)y << 32) | x;
+    }
+
+    /**
+     * Return true, if the reverse lookup index is available
+     */
+    bool HasReverseIndex() const;
+
+    /**
+     * Return the innermost region containing the given coordinate. region
+     * is reset, if the coordinate is not within any region.
+     */
+    bool GetRegionAt(const GeoCoord& coord,
+                     AdminRegionRef& region) const;
+
+    /**
+     * Return all addresses and POIs whose bounding box intersects the given box
+     */
+    bool GetReverseIndexEntries(const GeoBox& box,
+                                std::vector<ReverseIndexEntry>& entries) const;
+
+    /**
+     * Load the region, location and address or POI data for the given entry
+     * of the reverse lookup index. Either address or poi is set.
+     */
+    bool LoadReverseIndexEntry(const ReverseIndexEntry& entry,
+                               AdminRegionRef& region,
+                               LocationRef& location,
+                               AddressRef& address,
+                               POIRef& poi) const;
+
     void DumpStatistics();
   };
 
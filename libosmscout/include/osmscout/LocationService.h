@@ -22,6 +22,7 @@
 
 #include <list>
 #include <memory>
+#include <vector>
 
 #include <osmscout/Database.h>
 #include <osmscout/Location.h>
@@ -235,9 +236,6 @@ namespace osmscout {
        void Match(const std::string& name,
                   bool& match,
                   bool& candidate) const;
-
-     private:
-       void TolowerUmlaut(std::string& s) const;
      };
 
     class AdminRegionMatchVisitor : public AdminRegionVisitor, public VisitorMatcher
@@ -356,17 +354,52 @@ namespace osmscout {
       AddressRef     address;     //!< Address data if set
     };
 
+    /**
+     * \ingroup Location
+     *
+     * Result of a reverse lookup of a coordinate
+     */
+    struct OSMSCOUT_API CoordReverseLookupResult
+    {
+      std::list<AdminRegionRef> regions;  //!< Regions containing the coordinate, innermost region first
+      ReverseLookupResult       place;    //!< Closest address (or POI, if there is no address in range), object is invalid if nothing was found
+      double                    distance; //!< Distance to the bounding box of the place object in meter
+    };
+
+  private:
+    /**
+     * \ingroup Location
+     *
+     * Candidates for the location and address pattern of a search entry as
+     * returned by the token index of the location index. If no candidates are
+     * available (no token index or pattern too short) all entries have to be
+     * visited.
+     */
+    struct SearchEntryCandidates
+    {
+      bool                    hasLocationCandidates;  //!< 'true', if locationRegionOffsets restricts the search
+      std::vector<FileOffset> locationRegionOffsets;  //!< Regions possibly holding a matching POI or location
+      bool                    hasAddressCandidates;   //!< 'true', if addressLocationOffsets restricts the search
+      std::vector<FileOffset> addressLocationOffsets; //!< Locations possibly holding a matching address
+    };
+
   private:
     DatabaseRef database;
 
   private:
+    bool GetSearchEntryCandidates(const LocationIndex& locationIndex,
+                                  const LocationSearch::Entry& searchEntry,
+                                  SearchEntryCandidates& candidates) const;
+
     bool HandleAdminRegion(const LocationSearch& search,
                            const LocationSearch::Entry& searchEntry,
+                           const SearchEntryCandidates& candidates,
                            const AdminRegionMatchVisitor::AdminRegionResult& adminRegionResult,
                            LocationSearchResult& result) const;
 
     bool HandleAdminRegionLocation(const LocationSearch& search,
                                    const LocationSearch::Entry& searchEntry,
+                                   const SearchEntryCandidates& candidates,
                                    const AdminRegionMatchVisitor::AdminRegionResult& adminRegionResult,
                                    const LocationMatchVisitor::LocationResult& locationResult,
                                    LocationSearchResult& result) const;
@@ -382,6 +415,17 @@ namespace osmscout {
                                           const AddressMatchVisitor::AddressResult& addressResult,
                                           LocationSearchResult& result) const;
 
+    static void GetClosestArea(const GeoCoord& location,
+                               const std::vector<AreaRef>& areas,
+                               bool& atPlace,
+                               AreaRef& placeArea,
+                               double& distance,
+                               double& bearing);
+
+    bool DescribeLocationByAddressIndex(const LocationIndex& locationIndex,
+                                        const GeoCoord& location,
+                                        LocationDescription& description);
+
     bool DescribeLocationByAddress(const GeoCoord& location,
                                    LocationDescription& description);
 
@@ -411,6 +455,10 @@ namespace osmscout {
     bool ReverseLookupObject(const ObjectFileRef& object,
                               std::list<ReverseLookupResult>& result) const;
 
+    bool ReverseLookupCoord(const GeoCoord& coord,
+                            double maxDistance,
+                            CoordReverseLookupResult& result) const;
+
     bool DescribeLocation(const GeoCoord& location,
                           LocationDescription& description);
   };
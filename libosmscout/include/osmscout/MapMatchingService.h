@@ -0,0 +1,396 @@
+#ifndef OSMSCOUT_MAPMATCHINGSERVICE_H
+#define OSMSCOUT_MAPMATCHINGSERVICE_H
+
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2016  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <osmscout/Database.h>
+#include <osmscout/GeoCoord.h>
+#include <osmscout/ObjectRef.h>
+#include <osmscout/RouteData.h>
+#include <osmscout/RouteSegmentIndex.h>
+#include <osmscout/RoutingProfile.h>
+
+#include <osmscout/util/Cache.h>
+#include <osmscout/util/GeoBox.h>
+
+namespace osmscout {
+
+  /**
+   * \ingroup Routing
+   * Parameter for the map matching service. All distances are in meters.
+   */
+  class OSMSCOUT_API MapMatchingParameter
+  {
+  private:
+    double searchRadius;    //!< Maximum distance of a candidate segment to a trace point
+    double gpsSigma;        //!< Standard deviation of the GPS error
+    double transitionBeta;  //!< Scale of the difference between route and direct distance of two points
+    double maxDetourFactor; //!< Maximum route distance between two points relative to their direct distance
+    size_t maxCandidates;   //!< Maximum number of candidates per trace point
+    size_t maxLag;          //!< Maximum number of undecided trace points
+    size_t tileCacheSize;   //!< Number of cached road network tiles
+
+  public:
+    MapMatchingParameter();
+
+    void SetSearchRadius(double searchRadius);
+    void SetGPSSigma(double gpsSigma);
+    void SetTransitionBeta(double transitionBeta);
+    void SetMaxDetourFactor(double maxDetourFactor);
+    void SetMaxCandidates(size_t maxCandidates);
+    void SetMaxLag(size_t maxLag);
+    void SetTileCacheSize(size_t tileCacheSize);
+
+    double GetSearchRadius() const;
+    double GetGPSSigma() const;
+    double GetTransitionBeta() const;
+    double GetMaxDetourFactor() const;
+    size_t GetMaxCandidates() const;
+    size_t GetMaxLag() const;
+    size_t GetTileCacheSize() const;
+  };
+
+  class MapMatcher;
+
+  /**
+   * \ingroup Service
+   * \ingroup Routing
+   *
+   * The MapMatchingService matches (noisy) GPS traces to the routable ways of
+   * the database using a hidden markov model: The candidates of a trace point
+   * are the nearest segments of the routable ways around the point, the
+   * most probable sequence of candidates is calculated using the Viterbi
+   * algorithm. The transition probability of two candidates is based on the
+   * difference of their route distance and the direct distance of the trace points.
+   *
+   * Candidates are looked up using the RouteSegmentIndex of the database. For
+   * the calculation of route distances the service holds the road network in
+   * tiles, with the junctions (nodes with ids) of the ways. Tiles are loaded
+   * on demand and cached for all matchers of the service.
+   *
+   * Only ways are matched, routable areas are ignored.
+   *
+   * Matching a trace is done by a MapMatcher instance, that accepts the points of
+   * a trace one by one and emits the matched points and the resulting RouteData
+   * as soon as they are decided. MatchTrace() is a convenience method for
+   * matching a complete trace.
+   *
+   * The service is thread-safe, a MapMatcher instance is not.
+   */
+  class OSMSCOUT_API MapMatchingService
+  {
+  public:
+    /**
+     * A candidate of a trace point, a point on a segment of a way
+     */
+    struct OSMSCOUT_API Candidate
+    {
+      ObjectFileRef object;       //!< The way
+      size_t        segmentIndex; //!< Index of the first node of the segment
+      double        fraction;     //!< Position of the point on the segment in the interval [0..1]
+      GeoCoord      coord;        //!< The point on the segment
+      double        distance;     //!< Distance of the trace point to the point on the segment
+    };
+
+    /**
+     * Result of map matching for one trace point
+     */
+    struct OSMSCOUT_API MatchedPoint
+    {
+      size_t    pointIndex; //!< Index of the point in the trace
+      bool      matched;    //!< true, if the point was matched, else candidate is invalid
+      Candidate candidate;  //!< The matched candidate
+    };
+
+    /**
+     * Callback for the results of a MapMatcher. The callback is called with
+     * the newly decided points and the route between them. The route parts of
+     * consecutive calls can be appended. A route ends with an entry without
+     * path object (see RoutingService), if a trace cannot be matched
+     * continuously, a new route is started after that.
+     */
+    typedef std::function<void(const std::vector<MatchedPoint>& points,
+                               const RouteData& route)> MatchCallback;
+
+  private:
+    /**
+     * A routable way of the road network
+     */
+    struct RoadWay
+    {
+      WayRef              way;
+      ObjectFileRef       ref;
+      std::vector<double> distances; //!< Distance of each node from the first node of the way
+      std::vector<size_t> junctions; //!< Indexes of all nodes with id (sorted)
+    };
+
+    typedef std::shared_ptr<RoadWay> RoadWayRef;
+
+    /**
+     * Reference to a node of a way in a tile
+     */
+    struct RoadWayIndex
+    {
+      uint32_t way;   //!< Index of the way in the tile
+      uint32_t index; //!< Index of the node
+    };
+
+    /**
+     * A tile of the road network
+     */
+    struct RoadTile
+    {
+      GeoBox                                            boundingBox;
+      std::vector<RoadWayRef>                           ways;
+      std::unordered_map<FileOffset,uint32_t>           wayIndexes; //!< Index of a way in the tile by its file offset
+      std::unordered_map<Id,std::vector<RoadWayIndex> > junctions;  //!< Ways at a junction in the tile
+    };
+
+    typedef std::shared_ptr<RoadTile>  RoadTileRef;
+    typedef Cache<uint64_t,RoadTileRef> RoadTileCache;
+
+  private:
+    DatabaseRef           database;
+    MapMatchingParameter  parameter;
+
+    mutable std::mutex    tileMutex;     //!< Mutex to protect the tile cache
+    mutable RoadTileCache tileCache;     //!< Cache of loaded tiles
+
+  private:
+    static uint64_t GetTileKey(Vehicle vehicle,
+                               uint32_t x,
+                               uint32_t y);
+
+    bool LoadTile(Vehicle vehicle,
+                  uint32_t x,
+                  uint32_t y,
+                  RoadTile& tile) const;
+
+    RoadTileRef GetTile(Vehicle vehicle,
+                        uint32_t x,
+                        uint32_t y) const;
+
+    friend class MapMatcher;
+
+  public:
+    static const double TILE_SIZE; //!< Width and height of a tile in degrees
+
+    MapMatchingService(const DatabaseRef& database,
+                       const MapMatchingParameter& parameter);
+    virtual ~MapMatchingService();
+
+    const MapMatchingParameter& GetParameter() const;
+
+    bool GetCandidates(const RoutingProfile& profile,
+                       const std::vector<GeoCoord>& points,
+                       std::vector<std::vector<Candidate> >& candidates) const;
+
+    bool MatchTrace(const RoutingProfile& profile,
+                    const std::vector<GeoCoord>& points,
+                    std::vector<MatchedPoint>& matchedPoints,
+                    RouteData& route) const;
+
+    void FlushCache();
+  };
+
+  //! \ingroup Service
+  //! Reference counted reference to a MapMatchingService instance
+  typedef std::shared_ptr<MapMatchingService> MapMatchingServiceRef;
+
+  /**
+   * \ingroup Routing
+   *
+   * Streaming map matcher for one trace. Points are added one by one via
+   * AddPoint(), the results are passed to the callback as soon as the
+   * matching of a point is decided (all remaining candidate paths share it)
+   * or MapMatchingParameter::GetMaxLag() points are undecided. Finish()
+   * decides and emits all remaining points.
+   *
+   * The service passed must exist as long as the matcher.
+   */
+  class OSMSCOUT_API MapMatcher
+  {
+  private:
+    typedef MapMatchingService::RoadWay     RoadWay;
+    typedef MapMatchingService::RoadWayRef  RoadWayRef;
+    typedef MapMatchingService::RoadTileRef RoadTileRef;
+
+    /**
+     * Internal representation of a candidate
+     */
+    struct MatchCandidate
+    {
+      RoadWayRef way;
+      size_t     segmentIndex;
+      double     fraction;
+      double     position;     //!< Distance from the first node of the way
+      GeoCoord   coord;
+      double     distance;
+    };
+
+    /**
+     * Viterbi state of a candidate
+     */
+    struct State
+    {
+      MatchCandidate candidate;
+      double         score;    //!< Log probability of the best path to this state
+      size_t         previous; //!< Index of the previous state in the previous step
+    };
+
+    /**
+     * A trace point with candidates
+     */
+    struct Step
+    {
+      size_t             pointIndex;
+      GeoCoord           coord;
+      size_t             skippedPoints; //!< Number of unmatched points before this point
+      double             maxDistance;   //!< Maximum route distance from the previous step
+      std::vector<State> states;
+    };
+
+    /**
+     * Node of the way graph reached by the search from a junction
+     */
+    struct SearchNode
+    {
+      double     distance;
+      Id         previous;  //!< The junction the node was reached from
+      RoadWayRef way;       //!< The way used to reach the node
+      size_t     fromIndex; //!< Index of the previous junction in the way
+      size_t     toIndex;   //!< Index of the node in the way
+    };
+
+    /**
+     * Result of a search from a junction up to a given distance
+     */
+    struct SearchResult
+    {
+      double                            maxDistance;
+      std::unordered_map<Id,SearchNode> nodes;
+    };
+
+    typedef std::shared_ptr<SearchResult>   SearchResultRef;
+    typedef Cache<Id,SearchResultRef>       SearchCache;
+
+    /**
+     * Possible way to leave or to reach a candidate via a junction
+     */
+    struct JunctionAccess
+    {
+      Id     junction;
+      size_t junctionIndex;
+      double distance;
+      bool   forward;
+    };
+
+    /**
+     * A node of a matched route
+     */
+    struct RouteNode
+    {
+      RoadWayRef way;
+      size_t     index;
+    };
+
+  private:
+    const MapMatchingService&                   service;
+    const RoutingProfile&                       profile;
+    MapMatchingService::MatchCallback           callback;
+    Vehicle                                     vehicle;
+    RouteSegmentIndexRef                        routeSegmentIndex;
+
+    std::unordered_map<uint64_t,RoadTileRef>    tiles;        //!< Tiles used by this matcher
+    std::unordered_map<FileOffset,uint8_t>      wayAccess;    //!< Cached forward/backward usability of ways
+    SearchCache                                 searchCache;  //!< Cached search results per junction
+    std::vector<RouteSegmentIndex::Segment>     segments;     //!< Buffer for the segments of the candidate lookup
+
+    std::deque<Step>                            steps;        //!< Undecided steps
+    bool                                        anchorEmitted;//!< The first step has already been emitted
+    size_t                                      pointCount;
+    size_t                                      skippedPoints;
+
+    RouteData                                   routePart;    //!< Route entries not yet emitted
+    bool                                        hasLastNode;
+    RouteNode                                   lastNode;
+    std::vector<MapMatchingService::MatchedPoint> matchedPoints; //!< Matched points not yet emitted
+
+  private:
+    RoadTileRef GetTile(uint32_t x,
+                        uint32_t y);
+    RoadTileRef GetTile(const GeoCoord& coord);
+
+    RoadWayRef GetWay(const RouteSegmentIndex::Segment& segment);
+
+    uint8_t GetWayAccess(const RoadWay& way);
+
+    void GetCandidates(const GeoCoord& coord,
+                       std::vector<MatchCandidate>& candidates);
+
+    void GetExits(const MatchCandidate& candidate,
+                  std::vector<JunctionAccess>& exits);
+    void GetEntries(const MatchCandidate& candidate,
+                    std::vector<JunctionAccess>& entries);
+
+    SearchResultRef Search(Id junction,
+                           const GeoCoord& coord,
+                           double maxDistance);
+
+    double GetRouteDistance(const MatchCandidate& from,
+                            const MatchCandidate& to,
+                            double maxDistance,
+                            std::vector<RouteNode>* route);
+
+    void AddRouteNode(const RoadWayRef& way,
+                      size_t index);
+    void AddRouteNodes(const RoadWayRef& way,
+                       size_t from,
+                       size_t to);
+    void FinishRoute();
+
+    void AddMatchedPoint(const Step& step,
+                         const State& state);
+    void Commit(size_t stepIndex,
+                size_t stateIndex);
+    void CommitConverged();
+    void Emit();
+
+    friend class MapMatchingService;
+
+  public:
+    MapMatcher(const MapMatchingService& service,
+               const RoutingProfile& profile,
+               const MapMatchingService::MatchCallback& callback);
+    virtual ~MapMatcher();
+
+    void AddPoint(const GeoCoord& coord);
+    void Finish();
+  };
+}
+
+#endif
@@ -36,6 +36,9 @@ namespace osmscout {
     static const char* NODES_DAT;
     static const char* NODES_IDMAP;
 
+  protected:
+    size_t GetValueMemory(const Node& node) const;
+
   public:
     NodeDataFile();
   };
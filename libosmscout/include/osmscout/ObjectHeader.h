@@ -0,0 +1,64 @@
+#ifndef OSMSCOUT_OBJECTHEADER_H
+#define OSMSCOUT_OBJECTHEADER_H
+
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2016  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <functional>
+#include <vector>
+
+#include <osmscout/TypeConfig.h>
+
+#include <osmscout/util/GeoBox.h>
+
+namespace osmscout {
+
+  /**
+   * \ingroup Database
+   *
+   * Header of a way or area as stored in the data file. It can be read
+   * without decoding the feature values and the nodes of the object, which
+   * allows to reject objects early (see ObjectHeaderFilter) and to skip
+   * the rest of their data.
+   */
+  struct OSMSCOUT_API ObjectHeader
+  {
+    FileOffset           fileOffset;  //!< Offset of the object in the data file
+    TypeInfoRef          type;        //!< Type of the object
+    GeoBox               boundingBox; //!< Bounding box of the object
+    std::vector<uint8_t> featureBits; //!< Feature bits of the object, the feature values are not read
+    FileOffset           dataOffset;  //!< Offset of the object data (features and nodes) following the header
+    FileOffset           nextOffset;  //!< Offset directly behind the object data
+
+    inline bool HasFeature(size_t idx) const
+    {
+      return (featureBits[idx/8] & (1 << idx%8))!=0;
+    }
+  };
+
+  /**
+   * \ingroup Database
+   *
+   * Predicate evaluated on the header of an object. Only objects for which
+   * the predicate returns true are read completely.
+   */
+  typedef std::function<bool(const ObjectHeader& header)> ObjectHeaderFilter;
+}
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef OSMSCOUT_POIINDEX_H
+#define OSMSCOUT_POIINDEX_H
+
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2016  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <memory>
+#include <vector>
+
+#include <osmscout/GeoCoord.h>
+#include <osmscout/ObjectRef.h>
+#include <osmscout/TypeConfig.h>
+
+#include <osmscout/util/FileScanner.h>
+#include <osmscout/util/GeoBox.h>
+
+namespace osmscout {
+
+  /**
+   * \ingroup Database
+   *
+   * POIIndex holds a packed R-tree for each type that is marked as POI
+   * (nodes, ways and areas). The trees are bulk loaded at import time using
+   * Sort-Tile-Recursive packing. The index file is kept open and memory mapped,
+   * each query reads the tree nodes using its own scanner on the shared mapping,
+   * so concurrent queries do not block each other.
+   *
+   * The index supports queries for all POIs in an area, the k nearest POIs to a
+   * given coordinate and the POIs along a path (e.g. a route). The result
+   * are lightweight entries, the actual objects are not loaded.
+   *
+   * The position of a POI is the center of its bounding box, distances are
+   * spherical distances in km.
+   */
+  class OSMSCOUT_API POIIndex
+  {
+  public:
+    static const char* POI_IDX;
+
+    static const size_t NODE_SIZE; //!< Maximum number of children of a node in the R-tree
+
+    /**
+     * A POI as returned by the index
+     */
+    struct OSMSCOUT_API Entry
+    {
+      ObjectFileRef object;      //!< Reference to the object
+      TypeInfoRef   type;        //!< Type of the object
+      GeoBox        boundingBox; //!< Bounding box of the object
+      double        distance;    //!< Distance to the reference coordinate or path in km, 0.0 for area queries
+
+      inline GeoCoord GetCoord() const
+      {
+        return boundingBox.GetCenter();
+      }
+    };
+
+  private:
+    struct TypeData
+    {
+      FileOffset rootOffset;  //!< Offset of the root node, 0 if there are no entries
+      uint32_t   entryCount;  //!< Number of entries in the tree
+      GeoBox     boundingBox; //!< Bounding box of all entries
+
+      TypeData();
+    };
+
+    /**
+     * Child entry of a node in the R-tree, either a reference to a child node
+     * or (for leaf nodes) a reference to an object
+     */
+    struct NodeEntry
+    {
+      GeoBox        boundingBox;
+      FileOffset    childOffset;
+      ObjectFileRef object;
+    };
+
+    /**
+     * Bounding boxes of a number of consecutive segments of a path,
+     * expanded by the maximum distance
+     */
+    struct PathChunk
+    {
+      GeoBox boundingBox;
+      size_t start;
+      size_t end;
+    };
+
+  private:
+    std::string           datafilename;   //!< Full path and name of the data file
+    FileScanner           scanner;        //!< Scanner instance for reading this file, shared by the queries
+
+    std::vector<TypeData> typeData;
+
+  private:
+    void ReadNode(FileScanner& queryScanner,
+                  FileOffset offset,
+                  bool& leaf,
+                  std::vector<NodeEntry>& entries) const;
+
+    static double GetDistance(const GeoCoord& coord,
+                              const GeoBox& box);
+
+    static double GetDistance(const GeoCoord& coord,
+                              const std::vector<GeoCoord>& path,
+                              const std::vector<PathChunk>& chunks,
+                              const GeoBox& coordBox);
+
+  public:
+    POIIndex();
+    virtual ~POIIndex();
+
+    bool Open(const std::string& path);
+    void Close();
+
+    inline bool IsOpen() const
+    {
+      return scanner.IsOpen();
+    }
+
+    bool GetEntriesInArea(const GeoBox& boundingBox,
+                          const TypeInfoSet& types,
+                          std::vector<Entry>& entries) const;
+
+    bool GetNearestEntries(const GeoCoord& coord,
+                           const TypeInfoSet& types,
+                           size_t maxCount,
+                           double maxDistance,
+                           std::vector<Entry>& entries) const;
+
+    bool GetEntriesAlongPath(const std::vector<GeoCoord>& path,
+                             double maxDistance,
+                             const TypeInfoSet& types,
+                             std::vector<Entry>& entries) const;
+
+    void DumpStatistics() const;
+  };
+
+  typedef std::shared_ptr<POIIndex> POIIndexRef;
+}
+
+#endif
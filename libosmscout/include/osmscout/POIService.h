@@ -36,6 +36,12 @@ namespace osmscout {
    *
    * Currently this includes the following functionality:
    * - Locating POIs of given types in a given area
+   * - Locating the nearest POIs of given types to a given coordinate
+   * - Locating POIs of given types along a path (e.g. a route)
+   *
+   * The nearest and path queries (and the *Entries* variant of the area query)
+   * use the POI index and return lightweight entries without loading the
+   * actual objects. They only work for types that are marked as POI.
    */
   class OSMSCOUT_API POIService
   {
@@ -65,6 +71,21 @@ namespace osmscout {
                        std::vector<WayRef>& ways,
                        const TypeInfoSet& areaTypes,
                        std::vector<AreaRef>& areas) const;
+
+    bool GetPOIEntriesInArea(const GeoBox& boundingBox,
+                             const TypeInfoSet& types,
+                             std::vector<POIIndex::Entry>& pois) const;
+
+    bool GetNearestPOIs(const GeoCoord& coord,
+                        const TypeInfoSet& types,
+                        size_t maxCount,
+                        double maxDistance,
+                        std::vector<POIIndex::Entry>& pois) const;
+
+    bool GetPOIsAlongPath(const std::vector<GeoCoord>& path,
+                          double maxDistance,
+                          const TypeInfoSet& types,
+                          std::vector<POIIndex::Entry>& pois) const;
   };
 
   //! \ingroup Service
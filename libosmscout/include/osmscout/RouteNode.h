@@ -101,6 +101,8 @@ namespace osmscout {
       uint32_t   objectIndex; //!< The index of the way to use from this route node to the target route node
       uint8_t    flags;       //!< Certain flags
       //uint8_t    bearing;     //!< Encoded initial and final bearing of this path
+      uint16_t   ascent;      //!< Sum of ascents along the path in meter, 0 if no elevation data was available during import
+      uint16_t   descent;     //!< Sum of descents along the path in meter, 0 if no elevation data was available during import
 
       inline bool IsRestricted(Vehicle vehicle) const
       {
@@ -0,0 +1,138 @@
+#ifndef OSMSCOUT_ROUTESEGMENTINDEX_H
+#define OSMSCOUT_ROUTESEGMENTINDEX_H
+
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2016  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <memory>
+#include <vector>
+
+#include <osmscout/GeoCoord.h>
+#include <osmscout/ObjectRef.h>
+#include <osmscout/Types.h>
+
+#include <osmscout/util/FileScanner.h>
+#include <osmscout/util/GeoBox.h>
+
+namespace osmscout {
+
+  /**
+   * \ingroup Database
+   *
+   * RouteSegmentIndex holds a packed R-tree of the segments of all routable
+   * ways and areas (outer ring) for each vehicle. Only objects with at least
+   * one node with id (routing node) are indexed. The trees are bulk loaded at
+   * import time using Sort-Tile-Recursive packing.
+   *
+   * The leaves of the trees hold the coordinates of the segments, so nearest
+   * segment queries can be answered without loading the objects.
+   *
+   * Distances are spherical distances in km, the nearest point on a segment is
+   * calculated in a local metric projection around the reference coordinate.
+   *
+   * Queries read the index using their own scanner on the shared memory mapping
+   * and thus can run concurrently.
+   */
+  class OSMSCOUT_API RouteSegmentIndex
+  {
+  public:
+    static const char* ROUTESEGMENT_IDX;
+
+    static const size_t NODE_SIZE; //!< Maximum number of children of a node in the R-tree
+
+    /**
+     * A segment of a routable object as returned by the index
+     */
+    struct OSMSCOUT_API Segment
+    {
+      ObjectFileRef object;        //!< Reference to the way or area
+      size_t        fromNodeIndex; //!< Index of the start node of the segment in the object
+      size_t        toNodeIndex;   //!< Index of the end node of the segment in the object
+      GeoCoord      from;          //!< Coordinate of the start node
+      GeoCoord      to;            //!< Coordinate of the end node
+      GeoCoord      coord;         //!< Nearest point on the segment to the reference coordinate
+      double        distance;      //!< Distance of the reference coordinate to the segment in km
+
+      /**
+       * Return the index of the segment node nearest to the reference coordinate
+       */
+      size_t GetNearestNodeIndex() const;
+    };
+
+  private:
+    struct VehicleData
+    {
+      Vehicle    vehicle;
+      FileOffset rootOffset;   //!< Offset of the root node
+      uint32_t   segmentCount; //!< Number of segments in the tree
+      GeoBox     boundingBox;  //!< Bounding box of all segments
+    };
+
+    /**
+     * Child entry of a node in the R-tree, either a reference to a child node
+     * or (for leaf nodes) a segment
+     */
+    struct NodeEntry
+    {
+      GeoBox        boundingBox;
+      FileOffset    childOffset;
+      ObjectFileRef object;
+      uint32_t      fromNodeIndex;
+      uint32_t      toNodeIndex;
+      GeoCoord      from;
+      GeoCoord      to;
+    };
+
+  private:
+    std::string              datafilename;   //!< Full path and name of the data file
+    FileScanner              scanner;        //!< Scanner instance for reading this file, shared by the queries
+
+    std::vector<VehicleData> vehicleData;
+
+  private:
+    void ReadNode(FileScanner& queryScanner,
+                  FileOffset offset,
+                  bool& leaf,
+                  std::vector<NodeEntry>& entries) const;
+
+  public:
+    RouteSegmentIndex();
+    virtual ~RouteSegmentIndex();
+
+    bool Open(const std::string& path);
+    void Close();
+
+    inline bool IsOpen() const
+    {
+      return scanner.IsOpen();
+    }
+
+    bool GetNearestSegments(const GeoCoord& coord,
+                            Vehicle vehicle,
+                            size_t maxCount,
+                            double maxDistance,
+                            std::vector<Segment>& segments) const;
+
+    void DumpStatistics() const;
+  };
+
+  typedef std::shared_ptr<RouteSegmentIndex> RouteSegmentIndexRef;
+}
+
+#endif
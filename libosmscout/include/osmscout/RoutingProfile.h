@@ -90,12 +90,24 @@ namespace osmscout {
     double                     minSpeed;
     double                     maxSpeed;
     double                     vehicleMaxSpeed;
+    double                     ascentCostFactor; //!< Additional distance in km per meter of ascent
+
+  protected:
+    /**
+     * Returns the distance of the path plus the additional distance for the
+     * ascent along the path
+     */
+    inline double GetEffectiveDistance(const RouteNode::Path& path) const
+    {
+      return path.distance+path.ascent*ascentCostFactor;
+    }
 
   public:
     AbstractRoutingProfile(const TypeConfigRef& typeConfig);
 
     void SetVehicle(Vehicle vehicle);
     void SetVehicleMaxSpeed(double maxSpeed);
+    void SetAscentCostFactor(double ascentCostFactor);
 
     void ParametrizeForFoot(const TypeConfig& typeConfig,
                             double maxSpeed);
@@ -164,7 +176,7 @@ namespace osmscout {
                            const std::vector<ObjectVariantData>& /*objectVariantData*/,
                            size_t pathIndex) const
     {
-      return currentNode.paths[pathIndex].distance;
+      return GetEffectiveDistance(currentNode.paths[pathIndex]);
     }
 
     inline double GetCosts(const Area& /*area*/,
@@ -215,7 +227,7 @@ namespace osmscout {
 
       speed=std::min(vehicleMaxSpeed,speed);
 
-      return currentNode.paths[pathIndex].distance/speed;
+      return GetEffectiveDistance(currentNode.paths[pathIndex])/speed;
     }
 
     inline double GetCosts(const Area& area,
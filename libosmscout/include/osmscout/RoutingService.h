@@ -308,6 +308,11 @@ namespace osmscout {
                                 ObjectFileRef& object,
                                 size_t& nodeIndex) const;
 
+    bool GetClosestRoutableSegment(const GeoCoord& coord,
+                                   const Vehicle& vehicle,
+                                   double radius,
+                                   RouteSegmentIndex::Segment& segment) const;
+
     void DumpStatistics();
   };
 
@@ -28,12 +28,18 @@
  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
  */
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
-#include <iostream>
-#include <fstream>
+#include <vector>
 
+#include <osmscout/GeoCoord.h>
+#include <osmscout/Point.h>
 #include <osmscout/Types.h>
 
+#include <osmscout/util/Cache.h>
+
 #define SRTM1_GRID 3601
 #define SRTM3_GRID 1201
 #define SRTM1_FILESIZE (SRTM1_GRID*SRTM1_GRID*2)
@@ -43,29 +49,91 @@ namespace osmscout {
     
     /**
      * Read elevation data in hgt format
+     *
+     * Patches are memory mapped (if supported by the platform, else loaded into memory)
+     * and kept in a LRU cache of limited size, so that queries alternating between
+     * neighbouring patches do not reload the files. All methods are thread safe. A
+     * patch is loaded outside of the cache lock, so loading it only blocks callers
+     * of the same patch.
      */
     class OSMSCOUT_API SRTM
     {
     public:
-        static size_t rows;
-        static size_t columns;
-        static size_t patchSize;
-        
         static const int nodata = -32768;
-        
+
+        static const size_t DEFAULT_CACHE_SIZE = 16; //!< Default number of cached patches
+
+    private:
+        static const size_t INTERPOLATION_BLOCK_SIZE = 64; //!< Number of coordinates interpolated together by the batch kernel
+
+        /**
+         * The heights of one hgt file, stored as big endian 16 bit values
+         * in rows from north to south
+         */
+        struct Patch
+        {
+            size_t                     grid;     //!< Number of rows and columns
+            const unsigned char        *heights; //!< NULL, if there is no data for the patch
+            size_t                     size;
+            void                       *mapping; //!< Memory mapping of the file, NULL if heights points into buffer
+            std::vector<unsigned char> buffer;
+            std::mutex                 loadMutex;
+            std::atomic<bool>          loaded;   //!< Load() has been called and finished
+            std::atomic<bool>          failed;   //!< Loading failed with an I/O error, the patch is reloaded on next access
+
+            Patch();
+            ~Patch();
+
+            bool Load(const std::string& filename);
+            void AssureLoaded(const std::string& filename);
+
+            inline int GetHeight(size_t row, size_t column) const
+            {
+                const unsigned char *height=heights+2*(row*grid+column);
+
+                return (int16_t)((height[0]<<8)|height[1]);
+            }
+        };
+
+        typedef std::shared_ptr<Patch>      PatchRef;
+        typedef Cache<uint32_t,PatchRef>    PatchCache;
+
     private:
         std::string     srtmPath;
-        std::string     currentFilename;
-        std::ifstream   currentFile;
-        int             currentPatchLat;
-        int             currentPatchLon;
-        unsigned char   *heights;
-        
+        std::mutex      cacheMutex;
+        PatchCache      cache;
+
+    private:
+        PatchRef GetPatch(int patchLat, int patchLon);
+
+        static int InterpolateVoidHeight(const int samples[4],
+                                         double fracLat,
+                                         double fracLon);
+
+        static int InterpolateHeight(const Patch& patch,
+                                     int patchLat,
+                                     int patchLon,
+                                     const GeoCoord& coord);
+
+        static void InterpolateHeights(const Patch& patch,
+                                       int patchLat,
+                                       int patchLon,
+                                       const GeoCoord* coords,
+                                       size_t count,
+                                       int* heights);
+
     public:
-        SRTM(const std::string &path);
+        SRTM(const std::string &path,
+             size_t cacheSize=DEFAULT_CACHE_SIZE);
         virtual ~SRTM();
-        const std::string& srtmFilename(int patchLat, int patchLon);
+
+        std::string srtmFilename(int patchLat, int patchLon);
         int heightAtLocation(double latitude, double longitude);
+
+        void heightsAtLocations(const std::vector<GeoCoord>& coords,
+                                std::vector<int>& heights);
+        void heightsAtPoints(const std::vector<Point>& points,
+                             std::vector<int>& heights);
     };
 }
 
@@ -20,11 +20,21 @@
  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
  */
 
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include <osmscout/ObjectRef.h>
 
+#include <osmscout/util/Breaker.h>
 #include <osmscout/util/FileScanner.h>
+#include <osmscout/util/WorkQueue.h>
 
 #include <marisa.h>
 
@@ -42,17 +52,28 @@ namespace osmscout
     static const char* TEXT_LOC_DAT;
     static const char* TEXT_REGION_DAT;
     static const char* TEXT_OTHER_DAT;
+    static const char* TEXT_IMPORTANCE_DAT;
+
+    //! Score penalty for each edit between the query and the matching name
+    static const int DISTANCE_PENALTY=64;
+
+    //! Maximum number of results queued between the trie workers and the callback of a streaming search
+    static const size_t STREAMING_QUEUE_SIZE=1000;
 
   private:
     struct TrieInfo
     {
-      marisa::Trie *trie;
-      std::string  file;
-      bool         isAvail;
+      marisa::Trie         *trie;
+      std::string          file;
+      bool                 isAvail;
+      std::string          alphabet;      //!< Sorted bytes used in the names of the trie
+      std::vector<uint8_t> importance;    //!< Importance of each key, indexed by key id
+      uint8_t              maxImportance; //!< Maximum value of importance
 
       TrieInfo() :
         trie(NULL),
-        isAvail(false)
+        isAvail(false),
+        maxImportance(0)
       {
         // no code
       }
@@ -61,6 +82,91 @@ namespace osmscout
   public:
     typedef std::unordered_map<std::string,std::vector<ObjectFileRef> > ResultsMap;
 
+    /**
+     * A single result of a fuzzy search
+     */
+    struct OSMSCOUT_API ScoredResult
+    {
+      ObjectFileRef object;   //!< The matching object
+      uint8_t       distance; //!< Edit distance between the query and the best matching name prefix
+      int           score;    //!< Importance of the object minus DISTANCE_PENALTY for each edit
+    };
+
+  private:
+    /**
+     * State of a running fuzzy search
+     */
+    struct FuzzySearchState
+    {
+      std::string                          query;
+      size_t                               limit;
+      int                                  maxImportance;
+      std::vector<ScoredResult>            results;  //!< Heap of the best results, worst result first
+      std::vector<std::unordered_set<size_t> > seen; //!< Ids of already collected keys per trie
+    };
+
+  public:
+    /**
+     * A single result of a streaming search
+     */
+    struct OSMSCOUT_API SearchResult
+    {
+      std::string   text;   //!< The matching text
+      ObjectFileRef object; //!< The object the text belongs to
+    };
+
+    /**
+     * Callback receiving the results of a streaming search. Return false to stop
+     * the search.
+     */
+    typedef std::function<bool(const SearchResult& result)> SearchResultCallback;
+
+  private:
+    /**
+     * Bounded queue transporting the results of the trie workers
+     * to the thread running the streaming search
+     */
+    class ResultQueue
+    {
+    private:
+      std::mutex               mutex;
+      std::condition_variable  pushCondition;
+      std::condition_variable  popCondition;
+      std::deque<SearchResult> results;
+      size_t                   queueLimit;
+      size_t                   producerCount; //!< Number of workers still producing results
+      bool                     running;
+
+    public:
+      ResultQueue(size_t queueLimit,
+                  size_t producerCount);
+
+      bool Push(SearchResult& result);
+      void ProducerFinished();
+      bool Pop(SearchResult& result);
+
+      void Stop();
+    };
+
+    /**
+     * Stops the queue of a streaming search and waits for its trie workers on
+     * every exit path of the search, including an exception thrown by the
+     * callback
+     */
+    class SearchGuard
+    {
+    private:
+      ResultQueue&                    queue;
+      std::vector<std::future<bool>>& results;
+
+    public:
+      SearchGuard(ResultQueue& queue,
+                  std::vector<std::future<bool>>& results);
+      ~SearchGuard();
+    };
+
+  public:
+
     TextSearchIndex();
 
     ~TextSearchIndex();
@@ -74,14 +180,60 @@ namespace osmscout
                 bool searchOther,
                 ResultsMap& results) const;
 
+    bool Search(const std::string& query,
+                bool searchPOIs,
+                bool searchLocations,
+                bool searchRegions,
+                bool searchOther,
+                size_t limit,
+                const BreakerRef& breaker,
+                const SearchResultCallback& callback) const;
+
+    bool SearchFuzzy(const std::string& query,
+                     size_t maxDistance,
+                     size_t limit,
+                     bool searchPOIs,
+                     bool searchLocations,
+                     bool searchRegions,
+                     bool searchOther,
+                     std::vector<ScoredResult>& results) const;
+
   private:
+    bool LoadImportance(const std::string& path);
+
+    void StartWorkers() const;
+    void WorkerLoop() const;
+
+    bool SearchTrie(size_t trieIndex,
+                    const std::string& query,
+                    const BreakerRef& breaker,
+                    ResultQueue& queue) const;
+
     void splitSearchResult(const std::string& result,
                            std::string& text,
                            ObjectFileRef& ref) const;
 
+    bool DecodeKey(const marisa::Key& key,
+                   ObjectFileRef& ref) const;
+
+    void SearchFuzzyNode(size_t trieIndex,
+                         std::string& prefix,
+                         const std::vector<size_t>& row,
+                         size_t distance,
+                         FuzzySearchState& state) const;
+
+    void CollectFuzzyMatches(size_t trieIndex,
+                             const std::string& prefix,
+                             size_t distance,
+                             FuzzySearchState& state) const;
+
 
     uint8_t               offsetSizeBytes;  //! size in bytes of FileOffsets stored in the tries
     std::vector<TrieInfo> tries;
+
+    mutable std::once_flag           workersStarted; //!< Workers are started on the first streaming search
+    mutable WorkQueue<bool>          workerQueue;    //!< Trie searches of the streaming searches
+    mutable std::vector<std::thread> workerThreads;  //!< Worker pool, one thread per trie
   };
 }
 
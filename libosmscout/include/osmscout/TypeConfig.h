@@ -38,6 +38,7 @@
 
 #include <osmscout/util/FileScanner.h>
 #include <osmscout/util/FileWriter.h>
+#include <osmscout/util/MemoryArena.h>
 #include <osmscout/util/Progress.h>
 
 #include <osmscout/system/Assert.h>
@@ -953,6 +954,7 @@ namespace osmscout {
     TypeInfoRef type;
     uint8_t     *featureBits;
     char        *featureValueBuffer;
+    MemoryArena *arena;              //!< Arena to take the memory from, if NULL memory is allocated on the heap
 
   private:
     void DeleteData();
@@ -972,10 +974,22 @@ namespace osmscout {
   public:
     FeatureValueBuffer();
     FeatureValueBuffer(const FeatureValueBuffer& other);
+    FeatureValueBuffer(FeatureValueBuffer&& other);
     virtual ~FeatureValueBuffer();
 
     void Set(const FeatureValueBuffer& other);
 
+    /**
+     * Take the memory for feature bits and values from the given arena
+     * instead of the heap. Must be called before the type is set, the arena
+     * must live longer than the buffer. Copies of the buffer use the heap.
+     */
+    inline void SetArena(MemoryArena* arena)
+    {
+      assert(!type);
+      this->arena=arena;
+    }
+
     void SetType(const TypeInfoRef& type);
 
     inline TypeInfoRef GetType() const
@@ -1027,6 +1041,8 @@ namespace osmscout {
     FeatureValue* AllocateValue(size_t idx);
     void FreeValue(size_t idx);
 
+    size_t GetMemoryUsage() const;
+
     void Parse(Progress& progress,
                const TypeConfig& typeConfig,
                const ObjectOSMRef& object,
@@ -1046,11 +1062,12 @@ namespace osmscout {
                bool specialFlag2) const;
 
     FeatureValueBuffer& operator=(const FeatureValueBuffer& other);
+    FeatureValueBuffer& operator=(FeatureValueBuffer&& other);
     bool operator==(const FeatureValueBuffer& other) const;
     bool operator!=(const FeatureValueBuffer& other) const;
   };
 
-  static const uint32_t FILE_FORMAT_VERSION = 6;
+  static const uint32_t FILE_FORMAT_VERSION = 8;
 
   /**
    * \ingroup type
@@ -42,6 +42,27 @@ namespace osmscout {
   public:
     static const char* WATER_IDX;
 
+    static const uint32_t BLOCK_SIZE; //!< Width and height of a block in cells
+
+    /**
+     * Identifies a block of BLOCK_SIZE x BLOCK_SIZE cells of one index level.
+     * Blocks are aligned to the cell grid of the level and can be used as stable
+     * keys for caching ground tiles between different queries.
+     */
+    struct OSMSCOUT_API BlockId
+    {
+      uint32_t level; //!< Index of the level
+      uint32_t x;     //!< Horizontal block number
+      uint32_t y;     //!< Vertical block number
+
+      inline uint64_t GetKey() const
+      {
+        return ((uint64_t)level << 56) |
+               ((uint64_t)x << 28) |
+               (uint64_t)y;
+      }
+    };
+
   private:
     struct Level
     {
@@ -69,6 +90,14 @@ namespace osmscout {
     mutable std::mutex         lookupMutex;
 
   private:
+    uint32_t GetLevelIndex(const Magnification& magnification) const;
+
+    bool ReadCells(uint32_t idx,
+                   uint32_t cx1,
+                   uint32_t cx2,
+                   uint32_t cy1,
+                   uint32_t cy2,
+                   std::list<GroundTile>& tiles) const;
 
   public:
     WaterIndex();
@@ -81,6 +110,13 @@ namespace osmscout {
                     const Magnification& magnification,
                     std::list<GroundTile>& tiles) const;
 
+    void GetBlocks(const GeoBox& boundingBox,
+                   const Magnification& magnification,
+                   std::vector<BlockId>& blocks) const;
+
+    bool GetBlockRegions(const BlockId& block,
+                         std::list<GroundTile>& tiles) const;
+
     void DumpStatistics();
   };
 
@@ -22,7 +22,9 @@
 
 #include <memory>
 
+#include <osmscout/CompactPoints.h>
 #include <osmscout/GeoCoord.h>
+#include <osmscout/ObjectHeader.h>
 #include <osmscout/Point.h>
 #include <osmscout/Tag.h>
 #include <osmscout/TypeConfig.h>
@@ -42,9 +44,13 @@ namespace osmscout {
 
     FileOffset         fileOffset;         //!< Offset into the data file fo this way
 
+  private:
+    void ReadData(const TypeInfoRef& type,
+                  FileScanner& scanner);
 
   public:
-    std::vector<Point> nodes;              //!< List of nodes
+    std::vector<Point> nodes;              //!< List of nodes, empty if the way is compact
+    CompactPoints      compactNodes;       //!< Compact list of nodes, only filled if the way is compact
 
   public:
     inline Way()
@@ -93,46 +99,65 @@ namespace osmscout {
       return featureValueBuffer;
     }
 
+    /**
+     * Return true, if the nodes of the way are stored in compactNodes
+     * instead of nodes (see Compact()).
+     */
+    inline bool IsCompact() const
+    {
+      return !compactNodes.empty();
+    }
+
+    inline size_t GetNodeCount() const
+    {
+      return IsCompact() ? compactNodes.size() : nodes.size();
+    }
+
     inline bool IsCircular() const
     {
-      return nodes[0].GetId()!=0 &&
-             nodes[0].GetId()==nodes[nodes.size()-1].GetId();
+      return GetId(0)!=0 &&
+             GetId(0)==GetId(GetNodeCount()-1);
     }
 
     inline Id GetSerial(size_t index) const
     {
-      return nodes[index].GetSerial();
+      return IsCompact() ? compactNodes.GetSerial(index) : nodes[index].GetSerial();
     }
 
     inline Id GetId(size_t index) const
     {
-      return nodes[index].GetId();
+      return IsCompact() ? compactNodes.GetId(index) : nodes[index].GetId();
     }
 
     inline Id GetFrontId() const
     {
-      return nodes.front().GetId();
+      return GetId(0);
     }
 
     inline Id GetBackId() const
     {
-      return nodes.back().GetId();
+      return GetId(GetNodeCount()-1);
     }
 
-    inline const Point& GetPoint(size_t index) const
+    inline Point GetPoint(size_t index) const
     {
-      return nodes[index];
+      return IsCompact() ? compactNodes.GetPoint(index) : nodes[index];
     }
 
-    inline const GeoCoord& GetCoord(size_t index) const
+    inline GeoCoord GetCoord(size_t index) const
     {
-      return nodes[index].GetCoord();
+      return IsCompact() ? compactNodes.GetCoord(index) : nodes[index].GetCoord();
     }
 
     inline void GetBoundingBox(GeoBox& boundingBox) const
     {
-      osmscout::GetBoundingBox(nodes,
-                               boundingBox);
+      if (IsCompact()) {
+        compactNodes.GetBoundingBox(boundingBox);
+      }
+      else {
+        osmscout::GetBoundingBox(nodes,
+                                 boundingBox);
+      }
     }
 
     bool GetCenter(GeoCoord& center) const;
@@ -140,6 +165,18 @@ namespace osmscout {
     bool GetNodeIndexByNodeId(Id id,
                               size_t& index) const;
 
+    void Compact();
+    void Expand();
+
+    /**
+     * Take the memory for the feature values from the given arena, see
+     * FeatureValueBuffer::SetArena(). Must be called before reading.
+     */
+    inline void SetArena(MemoryArena* arena)
+    {
+      featureValueBuffer.SetArena(arena);
+    }
+
     inline void SetType(const TypeInfoRef& type)
     {
       featureValueBuffer.SetType(type);
@@ -152,7 +189,14 @@ namespace osmscout {
 
     void SetLayerToMax();
 
+    static void ReadHeader(const TypeConfig& typeConfig,
+                           FileScanner& scanner,
+                           ObjectHeader& header);
+
+    void Read(const TypeConfig& typeConfig,
+              FileScanner& scanner);
     void Read(const TypeConfig& typeConfig,
+              const ObjectHeader& header,
               FileScanner& scanner);
     void ReadOptimized(const TypeConfig& typeConfig,
                        FileScanner& scanner);
@@ -36,6 +36,9 @@ namespace osmscout {
     static const char* WAYS_DAT;
     static const char* WAYS_IDMAP;
 
+  protected:
+    size_t GetValueMemory(const Way& way) const;
+
   public:
     WayDataFile();
   };
@@ -114,6 +114,9 @@ namespace osmscout {
     OrderList order;
     Map       map;
     CacheRef  previousEntry;
+    size_t    hits;      //!< Number of successful lookups
+    size_t    misses;    //!< Number of failed lookups
+    size_t    evictions; //!< Number of entries removed because of the size limit
 
   private:
 
@@ -140,6 +143,7 @@ namespace osmscout {
         previousEntry=order.end();
 
         size--;
+        evictions++;
       }
     }
 
@@ -149,7 +153,10 @@ namespace osmscout {
       */
     Cache(size_t maxSize)
      : size(0),
-       maxSize(maxSize)
+       maxSize(maxSize),
+       hits(0),
+       misses(0),
+       evictions(0)
     {
       map.reserve(maxSize);
       previousEntry=order.end();
@@ -183,6 +190,7 @@ namespace osmscout {
       if (previousEntry!=order.end() &&
           previousEntry->key==key) {
         reference=previousEntry;
+        hits++;
         return true;
       }
 
@@ -197,10 +205,13 @@ namespace osmscout {
 
         reference=order.begin();
         previousEntry=reference;
+        hits++;
 
         return true;
       }
 
+      misses++;
+
       return false;
     }
 
@@ -258,6 +269,30 @@ namespace osmscout {
       map.reserve(maxSize);
     }
 
+    /**
+     * Returns the number of successful lookups via GetEntry()
+     */
+    size_t GetHits() const
+    {
+      return hits;
+    }
+
+    /**
+     * Returns the number of failed lookups via GetEntry()
+     */
+    size_t GetMisses() const
+    {
+      return misses;
+    }
+
+    /**
+     * Returns the number of entries removed because of the size limit
+     */
+    size_t GetEvictions() const
+    {
+      return evictions;
+    }
+
     /**
      * Returns the maximum size of the cache
      */
@@ -274,6 +309,7 @@ namespace osmscout {
       order.clear();
       map.clear();
       size=0;
+      previousEntry=order.end();
     }
 
     /**
@@ -0,0 +1,407 @@
+#ifndef OSMSCOUT_UTIL_CONCURRENTCACHE_H
+#define OSMSCOUT_UTIL_CONCURRENTCACHE_H
+
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2016  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include <osmscout/system/Assert.h>
+
+namespace osmscout {
+
+  /**
+   * \ingroup Util
+   *
+   * Thread-safe LRU cache limited by the overall size of its values.
+   *
+   * In contrast to Cache the entries are distributed over a number of
+   * shards by the hash of their key. Each shard has its own mutex, hash map
+   * and LRU list, so that threads accessing different keys rarely block
+   * each other. The LRU list is intrusive (the list links are part of the
+   * hash map entries), so lookup, insertion, update and eviction are O(1)
+   * without additional allocations.
+   *
+   * Each entry is charged by the size returned by the sizer (by default 1,
+   * which limits the number of entries). The maximum size is split between
+   * the shards, each shard evicts its least recently used entries until it
+   * fits into its share. The number of shards is reduced for small maximum
+   * sizes, so that each shard can hold at least one unit.
+   *
+   * Values are returned as copies, since a reference into the cache could
+   * be invalidated by another thread at any time. V should thus be cheap
+   * to copy, e.g. a std::shared_ptr.
+   *
+   * Hit, miss and eviction counters are atomic and updated without locking.
+   */
+  template <class K, class V, class H = std::hash<K>>
+  class ConcurrentCache
+  {
+  public:
+    typedef std::function<size_t(const V& value)> Sizer;
+
+  private:
+    struct Entry
+    {
+      V      value;
+      size_t size;     //!< Size charged for the value
+      K      key;
+      Entry* previous; //!< Next more recently used entry
+      Entry* next;     //!< Next less recently used entry
+    };
+
+    typedef std::unordered_map<K,Entry,H> Map;
+
+    struct Shard
+    {
+      std::mutex mutex;
+      Map        map;
+      Entry*     first;   //!< Most recently used entry
+      Entry*     last;    //!< Least recently used entry
+      size_t     size;    //!< Overall size of all values in the shard
+      size_t     maxSize; //!< Maximum size of the values in the shard
+
+      Shard()
+      : first(NULL),
+        last(NULL),
+        size(0),
+        maxSize(0)
+      {
+        // no code
+      }
+    };
+
+  private:
+    std::unique_ptr<Shard[]> shards;
+    size_t                   shardMask; //!< Number of shards - 1
+    size_t                   maxSize;   //!< Maximum overall size of the values
+    Sizer                    sizer;
+    H                        hasher;
+    std::atomic<size_t>      hits;      //!< Number of successful lookups
+    std::atomic<size_t>      misses;    //!< Number of failed lookups
+    std::atomic<size_t>      evictions; //!< Number of entries removed because of the size limit
+
+  private:
+    inline Shard& GetShard(const K& key) const
+    {
+      // Multiplicative hashing, since std::hash of integers is the identity and
+      // keys like file offsets often share their lower bits
+      uint64_t hash=(uint64_t)hasher(key)*UINT64_C(0x9E3779B97F4A7C15);
+
+      return shards[(size_t)(hash >> 32) & shardMask];
+    }
+
+    static void Unlink(Shard& shard,
+                       Entry& entry)
+    {
+      if (entry.previous!=NULL) {
+        entry.previous->next=entry.next;
+      }
+      else {
+        shard.first=entry.next;
+      }
+
+      if (entry.next!=NULL) {
+        entry.next->previous=entry.previous;
+      }
+      else {
+        shard.last=entry.previous;
+      }
+    }
+
+    static void PushFront(Shard& shard,
+                          Entry& entry)
+    {
+      entry.previous=NULL;
+      entry.next=shard.first;
+
+      if (shard.first!=NULL) {
+        shard.first->previous=&entry;
+      }
+      else {
+        shard.last=&entry;
+      }
+
+      shard.first=&entry;
+    }
+
+    /**
+     * Remove the least recently used entries from the shard until its
+     * values fit into the maximum size of the shard. The given entry is kept.
+     */
+    void StripShard(Shard& shard,
+                    const Entry* keep)
+    {
+      while (shard.size>shard.maxSize &&
+             shard.last!=NULL &&
+             shard.last!=keep) {
+        Entry* entry=shard.last;
+
+        Unlink(shard,*entry);
+        shard.size-=entry->size;
+        shard.map.erase(entry->key);
+
+        evictions.fetch_add(1,std::memory_order_relaxed);
+      }
+    }
+
+    static size_t DefaultSize(const V& /*value*/)
+    {
+      return 1;
+    }
+
+    /**
+     * Halve the given shard count until each shard gets at least one unit
+     * of the maximum size
+     */
+    static size_t GetShardCount(size_t maxSize,
+                                size_t shardCount)
+    {
+      while (shardCount>1 &&
+             shardCount>maxSize) {
+        shardCount/=2;
+      }
+
+      return shardCount;
+    }
+
+  public:
+    /**
+     * Create a cache with the given maximum overall size of its values, as
+     * returned by the sizer. The shard count must be a power of two, it is
+     * reduced if the maximum size is smaller.
+     */
+    explicit ConcurrentCache(size_t maxSize,
+                             const Sizer& sizer=DefaultSize,
+                             size_t shardCount=16)
+    : shards(new Shard[GetShardCount(maxSize,shardCount)]),
+      shardMask(GetShardCount(maxSize,shardCount)-1),
+      maxSize(maxSize),
+      sizer(sizer),
+      hits(0),
+      misses(0),
+      evictions(0)
+    {
+      assert(shardCount>0 && (shardCount & (shardCount-1))==0);
+
+      // The remainder is distributed over the first shards, so that the
+      // limits of all shards add up to maxSize
+      size_t count=shardMask+1;
+
+      for (size_t s=0; s<count; s++) {
+        shards[s].maxSize=maxSize/count+(s<maxSize%count ? 1 : 0);
+      }
+    }
+
+    ConcurrentCache(const ConcurrentCache& other) = delete;
+    ConcurrentCache& operator=(const ConcurrentCache& other) = delete;
+
+    /**
+     * Returns if the cache is active (maxSize > 0)
+     */
+    inline bool IsActive() const
+    {
+      return maxSize>0;
+    }
+
+    /**
+     * Copy the value stored for the given key to value and mark it as
+     * recently used. Returns false (leaving value untouched) if there is no
+     * such entry.
+     */
+    bool GetEntry(const K& key,
+                  V& value)
+    {
+      if (!IsActive()) {
+        return false;
+      }
+
+      Shard&                      shard=GetShard(key);
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      auto                        iter=shard.map.find(key);
+
+      if (iter==shard.map.end()) {
+        misses.fetch_add(1,std::memory_order_relaxed);
+
+        return false;
+      }
+
+      Entry& entry=iter->second;
+
+      if (shard.first!=&entry) {
+        Unlink(shard,entry);
+        PushFront(shard,entry);
+      }
+
+      value=entry.value;
+
+      hits.fetch_add(1,std::memory_order_relaxed);
+
+      return true;
+    }
+
+    /**
+     * Store the value for the given key, replacing an existing value, and
+     * mark it as recently used. Evicts the least recently used entries of
+     * the same shard if its size limit is exceeded. A value larger than the
+     * limit of a shard is kept until the next insertion into the shard.
+     */
+    void SetEntry(const K& key,
+                  const V& value)
+    {
+      if (!IsActive()) {
+        return;
+      }
+
+      size_t                      size=sizer(value);
+      Shard&                      shard=GetShard(key);
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      auto                        result=shard.map.emplace(key,Entry());
+      Entry&                      entry=result.first->second;
+
+      if (result.second) {
+        entry.key=key;
+      }
+      else {
+        Unlink(shard,entry);
+        shard.size-=entry.size;
+      }
+
+      entry.value=value;
+      entry.size=size;
+      shard.size+=size;
+
+      PushFront(shard,entry);
+      StripShard(shard,&entry);
+    }
+
+    /**
+     * Remove the entry with the given key, if it exists
+     */
+    void Remove(const K& key)
+    {
+      Shard&                      shard=GetShard(key);
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      auto                        iter=shard.map.find(key);
+
+      if (iter!=shard.map.end()) {
+        Unlink(shard,iter->second);
+        shard.size-=iter->second.size;
+        shard.map.erase(iter);
+      }
+    }
+
+    /**
+     * Remove all entries from the cache
+     */
+    void Flush()
+    {
+      for (size_t s=0; s<=shardMask; s++) {
+        Shard&                      shard=shards[s];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        shard.map.clear();
+        shard.first=NULL;
+        shard.last=NULL;
+        shard.size=0;
+      }
+    }
+
+    /**
+     * Returns the maximum overall size of the values
+     */
+    inline size_t GetMaxSize() const
+    {
+      return maxSize;
+    }
+
+    /**
+     * Returns the number of entries in the cache
+     */
+    size_t GetEntryCount() const
+    {
+      size_t count=0;
+
+      for (size_t s=0; s<=shardMask; s++) {
+        std::lock_guard<std::mutex> lock(shards[s].mutex);
+
+        count+=shards[s].map.size();
+      }
+
+      return count;
+    }
+
+    /**
+     * Returns the overall size of the values in the cache
+     */
+    size_t GetSize() const
+    {
+      size_t size=0;
+
+      for (size_t s=0; s<=shardMask; s++) {
+        std::lock_guard<std::mutex> lock(shards[s].mutex);
+
+        size+=shards[s].size;
+      }
+
+      return size;
+    }
+
+    /**
+     * Returns the number of successful lookups via GetEntry()
+     */
+    inline size_t GetHits() const
+    {
+      return hits.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Returns the number of failed lookups via GetEntry()
+     */
+    inline size_t GetMisses() const
+    {
+      return misses.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Returns the number of entries removed because of the size limit
+     */
+    inline size_t GetEvictions() const
+    {
+      return evictions.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Dump some cache statistics to std::cout
+     */
+    void DumpStatistics(const char* cacheName) const
+    {
+      std::cout << cacheName << " entries: " << GetEntryCount() << ", size " << GetSize() << "/" << maxSize;
+      std::cout << ", hits " << GetHits() << ", misses " << GetMisses() << ", evictions " << GetEvictions() << std::endl;
+    }
+  };
+}
+
+#endif
@@ -67,6 +67,17 @@ namespace osmscout {
       Normal
     };
 
+    /**
+     * Implementation used for decoding delta encoded coordinates
+     */
+    enum DeltaDecoder
+    {
+      decoderAuto   = 0, //!< Select the fastest decoder supported by the CPU at runtime
+      decoderScalar = 1, //!< Plain C++ implementation
+      decoderSSE4   = 2, //!< Decodes two coordinates at once using SSE4.1 instructions
+      decoderAVX2   = 3  //!< Decodes four coordinates at once using AVX2 instructions
+    };
+
   private:
     std::string          filename;       //!< Filename
     std::FILE            *file;          //!< Internal low level file handle
@@ -77,9 +88,14 @@ namespace osmscout {
     FileOffset           size;           //!< Size of the memory/file
     FileOffset           offset;         //!< Current offset into the file memory
 
+    // For reading from a range of the file in memory
+    bool                 memoryBuffer;   //!< The buffer is a range of the file read into memory, not a mapping
+    FileOffset           bufferOffset;   //!< File offset of the first byte of the buffer
+
     // For std::vector<GeoCoord> loading
     uint8_t              *byteBuffer;    //!< Temporary buffer for loading of std::vector<GeoCoord>
     size_t               byteBufferSize; //!< Size of the temporary byte buffer
+    DeltaDecoder         deltaDecoder;   //!< Decoder to use for delta encoded coordinates
 
     // For Windows mmap usage
 #if defined(__WIN32__) || defined(WIN32)
@@ -97,19 +113,50 @@ namespace osmscout {
     void Open(const std::string& filename,
               Mode mode,
               bool useMmap);
+    void Open(const std::string& filename,
+              FileOffset offset,
+              char* data,
+              size_t size);
+    void Open(const FileScanner& scanner,
+              Mode mode);
     void Close();
     void CloseFailsafe();
 
+    static bool IsDeltaDecoderSupported(DeltaDecoder decoder);
+
+    void SetDeltaDecoder(DeltaDecoder decoder);
+
+    inline DeltaDecoder GetDeltaDecoder() const
+    {
+      return deltaDecoder;
+    }
+
     inline bool IsOpen() const
     {
-      return file!=NULL;
+      return file!=NULL || memoryBuffer;
+    }
+
+    /**
+     * Returns true, if the file is accessed via a memory mapping
+     */
+    inline bool IsMemoryMapped() const
+    {
+      return buffer!=NULL && !memoryBuffer;
+    }
+
+    /**
+     * Returns the size of the file (or of the range of the file in memory)
+     */
+    inline FileOffset GetSize() const
+    {
+      return size;
     }
 
     bool IsEOF() const;
 
     inline  bool HasError() const
     {
-      return file==NULL || hasError;
+      return !IsOpen() || hasError;
     }
 
     std::string GetFilename() const;
@@ -118,7 +165,15 @@ namespace osmscout {
     void SetPos(FileOffset pos);
     FileOffset GetPos() const;
 
+    void Prefetch(FileOffset pos,
+                  FileOffset bytes) const;
+
+    bool Lock() const;
+
     void Read(char* buffer, size_t bytes);
+    void ReadAt(FileOffset pos,
+                char* buffer,
+                size_t bytes);
 
     void Read(std::string& value);
 
@@ -159,6 +214,7 @@ namespace osmscout {
     void Read(std::vector<Point>& nodes, bool readIds);
 
     void ReadBox(GeoBox& box);
+    void ReadCompactBox(GeoBox& box);
 
     void ReadTypeId(TypeId& id,
                     uint8_t maxBytes);
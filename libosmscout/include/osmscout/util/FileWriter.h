@@ -34,6 +34,7 @@
 #include <osmscout/Types.h>
 
 #include <osmscout/util/Exception.h>
+#include <osmscout/util/GeoBox.h>
 
 namespace osmscout {
 
@@ -47,27 +48,42 @@ namespace osmscout {
   class OSMSCOUT_API FileWriter
   {
   private:
-    std::string          filename;    //!< The filename
-    std::FILE            *file;       //!< The low level FILE object
-    bool                 hasError;    //!< Flag for signaling that the stream has errors
-    std::vector<int32_t> deltaBuffer; //!< Temporary storage for deltas for storing of std::vector<GeoCoord>
-    std::vector<uint8_t> byteBuffer;  //!< Temporary data buffer for storing of std::vector<GeoCoord>
+    std::string          filename;     //!< The filename
+    std::FILE            *file;        //!< The low level FILE object
+    bool                 hasError;     //!< Flag for signaling that the stream has errors
+    bool                 memoryBuffer; //!< Data is written to memory, not to a file
+    std::vector<char>    memory;       //!< The data written, if writing to memory
+    size_t               memoryPos;    //!< Current position in the memory buffer
+    std::vector<int32_t> deltaBuffer;  //!< Temporary storage for deltas for storing of std::vector<GeoCoord>
+    std::vector<uint8_t> byteBuffer;   //!< Temporary data buffer for storing of std::vector<GeoCoord>
+
+  private:
+    bool WriteData(const void* data, size_t bytes);
 
   public:
     FileWriter();
     virtual ~FileWriter();
 
     void Open(const std::string& filename);
+    void OpenMemory();
     void Close();
     void CloseFailsafe();
     inline bool IsOpen() const
     {
-      return file!=NULL;
+      return file!=NULL || memoryBuffer;
     }
 
     inline bool HasError() const
     {
-      return file==NULL || hasError;
+      return (file==NULL && !memoryBuffer) || hasError;
+    }
+
+    /**
+     * Return the data written so far, if writing to memory
+     */
+    inline const std::vector<char>& GetMemory() const
+    {
+      return memory;
     }
 
     std::string GetFilename() const;
@@ -112,6 +128,7 @@ namespace osmscout {
 
     void WriteCoord(const GeoCoord& coord);
     void WriteInvalidCoord();
+    void WriteCompactBox(const GeoBox& box);
 
     void Write(const std::vector<Point>& nodes, bool writeIds);
 
@@ -813,6 +813,19 @@ namespace osmscout {
   extern OSMSCOUT_API double GetSphericalDistance(const GeoCoord& a,
                                                   const GeoCoord& b);
 
+  /**
+   * \ingroup Geometry
+   * Calculates the point on the line segment a-b that is nearest to p and returns
+   * the spherical distance between p and this point in km. In contrast to
+   * CalculateDistancePointToLineSegment() the point is projected in a local metric
+   * frame around p (longitudes scaled by the cosine of the latitude), so that the
+   * result is also correct at higher latitudes.
+   */
+  extern OSMSCOUT_API double GetSphericalDistanceToLineSegment(const GeoCoord& p,
+                                                               const GeoCoord& a,
+                                                               const GeoCoord& b,
+                                                               GeoCoord& nearest);
+
   /**
    * \ingroup Geometry
    * Calculates the ellipsoidal (WGS-84) distance between the two given points
@@ -0,0 +1,146 @@
+#ifndef OSMSCOUT_UTIL_MEMORYARENA_H
+#define OSMSCOUT_UTIL_MEMORYARENA_H
+
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2016  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <osmscout/private/CoreImportExport.h>
+
+namespace osmscout {
+
+  /**
+   * \ingroup Util
+   *
+   * Simple bump allocator. Memory is taken from larger chunks by just
+   * moving a pointer forward, single allocations cannot be freed. All
+   * memory is released at once on destruction of the arena.
+   *
+   * Useful for a large number of small objects with the same lifetime, like
+   * the objects loaded for one tile.
+   *
+   * The arena is not thread-safe.
+   */
+  class OSMSCOUT_API MemoryArena
+  {
+  private:
+    size_t             chunkSize;     //!< Size of a standard chunk
+    std::vector<char*> chunks;        //!< All allocated chunks
+    char*              current;       //!< Start of the free space in the current chunk
+    size_t             available;     //!< Number of free bytes in the current chunk
+    size_t             allocated;     //!< Overall number of bytes handed out
+
+  public:
+    static const size_t DEFAULT_CHUNK_SIZE;
+
+  public:
+    explicit MemoryArena(size_t chunkSize=DEFAULT_CHUNK_SIZE);
+    ~MemoryArena();
+
+    MemoryArena(const MemoryArena& other) = delete;
+    MemoryArena& operator=(const MemoryArena& other) = delete;
+
+    void* Allocate(size_t size,
+                   size_t alignment=alignof(std::max_align_t));
+
+    /**
+     * Return the number of bytes handed out by the arena
+     */
+    inline size_t GetAllocatedBytes() const
+    {
+      return allocated;
+    }
+
+    /**
+     * Return the number of chunks allocated by the arena
+     */
+    inline size_t GetChunkCount() const
+    {
+      return chunks.size();
+    }
+  };
+
+  typedef std::shared_ptr<MemoryArena> MemoryArenaRef;
+
+  /**
+   * \ingroup Util
+   *
+   * Standard library allocator taking its memory from a MemoryArena.
+   * Deallocation is a no-op.
+   *
+   * The allocator holds a reference to the arena, so the arena is kept
+   * alive as long as any object allocated via std::allocate_shared() using
+   * this allocator exists.
+   */
+  template<typename T>
+  class ArenaAllocator
+  {
+  public:
+    typedef T value_type;
+
+  private:
+    MemoryArenaRef arena;
+
+    template<typename U>
+    friend class ArenaAllocator;
+
+  public:
+    explicit ArenaAllocator(const MemoryArenaRef& arena)
+    : arena(arena)
+    {
+      // no code
+    }
+
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other)
+    : arena(other.arena)
+    {
+      // no code
+    }
+
+    inline T* allocate(size_t n)
+    {
+      return static_cast<T*>(arena->Allocate(n*sizeof(T),
+                                             alignof(T)));
+    }
+
+    inline void deallocate(T* /*p*/,
+                           size_t /*n*/)
+    {
+      // no code
+    }
+
+    template<typename U>
+    inline bool operator==(const ArenaAllocator<U>& other) const
+    {
+      return arena==other.arena;
+    }
+
+    template<typename U>
+    inline bool operator!=(const ArenaAllocator<U>& other) const
+    {
+      return arena!=other.arena;
+    }
+  };
+}
+
+#endif
@@ -23,6 +23,7 @@
 #include <osmscout/private/CoreImportExport.h>
 
 #include <osmscout/GeoCoord.h>
+#include <osmscout/Point.h>
 
 #include <osmscout/util/GeoBox.h>
 #include <osmscout/util/Magnification.h>
@@ -299,6 +300,23 @@ namespace osmscout {
     virtual void GeoToPixel(const GeoCoord& coord,
                             double& x, double& y) const = 0;
 
+    /**
+     * Converts the given count geo coordinates to pixel coordinates and returns
+     * the bounding box of the resulting pixel coordinates.
+     *
+     * The pixel coordinate of node i is written to the double at x (and y)
+     * plus i*stride bytes, allowing to directly fill an array of structures.
+     *
+     * The default implementation transforms using a BatchTransformer.
+     */
+    virtual void BatchGeoToPixel(const Point* nodes,
+                                 size_t count,
+                                 double* x,
+                                 double* y,
+                                 size_t stride,
+                                 double& xMin, double& yMin,
+                                 double& xMax, double& yMax) const;
+
   protected:
     virtual void GeoToPixel(const BatchTransformer& transformData) const = 0;
 
@@ -419,6 +437,17 @@ namespace osmscout {
    */
   class OSMSCOUT_API MercatorProjection : public Projection
   {
+  public:
+    /**
+     * Implementation used by BatchGeoToPixel()
+     */
+    enum BatchKernel
+    {
+      kernelAuto   = 0, //!< Select the fastest kernel supported by the CPU at runtime
+      kernelScalar = 1, //!< Plain C++ implementation, identical to GeoToPixel()
+      kernelAVX2   = 2  //!< Transforms four coordinates at once using AVX2 instructions
+    };
+
   protected:
     bool   valid;          //!< projection is valid
 
@@ -431,9 +460,20 @@ namespace osmscout {
     double scale;
     double scaleGradtorad; //!< Precalculated scale*Gradtorad
 
+    BatchKernel batchKernel; //!< Kernel to use for BatchGeoToPixel()
+
   public:
     MercatorProjection();
 
+    static bool IsBatchKernelSupported(BatchKernel kernel);
+
+    void SetBatchKernel(BatchKernel kernel);
+
+    inline BatchKernel GetBatchKernel() const
+    {
+      return batchKernel;
+    }
+
     inline bool CanBatch() const
     {
       return false;
@@ -482,6 +522,14 @@ namespace osmscout {
     void GeoToPixel(const GeoCoord& coord,
                     double& x, double& y) const;
 
+    void BatchGeoToPixel(const Point* nodes,
+                         size_t count,
+                         double* x,
+                         double* y,
+                         size_t stride,
+                         double& xMin, double& yMin,
+                         double& xMax, double& yMax) const;
+
     bool Move(double horizPixel,
               double vertPixel);
 
@@ -372,6 +372,17 @@ namespace osmscout {
    */
   extern OSMSCOUT_API void SimplifyTokenList(std::list<std::string>& tokens);
 
+  /**
+   * \ingroup Util
+   * Converts the given UTF-8 string to lower case in place. Beside ASCII
+   * characters the upper case letters of the Latin-1 supplement (U+00C0 to
+   * U+00DE) are converted, too.
+   *
+   * This is the normalisation used for name matching in the location index
+   * and the location service.
+   */
+  extern OSMSCOUT_API void TolowerUmlaut(std::string& s);
+
   /**
    * \ingroup Util
    * Given a list of strings, individual strings will be combined into a given
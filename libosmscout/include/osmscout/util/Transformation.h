@@ -28,6 +28,7 @@
 
 #include <osmscout/private/CoreImportExport.h>
 
+#include <osmscout/CompactPoints.h>
 #include <osmscout/GeoCoord.h>
 #include <osmscout/Pixel.h>
 
@@ -45,10 +46,29 @@ namespace osmscout {
   class OSMSCOUT_API TransPolygon
   {
   private:
+    /**
+     * Range of drawn points still to be simplified by the Douglas-Peucker algorithm
+     */
+    struct SimplifySegment
+    {
+      size_t begin;      //!< Position of the first point of the line segment
+      size_t end;        //!< Position after the last point to check
+      size_t endValue;   //!< Position of the last point of the line segment
+    };
+
     size_t  pointsSize;
     size_t  length;
     size_t  start;
     size_t  end;
+    bool    optimized; //!< Points may have been dropped since transformation
+    double  xMin;      //!< Bounding box of all transformed points
+    double  yMin;
+    double  xMax;
+    double  yMax;
+
+    std::vector<size_t>          drawn;           //!< Indexes of the currently drawn points, reused between calls
+    std::vector<SimplifySegment> simplifyStack;   //!< Work stack of the Douglas-Peucker algorithm, reused between calls
+    std::vector<Point>           pointBlock;      //!< Block of decoded compact points, reused between calls
 
   public:
     enum OptimizeMethod
@@ -69,11 +89,36 @@ namespace osmscout {
     TransPoint* points;
 
   private:
+    const Point* GetPointBlock(const std::vector<Point>& nodes,
+                               size_t start,
+                               size_t count);
+    const Point* GetPointBlock(const CompactPoints& nodes,
+                               size_t start,
+                               size_t count);
+    template<class N>
     void TransformGeoToPixel(const Projection& projection,
-                             const std::vector<Point>& nodes);
-    void DropSimilarPoints(double optimizeErrorTolerance);
+                             const N& nodes,
+                             bool dropSimilarPoints,
+                             double optimizeErrorTolerance);
+    template<class N>
+    void TransformAreaNodes(const Projection& projection,
+                            OptimizeMethod optimize,
+                            const N& nodes,
+                            double optimizeErrorTolerance);
+    template<class N>
+    void TransformWayNodes(const Projection& projection,
+                           OptimizeMethod optimize,
+                           const N& nodes,
+                           double optimizeErrorTolerance);
+    void CollectDrawnPoints();
+    void DropOffscreenPoints(const Projection& projection);
     void DropRedundantPointsFast(double optimizeErrorTolerance);
     void DropRedundantPointsDouglasPeucker(double optimizeErrorTolerance, bool isArea);
+    void SimplifyDouglasPeucker(size_t begin,
+                                size_t end,
+                                size_t endValue,
+                                double optimizeErrorToleranceSquared);
+    void CalculateRange(size_t nodeCount);
 
   public:
     TransPolygon();
@@ -103,11 +148,19 @@ namespace osmscout {
                        OptimizeMethod optimize,
                        const std::vector<Point>& nodes,
                        double optimizeErrorTolerance);
+    void TransformArea(const Projection& projection,
+                       OptimizeMethod optimize,
+                       const CompactPoints& nodes,
+                       double optimizeErrorTolerance);
 
     void TransformWay(const Projection& projection,
                       OptimizeMethod optimize,
                       const std::vector<Point>& nodes,
                       double optimizeErrorTolerance);
+    void TransformWay(const Projection& projection,
+                      OptimizeMethod optimize,
+                      const CompactPoints& nodes,
+                      double optimizeErrorTolerance);
 
     bool GetBoundingBox(double& xmin, double& ymin,
                         double& xmax, double& ymax) const;
@@ -321,6 +374,9 @@ namespace osmscout {
     TransPolygon transPolygon;
     CoordBuffer *buffer;
 
+  private:
+    void PushDrawnPoints(size_t& start, size_t &end);
+
   public:
     TransBuffer(CoordBuffer* buffer);
     virtual ~TransBuffer();
@@ -332,11 +388,21 @@ namespace osmscout {
                        const std::vector<Point>& nodes,
                        size_t& start, size_t &end,
                        double optimizeErrorTolerance);
+    void TransformArea(const Projection& projection,
+                       TransPolygon::OptimizeMethod optimize,
+                       const CompactPoints& nodes,
+                       size_t& start, size_t &end,
+                       double optimizeErrorTolerance);
     bool TransformWay(const Projection& projection,
                       TransPolygon::OptimizeMethod optimize,
                       const std::vector<Point>& nodes,
                       size_t& start, size_t &end,
                       double optimizeErrorTolerance);
+    bool TransformWay(const Projection& projection,
+                      TransPolygon::OptimizeMethod optimize,
+                      const CompactPoints& nodes,
+                      size_t& start, size_t &end,
+                      double optimizeErrorTolerance);
   };
 }
 
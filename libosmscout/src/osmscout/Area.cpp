@@ -22,6 +22,7 @@
 #include <algorithm>
 #include <limits>
 
+#include <osmscout/util/Number.h>
 #include <osmscout/util/String.h>
 
 #include <osmscout/system/Math.h>
@@ -44,42 +45,27 @@ namespace osmscout {
 
   bool Area::Ring::GetCenter(GeoCoord& center) const
   {
-    double minLat=0.0;
-    double minLon=0.0;
-    double maxLat=0.0;
-    double maxLon=0.0;
-
-    bool start=true;
-
-    for (size_t j=0; j<nodes.size(); j++) {
-      if (start) {
-        minLat=nodes[j].GetLat();
-        minLon=nodes[j].GetLon();
-        maxLat=nodes[j].GetLat();
-        maxLon=nodes[j].GetLon();
-
-        start=false;
-      }
-      else {
-        minLat=std::min(minLat,nodes[j].GetLat());
-        minLon=std::min(minLon,nodes[j].GetLon());
-        maxLat=std::max(maxLat,nodes[j].GetLat());
-        maxLon=std::max(maxLon,nodes[j].GetLon());
-      }
-    }
-
-    if (start) {
+    if (GetNodeCount()==0) {
       return false;
     }
 
-    center.Set(minLat+(maxLat-minLat)/2,
-               minLon+(maxLon-minLon)/2);
+    GeoBox boundingBox;
+
+    GetBoundingBox(boundingBox);
+
+    center.Set(boundingBox.GetMinLat()+(boundingBox.GetMaxLat()-boundingBox.GetMinLat())/2,
+               boundingBox.GetMinLon()+(boundingBox.GetMaxLon()-boundingBox.GetMinLon())/2);
 
     return true;
   }
 
   void Area::Ring::GetBoundingBox(GeoBox& boundingBox) const
   {
+    if (IsCompact()) {
+      compactNodes.GetBoundingBox(boundingBox);
+      return;
+    }
+
     assert(!nodes.empty());
 
     double minLon=nodes[0].GetLon();
@@ -102,42 +88,18 @@ namespace osmscout {
   {
     assert(!rings.empty());
 
-    double minLat=0.0;
-    double minLon=0.0;
-    double maxLat=0.0;
-    double maxLon=0.0;
-
-    bool start=true;
+    GeoBox boundingBox;
 
-    for (const auto& ring : rings) {
-      if (ring.IsOuterRing()) {
-        for (size_t j=0; j<ring.nodes.size(); j++) {
-          if (start) {
-            minLat=ring.nodes[j].GetLat();
-            maxLat=minLat;
-            minLon=ring.nodes[j].GetLon();
-            maxLon=minLon;
-
-            start=false;
-          }
-          else {
-            minLat=std::min(minLat,ring.nodes[j].GetLat());
-            minLon=std::min(minLon,ring.nodes[j].GetLon());
-            maxLat=std::max(maxLat,ring.nodes[j].GetLat());
-            maxLon=std::max(maxLon,ring.nodes[j].GetLon());
-          }
-        }
-      }
-    }
+    GetBoundingBox(boundingBox);
 
-    assert(!start);
+    assert(boundingBox.IsValid());
 
-    if (start) {
+    if (!boundingBox.IsValid()) {
       return false;
     }
 
-    center.Set(minLat+(maxLat-minLat)/2,
-               minLon+(maxLon-minLon)/2);
+    center.Set(boundingBox.GetMinLat()+(boundingBox.GetMaxLat()-boundingBox.GetMinLat())/2,
+               boundingBox.GetMinLon()+(boundingBox.GetMaxLon()-boundingBox.GetMinLon())/2);
 
     return true;
   }
@@ -163,26 +125,58 @@ namespace osmscout {
   }
 
   /**
-   * Reads data from the given Filescanner. Node ids will only be read
-   * if not thought to be required for this area.
+   * Move the nodes of all rings into the compact fixed-point representation
+   * (see CompactPoints and Way::Compact()). Compact areas cannot be written,
+   * call Expand() before.
+   */
+  void Area::Compact()
+  {
+    for (auto& ring : rings) {
+      if (ring.IsCompact() ||
+          ring.nodes.empty()) {
+        continue;
+      }
+
+      ring.compactNodes.Set(ring.nodes);
+      std::vector<Point>().swap(ring.nodes);
+    }
+  }
+
+  /**
+   * Move the nodes of all rings back from the compact representation into
+   * the nodes vectors.
+   */
+  void Area::Expand()
+  {
+    for (auto& ring : rings) {
+      if (!ring.IsCompact()) {
+        continue;
+      }
+
+      ring.compactNodes.Get(ring.nodes);
+      ring.compactNodes.clear();
+    }
+  }
+
+  /**
+   * Read the rings of the area, following the header.
    *
    * @throws IOException
    */
-  void Area::Read(const TypeConfig& typeConfig,
-                  FileScanner& scanner)
+  void Area::ReadData(const TypeConfig& typeConfig,
+                      const TypeInfoRef& type,
+                      FileScanner& scanner)
   {
     TypeId             ringType;
     bool               multipleRings;
     bool               hasMaster;
     uint32_t           ringCount=1;
     FeatureValueBuffer featureValueBuffer;
+    TypeInfoRef        ringTypeInfo;
 
-    fileOffset=scanner.GetPos();
-
-    scanner.ReadTypeId(ringType,
-                       typeConfig.GetAreaTypeIdBytes());
-
-    TypeInfoRef type=typeConfig.GetAreaTypeInfo(ringType);
+    if (arena!=NULL) {
+      featureValueBuffer.SetArena(arena);
+    }
 
     featureValueBuffer.SetType(type);
 
@@ -198,6 +192,12 @@ namespace osmscout {
 
     rings.resize(ringCount);
 
+    if (arena!=NULL) {
+      for (auto& ring : rings) {
+        ring.featureValueBuffer.SetArena(arena);
+      }
+    }
+
     rings[0].featureValueBuffer=std::move(featureValueBuffer);
 
     if (hasMaster) {
@@ -214,9 +214,9 @@ namespace osmscout {
       scanner.ReadTypeId(ringType,
                          typeConfig.GetAreaTypeIdBytes());
 
-      type=typeConfig.GetAreaTypeInfo(ringType);
+      ringTypeInfo=typeConfig.GetAreaTypeInfo(ringType);
 
-      rings[i].SetType(type);
+      rings[i].SetType(ringTypeInfo);
 
       if (rings[i].GetType()->GetAreaId()!=typeIgnore) {
         rings[i].featureValueBuffer.Read(scanner);
@@ -229,6 +229,91 @@ namespace osmscout {
     }
   }
 
+  /**
+   * Read the header of the area at the current position of the given
+   * FileScanner (see Write()). Feature values and rings are not read,
+   * afterwards the area can be either read completely by passing the header
+   * to Read() or skipped by continuing at header.nextOffset.
+   *
+   * The feature bits are the feature bits of the first (outer or master) ring,
+   * without the special flags for multiple rings and master rings.
+   *
+   * @throws IOException
+   */
+  void Area::ReadHeader(const TypeConfig& typeConfig,
+                        FileScanner& scanner,
+                        ObjectHeader& header)
+  {
+    TypeId   typeId;
+    uint32_t dataSize;
+
+    header.fileOffset=scanner.GetPos();
+
+    scanner.ReadTypeId(typeId,
+                       typeConfig.GetAreaTypeIdBytes());
+    scanner.ReadCompactBox(header.boundingBox);
+    scanner.Read(dataSize);
+
+    header.type=typeConfig.GetAreaTypeInfo(typeId);
+    header.dataOffset=scanner.GetPos();
+    header.nextOffset=header.dataOffset+dataSize;
+
+    header.featureBits.resize(header.type->GetFeatureMaskBytes());
+
+    for (auto& bits : header.featureBits) {
+      scanner.Read(bits);
+    }
+
+    // Clear the special flags (multiple rings, master ring) if they are stored
+    // in the otherwise unused bits of the last byte of the feature mask
+    if (BitsToBytes(header.type->GetFeatureCount())==BitsToBytes(header.type->GetFeatureCount()+2)) {
+      header.featureBits.back()&=~0xc0;
+    }
+  }
+
+  /**
+   * Reads data from the given Filescanner. Node ids will only be read
+   * if not thought to be required for this area.
+   *
+   * @throws IOException
+   */
+  void Area::Read(const TypeConfig& typeConfig,
+                  FileScanner& scanner)
+  {
+    TypeId   typeId;
+    GeoBox   boundingBox;
+    uint32_t dataSize;
+
+    fileOffset=scanner.GetPos();
+
+    scanner.ReadTypeId(typeId,
+                       typeConfig.GetAreaTypeIdBytes());
+    scanner.ReadCompactBox(boundingBox);
+    scanner.Read(dataSize);
+
+    ReadData(typeConfig,
+             typeConfig.GetAreaTypeInfo(typeId),
+             scanner);
+  }
+
+  /**
+   * Read the area with the given header, as returned by ReadHeader().
+   *
+   * @throws IOException
+   */
+  void Area::Read(const TypeConfig& typeConfig,
+                  const ObjectHeader& header,
+                  FileScanner& scanner)
+  {
+    fileOffset=header.fileOffset;
+
+    scanner.SetPos(header.dataOffset);
+
+    ReadData(typeConfig,
+             header.type,
+             scanner);
+  }
+
   /**
    * Reads data from the given FileScanner. All data available will be read.
    *
@@ -364,6 +449,10 @@ namespace osmscout {
    * Writes data to the given FileWriter. Node ids will only be written
    * if not thought to be required for this area.
    *
+   * The type, the bounding box and the size of the following ring data are
+   * written first, so that areas can be filtered and skipped without
+   * decoding their data (see ReadHeader()).
+   *
    * @throws IOException
    */
   void Area::Write(const TypeConfig& typeConfig,
@@ -380,41 +469,79 @@ namespace osmscout {
     // Also for each ring we would like to have a bit flag, if
     // we stor eids or not
 
-    // Outer ring
+    GeoBox     boundingBox;
+    FileWriter dataWriter;
 
-    writer.WriteTypeId(ring->GetType()->GetAreaId(),
-                       typeConfig.GetAreaTypeIdBytes());
+    GetBoundingBox(boundingBox);
 
-    ring->featureValueBuffer.Write(writer,
+    // Fall back to all nodes, if the area has no valid outer ring
+    if (!boundingBox.IsValid()) {
+      for (const auto& r : rings) {
+        if (!r.nodes.empty()) {
+          GeoBox ringBoundingBox;
+
+          r.GetBoundingBox(ringBoundingBox);
+
+          if (boundingBox.IsValid()) {
+            boundingBox.Include(ringBoundingBox);
+          }
+          else {
+            boundingBox=ringBoundingBox;
+          }
+        }
+      }
+    }
+
+    // Write the ring data to memory first, to write its size in front of it
+    // without seeking in the file
+    dataWriter.OpenMemory();
+
+    // Outer ring
+
+    ring->featureValueBuffer.Write(dataWriter,
                                    multipleRings,
                                    hasMaster);
 
     if (multipleRings) {
-      writer.WriteNumber((uint32_t)(rings.size()-1));
+      dataWriter.WriteNumber((uint32_t)(rings.size()-1));
     }
 
-    writer.Write(ring->nodes,
-                 ring->GetType()->CanRoute());
+    dataWriter.Write(ring->nodes,
+                     ring->GetType()->CanRoute());
 
     ++ring;
 
     // Potential additional rings
 
     while (ring!=rings.end()) {
-      writer.WriteTypeId(ring->GetType()->GetAreaId(),
-                         typeConfig.GetAreaTypeIdBytes());
+      dataWriter.WriteTypeId(ring->GetType()->GetAreaId(),
+                             typeConfig.GetAreaTypeIdBytes());
 
       if (ring->GetType()->GetAreaId()!=typeIgnore) {
-        ring->featureValueBuffer.Write(writer);
+        ring->featureValueBuffer.Write(dataWriter);
       }
 
-      writer.Write(ring->ring);
-      writer.Write(ring->nodes,
-                   ring->GetType()->GetAreaId()!=typeIgnore &&
-                   ring->GetType()->CanRoute());
+      dataWriter.Write(ring->ring);
+      dataWriter.Write(ring->nodes,
+                       ring->GetType()->GetAreaId()!=typeIgnore &&
+                       ring->GetType()->CanRoute());
 
       ++ring;
     }
+
+    // Header
+
+    writer.WriteTypeId(rings[0].GetType()->GetAreaId(),
+                       typeConfig.GetAreaTypeIdBytes());
+    writer.WriteCompactBox(boundingBox);
+    writer.Write((uint32_t)dataWriter.GetMemory().size());
+
+    // Ring data
+
+    writer.Write(dataWriter.GetMemory().data(),
+                 dataWriter.GetMemory().size());
+
+    dataWriter.Close();
   }
 
   /**
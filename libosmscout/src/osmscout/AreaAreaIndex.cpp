@@ -243,6 +243,63 @@ namespace osmscout {
     }
   }
 
+  /**
+   * Load the top levels of the index into the index cache, level by level,
+   * until half of the cache is filled or the lowest cached level is reached.
+   * Lookups in the top levels, which are part of every query, then do not
+   * have to touch the file anymore.
+   */
+  bool AreaAreaIndex::WarmUp() const
+  {
+    std::vector<FileOffset> offsets;
+    std::vector<FileOffset> nextOffsets;
+    size_t                  cellCount=0;
+    size_t                  maxCellCount=indexCache.GetMaxSize()/2;
+
+    offsets.push_back(topLevelOffset);
+
+    try {
+      for (uint32_t level=0;
+           level<maxLevel &&
+           !offsets.empty();
+           level++) {
+        if (cellCount+offsets.size()>maxCellCount) {
+          break;
+        }
+
+        nextOffsets.clear();
+
+        for (const auto offset : offsets) {
+          IndexCell  cell;
+          FileOffset dataOffset;
+
+          if (!GetIndexCell(level,
+                            offset,
+                            cell,
+                            dataOffset)) {
+            return false;
+          }
+
+          for (size_t c=0; c<4; c++) {
+            if (cell.children[c]!=0) {
+              nextOffsets.push_back(cell.children[c]);
+            }
+          }
+        }
+
+        cellCount+=offsets.size();
+
+        std::swap(offsets,nextOffsets);
+      }
+    }
+    catch (IOException& e) {
+      log.Error() << e.GetDescription();
+      return false;
+    }
+
+    return true;
+  }
+
   /**
    * Returns references in form of DataBlockSpans to all areas within the
    * given area,
@@ -29,5 +29,22 @@ namespace osmscout {
   {
     // no code
   }
+
+  /**
+   * Return the memory of the area including its nodes and features
+   */
+  size_t AreaDataFile::GetValueMemory(const Area& area) const
+  {
+    size_t memory=sizeof(Area)+
+                  area.rings.capacity()*sizeof(Area::Ring);
+
+    for (const auto& ring : area.rings) {
+      memory+=ring.nodes.capacity()*sizeof(Point)+
+              ring.compactNodes.GetMemoryUsage()+
+              ring.GetFeatureValueBuffer().GetMemoryUsage();
+    }
+
+    return memory;
+  }
 }
 
@@ -0,0 +1,169 @@
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2016  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <osmscout/CompactPoints.h>
+
+#include <algorithm>
+
+#include <osmscout/system/Assert.h>
+#include <osmscout/system/Math.h>
+
+namespace osmscout {
+
+  void CompactPoints::clear()
+  {
+    std::vector<uint32_t>().swap(lats);
+    std::vector<uint32_t>().swap(lons);
+    std::vector<uint8_t>().swap(serials);
+  }
+
+  /**
+   * Replace the current content with the given points.
+   */
+  void CompactPoints::Set(const std::vector<Point>& points)
+  {
+    clear();
+
+    lats.resize(points.size());
+    lons.resize(points.size());
+
+    bool hasSerials=false;
+
+    for (size_t i=0; i<points.size(); i++) {
+      lats[i]=(uint32_t)round((points[i].GetLat()+90.0)*latConversionFactor);
+      lons[i]=(uint32_t)round((points[i].GetLon()+180.0)*lonConversionFactor);
+
+      hasSerials=hasSerials || points[i].GetSerial()!=0;
+    }
+
+    if (hasSerials) {
+      serials.resize(points.size());
+
+      for (size_t i=0; i<points.size(); i++) {
+        serials[i]=points[i].GetSerial();
+      }
+    }
+  }
+
+  /**
+   * Convert all points back to the standard representation.
+   */
+  void CompactPoints::Get(std::vector<Point>& points) const
+  {
+    points.resize(size());
+
+    GetPoints(0,
+              size(),
+              points.data());
+  }
+
+  /**
+   * Convert count points starting at index start to the standard
+   * representation. The given array must have room for count points.
+   */
+  void CompactPoints::GetPoints(size_t start,
+                                size_t count,
+                                Point* points) const
+  {
+    assert(start+count<=size());
+
+    for (size_t i=0; i<count; i++) {
+      points[i].Set(GetSerial(start+i),
+                    GeoCoord(lats[start+i]/latConversionFactor-90.0,
+                             lons[start+i]/lonConversionFactor-180.0));
+    }
+  }
+
+  /**
+   * Return the same id as Point::GetId() for the given point. Since the
+   * values are already stored in fixed-point no conversion is required.
+   */
+  Id CompactPoints::GetId(size_t index) const
+  {
+    uint64_t latValue=lats[index];
+    uint64_t lonValue=lons[index];
+    Id       id;
+
+    id=((latValue & 0x000000ff) <<  8)+  // 0 => 8
+       ((lonValue & 0x000000ff) <<  0)+  // 0 => 0
+       ((latValue & 0x0000ff00) << 16)+  // 8 => 24
+       ((lonValue & 0x0000ff00) <<  8)+  // 8 => 16
+       ((latValue & 0x00ff0000) << 24)+  // 16 => 40
+       ((lonValue & 0x00ff0000) << 16)+  // 16 => 32
+       ((latValue & 0x07000000) << 27)+  // 24 => 51
+       ((lonValue & 0x07000000) << 24);  // 24 => 48
+
+    id=id << 8;
+
+    id|=GetSerial(index);
+
+    return id;
+  }
+
+  void CompactPoints::SetSerial(size_t index,
+                                uint8_t serial)
+  {
+    if (serials.empty()) {
+      if (serial==0) {
+        return;
+      }
+
+      serials.resize(size(),0);
+    }
+
+    serials[index]=serial;
+  }
+
+  /**
+   * Calculate the bounding box of the (non empty) list of points. The
+   * comparison is done on the fixed-point values, only the resulting
+   * values are converted.
+   */
+  void CompactPoints::GetBoundingBox(GeoBox& boundingBox) const
+  {
+    assert(!empty());
+
+    uint32_t minLat=lats[0];
+    uint32_t maxLat=lats[0];
+    uint32_t minLon=lons[0];
+    uint32_t maxLon=lons[0];
+
+    for (size_t i=1; i<size(); i++) {
+      minLat=std::min(minLat,lats[i]);
+      maxLat=std::max(maxLat,lats[i]);
+      minLon=std::min(minLon,lons[i]);
+      maxLon=std::max(maxLon,lons[i]);
+    }
+
+    boundingBox.Set(GeoCoord(minLat/latConversionFactor-90.0,
+                             minLon/lonConversionFactor-180.0),
+                    GeoCoord(maxLat/latConversionFactor-90.0,
+                             maxLon/lonConversionFactor-180.0));
+  }
+
+  /**
+   * Return the number of bytes allocated for the points
+   */
+  size_t CompactPoints::GetMemoryUsage() const
+  {
+    return lats.capacity()*sizeof(uint32_t)+
+           lons.capacity()*sizeof(uint32_t)+
+           serials.capacity()*sizeof(uint8_t);
+  }
+}
@@ -20,6 +20,8 @@
 #include <osmscout/Database.h>
 
 #include <algorithm>
+#include <functional>
+#include <future>
 
 #if _OPENMP
 #include <omp.h>
@@ -36,7 +38,12 @@ namespace osmscout {
 
   DatabaseParameter::DatabaseParameter()
   : areaAreaIndexCacheSize(5000),
-    areaNodeIndexCacheSize(1000)
+    areaNodeIndexCacheSize(1000),
+    nodeDataCacheMemory(0),
+    wayDataCacheMemory(0),
+    areaDataCacheMemory(0),
+    eagerOpen(false),
+    maxLockedIndexSize(0)
   {
     // no code
   }
@@ -51,6 +58,59 @@ namespace osmscout {
     this->areaNodeIndexCacheSize=areaNodeIndexCacheSize;
   }
 
+  /**
+   * Maximum memory in bytes of the nodes cached by their file offset. The
+   * cache is shared by all users of the database. 0 (the default) disables
+   * the cache.
+   */
+  void DatabaseParameter::SetNodeDataCacheMemory(size_t nodeDataCacheMemory)
+  {
+    this->nodeDataCacheMemory=nodeDataCacheMemory;
+  }
+
+  /**
+   * Maximum memory in bytes of the ways cached by their file offset. The
+   * cache is shared by all users of the database. 0 (the default) disables
+   * the cache.
+   */
+  void DatabaseParameter::SetWayDataCacheMemory(size_t wayDataCacheMemory)
+  {
+    this->wayDataCacheMemory=wayDataCacheMemory;
+  }
+
+  /**
+   * Maximum memory in bytes of the areas cached by their file offset. The
+   * cache is shared by all users of the database. 0 (the default) disables
+   * the cache.
+   */
+  void DatabaseParameter::SetAreaDataCacheMemory(size_t areaDataCacheMemory)
+  {
+    this->areaDataCacheMemory=areaDataCacheMemory;
+  }
+
+  /**
+   * If set, Database::Open() already opens all data files and indexes
+   * required for rendering and the location, POI and route segment indexes
+   * (in parallel, see Database::WarmUp()) instead of opening them lazily on
+   * first access. Open() fails, if one of the files required for rendering
+   * cannot be opened. Default is false.
+   */
+  void DatabaseParameter::SetEagerOpen(bool eagerOpen)
+  {
+    this->eagerOpen=eagerOpen;
+  }
+
+  /**
+   * Index files with a size of up to the given number of bytes are locked
+   * into memory (see FileScanner::Lock()) by Database::WarmUp(), so that
+   * index lookups never wait for pages to be read back from disk. 0 (the
+   * default) disables locking.
+   */
+  void DatabaseParameter::SetMaxLockedIndexSize(size_t maxLockedIndexSize)
+  {
+    this->maxLockedIndexSize=maxLockedIndexSize;
+  }
+
   unsigned long DatabaseParameter::GetAreaAreaIndexCacheSize() const
   {
     return areaAreaIndexCacheSize;
@@ -61,6 +121,31 @@ namespace osmscout {
     return areaNodeIndexCacheSize;
   }
 
+  size_t DatabaseParameter::GetNodeDataCacheMemory() const
+  {
+    return nodeDataCacheMemory;
+  }
+
+  size_t DatabaseParameter::GetWayDataCacheMemory() const
+  {
+    return wayDataCacheMemory;
+  }
+
+  size_t DatabaseParameter::GetAreaDataCacheMemory() const
+  {
+    return areaDataCacheMemory;
+  }
+
+  bool DatabaseParameter::GetEagerOpen() const
+  {
+    return eagerOpen;
+  }
+
+  size_t DatabaseParameter::GetMaxLockedIndexSize() const
+  {
+    return maxLockedIndexSize;
+  }
+
   Database::Database(const DatabaseParameter& parameter)
    : parameter(parameter),
      isOpen(false)
@@ -111,6 +196,13 @@ namespace osmscout {
 
     isOpen=true;
 
+    if (parameter.GetEagerOpen() &&
+        !WarmUp()) {
+      log.Error() << "Cannot open database files in '" << path << "'!";
+      Close();
+      return false;
+    }
+
     return true;
   }
 
@@ -163,6 +255,16 @@ namespace osmscout {
       waterIndex=NULL;
     }
 
+    if (poiIndex) {
+      poiIndex->Close();
+      poiIndex=NULL;
+    }
+
+    if (routeSegmentIndex) {
+      routeSegmentIndex->Close();
+      routeSegmentIndex=NULL;
+    }
+
     if (optimizeWaysLowZoom) {
       optimizeWaysLowZoom->Close();
       optimizeWaysLowZoom=NULL;
@@ -173,9 +275,164 @@ namespace osmscout {
       optimizeAreasLowZoom=NULL;
     }
 
+    {
+      std::lock_guard<std::mutex> guard(lockedIndexesMutex);
+
+      for (auto& scanner : lockedIndexes) {
+        scanner->CloseFailsafe();
+      }
+
+      lockedIndexes.clear();
+    }
+
     isOpen=false;
   }
 
+  /**
+   * Lock the small index files into memory, see
+   * DatabaseParameter::SetMaxLockedIndexSize(). The files are mapped
+   * a second time, the mapping shares its pages with the mapping of the
+   * index itself. Failing to lock a file is not an error.
+   */
+  void Database::LockIndexes() const
+  {
+    static const char* indexFiles[]={
+      AreaNodeIndex::AREA_NODE_IDX,
+      AreaWayIndex::AREA_WAY_IDX,
+      AreaAreaIndex::AREA_AREA_IDX,
+      WaterIndex::WATER_IDX
+    };
+
+    std::lock_guard<std::mutex> guard(lockedIndexesMutex);
+
+    if (!lockedIndexes.empty()) {
+      return;
+    }
+
+    for (const auto indexFile : indexFiles) {
+      std::string                  filename=AppendFileToDir(path,indexFile);
+      std::shared_ptr<FileScanner> scanner=std::make_shared<FileScanner>();
+
+      try {
+        if (GetFileSize(filename)>parameter.GetMaxLockedIndexSize()) {
+          continue;
+        }
+
+        scanner->Open(filename,FileScanner::FastRandom,true);
+
+        if (scanner->Lock()) {
+          lockedIndexes.push_back(scanner);
+        }
+        else {
+          scanner->Close();
+        }
+      }
+      catch (IOException& e) {
+        log.Warn() << e.GetDescription();
+        scanner->CloseFailsafe();
+      }
+    }
+
+    log.Debug() << "Locked " << lockedIndexes.size() << " index file(s) into memory";
+  }
+
+  /**
+   * Open all data files and indexes required for rendering and the location,
+   * POI and route segment indexes, which are otherwise opened lazily on
+   * first access. This moves the I/O to a defined point in time, e.g. before
+   * a new database version is published via DatabaseHandle or at Open() (see
+   * DatabaseParameter::SetEagerOpen()).
+   *
+   * The files are opened in parallel, one thread per file. The top levels of
+   * the area area index are loaded into its cache and small indexes are
+   * locked into memory, if requested. The time spent per file is logged.
+   *
+   * Returns false, if one of the files required for rendering cannot be
+   * opened. The location, POI and route segment indexes are optional, if
+   * they cannot be opened, only a warning is logged.
+   */
+  bool Database::WarmUp() const
+  {
+    struct WarmUpTask
+    {
+      const char*           filename;
+      std::function<bool()> open;
+      bool                  required; //!< Warm-up fails, if the file cannot be opened
+      bool                  success;
+      double                milliseconds;
+    };
+
+    if (!IsOpen()) {
+      return false;
+    }
+
+    StopClock               timer;
+    std::vector<WarmUpTask> tasks={
+      {NodeDataFile::NODES_DAT,[this]() {return (bool)GetNodeDataFile();},true,false,0.0},
+      {AreaDataFile::AREAS_DAT,[this]() {return (bool)GetAreaDataFile();},true,false,0.0},
+      {WayDataFile::WAYS_DAT,[this]() {return (bool)GetWayDataFile();},true,false,0.0},
+      {AreaNodeIndex::AREA_NODE_IDX,[this]() {return (bool)GetAreaNodeIndex();},true,false,0.0},
+      {AreaAreaIndex::AREA_AREA_IDX,[this]() {
+          AreaAreaIndexRef index=GetAreaAreaIndex();
+
+          return index && index->WarmUp();
+        },true,false,0.0},
+      {AreaWayIndex::AREA_WAY_IDX,[this]() {return (bool)GetAreaWayIndex();},true,false,0.0},
+      {WaterIndex::WATER_IDX,[this]() {return (bool)GetWaterIndex();},true,false,0.0},
+      {LocationIndex::FILENAME_LOCATION_IDX,[this]() {return (bool)GetLocationIndex();},false,false,0.0},
+      {POIIndex::POI_IDX,[this]() {return (bool)GetPOIIndex();},false,false,0.0},
+      {RouteSegmentIndex::ROUTESEGMENT_IDX,[this]() {return (bool)GetRouteSegmentIndex();},false,false,0.0},
+      {OptimizeAreasLowZoom::FILE_AREASOPT_DAT,[this]() {return (bool)GetOptimizeAreasLowZoom();},true,false,0.0},
+      {OptimizeWaysLowZoom::FILE_WAYSOPT_DAT,[this]() {return (bool)GetOptimizeWaysLowZoom();},true,false,0.0}
+    };
+    std::vector<std::future<void>> results;
+
+    results.reserve(tasks.size());
+
+    for (auto& task : tasks) {
+      results.push_back(std::async(std::launch::async,[&task]() {
+        StopClock taskTimer;
+
+        task.success=task.open();
+
+        taskTimer.Stop();
+
+        task.milliseconds=taskTimer.GetMilliseconds();
+      }));
+    }
+
+    for (auto& result : results) {
+      result.get();
+    }
+
+    bool success=true;
+
+    for (const auto& task : tasks) {
+      if (!task.success &&
+          task.required) {
+        log.Error() << "Cannot warm up '" << task.filename << "'!";
+        success=false;
+      }
+      else if (!task.success) {
+        log.Warn() << "Cannot warm up optional '" << task.filename << "'";
+      }
+      else {
+        log.Info() << "Warm-up of '" << task.filename << "': " << task.milliseconds << "ms";
+      }
+    }
+
+    if (success &&
+        parameter.GetMaxLockedIndexSize()>0) {
+      LockIndexes();
+    }
+
+    timer.Stop();
+
+    log.Info() << "Warm-up of database '" << path << "': " << timer.ResultString();
+
+    return success;
+  }
+
   std::string Database::GetPath() const
   {
     return path;
@@ -196,6 +453,7 @@ namespace osmscout {
 
     if (!nodeDataFile) {
       nodeDataFile=std::make_shared<NodeDataFile>();
+      nodeDataFile->SetCacheMemory(parameter.GetNodeDataCacheMemory());
     }
 
     if (!nodeDataFile->IsOpen()) {
@@ -226,6 +484,7 @@ namespace osmscout {
 
     if (!areaDataFile) {
       areaDataFile=std::make_shared<AreaDataFile>();
+      areaDataFile->SetCacheMemory(parameter.GetAreaDataCacheMemory());
     }
 
     if (!areaDataFile->IsOpen()) {
@@ -256,6 +515,7 @@ namespace osmscout {
 
     if (!wayDataFile) {
       wayDataFile=std::make_shared<WayDataFile>();
+      wayDataFile->SetCacheMemory(parameter.GetWayDataCacheMemory());
     }
 
     if (!wayDataFile->IsOpen()) {
@@ -417,6 +677,62 @@ namespace osmscout {
     return waterIndex;
   }
 
+  POIIndexRef Database::GetPOIIndex() const
+  {
+    std::lock_guard<std::mutex> guard(poiIndexMutex);
+
+    if (!IsOpen()) {
+      return NULL;
+    }
+
+    if (!poiIndex) {
+      poiIndex=std::make_shared<POIIndex>();
+
+      StopClock timer;
+
+      if (!poiIndex->Open(path)) {
+        log.Error() << "Cannot load POI index!";
+        poiIndex=NULL;
+
+        return NULL;
+      }
+
+      timer.Stop();
+
+      log.Debug() << "Opening POIIndex: " << timer.ResultString();
+    }
+
+    return poiIndex;
+  }
+
+  RouteSegmentIndexRef Database::GetRouteSegmentIndex() const
+  {
+    std::lock_guard<std::mutex> guard(routeSegmentIndexMutex);
+
+    if (!IsOpen()) {
+      return NULL;
+    }
+
+    if (!routeSegmentIndex) {
+      routeSegmentIndex=std::make_shared<RouteSegmentIndex>();
+
+      StopClock timer;
+
+      if (!routeSegmentIndex->Open(path)) {
+        log.Error() << "Cannot load route segment index!";
+        routeSegmentIndex=NULL;
+
+        return NULL;
+      }
+
+      timer.Stop();
+
+      log.Debug() << "Opening RouteSegmentIndex: " << timer.ResultString();
+    }
+
+    return routeSegmentIndex;
+  }
+
   OptimizeAreasLowZoomRef Database::GetOptimizeAreasLowZoom() const
   {
     std::lock_guard<std::mutex> guard(optimizeAreasMutex);
@@ -719,6 +1035,24 @@ namespace osmscout {
     return areaDataFile->GetByBlockSpans(spans,areas);
   }
 
+  /**
+   * Read the areas in the given spans, only returning the areas accepted
+   * by the given filter. If arena is set, the areas are allocated from it.
+   */
+  bool Database::GetAreasByBlockSpans(const std::vector<DataBlockSpan>& spans,
+                                      const ObjectHeaderFilter& filter,
+                                      const MemoryArenaRef& arena,
+                                      std::vector<AreaRef>& areas) const
+  {
+    AreaDataFileRef areaDataFile=GetAreaDataFile();
+
+    if (!areaDataFile) {
+      return false;
+    }
+
+    return areaDataFile->GetByBlockSpans(spans,filter,arena,areas);
+  }
+
   bool Database::GetWayByOffset(const FileOffset& offset,
                                 WayRef& way) const
   {
@@ -819,8 +1153,97 @@ namespace osmscout {
     return result;
   }
 
+  /**
+   * Read the ways at the given offsets, only returning the ways accepted
+   * by the given filter. If arena is set, the ways are allocated from it.
+   */
+  bool Database::GetWaysByOffset(const std::vector<FileOffset>& offsets,
+                                 const ObjectHeaderFilter& filter,
+                                 const MemoryArenaRef& arena,
+                                 std::vector<WayRef>& ways) const
+  {
+    WayDataFileRef wayDataFile=GetWayDataFile();
+
+    if (!wayDataFile) {
+      return false;
+    }
+
+    StopClock time;
+
+    bool result=wayDataFile->GetByOffset(offsets,filter,arena,ways);
+
+    if (time.GetMilliseconds()>100) {
+      log.Warn() << "Retrieving " << ways.size() << " of " << offsets.size() << " ways by offset took " << time.ResultString();
+    }
+
+    return result;
+  }
+
+  /**
+   * Advise the operating system to load the nodes at the given offsets in
+   * the background. Does not block on I/O (besides opening the data file).
+   */
+  bool Database::PrefetchNodesByOffset(const std::vector<FileOffset>& offsets) const
+  {
+    NodeDataFileRef nodeDataFile=GetNodeDataFile();
+
+    if (!nodeDataFile) {
+      return false;
+    }
+
+    nodeDataFile->Prefetch(offsets);
+
+    return true;
+  }
+
+  /**
+   * Advise the operating system to load the areas in the given spans in
+   * the background. Does not block on I/O (besides opening the data file).
+   */
+  bool Database::PrefetchAreasByBlockSpans(const std::vector<DataBlockSpan>& spans) const
+  {
+    AreaDataFileRef areaDataFile=GetAreaDataFile();
+
+    if (!areaDataFile) {
+      return false;
+    }
+
+    areaDataFile->Prefetch(spans);
+
+    return true;
+  }
+
+  /**
+   * Advise the operating system to load the ways at the given offsets in
+   * the background. Does not block on I/O (besides opening the data file).
+   */
+  bool Database::PrefetchWaysByOffset(const std::vector<FileOffset>& offsets) const
+  {
+    WayDataFileRef wayDataFile=GetWayDataFile();
+
+    if (!wayDataFile) {
+      return false;
+    }
+
+    wayDataFile->Prefetch(offsets);
+
+    return true;
+  }
+
   void Database::DumpStatistics()
   {
+    if (nodeDataFile) {
+      nodeDataFile->DumpStatistics();
+    }
+
+    if (areaDataFile) {
+      areaDataFile->DumpStatistics();
+    }
+
+    if (wayDataFile) {
+      wayDataFile->DumpStatistics();
+    }
+
     if (areaAreaIndex) {
       areaAreaIndex->DumpStatistics();
     }
@@ -832,5 +1255,78 @@ namespace osmscout {
     if (waterIndex) {
       waterIndex->DumpStatistics();
     }
+
+    if (poiIndex) {
+      poiIndex->DumpStatistics();
+    }
+
+    if (routeSegmentIndex) {
+      routeSegmentIndex->DumpStatistics();
+    }
+  }
+
+  DatabaseHandle::DatabaseHandle(const DatabaseParameter& parameter)
+  : parameter(parameter)
+  {
+    // no code
+  }
+
+  /**
+   * Open the database in the given directory, warm it up and make it the
+   * current version. On error the current version stays active.
+   *
+   * Method is thread-safe and does not block GetDatabase().
+   */
+  bool DatabaseHandle::Open(const std::string& path)
+  {
+    std::lock_guard<std::mutex> lock(openMutex);
+
+    StopClock   timer;
+    DatabaseRef newDatabase=std::make_shared<Database>(parameter);
+
+    if (!newDatabase->Open(path)) {
+      log.Error() << "Cannot open database '" << path << "'";
+      return false;
+    }
+
+    // With eager opening Database::Open() has already warmed up the database
+    if (!parameter.GetEagerOpen() &&
+        !newDatabase->WarmUp()) {
+      log.Error() << "Cannot load data files and indexes of database '" << path << "'";
+      return false;
+    }
+
+    std::atomic_store(&database,newDatabase);
+
+    timer.Stop();
+
+    log.Info() << "Switched to database '" << path << "' after " << timer.ResultString();
+
+    return true;
+  }
+
+  /**
+   * Drop the current version. It is closed as soon as the last reference
+   * to it is dropped.
+   *
+   * Method is thread-safe.
+   */
+  void DatabaseHandle::Close()
+  {
+    std::lock_guard<std::mutex> lock(openMutex);
+
+    std::atomic_store(&database,DatabaseRef());
+  }
+
+  /**
+   * Return the current version of the database or NULL, if no database has
+   * been opened. The snapshot stays valid as long as the reference is held,
+   * even if another version is opened in the meantime.
+   *
+   * Method is thread-safe and does not wait for a running Open().
+   */
+  DatabaseRef DatabaseHandle::GetDatabase() const
+  {
+    return std::atomic_load(&database);
   }
 }
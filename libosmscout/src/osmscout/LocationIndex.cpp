@@ -19,24 +19,56 @@
 
 #include <osmscout/LocationIndex.h>
 
+#include <algorithm>
+
 #include <osmscout/system/Assert.h>
 
 #include <osmscout/util/File.h>
+#include <osmscout/util/Geometry.h>
 #include <osmscout/util/Logger.h>
 #include <osmscout/util/StopClock.h>
+#include <osmscout/util/String.h>
 #include <iostream>
 namespace osmscout {
 
   const char* const LocationIndex::FILENAME_LOCATION_IDX = "location.idx";
+  const char* const LocationIndex::FILENAME_LOCATION_TOKEN_IDX = "locationtoken.idx";
+  const char* const LocationIndex::FILENAME_LOCATION_REVERSE_IDX = "locationreverse.idx";
+
+  const size_t LocationIndex::TOKEN_LENGTH = 3;
+
+  const uint32_t LocationIndex::REVERSE_CELLS_PER_DEGREE = 100;
+
+  /**
+   * Number of cells in each dimension of the in memory grid of region bounding boxes
+   */
+  static const size_t REVERSE_REGION_GRID_SIZE = 64;
+
+  static size_t GetReverseRegionCell(double value,
+                                     double min,
+                                     double cellSize)
+  {
+    if (cellSize<=0.0 ||
+        value<=min) {
+      return 0;
+    }
+
+    return std::min((size_t)((value-min)/cellSize),
+                    REVERSE_REGION_GRID_SIZE-1);
+  }
 
   LocationIndex::LocationIndex()
+  : hasTokenIndex(false),
+    hasReverseIndex(false),
+    reverseRegionCellWidth(0.0),
+    reverseRegionCellHeight(0.0)
   {
     // no code
   }
 
   LocationIndex::~LocationIndex()
   {
-    // no code
+    reverseScanner.CloseFailsafe();
   }
 
   bool LocationIndex::Load(const std::string& path)
@@ -80,14 +112,182 @@ namespace osmscout {
       indexOffset=scanner.GetPos();
 
       scanner.Close();
+    }
+    catch (IOException& e) {
+      log.Error() << e.GetDescription();
+      scanner.CloseFailsafe();
+      return false;
+    }
+
+    hasTokenIndex=LoadTokenIndex();
+    hasReverseIndex=LoadReverseIndex();
+
+    return true;
+  }
+
+  /**
+   * Load the dictionaries of the token index. The token index is optional,
+   * if it cannot be loaded location search falls back to a full scan
+   * of the location index.
+   */
+  bool LocationIndex::LoadTokenIndex()
+  {
+    FileScanner scanner;
+
+    for (auto& section : tokenIndex) {
+      section.clear();
+    }
+
+    try {
+      scanner.Open(AppendFileToDir(path,
+                                   FILENAME_LOCATION_TOKEN_IDX),
+                   FileScanner::LowMemRandom,
+                   true);
+
+      FileOffset dictionaryOffsets[3];
+
+      for (auto& offset : dictionaryOffsets) {
+        scanner.ReadFileOffset(offset);
+      }
+
+      for (size_t s=0; s<3; s++) {
+        uint32_t entryCount;
+        uint32_t token=0;
+
+        scanner.SetPos(dictionaryOffsets[s]);
+        scanner.ReadNumber(entryCount);
+
+        tokenIndex[s].resize(entryCount);
+
+        for (auto& entry : tokenIndex[s]) {
+          uint32_t tokenDelta;
+
+          scanner.ReadNumber(tokenDelta);
+          scanner.ReadNumber(entry.count);
+          scanner.ReadFileOffset(entry.listOffset);
+
+          token+=tokenDelta;
+          entry.token=token;
+        }
+      }
+
+      scanner.Close();
 
       return true;
     }
     catch (IOException& e) {
-      log.Error() << e.GetDescription();
+      log.Warn() << "Location token index not available, using full scan for location search: " << e.GetDescription();
+      scanner.CloseFailsafe();
+
+      for (auto& section : tokenIndex) {
+        section.clear();
+      }
+
+      return false;
+    }
+  }
+
+  /**
+   * Load the region table and the cell table of the reverse lookup index and
+   * build a grid of the region bounding boxes. The reverse lookup index is optional.
+   *
+   * The index file stays open and memory mapped for the lookups of region
+   * polygons and cell entries. Each lookup reads using its own scanner on the
+   * shared mapping, so concurrent lookups do not block each other.
+   */
+  bool LocationIndex::LoadReverseIndex()
+  {
+    FileScanner& scanner=reverseScanner;
+
+    scanner.CloseFailsafe();
+
+    reverseRegions.clear();
+    reverseCells.clear();
+    reverseRegionGrid.clear();
+    reverseRegionBox.Invalidate();
+
+    try {
+      scanner.Open(AppendFileToDir(path,
+                                   FILENAME_LOCATION_REVERSE_IDX),
+                   FileScanner::LowMemRandom,
+                   true);
+
+      FileOffset regionTableOffset;
+      FileOffset cellTableOffset;
+      uint32_t   regionCount;
+      uint32_t   cellCount;
+      uint64_t   cellId=0;
+
+      scanner.ReadFileOffset(regionTableOffset);
+      scanner.ReadFileOffset(cellTableOffset);
+
+      scanner.SetPos(regionTableOffset);
+      scanner.ReadNumber(regionCount);
+
+      reverseRegions.resize(regionCount);
+
+      for (auto& region : reverseRegions) {
+        scanner.ReadFileOffset(region.regionOffset);
+        scanner.ReadNumber(region.depth);
+        scanner.ReadBox(region.boundingBox);
+        scanner.ReadFileOffset(region.polygonsOffset);
+
+        if (reverseRegionBox.IsValid()) {
+          reverseRegionBox.Include(region.boundingBox);
+        }
+        else {
+          reverseRegionBox=region.boundingBox;
+        }
+      }
+
+      scanner.SetPos(cellTableOffset);
+      scanner.ReadNumber(cellCount);
+
+      reverseCells.resize(cellCount);
+
+      for (auto& cell : reverseCells) {
+        uint64_t cellIdDelta;
+
+        scanner.ReadNumber(cellIdDelta);
+        scanner.ReadNumber(cell.count);
+        scanner.ReadFileOffset(cell.entryOffset);
+
+        cellId+=cellIdDelta;
+        cell.cellId=cellId;
+      }
+    }
+    catch (IOException& e) {
+      log.Warn() << "Location reverse index not available: " << e.GetDescription();
       scanner.CloseFailsafe();
+
+      reverseRegions.clear();
+      reverseCells.clear();
+
       return false;
     }
+
+    if (reverseRegionBox.IsValid()) {
+      reverseRegionCellWidth=reverseRegionBox.GetWidth()/REVERSE_REGION_GRID_SIZE;
+      reverseRegionCellHeight=reverseRegionBox.GetHeight()/REVERSE_REGION_GRID_SIZE;
+
+      reverseRegionGrid.resize(REVERSE_REGION_GRID_SIZE*REVERSE_REGION_GRID_SIZE);
+
+      for (size_t r=0; r<reverseRegions.size(); r++) {
+        const GeoBox& box=reverseRegions[r].boundingBox;
+        size_t        minX=GetReverseRegionCell(box.GetMinLon(),reverseRegionBox.GetMinLon(),reverseRegionCellWidth);
+        size_t        maxX=GetReverseRegionCell(box.GetMaxLon(),reverseRegionBox.GetMinLon(),reverseRegionCellWidth);
+        size_t        minY=GetReverseRegionCell(box.GetMinLat(),reverseRegionBox.GetMinLat(),reverseRegionCellHeight);
+        size_t        maxY=GetReverseRegionCell(box.GetMaxLat(),reverseRegionBox.GetMinLat(),reverseRegionCellHeight);
+
+        for (size_t y=minY; y<=maxY; y++) {
+          for (size_t x=minX; x<=maxX; x++) {
+            reverseRegionGrid[y*REVERSE_REGION_GRID_SIZE+x].push_back(r);
+          }
+        }
+      }
+    }
+
+    return true;
   }
 
   bool LocationIndex::IsRegionIgnoreToken(const std::string& token) const
@@ -226,6 +426,44 @@ namespace osmscout {
     }
   }
 
+  /**
+   * Load the location entry at the current position of the scanner.
+   * The object references of a location are encoded independently of
+   * the other locations, so any location can be loaded on its own.
+   */
+  void LocationIndex::LoadLocation(FileScanner& scanner,
+                                   Location& location) const
+  {
+    uint32_t                  objectCount;
+    bool                      hasAddresses;
+    ObjectFileRefStreamReader objectFileRefReader(scanner);
+
+    location.locationOffset=scanner.GetPos();
+
+    scanner.Read(location.name);
+    scanner.ReadNumber(objectCount);
+
+    location.objects.clear();
+    location.objects.reserve(objectCount);
+
+    scanner.Read(hasAddresses);
+
+    if (hasAddresses) {
+      scanner.ReadFileOffset(location.addressesOffset);
+    }
+    else {
+      location.addressesOffset=0;
+    }
+
+    for (size_t j=0; j<objectCount; j++) {
+      ObjectFileRef ref;
+
+      objectFileRefReader.Read(ref);
+
+      location.objects.push_back(ref);
+    }
+  }
+
   bool LocationIndex::LoadRegionDataEntry(FileScanner& scanner,
                                           const AdminRegion& adminRegion,
                                           LocationVisitor& visitor,
@@ -258,38 +496,11 @@ namespace osmscout {
 
     for (size_t i=0; i<locationCount; i++) {
       Location location;
-      uint32_t  objectCount;
-
-      location.locationOffset=scanner.GetPos();
-
-      scanner.Read(location.name);
 
       location.regionOffset=adminRegion.regionOffset;
 
-      scanner.ReadNumber(objectCount);
-
-      location.objects.reserve(objectCount);
-
-      bool hasAddresses;
-
-      scanner.Read(hasAddresses);
-
-      if (hasAddresses) {
-        scanner.ReadFileOffset(location.addressesOffset);
-      }
-      else {
-        location.addressesOffset=0;
-      }
-
-      objectFileRefReader.Reset();
-
-      for (size_t j=0; j<objectCount; j++) {
-        ObjectFileRef ref;
-
-        objectFileRefReader.Read(ref);
-
-        location.objects.push_back(ref);
-      }
+      LoadLocation(scanner,
+                   location);
 
       if (!visitor.Visit(adminRegion,
                          location)) {
@@ -571,6 +782,536 @@ namespace osmscout {
     }
   }
 
+  /**
+   * Split the given (already normalized, see TolowerUmlaut()) name into
+   * all overlapping tokens of TOKEN_LENGTH bytes. Returns a sorted list
+   * without duplicates. Names shorter than TOKEN_LENGTH do not have tokens.
+   */
+  void LocationIndex::GetNameTokens(const std::string& normalizedName,
+                                    std::vector<uint32_t>& tokens)
+  {
+    tokens.clear();
+
+    if (normalizedName.length()<TOKEN_LENGTH) {
+      return;
+    }
+
+    tokens.reserve(normalizedName.length()-TOKEN_LENGTH+1);
+
+    for (size_t i=0; i+TOKEN_LENGTH<=normalizedName.length(); i++) {
+      tokens.push_back(((uint32_t)(uint8_t)normalizedName[i] << 16) |
+                       ((uint32_t)(uint8_t)normalizedName[i+1] << 8) |
+                       (uint32_t)(uint8_t)normalizedName[i+2]);
+    }
+
+    std::sort(tokens.begin(),
+              tokens.end());
+
+    tokens.erase(std::unique(tokens.begin(),
+                             tokens.end()),
+                 tokens.end());
+  }
+
+  bool LocationIndex::CanUseTokenIndex(const std::string& pattern) const
+  {
+    return hasTokenIndex &&
+           pattern.length()>=TOKEN_LENGTH;
+  }
+
+  bool LocationIndex::GetTokenCandidates(TokenSection section,
+                                         const std::string& pattern,
+                                         std::vector<FileOffset>& offsets) const
+  {
+    assert(CanUseTokenIndex(pattern));
+
+    const std::vector<TokenEntry>& dictionary=tokenIndex[section];
+    std::string                    normalizedPattern(pattern);
+    std::vector<uint32_t>          tokens;
+    std::vector<TokenEntry>        entries;
+
+    offsets.clear();
+
+    TolowerUmlaut(normalizedPattern);
+
+    GetNameTokens(normalizedPattern,
+                  tokens);
+
+    entries.reserve(tokens.size());
+
+    for (const auto token : tokens) {
+      TokenEntry key;
+
+      key.token=token;
+
+      auto entry=std::lower_bound(dictionary.begin(),
+                                  dictionary.end(),
+                                  key);
+
+      if (entry==dictionary.end() ||
+          entry->token!=token) {
+        // A token of the pattern is not part of any name
+        return true;
+      }
+
+      entries.push_back(*entry);
+    }
+
+    // Intersect starting with the shortest posting list
+    std::sort(entries.begin(),
+              entries.end(),
+              [](const TokenEntry& a, const TokenEntry& b) {
+                return a.count<b.count;
+              });
+
+    FileScanner scanner;
+
+    try {
+      scanner.Open(AppendFileToDir(path,
+                                   FILENAME_LOCATION_TOKEN_IDX),
+                   FileScanner::LowMemRandom,
+                   true);
+
+      std::vector<FileOffset> postings;
+      std::vector<FileOffset> intersection;
+
+      for (size_t i=0; i<entries.size(); i++) {
+        FileOffset offset=0;
+
+        postings.resize(entries[i].count);
+
+        scanner.SetPos(entries[i].listOffset);
+
+        for (auto& posting : postings) {
+          FileOffset offsetDelta;
+
+          scanner.ReadNumber(offsetDelta);
+
+          offset+=offsetDelta;
+          posting=offset;
+        }
+
+        if (i==0) {
+          offsets.swap(postings);
+        }
+        else {
+          intersection.clear();
+
+          std::set_intersection(offsets.begin(),
+                                offsets.end(),
+                                postings.begin(),
+                                postings.end(),
+                                std::back_inserter(intersection));
+
+          offsets.swap(intersection);
+        }
+
+        if (offsets.empty()) {
+          break;
+        }
+      }
+
+      scanner.Close();
+
+      return true;
+    }
+    catch (IOException& e) {
+      log.Error() << e.GetDescription();
+      scanner.CloseFailsafe();
+      return false;
+    }
+  }
+
+  bool LocationIndex::VisitAdminRegions(const std::vector<FileOffset>& regionOffsets,
+                                        AdminRegionVisitor& visitor) const
+  {
+    FileScanner scanner;
+
+    try {
+      scanner.Open(AppendFileToDir(path,
+                                   FILENAME_LOCATION_IDX),
+                   FileScanner::LowMemRandom,
+                   true);
+
+      for (const auto offset : regionOffsets) {
+        AdminRegion region;
+
+        scanner.SetPos(offset);
+
+        if (!LoadAdminRegion(scanner,
+                             region)) {
+          return false;
+        }
+
+        AdminRegionVisitor::Action action=visitor.Visit(region);
+
+        if (action==AdminRegionVisitor::error) {
+          return false;
+        }
+        else if (action==AdminRegionVisitor::stop) {
+          break;
+        }
+      }
+
+      scanner.Close();
+
+      return true;
+    }
+    catch (IOException& e) {
+      log.Error() << e.GetDescription();
+      scanner.CloseFailsafe();
+      return false;
+    }
+  }
+
+  bool LocationIndex::VisitAdminRegionLocations(const AdminRegion& region,
+                                                const std::vector<FileOffset>& regionOffsets,
+                                                LocationVisitor& visitor) const
+  {
+    FileScanner scanner;
+    bool        stopped=false;
+
+    try {
+      scanner.Open(AppendFileToDir(path,
+                                   FILENAME_LOCATION_IDX),
+                   FileScanner::LowMemRandom,
+                   true);
+
+      // Regions are stored in depth first order with all children directly
+      // following their parent, so the sub regions of the given region
+      // form a continuous range of offsets, which ends with the last
+      // child (or the region itself, if it does not have children).
+      AdminRegion tmpRegion;
+      uint32_t    childCount;
+      FileOffset  endOffset;
+
+      scanner.SetPos(region.regionOffset);
+
+      if (!LoadAdminRegion(scanner,
+                           tmpRegion)) {
+        return false;
+      }
+
+      scanner.ReadNumber(childCount);
+
+      endOffset=scanner.GetPos();
+
+      for (size_t i=0; i<childCount; i++) {
+        scanner.ReadFileOffset(endOffset);
+        scanner.SetPos(endOffset);
+      }
+
+      auto offset=std::lower_bound(regionOffsets.begin(),
+                                   regionOffsets.end(),
+                                   region.regionOffset);
+
+      while (offset!=regionOffsets.end() &&
+             *offset<endOffset &&
+             !stopped) {
+        AdminRegion subRegion;
+
+        scanner.SetPos(*offset);
+
+        if (!LoadAdminRegion(scanner,
+                             subRegion)) {
+          return false;
+        }
+
+        scanner.SetPos(subRegion.dataOffset);
+
+        if (!LoadRegionDataEntry(scanner,
+                                 subRegion,
+                                 visitor,
+                                 stopped)) {
+          return false;
+        }
+
+        ++offset;
+      }
+
+      scanner.Close();
+
+      return true;
+    }
+    catch (IOException& e) {
+      log.Error() << e.GetDescription();
+      scanner.CloseFailsafe();
+      return false;
+    }
+  }
+
+  bool LocationIndex::HasReverseIndex() const
+  {
+    return hasReverseIndex;
+  }
+
+  bool LocationIndex::GetRegionAt(const GeoCoord& coord,
+                                  AdminRegionRef& region) const
+  {
+    assert(hasReverseIndex);
+
+    region=NULL;
+
+    if (!reverseRegionBox.IsValid() ||
+        !reverseRegionBox.Includes(coord)) {
+      return true;
+    }
+
+    size_t x=GetReverseRegionCell(coord.GetLon(),reverseRegionBox.GetMinLon(),reverseRegionCellWidth);
+    size_t y=GetReverseRegionCell(coord.GetLat(),reverseRegionBox.GetMinLat(),reverseRegionCellHeight);
+
+    const std::vector<size_t>& candidates=reverseRegionGrid[y*REVERSE_REGION_GRID_SIZE+x];
+    const ReverseRegionEntry*  bestRegion=NULL;
+
+    if (candidates.empty()) {
+      return true;
+    }
+
+    FileScanner reverseIndexScanner;
+
+    try {
+      std::vector<Point> nodes;
+
+      reverseIndexScanner.Open(reverseScanner,
+                               FileScanner::LowMemRandom);
+
+      for (const auto r : candidates) {
+        const ReverseRegionEntry& candidate=reverseRegions[r];
+
+        // Regions are nested, we are only interested in the deepest one
+        if ((bestRegion!=NULL &&
+             candidate.depth<=bestRegion->depth) ||
+            !candidate.boundingBox.Includes(coord)) {
+          continue;
+        }
+
+        uint32_t polygonCount;
+
+        reverseIndexScanner.SetPos(candidate.polygonsOffset);
+        reverseIndexScanner.ReadNumber(polygonCount);
+
+        for (size_t p=0; p<polygonCount; p++) {
+          reverseIndexScanner.Read(nodes,
+                                   false);
+
+          if (IsCoordInArea(coord,
+                            nodes)) {
+            bestRegion=&candidate;
+            break;
+          }
+        }
+      }
+
+      reverseIndexScanner.Close();
+    }
+    catch (IOException& e) {
+      log.Error() << e.GetDescription();
+      reverseIndexScanner.CloseFailsafe();
+      return false;
+    }
+
+    if (bestRegion==NULL) {
+      return true;
+    }
+
+    FileScanner scanner;
+
+    try {
+      scanner.Open(AppendFileToDir(path,
+                                   FILENAME_LOCATION_IDX),
+                   FileScanner::LowMemRandom,
+                   true);
+
+      AdminRegion adminRegion;
+
+      scanner.SetPos(bestRegion->regionOffset);
+
+      if (!LoadAdminRegion(scanner,
+                           adminRegion)) {
+        return false;
+      }
+
+      region=std::make_shared<AdminRegion>(adminRegion);
+
+      scanner.Close();
+
+      return true;
+    }
+    catch (IOException& e) {
+      log.Error() << e.GetDescription();
+      scanner.CloseFailsafe();
+      return false;
+    }
+  }
+
+  void LocationIndex::ReadReverseIndexEntry(FileScanner& scanner,
+                                            ReverseIndexEntry& entry) const
+  {
+    uint8_t    type;
+    FileOffset offset;
+
+    scanner.Read(type);
+    scanner.ReadFileOffset(offset);
+
+    entry.object.Set(offset,
+                     (RefType)type);
+
+    scanner.ReadFileOffset(entry.regionOffset);
+    scanner.ReadFileOffset(entry.locationOffset);
+    scanner.ReadFileOffset(entry.entryOffset);
+    scanner.ReadBox(entry.boundingBox);
+  }
+
+  bool LocationIndex::GetReverseIndexEntries(const GeoBox& box,
+                                             std::vector<ReverseIndexEntry>& entries) const
+  {
+    assert(hasReverseIndex);
+
+    entries.clear();
+
+    if (!box.IsValid() ||
+        reverseCells.empty()) {
+      return true;
+    }
+
+    uint32_t minX=(uint32_t)(std::max(box.GetMinLon()+180.0,0.0)*REVERSE_CELLS_PER_DEGREE);
+    uint32_t maxX=(uint32_t)(std::max(box.GetMaxLon()+180.0,0.0)*REVERSE_CELLS_PER_DEGREE);
+    uint32_t minY=(uint32_t)(std::max(box.GetMinLat()+90.0,0.0)*REVERSE_CELLS_PER_DEGREE);
+    uint32_t maxY=(uint32_t)(std::max(box.GetMaxLat()+90.0,0.0)*REVERSE_CELLS_PER_DEGREE);
+
+    // Cells are sorted by row and column, rows outside of the first and the
+    // last non-empty cell do not need to be looked at
+    minY=std::max(minY,(uint32_t)(reverseCells.front().cellId >> 32));
+    maxY=std::min(maxY,(uint32_t)(reverseCells.back().cellId >> 32));
+
+    FileScanner scanner;
+
+    try {
+      scanner.Open(reverseScanner,
+                   FileScanner::LowMemRandom);
+
+      for (uint32_t y=minY; y<=maxY; y++) {
+        ReverseCellEntry key;
+        uint64_t         lastCellId=GetReverseCellId(maxX,y);
+
+        key.cellId=GetReverseCellId(minX,y);
+
+        // Only the non-empty cells of the row within the box are visited
+        for (auto cell=std::lower_bound(reverseCells.begin(),
+                                        reverseCells.end(),
+                                        key);
+             cell!=reverseCells.end() &&
+             cell->cellId<=lastCellId;
+             ++cell) {
+          scanner.SetPos(cell->entryOffset);
+
+          for (size_t i=0; i<cell->count; i++) {
+            ReverseIndexEntry entry;
+
+            ReadReverseIndexEntry(scanner,
+                                  entry);
+
+            if (entry.boundingBox.Intersects(box)) {
+              entries.push_back(entry);
+            }
+          }
+        }
+      }
+
+      scanner.Close();
+    }
+    catch (IOException& e) {
+      log.Error() << e.GetDescription();
+      scanner.CloseFailsafe();
+      return false;
+    }
+
+    // Entries spanning multiple cells are stored in each of them
+    std::sort(entries.begin(),
+              entries.end(),
+              [](const ReverseIndexEntry& a, const ReverseIndexEntry& b) {
+                return a.entryOffset<b.entryOffset;
+              });
+
+    entries.erase(std::unique(entries.begin(),
+                              entries.end(),
+                              [](const ReverseIndexEntry& a, const ReverseIndexEntry& b) {
+                                return a.entryOffset==b.entryOffset;
+                              }),
+                  entries.end());
+
+    return true;
+  }
+
+  bool LocationIndex::LoadReverseIndexEntry(const ReverseIndexEntry& entry,
+                                            AdminRegionRef& region,
+                                            LocationRef& location,
+                                            AddressRef& address,
+                                            POIRef& poi) const
+  {
+    FileScanner scanner;
+
+    region=NULL;
+    location=NULL;
+    address=NULL;
+    poi=NULL;
+
+    try {
+      scanner.Open(AppendFileToDir(path,
+                                   FILENAME_LOCATION_IDX),
+                   FileScanner::LowMemRandom,
+                   true);
+
+      AdminRegion adminRegion;
+
+      scanner.SetPos(entry.regionOffset);
+
+      if (!LoadAdminRegion(scanner,
+                           adminRegion)) {
+        return false;
+      }
+
+      region=std::make_shared<AdminRegion>(adminRegion);
+
+      if (entry.IsAddress()) {
+        location=std::make_shared<Location>();
+        location->regionOffset=entry.regionOffset;
+
+        scanner.SetPos(entry.locationOffset);
+
+        LoadLocation(scanner,
+                     *location);
+
+        address=std::make_shared<Address>();
+
+        address->addressOffset=entry.entryOffset;
+        address->locationOffset=entry.locationOffset;
+        address->regionOffset=entry.regionOffset;
+        address->object=entry.object;
+
+        scanner.SetPos(entry.entryOffset);
+        scanner.Read(address->name);
+      }
+      else {
+        poi=std::make_shared<POI>();
+
+        poi->regionOffset=entry.regionOffset;
+        poi->object=entry.object;
+
+        scanner.SetPos(entry.entryOffset);
+        scanner.Read(poi->name);
+      }
+
+      scanner.Close();
+
+      return true;
+    }
+    catch (IOException& e) {
+      log.Error() << e.GetDescription();
+      scanner.CloseFailsafe();
+      return false;
+    }
+  }
+
   void LocationIndex::DumpStatistics()
   {
     size_t memory=0;
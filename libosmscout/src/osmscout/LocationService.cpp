@@ -19,6 +19,8 @@
 
 #include <osmscout/LocationService.h>
 
+#include <algorithm>
+
 #include <osmscout/util/Geometry.h>
 #include <osmscout/util/Logger.h>
 #include <osmscout/util/String.h>
@@ -98,31 +100,6 @@ namespace osmscout {
     candidate=matchPosition!=std::string::npos;
   }
 
-  void LocationService::VisitorMatcher::TolowerUmlaut(std::string& s) const
-  {
-    for (std::string::iterator it=s.begin();
-         it!=s.end();
-         ++it)
-    {
-      /* this filter matches all character from the table
-       * http://en.wikipedia.org/wiki/Latin-1_Supplement_%28Unicode_block%29#Compact_table
-       * beginning at U+0x00C0 to U+0x00DE
-       */
-      if((uint8_t)*it == 0xC3)
-      {
-        ++it;
-
-        if((uint8_t)*it>=0x80 && (uint8_t)*it<=0x9E) {
-          // 0x9F is german "sz" which is already small caps.
-          *it+=0x20;
-        }
-      }
-      else {
-        *it=tolower(*it);
-      }
-    }
-  }
-
   LocationService::AdminRegionMatchVisitor::AdminRegionMatchVisitor(const std::string& pattern,
                                                                     size_t limit)
   : VisitorMatcher(pattern),
@@ -507,8 +484,39 @@ namespace osmscout {
                                                       refs);
   }
 
+  /**
+   * Lookup the candidates for the location and address pattern of the given search entry
+   * in the token index (if available)
+   */
+  bool LocationService::GetSearchEntryCandidates(const LocationIndex& locationIndex,
+                                                 const LocationSearch::Entry& searchEntry,
+                                                 SearchEntryCandidates& candidates) const
+  {
+    candidates.hasLocationCandidates=!searchEntry.locationPattern.empty() &&
+                                     locationIndex.CanUseTokenIndex(searchEntry.locationPattern);
+    candidates.hasAddressCandidates=!searchEntry.addressPattern.empty() &&
+                                    locationIndex.CanUseTokenIndex(searchEntry.addressPattern);
+
+    if (candidates.hasLocationCandidates &&
+        !locationIndex.GetTokenCandidates(LocationIndex::regionLocationTokenSection,
+                                          searchEntry.locationPattern,
+                                          candidates.locationRegionOffsets)) {
+      return false;
+    }
+
+    if (candidates.hasAddressCandidates &&
+        !locationIndex.GetTokenCandidates(LocationIndex::locationAddressTokenSection,
+                                          searchEntry.addressPattern,
+                                          candidates.addressLocationOffsets)) {
+      return false;
+    }
+
+    return true;
+  }
+
   bool LocationService::HandleAdminRegion(const LocationSearch& search,
                                           const LocationSearch::Entry& searchEntry,
+                                          const SearchEntryCandidates& candidates,
                                           const AdminRegionMatchVisitor::AdminRegionResult& adminRegionResult,
                                           LocationSearchResult& result) const
   {
@@ -540,8 +548,19 @@ namespace osmscout {
                                  search.limit>=result.results.size() ? search.limit-result.results.size() : 0);
 
 
-    if (!VisitAdminRegionLocations(*adminRegionResult.adminRegion,
-                                   visitor)) {
+    if (candidates.hasLocationCandidates) {
+      LocationIndexRef locationIndex=database->GetLocationIndex();
+
+      if (!locationIndex ||
+          !locationIndex->VisitAdminRegionLocations(*adminRegionResult.adminRegion,
+                                                    candidates.locationRegionOffsets,
+                                                    visitor)) {
+        log.Error() << "Error during traversal of region location list";
+        return false;
+      }
+    }
+    else if (!VisitAdminRegionLocations(*adminRegionResult.adminRegion,
+                                        visitor)) {
       log.Error() << "Error during traversal of region location list";
       return false;
     }
@@ -568,6 +587,7 @@ namespace osmscout {
       //std::cout << "  - '" << locationResult->location->name << "'" << std::endl;
       if (!HandleAdminRegionLocation(search,
                                      searchEntry,
+                                     candidates,
                                      adminRegionResult,
                                      locationResult,
                                      result)) {
@@ -581,6 +601,7 @@ namespace osmscout {
 
   bool LocationService::HandleAdminRegionLocation(const LocationSearch& search,
                                                   const LocationSearch::Entry& searchEntry,
+                                                  const SearchEntryCandidates& candidates,
                                                   const AdminRegionMatchVisitor::AdminRegionResult& adminRegionResult,
                                                   const LocationMatchVisitor::LocationResult& locationResult,
                                                   LocationSearchResult& result) const
@@ -619,11 +640,18 @@ namespace osmscout {
                                 search.limit>=result.results.size() ? search.limit-result.results.size() : 0);
 
 
-    if (!VisitLocationAddresses(*locationResult.adminRegion,
-                                *locationResult.location,
-                                visitor)) {
-      log.Error() << "Error during traversal of region location address list";
-      return false;
+    // If the token index tells us, that no address of the location can match,
+    // we can skip the traversal, the visitor result would be empty anyway
+    if (!candidates.hasAddressCandidates ||
+        std::binary_search(candidates.addressLocationOffsets.begin(),
+                           candidates.addressLocationOffsets.end(),
+                           locationResult.location->locationOffset)) {
+      if (!VisitLocationAddresses(*locationResult.adminRegion,
+                                  *locationResult.location,
+                                  visitor)) {
+        log.Error() << "Error during traversal of region location address list";
+        return false;
+      }
     }
 
     if (visitor.results.empty()) {
@@ -895,6 +923,8 @@ namespace osmscout {
   bool LocationService::SearchForLocations(const LocationSearch& search,
                                            LocationSearchResult& result) const
   {
+    LocationIndexRef locationIndex=database->GetLocationIndex();
+
     result.limitReached=false;
     result.results.clear();
 
@@ -907,12 +937,40 @@ namespace osmscout {
 
       AdminRegionMatchVisitor adminRegionVisitor(searchEntry.adminRegionPattern,
                                                  search.limit);
-
-      if (!VisitAdminRegions(adminRegionVisitor)) {
+      SearchEntryCandidates   candidates;
+
+      candidates.hasLocationCandidates=false;
+      candidates.hasAddressCandidates=false;
+
+      if (locationIndex &&
+          locationIndex->CanUseTokenIndex(searchEntry.adminRegionPattern)) {
+        // Only visit the regions whose names (or aliases) contain all
+        // tokens of the pattern, the visitor then does the actual matching
+        std::vector<FileOffset> regionOffsets;
+
+        if (!locationIndex->GetTokenCandidates(LocationIndex::regionTokenSection,
+                                               searchEntry.adminRegionPattern,
+                                               regionOffsets) ||
+            !locationIndex->VisitAdminRegions(regionOffsets,
+                                              adminRegionVisitor)) {
+          log.Error() << "Error during traversal of region tree";
+          return false;
+        }
+      }
+      else if (!VisitAdminRegions(adminRegionVisitor)) {
         log.Error() << "Error during traversal of region tree";
         return false;
       }
 
+      if (locationIndex &&
+          !adminRegionVisitor.results.empty() &&
+          !GetSearchEntryCandidates(*locationIndex,
+                                    searchEntry,
+                                    candidates)) {
+        log.Error() << "Error during lookup of location token index";
+        return false;
+      }
+
       if (adminRegionVisitor.limitReached) {
         result.limitReached=true;
       }
@@ -922,6 +980,7 @@ namespace osmscout {
 
         if (!HandleAdminRegion(search,
                                searchEntry,
+                               candidates,
                                regionResult,
                                result)) {
           return false;
@@ -1317,62 +1376,229 @@ namespace osmscout {
                                 result);
   }
 
-  bool LocationService::DescribeLocationByAddress(const GeoCoord& location,
-                                                  LocationDescription& description)
+  /**
+   * Return the distance of the given coordinate to the given bounding box in meter
+   * (0, if the coordinate is within the box).
+   */
+  static double GetDistanceToBox(const GeoCoord& coord,
+                                 const GeoBox& box)
   {
-    TypeConfigRef    typeConfig=database->GetTypeConfig();
-    AreaAreaIndexRef areaAreaIndex=database->GetAreaAreaIndex();
-    GeoBox           box100=GeoBox::BoxByCenterAndRadius(location,100);
+    GeoCoord closest(std::max(box.GetMinLat(),std::min(coord.GetLat(),box.GetMaxLat())),
+                     std::max(box.GetMinLon(),std::min(coord.GetLon(),box.GetMaxLon())));
 
-    if (!typeConfig ||
-        !areaAreaIndex) {
+    return GetEllipsoidalDistance(coord,
+                                  closest)*1000.0;
+  }
+
+  /**
+   * Lookup the closest address (or POI if there is no address in range)
+   * and the hierarchy of regions for the given coordinate using the
+   * reverse lookup index.
+   *
+   * @param coord
+   *    The coordinate to lookup
+   * @param maxDistance
+   *    Maximum distance of the address or POI in meter
+   * @param result
+   *    The result, result.place.object is invalid, if there was no address
+   *    or POI in range
+   * @return
+   *    True, if there was no error
+   */
+  bool LocationService::ReverseLookupCoord(const GeoCoord& coord,
+                                           double maxDistance,
+                                           CoordReverseLookupResult& result) const
+  {
+    LocationIndexRef locationIndex=database->GetLocationIndex();
+
+    result.regions.clear();
+    result.place=ReverseLookupResult();
+    result.distance=0.0;
+
+    if (!locationIndex) {
       return false;
     }
 
-    TypeInfoSet addressTypes;
+    if (!locationIndex->HasReverseIndex()) {
+      log.Error() << "Reverse lookup index not available";
+      return false;
+    }
 
-    for (const auto& type : typeConfig->GetTypes()) {
-      if (type->CanBeArea() &&
-          type->HasFeature(AddressFeature::NAME)) {
-        addressTypes.Set(type);
+    AdminRegionRef region;
+
+    if (!locationIndex->GetRegionAt(coord,
+                                    region)) {
+      return false;
+    }
+
+    if (region) {
+      std::map<FileOffset,AdminRegionRef> refs;
+
+      if (!locationIndex->ResolveAdminRegionHierachie(region,
+                                                      refs)) {
+        return false;
+      }
+
+      while (region) {
+        result.regions.push_back(region);
+
+        auto parent=refs.find(region->parentRegionOffset);
+
+        if (region->parentRegionOffset==0 ||
+            parent==refs.end()) {
+          break;
+        }
+
+        region=parent->second;
       }
     }
 
-    if (addressTypes.Empty()) {
+    std::vector<LocationIndex::ReverseIndexEntry> entries;
+
+    // BoxByCenterAndRadius() places the corners (not the edges) of the
+    // box at the given distance, so we enlarge it to cover the circle
+    if (!locationIndex->GetReverseIndexEntries(GeoBox::BoxByCenterAndRadius(coord,
+                                                                            maxDistance*1.5),
+                                               entries)) {
+      return false;
+    }
+
+    const LocationIndex::ReverseIndexEntry* bestEntry=NULL;
+    double                                  bestDistance=maxDistance;
+
+    for (const auto& entry : entries) {
+      double distance=GetDistanceToBox(coord,
+                                       entry.boundingBox);
+
+      if (distance>maxDistance) {
+        continue;
+      }
+
+      // Addresses always win over POIs
+      if (bestEntry==NULL ||
+          (entry.IsAddress() && !bestEntry->IsAddress()) ||
+          (entry.IsAddress()==bestEntry->IsAddress() && distance<bestDistance)) {
+        bestEntry=&entry;
+        bestDistance=distance;
+      }
+    }
+
+    if (bestEntry==NULL) {
       return true;
     }
 
-    std::vector<DataBlockSpan> areaSpans;
-    TypeInfoSet                loadedAddressTypes;
+    result.place.object=bestEntry->object;
+    result.distance=bestDistance;
 
-    if (!areaAreaIndex->GetAreasInArea(*typeConfig,
-                                       box100,
-                                       std::numeric_limits<size_t>::max(),
-                                       addressTypes,
-                                       areaSpans,
-                                       loadedAddressTypes)) {
+    return locationIndex->LoadReverseIndexEntry(*bestEntry,
+                                                result.place.adminRegion,
+                                                result.place.location,
+                                                result.place.address,
+                                                result.place.poi);
+  }
+
+  /**
+   * Describe the location by the closest address area within 100m using
+   * the reverse lookup index
+   */
+  bool LocationService::DescribeLocationByAddressIndex(const LocationIndex& locationIndex,
+                                                       const GeoCoord& location,
+                                                       LocationDescription& description)
+  {
+    GeoBox                                        box100=GeoBox::BoxByCenterAndRadius(location,100);
+    std::vector<LocationIndex::ReverseIndexEntry> entries;
+    std::vector<FileOffset>                       offsets;
+
+    if (!locationIndex.GetReverseIndexEntries(box100,
+                                              entries)) {
       return false;
     }
 
-    if (areaSpans.empty()) {
+    for (const auto& entry : entries) {
+      if (entry.IsAddress() &&
+          entry.object.GetType()==refArea) {
+        offsets.push_back(entry.object.GetFileOffset());
+      }
+    }
+
+    if (offsets.empty()) {
       return true;
     }
 
     std::vector<AreaRef> areas;
 
-    if (!database->GetAreasByBlockSpans(areaSpans,
-                                        areas)) {
+    if (!database->GetAreasByOffset(offsets,
+                                    areas)) {
       return false;
     }
 
-    if (areas.empty()) {
+    bool    atPlace;
+    AreaRef placeArea;
+    double  distance;
+    double  bearing;
+
+    GetClosestArea(location,
+                   areas,
+                   atPlace,
+                   placeArea,
+                   distance,
+                   bearing);
+
+    if (!placeArea) {
       return true;
     }
 
-    bool    atPlace=false;
-    AreaRef placeArea;
-    double  distance=std::numeric_limits<double>::max(); // In Km
-    double  bearing;
+    for (const auto& entry : entries) {
+      if (entry.IsAddress() &&
+          entry.object==ObjectFileRef(placeArea->GetFileOffset(),refArea)) {
+        AdminRegionRef adminRegion;
+        LocationRef    loc;
+        AddressRef     address;
+        POIRef         poi;
+
+        if (!locationIndex.LoadReverseIndexEntry(entry,
+                                                 adminRegion,
+                                                 loc,
+                                                 address,
+                                                 poi)) {
+          return false;
+        }
+
+        Place place=Place(entry.object,
+                          adminRegion,
+                          poi,
+                          loc,
+                          address);
+
+        if (atPlace) {
+          description.SetAtAddressDescription(std::make_shared<LocationAtPlaceDescription>(place));
+        }
+        else {
+          description.SetAtAddressDescription(std::make_shared<LocationAtPlaceDescription>(place,distance*1000,bearing));
+        }
+
+        break;
+      }
+    }
+
+    return true;
+  }
+
+  /**
+   * Find the area the location is in or - if it is not in any of them - the area
+   * with the closest border. distance is in km.
+   */
+  void LocationService::GetClosestArea(const GeoCoord& location,
+                                       const std::vector<AreaRef>& areas,
+                                       bool& atPlace,
+                                       AreaRef& placeArea,
+                                       double& distance,
+                                       double& bearing)
+  {
+    atPlace=false;
+    placeArea=NULL;
+    distance=std::numeric_limits<double>::max(); // In Km
+    bearing=0.0;
 
     for (const auto& area : areas) {
       for (const auto& ring : area->rings) {
@@ -1418,6 +1644,80 @@ namespace osmscout {
         }
       }
     }
+  }
+
+  bool LocationService::DescribeLocationByAddress(const GeoCoord& location,
+                                                  LocationDescription& description)
+  {
+    LocationIndexRef locationIndex=database->GetLocationIndex();
+
+    if (locationIndex &&
+        locationIndex->HasReverseIndex()) {
+      return DescribeLocationByAddressIndex(*locationIndex,
+                                            location,
+                                            description);
+    }
+
+    TypeConfigRef    typeConfig=database->GetTypeConfig();
+    AreaAreaIndexRef areaAreaIndex=database->GetAreaAreaIndex();
+    GeoBox           box100=GeoBox::BoxByCenterAndRadius(location,100);
+
+    if (!typeConfig ||
+        !areaAreaIndex) {
+      return false;
+    }
+
+    TypeInfoSet addressTypes;
+
+    for (const auto& type : typeConfig->GetTypes()) {
+      if (type->CanBeArea() &&
+          type->HasFeature(AddressFeature::NAME)) {
+        addressTypes.Set(type);
+      }
+    }
+
+    if (addressTypes.Empty()) {
+      return true;
+    }
+
+    std::vector<DataBlockSpan> areaSpans;
+    TypeInfoSet                loadedAddressTypes;
+
+    if (!areaAreaIndex->GetAreasInArea(*typeConfig,
+                                       box100,
+                                       std::numeric_limits<size_t>::max(),
+                                       addressTypes,
+                                       areaSpans,
+                                       loadedAddressTypes)) {
+      return false;
+    }
+
+    if (areaSpans.empty()) {
+      return true;
+    }
+
+    std::vector<AreaRef> areas;
+
+    if (!database->GetAreasByBlockSpans(areaSpans,
+                                        areas)) {
+      return false;
+    }
+
+    if (areas.empty()) {
+      return true;
+    }
+
+    bool    atPlace;
+    AreaRef placeArea;
+    double  distance;
+    double  bearing;
+
+    GetClosestArea(location,
+                   areas,
+                   atPlace,
+                   placeArea,
+                   distance,
+                   bearing);
 
     if (placeArea) {
       std::list<ReverseLookupResult> result;
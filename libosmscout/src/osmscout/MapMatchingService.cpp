@@ -0,0 +1,1310 @@
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2016  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <osmscout/MapMatchingService.h>
+
+#include <algorithm>
+#include <limits>
+#include <queue>
+
+#include <osmscout/system/Math.h>
+
+#include <osmscout/util/Geometry.h>
+#include <osmscout/util/Logger.h>
+
+namespace osmscout {
+
+  /**
+   * Meters per degree latitude, used for approximated distances of close
+   * coordinates
+   */
+  static const double METERS_PER_DEGREE=111195.0;
+
+  static const uint8_t WAY_USABLE   = 1 << 0;
+  static const uint8_t WAY_FORWARD  = 1 << 1;
+  static const uint8_t WAY_BACKWARD = 1 << 2;
+
+  static const size_t SEARCH_CACHE_SIZE      = 2000;
+  static const size_t MAX_SESSION_TILES      = 64;
+  static const size_t SEGMENTS_PER_CANDIDATE = 4; //!< Initial number of segments requested per candidate
+
+  static inline uint32_t GetTileX(double lon)
+  {
+    return (uint32_t)floor((lon+180.0)/MapMatchingService::TILE_SIZE);
+  }
+
+  static inline uint32_t GetTileY(double lat)
+  {
+    return (uint32_t)floor((lat+90.0)/MapMatchingService::TILE_SIZE);
+  }
+
+  /**
+   * Approximated distance in meters of two close coordinates
+   */
+  static inline double GetLocalDistance(const GeoCoord& a,
+                                        const GeoCoord& b)
+  {
+    double dx=(b.GetLon()-a.GetLon())*cos(a.GetLat()*M_PI/180.0);
+    double dy=b.GetLat()-a.GetLat();
+
+    return sqrt(dx*dx+dy*dy)*METERS_PER_DEGREE;
+  }
+
+  MapMatchingParameter::MapMatchingParameter()
+  : searchRadius(50.0),
+    gpsSigma(10.0),
+    transitionBeta(20.0),
+    maxDetourFactor(2.0),
+    maxCandidates(8),
+    maxLag(100),
+    tileCacheSize(256)
+  {
+    // no code
+  }
+
+  void MapMatchingParameter::SetSearchRadius(double searchRadius)
+  {
+    this->searchRadius=searchRadius;
+  }
+
+  void MapMatchingParameter::SetGPSSigma(double gpsSigma)
+  {
+    this->gpsSigma=gpsSigma;
+  }
+
+  void MapMatchingParameter::SetTransitionBeta(double transitionBeta)
+  {
+    this->transitionBeta=transitionBeta;
+  }
+
+  void MapMatchingParameter::SetMaxDetourFactor(double maxDetourFactor)
+  {
+    this->maxDetourFactor=maxDetourFactor;
+  }
+
+  void MapMatchingParameter::SetMaxCandidates(size_t maxCandidates)
+  {
+    this->maxCandidates=maxCandidates;
+  }
+
+  void MapMatchingParameter::SetMaxLag(size_t maxLag)
+  {
+    this->maxLag=maxLag;
+  }
+
+  void MapMatchingParameter::SetTileCacheSize(size_t tileCacheSize)
+  {
+    this->tileCacheSize=tileCacheSize;
+  }
+
+  double MapMatchingParameter::GetSearchRadius() const
+  {
+    return searchRadius;
+  }
+
+  double MapMatchingParameter::GetGPSSigma() const
+  {
+    return gpsSigma;
+  }
+
+  double MapMatchingParameter::GetTransitionBeta() const
+  {
+    return transitionBeta;
+  }
+
+  double MapMatchingParameter::GetMaxDetourFactor() const
+  {
+    return maxDetourFactor;
+  }
+
+  size_t MapMatchingParameter::GetMaxCandidates() const
+  {
+    return maxCandidates;
+  }
+
+  size_t MapMatchingParameter::GetMaxLag() const
+  {
+    return maxLag;
+  }
+
+  size_t MapMatchingParameter::GetTileCacheSize() const
+  {
+    return tileCacheSize;
+  }
+
+  const double MapMatchingService::TILE_SIZE=0.02;
+
+  MapMatchingService::MapMatchingService(const DatabaseRef& database,
+                                         const MapMatchingParameter& parameter)
+  : database(database),
+    parameter(parameter),
+    tileCache(parameter.GetTileCacheSize())
+  {
+    // no code
+  }
+
+  MapMatchingService::~MapMatchingService()
+  {
+    // no code
+  }
+
+  const MapMatchingParameter& MapMatchingService::GetParameter() const
+  {
+    return parameter;
+  }
+
+  uint64_t MapMatchingService::GetTileKey(Vehicle vehicle,
+                                          uint32_t x,
+                                          uint32_t y)
+  {
+    return ((uint64_t)vehicle << 56) | ((uint64_t)x << 28) | (uint64_t)y;
+  }
+
+  /**
+   * Load all ways routable for the given vehicle in the given tile and
+   * build the junction table of the tile
+   */
+  bool MapMatchingService::LoadTile(Vehicle vehicle,
+                                    uint32_t x,
+                                    uint32_t y,
+                                    RoadTile& tile) const
+  {
+    TypeConfigRef   typeConfig=database->GetTypeConfig();
+    AreaWayIndexRef areaWayIndex=database->GetAreaWayIndex();
+    WayDataFileRef  wayDataFile=database->GetWayDataFile();
+
+    if (!typeConfig ||
+        !areaWayIndex ||
+        !wayDataFile) {
+      log.Error() << "Cannot load road network, database is not open!";
+      return false;
+    }
+
+    tile.boundingBox.Set(GeoCoord(y*TILE_SIZE-90.0,
+                                  x*TILE_SIZE-180.0),
+                         GeoCoord((y+1)*TILE_SIZE-90.0,
+                                  (x+1)*TILE_SIZE-180.0));
+
+    TypeInfoSet types;
+
+    for (const auto& type : typeConfig->GetWayTypes()) {
+      if (type->CanRoute(vehicle)) {
+        types.Set(type);
+      }
+    }
+
+    std::vector<FileOffset> offsets;
+    TypeInfoSet             loadedTypes;
+    std::vector<WayRef>     ways;
+
+    if (!areaWayIndex->GetOffsets(tile.boundingBox,
+                                  types,
+                                  offsets,
+                                  loadedTypes)) {
+      log.Error() << "Error getting ways from area way index!";
+      return false;
+    }
+
+    std::sort(offsets.begin(),
+              offsets.end());
+
+    if (!wayDataFile->GetByOffset(offsets,
+                                  ways)) {
+      log.Error() << "Error reading ways of road network!";
+      return false;
+    }
+
+    for (const auto& way : ways) {
+      if (way->nodes.size()<2) {
+        continue;
+      }
+
+      RoadWayRef roadWay=std::make_shared<RoadWay>();
+      uint32_t   wayIndex=(uint32_t)tile.ways.size();
+      bool       used=false;
+
+      roadWay->way=way;
+      roadWay->ref.Set(way->GetFileOffset(),
+                       refWay);
+      roadWay->distances.resize(way->nodes.size());
+      roadWay->distances[0]=0.0;
+
+      for (size_t i=0; i<way->nodes.size(); i++) {
+        const Point& node=way->nodes[i];
+
+        if (i>0) {
+          roadWay->distances[i]=roadWay->distances[i-1]+
+            GetSphericalDistance(way->nodes[i-1].GetCoord(),
+                                 node.GetCoord())*1000.0;
+        }
+
+        if (!node.IsRelevant()) {
+          continue;
+        }
+
+        roadWay->junctions.push_back(i);
+
+        // Each junction is registered only in the tile it is located in
+        if (GetTileX(node.GetLon())==x &&
+            GetTileY(node.GetLat())==y) {
+          tile.junctions[node.GetId()].push_back(RoadWayIndex{wayIndex,(uint32_t)i});
+          used=true;
+        }
+      }
+
+      // Ways with a segment starting in the tile are kept, too, so that
+      // candidate segments of the route segment index can be resolved
+      // (see MapMatcher::GetWay())
+      for (size_t i=0; i+1<way->nodes.size() && !used; i++) {
+        const GeoCoord& from=way->nodes[i].GetCoord();
+
+        used=GetTileX(from.GetLon())==x &&
+             GetTileY(from.GetLat())==y;
+      }
+
+      if (used) {
+        tile.wayIndexes[way->GetFileOffset()]=wayIndex;
+        tile.ways.push_back(roadWay);
+      }
+    }
+
+    return true;
+  }
+
+  /**
+   * Return the given tile, either from cache or freshly loaded. Returns an
+   * empty reference, if the tile could not be loaded.
+   */
+  MapMatchingService::RoadTileRef MapMatchingService::GetTile(Vehicle vehicle,
+                                                              uint32_t x,
+                                                              uint32_t y) const
+  {
+    uint64_t key=GetTileKey(vehicle,x,y);
+
+    {
+      std::lock_guard<std::mutex> guard(tileMutex);
+      RoadTileCache::CacheRef     entry;
+
+      if (tileCache.GetEntry(key,entry)) {
+        return entry->value;
+      }
+    }
+
+    // We load the tile without holding the lock, in the worst case a tile is
+    // loaded twice by concurrent matchers
+    RoadTileRef tile=std::make_shared<RoadTile>();
+
+    if (!LoadTile(vehicle,
+                  x,
+                  y,
+                  *tile)) {
+      return NULL;
+    }
+
+    std::lock_guard<std::mutex> guard(tileMutex);
+
+    tileCache.SetEntry(RoadTileCache::CacheEntry(key,tile));
+
+    return tile;
+  }
+
+  /**
+   * Return the candidates of each of the given points. Points without
+   * candidates get an empty list.
+   */
+  bool MapMatchingService::GetCandidates(const RoutingProfile& profile,
+                                         const std::vector<GeoCoord>& points,
+                                         std::vector<std::vector<Candidate> >& candidates) const
+  {
+    if (!database->IsOpen()) {
+      log.Error() << "Database is not open!";
+      return false;
+    }
+
+    if (!database->GetRouteSegmentIndex()) {
+      log.Error() << "Route segment index is not available!";
+      return false;
+    }
+
+    MapMatcher                              matcher(*this,
+                                                    profile,
+                                                    MatchCallback());
+    std::vector<MapMatcher::MatchCandidate> matchCandidates;
+
+    candidates.clear();
+    candidates.resize(points.size());
+
+    for (size_t i=0; i<points.size(); i++) {
+      matchCandidates.clear();
+
+      matcher.GetCandidates(points[i],
+                            matchCandidates);
+
+      candidates[i].reserve(matchCandidates.size());
+
+      for (const auto& matchCandidate : matchCandidates) {
+        Candidate candidate;
+
+        candidate.object=matchCandidate.way->ref;
+        candidate.segmentIndex=matchCandidate.segmentIndex;
+        candidate.fraction=matchCandidate.fraction;
+        candidate.coord=matchCandidate.coord;
+        candidate.distance=matchCandidate.distance;
+
+        candidates[i].push_back(candidate);
+      }
+    }
+
+    return true;
+  }
+
+  /**
+   * Match the complete trace and return the matched points (one for each
+   * point of the trace) and the resulting route.
+   */
+  bool MapMatchingService::MatchTrace(const RoutingProfile& profile,
+                                      const std::vector<GeoCoord>& points,
+                                      std::vector<MatchedPoint>& matchedPoints,
+                                      RouteData& route) const
+  {
+    if (!database->IsOpen()) {
+      log.Error() << "Database is not open!";
+      return false;
+    }
+
+    if (!database->GetRouteSegmentIndex()) {
+      log.Error() << "Route segment index is not available!";
+      return false;
+    }
+
+    matchedPoints.clear();
+    matchedPoints.reserve(points.size());
+    route.Clear();
+
+    MapMatcher matcher(*this,
+                       profile,
+                       [&matchedPoints,&route](const std::vector<MatchedPoint>& points,
+                                               const RouteData& routePart) {
+                         matchedPoints.insert(matchedPoints.end(),
+                                              points.begin(),
+                                              points.end());
+                         route.Append(routePart);
+                       });
+
+    for (const auto& point : points) {
+      matcher.AddPoint(point);
+    }
+
+    matcher.Finish();
+
+    return true;
+  }
+
+  void MapMatchingService::FlushCache()
+  {
+    std::lock_guard<std::mutex> guard(tileMutex);
+
+    tileCache.Flush();
+  }
+
+  MapMatcher::MapMatcher(const MapMatchingService& service,
+                         const RoutingProfile& profile,
+                         const MapMatchingService::MatchCallback& callback)
+  : service(service),
+    profile(profile),
+    callback(callback),
+    vehicle(profile.GetVehicle()),
+    routeSegmentIndex(service.database->GetRouteSegmentIndex()),
+    searchCache(SEARCH_CACHE_SIZE),
+    anchorEmitted(false),
+    pointCount(0),
+    skippedPoints(0),
+    hasLastNode(false)
+  {
+    // no code
+  }
+
+  MapMatcher::~MapMatcher()
+  {
+    // no code
+  }
+
+  MapMatcher::RoadTileRef MapMatcher::GetTile(uint32_t x,
+                                              uint32_t y)
+  {
+    uint64_t key=MapMatchingService::GetTileKey(vehicle,x,y);
+    auto     entry=tiles.find(key);
+
+    if (entry!=tiles.end()) {
+      return entry->second;
+    }
+
+    if (tiles.size()>=MAX_SESSION_TILES) {
+      tiles.clear();
+      wayAccess.clear();
+    }
+
+    RoadTileRef tile=service.GetTile(vehicle,x,y);
+
+    tiles[key]=tile;
+
+    return tile;
+  }
+
+  MapMatcher::RoadTileRef MapMatcher::GetTile(const GeoCoord& coord)
+  {
+    return GetTile(GetTileX(coord.GetLon()),
+                   GetTileY(coord.GetLat()));
+  }
+
+  /**
+   * Return the usability of the way for the routing profile as combination
+   * of the WAY_* flags
+   */
+  uint8_t MapMatcher::GetWayAccess(const RoadWay& way)
+  {
+    auto entry=wayAccess.find(way.way->GetFileOffset());
+
+    if (entry!=wayAccess.end()) {
+      return entry->second;
+    }
+
+    uint8_t access=0;
+
+    if (profile.CanUse(*way.way)) {
+      access|=WAY_USABLE;
+
+      if (profile.CanUseForward(*way.way)) {
+        access|=WAY_FORWARD;
+      }
+
+      if (profile.CanUseBackward(*way.way)) {
+        access|=WAY_BACKWARD;
+      }
+    }
+
+    wayAccess[way.way->GetFileOffset()]=access;
+
+    return access;
+  }
+
+  /**
+   * Return the way of the given segment from the tile the segment starts in.
+   * Returns an empty reference, if the way is not part of the road network.
+   */
+  MapMatcher::RoadWayRef MapMatcher::GetWay(const RouteSegmentIndex::Segment& segment)
+  {
+    RoadTileRef tile=GetTile(segment.from);
+
+    if (!tile) {
+      return NULL;
+    }
+
+    auto entry=tile->wayIndexes.find(segment.object.GetFileOffset());
+
+    if (entry==tile->wayIndexes.end()) {
+      return NULL;
+    }
+
+    return tile->ways[entry->second];
+  }
+
+  /**
+   * Return the nearest point of each usable way within the search radius
+   * of the given coordinate, sorted by distance. The nearest segments are
+   * taken from the route segment index, if not enough usable ways are found
+   * within the requested segments, the request is repeated with more segments.
+   */
+  void MapMatcher::GetCandidates(const GeoCoord& coord,
+                                 std::vector<MatchCandidate>& candidates)
+  {
+    const MapMatchingParameter& parameter=service.GetParameter();
+    size_t                      maxSegments=parameter.GetMaxCandidates()*SEGMENTS_PER_CANDIDATE;
+
+    candidates.clear();
+
+    if (!routeSegmentIndex) {
+      return;
+    }
+
+    while (true) {
+      if (!routeSegmentIndex->GetNearestSegments(coord,
+                                                 vehicle,
+                                                 maxSegments,
+                                                 parameter.GetSearchRadius()/1000.0,
+                                                 segments)) {
+        return;
+      }
+
+      candidates.clear();
+
+      for (const auto& segment : segments) {
+        // Only ways are matched
+        if (segment.object.GetType()!=refWay) {
+          continue;
+        }
+
+        // Segments are sorted by distance, so only the first segment of each way is kept
+        auto existing=std::find_if(candidates.begin(),
+                                   candidates.end(),
+                                   [&segment](const MatchCandidate& candidate) {
+                                     return candidate.way->ref==segment.object;
+                                   });
+
+        if (existing!=candidates.end()) {
+          continue;
+        }
+
+        RoadWayRef way=GetWay(segment);
+
+        if (!way ||
+            (GetWayAccess(*way) & WAY_USABLE)==0) {
+          continue;
+        }
+
+        double         length=GetLocalDistance(segment.from,segment.to);
+        MatchCandidate candidate;
+
+        candidate.way=way;
+        candidate.segmentIndex=segment.fromNodeIndex;
+        candidate.fraction=length>0.0 ? std::min(1.0,GetLocalDistance(segment.from,segment.coord)/length) : 0.0;
+        candidate.position=way->distances[candidate.segmentIndex]+
+                           candidate.fraction*(way->distances[candidate.segmentIndex+1]-way->distances[candidate.segmentIndex]);
+        candidate.coord=segment.coord;
+        candidate.distance=segment.distance*1000.0;
+
+        candidates.push_back(candidate);
+
+        if (candidates.size()>=parameter.GetMaxCandidates()) {
+          return;
+        }
+      }
+
+      // All segments within the search radius have been checked
+      if (segments.size()<maxSegments) {
+        return;
+      }
+
+      maxSegments*=2;
+    }
+  }
+
+  /**
+   * Return the junctions the route can leave the way of the candidate at
+   */
+  void MapMatcher::GetExits(const MatchCandidate& candidate,
+                            std::vector<JunctionAccess>& exits)
+  {
+    const RoadWay& way=*candidate.way;
+    uint8_t        access=GetWayAccess(way);
+    auto           next=std::upper_bound(way.junctions.begin(),
+                                         way.junctions.end(),
+                                         candidate.segmentIndex);
+
+    exits.clear();
+
+    if ((access & WAY_FORWARD)!=0 &&
+        next!=way.junctions.end()) {
+      exits.push_back(JunctionAccess{way.way->nodes[*next].GetId(),
+                                     *next,
+                                     way.distances[*next]-candidate.position,
+                                     true});
+    }
+
+    if ((access & WAY_BACKWARD)!=0 &&
+        next!=way.junctions.begin()) {
+      --next;
+      exits.push_back(JunctionAccess{way.way->nodes[*next].GetId(),
+                                     *next,
+                                     candidate.position-way.distances[*next],
+                                     false});
+    }
+  }
+
+  /**
+   * Return the junctions the route can enter the way of the candidate at
+   */
+  void MapMatcher::GetEntries(const MatchCandidate& candidate,
+                              std::vector<JunctionAccess>& entries)
+  {
+    const RoadWay& way=*candidate.way;
+    uint8_t        access=GetWayAccess(way);
+    auto           next=std::upper_bound(way.junctions.begin(),
+                                         way.junctions.end(),
+                                         candidate.segmentIndex);
+
+    entries.clear();
+
+    if ((access & WAY_BACKWARD)!=0 &&
+        next!=way.junctions.end()) {
+      entries.push_back(JunctionAccess{way.way->nodes[*next].GetId(),
+                                       *next,
+                                       way.distances[*next]-candidate.position,
+                                       false});
+    }
+
+    if ((access & WAY_FORWARD)!=0 &&
+        next!=way.junctions.begin()) {
+      --next;
+      entries.push_back(JunctionAccess{way.way->nodes[*next].GetId(),
+                                       *next,
+                                       candidate.position-way.distances[*next],
+                                       true});
+    }
+  }
+
+  /**
+   * Return the shortest distances from the given junction to all junctions
+   * within the given distance. Results are cached and reused for later
+   * searches with the same or a smaller distance.
+   */
+  MapMatcher::SearchResultRef MapMatcher::Search(Id junction,
+                                                 const GeoCoord& coord,
+                                                 double maxDistance)
+  {
+    SearchCache::CacheRef entry;
+
+    if (searchCache.GetEntry(junction,entry) &&
+        entry->value->maxDistance>=maxDistance) {
+      return entry->value;
+    }
+
+    struct QueueEntry
+    {
+      double   distance;
+      Id       id;
+      GeoCoord coord;
+
+      inline bool operator<(const QueueEntry& other) const
+      {
+        return distance>other.distance;
+      }
+    };
+
+    SearchResultRef                 result=std::make_shared<SearchResult>();
+    std::priority_queue<QueueEntry> queue;
+
+    result->maxDistance=maxDistance;
+    result->nodes[junction]=SearchNode{0.0,junction,RoadWayRef(),0,0};
+    queue.push(QueueEntry{0.0,junction,coord});
+
+    while (!queue.empty()) {
+      QueueEntry current=queue.top();
+
+      queue.pop();
+
+      if (current.distance>result->nodes[current.id].distance) {
+        continue;
+      }
+
+      RoadTileRef tile=GetTile(current.coord);
+
+      if (!tile) {
+        continue;
+      }
+
+      auto ways=tile->junctions.find(current.id);
+
+      if (ways==tile->junctions.end()) {
+        continue;
+      }
+
+      for (const auto& index : ways->second) {
+        const RoadWayRef& way=tile->ways[index.way];
+        uint8_t           access=GetWayAccess(*way);
+
+        if ((access & WAY_USABLE)==0) {
+          continue;
+        }
+
+        auto junctionIter=std::lower_bound(way->junctions.begin(),
+                                           way->junctions.end(),
+                                           (size_t)index.index);
+
+        std::vector<size_t> targets;
+
+        if ((access & WAY_FORWARD)!=0 &&
+            junctionIter+1<way->junctions.end()) {
+          targets.push_back(*(junctionIter+1));
+        }
+
+        if ((access & WAY_BACKWARD)!=0 &&
+            junctionIter!=way->junctions.begin()) {
+          targets.push_back(*(junctionIter-1));
+        }
+
+        for (size_t target : targets) {
+          double distance=current.distance+std::abs(way->distances[target]-way->distances[index.index]);
+
+          if (distance>maxDistance) {
+            continue;
+          }
+
+          const Point& targetNode=way->way->nodes[target];
+          Id           targetId=targetNode.GetId();
+          auto         node=result->nodes.find(targetId);
+
+          if (node!=result->nodes.end() &&
+              node->second.distance<=distance) {
+            continue;
+          }
+
+          result->nodes[targetId]=SearchNode{distance,current.id,way,index.index,target};
+          queue.push(QueueEntry{distance,targetId,targetNode.GetCoord()});
+        }
+      }
+    }
+
+    searchCache.SetEntry(SearchCache::CacheEntry(junction,result));
+
+    return result;
+  }
+
+  /**
+   * Return the length of the shortest route from candidate 'from' to
+   * candidate 'to' or infinity, if there is no route shorter than
+   * 'maxDistance'. If 'route' is given the nodes of the route are returned
+   * as pairs of start and end index on a way, starting with the first node
+   * after 'from' and ending with the last node before 'to'. Movements
+   * within a segment do not result in route nodes.
+   */
+  double MapMatcher::GetRouteDistance(const MatchCandidate& from,
+                                      const MatchCandidate& to,
+                                      double maxDistance,
+                                      std::vector<RouteNode>* route)
+  {
+    const double infinity=std::numeric_limits<double>::infinity();
+
+    if (from.way->way->GetFileOffset()==to.way->way->GetFileOffset()) {
+      uint8_t access=GetWayAccess(*from.way);
+
+      if (to.position>=from.position &&
+          (access & WAY_FORWARD)!=0) {
+        if (route!=NULL &&
+            to.segmentIndex>from.segmentIndex) {
+          route->push_back(RouteNode{from.way,from.segmentIndex+1});
+          route->push_back(RouteNode{to.way,to.segmentIndex});
+        }
+
+        return to.position-from.position;
+      }
+
+      if (to.position<=from.position &&
+          (access & WAY_BACKWARD)!=0) {
+        if (route!=NULL &&
+            to.segmentIndex<from.segmentIndex) {
+          route->push_back(RouteNode{from.way,from.segmentIndex});
+          route->push_back(RouteNode{to.way,to.segmentIndex+1});
+        }
+
+        return from.position-to.position;
+      }
+
+      // Small backward movements on the same segment of a oneway are GPS noise
+      if (to.segmentIndex==from.segmentIndex &&
+          from.position-to.position<=service.GetParameter().GetGPSSigma()) {
+        return 0.0;
+      }
+    }
+
+    std::vector<JunctionAccess> exits;
+    std::vector<JunctionAccess> entries;
+
+    GetExits(from,exits);
+    GetEntries(to,entries);
+
+    double                bestDistance=infinity;
+    const JunctionAccess* bestExit=NULL;
+    const JunctionAccess* bestEntry=NULL;
+    SearchResultRef       bestResult;
+
+    for (const auto& exit : exits) {
+      if (exit.distance>maxDistance) {
+        continue;
+      }
+
+      SearchResultRef result=Search(exit.junction,
+                                    from.way->way->nodes[exit.junctionIndex].GetCoord(),
+                                    maxDistance);
+
+      for (const auto& entry : entries) {
+        auto node=result->nodes.find(entry.junction);
+
+        if (node==result->nodes.end() ||
+            node->second.distance>result->maxDistance) {
+          continue;
+        }
+
+        double distance=exit.distance+node->second.distance+entry.distance;
+
+        if (distance<bestDistance) {
+          bestDistance=distance;
+          bestExit=&exit;
+          bestEntry=&entry;
+          bestResult=result;
+        }
+      }
+    }
+
+    if (bestDistance>maxDistance) {
+      return infinity;
+    }
+
+    if (route!=NULL) {
+      std::vector<const SearchNode*> path;
+      Id                             current=bestEntry->junction;
+
+      while (current!=bestExit->junction) {
+        const SearchNode& node=bestResult->nodes[current];
+
+        path.push_back(&node);
+        current=node.previous;
+      }
+
+      route->push_back(RouteNode{from.way,bestExit->forward ? from.segmentIndex+1 : from.segmentIndex});
+      route->push_back(RouteNode{from.way,bestExit->junctionIndex});
+
+      for (auto node=path.rbegin(); node!=path.rend(); ++node) {
+        route->push_back(RouteNode{(*node)->way,(*node)->fromIndex});
+        route->push_back(RouteNode{(*node)->way,(*node)->toIndex});
+      }
+
+      route->push_back(RouteNode{to.way,bestEntry->junctionIndex});
+      route->push_back(RouteNode{to.way,bestEntry->forward ? to.segmentIndex : to.segmentIndex+1});
+    }
+
+    return bestDistance;
+  }
+
+  /**
+   * Add a node to the current route. Consecutive nodes on the same way
+   * result in a route entry, a node on another way is taken as the same
+   * (junction) node on the new way.
+   */
+  void MapMatcher::AddRouteNode(const RoadWayRef& way,
+                                size_t index)
+  {
+    if (!hasLastNode) {
+      lastNode=RouteNode{way,index};
+      hasLastNode=true;
+      return;
+    }
+
+    if (lastNode.way->way->GetFileOffset()!=way->way->GetFileOffset()) {
+      lastNode=RouteNode{way,index};
+      return;
+    }
+
+    if (lastNode.index==index) {
+      return;
+    }
+
+    const Point& node=lastNode.way->way->nodes[lastNode.index];
+
+    routePart.AddEntry(node.IsRelevant() ? node.GetId() : 0,
+                       lastNode.index,
+                       way->ref,
+                       index);
+
+    lastNode=RouteNode{way,index};
+  }
+
+  /**
+   * Add all nodes from index 'from' to index 'to' of the way to the route
+   */
+  void MapMatcher::AddRouteNodes(const RoadWayRef& way,
+                                 size_t from,
+                                 size_t to)
+  {
+    if (from<=to) {
+      for (size_t i=from; i<=to; i++) {
+        AddRouteNode(way,i);
+      }
+    }
+    else {
+      for (size_t i=from+1; i>to; i--) {
+        AddRouteNode(way,i-1);
+      }
+    }
+  }
+
+  void MapMatcher::FinishRoute()
+  {
+    if (hasLastNode) {
+      routePart.AddEntry(0,
+                         lastNode.index,
+                         ObjectFileRef(),
+                         0);
+    }
+
+    hasLastNode=false;
+    lastNode=RouteNode();
+  }
+
+  void MapMatcher::AddMatchedPoint(const Step& step,
+                                   const State& state)
+  {
+    for (size_t i=step.skippedPoints; i>0; i--) {
+      MapMatchingService::MatchedPoint point;
+
+      point.pointIndex=step.pointIndex-i;
+      point.matched=false;
+
+      matchedPoints.push_back(point);
+    }
+
+    MapMatchingService::MatchedPoint point;
+
+    point.pointIndex=step.pointIndex;
+    point.matched=true;
+    point.candidate.object=state.candidate.way->ref;
+    point.candidate.segmentIndex=state.candidate.segmentIndex;
+    point.candidate.fraction=state.candidate.fraction;
+    point.candidate.coord=state.candidate.coord;
+    point.candidate.distance=state.candidate.distance;
+
+    matchedPoints.push_back(point);
+  }
+
+  /**
+   * Decide the given state of the given step and all its predecessors:
+   * matched points and route are generated up to the step and all
+   * previous steps are removed. Afterwards the decided step is the first
+   * step and has only one (the decided) state. States of later steps not
+   * descending from the decided state are invalidated.
+   */
+  void MapMatcher::Commit(size_t stepIndex,
+                          size_t stateIndex)
+  {
+    const double        minusInfinity=-std::numeric_limits<double>::infinity();
+    std::vector<size_t> path(stepIndex+1);
+
+    path[stepIndex]=stateIndex;
+
+    for (size_t i=stepIndex; i>0; i--) {
+      path[i-1]=steps[i].states[path[i]].previous;
+    }
+
+    for (size_t i=anchorEmitted ? 1 : 0; i<=stepIndex; i++) {
+      const State& state=steps[i].states[path[i]];
+
+      if (i>0) {
+        std::vector<RouteNode> route;
+
+        GetRouteDistance(steps[i-1].states[path[i-1]].candidate,
+                         state.candidate,
+                         steps[i].maxDistance,
+                         &route);
+
+        if (!hasLastNode &&
+            !route.empty()) {
+          // Start the route with the node before the first candidate
+          const MatchCandidate& start=steps[i-1].states[path[i-1]].candidate;
+
+          AddRouteNode(start.way,
+                       route.front().index==start.segmentIndex ? start.segmentIndex+1 : start.segmentIndex);
+        }
+
+        for (size_t r=0; r+1<route.size(); r+=2) {
+          AddRouteNodes(route[r].way,
+                        route[r].index,
+                        route[r+1].index);
+        }
+      }
+
+      AddMatchedPoint(steps[i],
+                      state);
+    }
+
+    steps.erase(steps.begin(),
+                steps.begin()+stepIndex);
+
+    State decided=steps.front().states[stateIndex];
+
+    decided.previous=0;
+    steps.front().states.assign(1,decided);
+
+    for (size_t i=1; i<steps.size(); i++) {
+      for (auto& state : steps[i].states) {
+        if (i==1 && state.previous!=stateIndex) {
+          state.score=minusInfinity;
+        }
+        else if (i>1 && steps[i-1].states[state.previous].score==minusInfinity) {
+          state.score=minusInfinity;
+        }
+
+        if (i==1) {
+          state.previous=0;
+        }
+      }
+    }
+
+    anchorEmitted=true;
+  }
+
+  /**
+   * Decide the latest step all valid paths share. If there is none and
+   * there are more undecided steps than allowed, decide the step of the
+   * currently best path that is 'maxLag' steps behind.
+   */
+  void MapMatcher::CommitConverged()
+  {
+    const double        minusInfinity=-std::numeric_limits<double>::infinity();
+    std::vector<size_t> current;
+    std::vector<size_t> previous;
+
+    for (size_t s=0; s<steps.back().states.size(); s++) {
+      if (steps.back().states[s].score!=minusInfinity) {
+        current.push_back(s);
+      }
+    }
+
+    for (size_t i=steps.size(); i>0; i--) {
+      if (current.size()==1) {
+        if (i-1>0 || !anchorEmitted) {
+          Commit(i-1,current.front());
+
+          return;
+        }
+
+        break;
+      }
+
+      if (i==1) {
+        break;
+      }
+
+      previous.clear();
+
+      for (size_t s : current) {
+        previous.push_back(steps[i-1].states[s].previous);
+      }
+
+      std::sort(previous.begin(),previous.end());
+      previous.erase(std::unique(previous.begin(),previous.end()),
+                     previous.end());
+
+      current.swap(previous);
+    }
+
+    size_t maxLag=std::max((size_t)1,service.GetParameter().GetMaxLag());
+
+    if (steps.size()<=maxLag) {
+      return;
+    }
+
+    size_t best=0;
+
+    for (size_t s=1; s<steps.back().states.size(); s++) {
+      if (steps.back().states[s].score>steps.back().states[best].score) {
+        best=s;
+      }
+    }
+
+    size_t stepIndex=steps.size()-maxLag;
+
+    for (size_t i=steps.size()-1; i>stepIndex; i--) {
+      best=steps[i].states[best].previous;
+    }
+
+    Commit(stepIndex,best);
+  }
+
+  void MapMatcher::Emit()
+  {
+    if (matchedPoints.empty() &&
+        routePart.IsEmpty()) {
+      return;
+    }
+
+    if (callback) {
+      callback(matchedPoints,
+               routePart);
+    }
+
+    matchedPoints.clear();
+    routePart.Clear();
+  }
+
+  /**
+   * Add the next point of the trace
+   */
+  void MapMatcher::AddPoint(const GeoCoord& coord)
+  {
+    const MapMatchingParameter& parameter=service.GetParameter();
+    const double                minusInfinity=-std::numeric_limits<double>::infinity();
+    std::vector<MatchCandidate> candidates;
+    size_t                      pointIndex=pointCount++;
+
+    GetCandidates(coord,
+                  candidates);
+
+    if (candidates.empty()) {
+      skippedPoints++;
+      return;
+    }
+
+    Step step;
+
+    step.pointIndex=pointIndex;
+    step.coord=coord;
+    step.skippedPoints=skippedPoints;
+    step.maxDistance=0.0;
+    step.states.resize(candidates.size());
+
+    skippedPoints=0;
+
+    double sigma=parameter.GetGPSSigma();
+    double beta=parameter.GetTransitionBeta();
+    bool   connected=false;
+
+    if (!steps.empty()) {
+      const Step& last=steps.back();
+      double      directDistance=GetLocalDistance(last.coord,coord);
+
+      step.maxDistance=directDistance*parameter.GetMaxDetourFactor()+2*parameter.GetSearchRadius();
+
+      for (size_t s=0; s<candidates.size(); s++) {
+        State& state=step.states[s];
+
+        state.candidate=candidates[s];
+        state.score=minusInfinity;
+        state.previous=0;
+
+        for (size_t p=0; p<last.states.size(); p++) {
+          if (last.states[p].score==minusInfinity) {
+            continue;
+          }
+
+          double routeDistance=GetRouteDistance(last.states[p].candidate,
+                                                state.candidate,
+                                                step.maxDistance,
+                                                NULL);
+
+          if (routeDistance==std::numeric_limits<double>::infinity()) {
+            continue;
+          }
+
+          double score=last.states[p].score-std::abs(routeDistance-directDistance)/beta;
+
+          if (score>state.score) {
+            state.score=score;
+            state.previous=p;
+          }
+        }
+
+        if (state.score!=minusInfinity) {
+          double d=state.candidate.distance/sigma;
+
+          state.score-=0.5*d*d;
+          connected=true;
+        }
+      }
+
+      if (!connected) {
+        // No route from the previous point, finish the current route and start a new one
+        size_t best=0;
+
+        for (size_t s=1; s<last.states.size(); s++) {
+          if (last.states[s].score>last.states[best].score) {
+            best=s;
+          }
+        }
+
+        if (steps.size()>1 || !anchorEmitted) {
+          Commit(steps.size()-1,best);
+        }
+
+        FinishRoute();
+        steps.clear();
+        anchorEmitted=false;
+      }
+    }
+
+    if (!connected) {
+      step.maxDistance=0.0;
+
+      for (size_t s=0; s<candidates.size(); s++) {
+        double d=candidates[s].distance/sigma;
+
+        step.states[s].candidate=candidates[s];
+        step.states[s].score=-0.5*d*d;
+        step.states[s].previous=0;
+      }
+    }
+    else {
+      // Normalize scores to avoid loss of precision on long traces
+      double maxScore=minusInfinity;
+
+      for (const auto& state : step.states) {
+        maxScore=std::max(maxScore,state.score);
+      }
+
+      for (auto& state : step.states) {
+        if (state.score!=minusInfinity) {
+          state.score-=maxScore;
+        }
+      }
+    }
+
+    steps.push_back(step);
+
+    CommitConverged();
+    Emit();
+  }
+
+  /**
+   * Decide all remaining points and finish the route. The matcher can be
+   * used for another trace afterwards.
+   */
+  void MapMatcher::Finish()
+  {
+    if (!steps.empty()) {
+      size_t best=0;
+
+      for (size_t s=1; s<steps.back().states.size(); s++) {
+        if (steps.back().states[s].score>steps.back().states[best].score) {
+          best=s;
+        }
+      }
+
+      if (steps.size()>1 || !anchorEmitted) {
+        Commit(steps.size()-1,best);
+      }
+    }
+
+    FinishRoute();
+
+    for (size_t i=skippedPoints; i>0; i--) {
+      MapMatchingService::MatchedPoint point;
+
+      point.pointIndex=pointCount-i;
+      point.matched=false;
+
+      matchedPoints.push_back(point);
+    }
+
+    Emit();
+
+    steps.clear();
+    anchorEmitted=false;
+    pointCount=0;
+    skippedPoints=0;
+  }
+}
@@ -29,5 +29,14 @@ namespace osmscout {
   {
     // no code
   }
+
+  /**
+   * Return the memory of the node including its features
+   */
+  size_t NodeDataFile::GetValueMemory(const Node& node) const
+  {
+    return sizeof(Node)+
+           node.GetFeatureValueBuffer().GetMemoryUsage();
+  }
 }
 
@@ -0,0 +1,605 @@
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2016  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <osmscout/POIIndex.h>
+
+#include <algorithm>
+#include <queue>
+
+#include <osmscout/system/Math.h>
+
+#include <osmscout/util/File.h>
+#include <osmscout/util/Geometry.h>
+#include <osmscout/util/Logger.h>
+
+namespace osmscout {
+
+  const char* POIIndex::POI_IDX="poi.idx";
+
+  const size_t POIIndex::NODE_SIZE=16;
+
+  /**
+   * Number of path segments that are grouped into one chunk for
+   * path queries
+   */
+  static const size_t PATH_CHUNK_SIZE=16;
+
+  /**
+   * Length of one degree of latitude in km
+   */
+  static const double KM_PER_DEGREE=6371.01*M_PI/180.0;
+
+  /**
+   * Returns true, if the two boxes intersect. In contrast to GeoBox::Intersects()
+   * the borders of both boxes are included, so degraded boxes (of nodes) work, too.
+   */
+  static inline bool BoxesIntersect(const GeoBox& a,
+                                    const GeoBox& b)
+  {
+    return !(b.GetMaxLon()<a.GetMinLon() ||
+             b.GetMinLon()>a.GetMaxLon() ||
+             b.GetMaxLat()<a.GetMinLat() ||
+             b.GetMinLat()>a.GetMaxLat());
+  }
+
+  static inline bool BoxIncludes(const GeoBox& box,
+                                 const GeoCoord& coord)
+  {
+    return coord.GetLat()>=box.GetMinLat() &&
+           coord.GetLat()<=box.GetMaxLat() &&
+           coord.GetLon()>=box.GetMinLon() &&
+           coord.GetLon()<=box.GetMaxLon();
+  }
+
+  /**
+   * Candidate of the best first search for the nearest entries. Either a node
+   * of the R-tree (with the minimum possible distance of its entries) or an entry.
+   */
+  struct NearestCandidate
+  {
+    double        distance;
+    FileOffset    nodeOffset;
+    size_t        typeIndex;
+    ObjectFileRef object;
+    GeoBox        boundingBox;
+
+    inline bool operator<(const NearestCandidate& other) const
+    {
+      // Inverted, to make std::priority_queue return the nearest candidate first
+      return distance>other.distance;
+    }
+  };
+
+  POIIndex::TypeData::TypeData()
+  : rootOffset(0),
+    entryCount(0)
+  {
+    // no code
+  }
+
+  POIIndex::POIIndex()
+  {
+    // no code
+  }
+
+  POIIndex::~POIIndex()
+  {
+    Close();
+  }
+
+  bool POIIndex::Open(const std::string& path)
+  {
+    datafilename=AppendFileToDir(path,POI_IDX);
+
+    typeData.clear();
+
+    try {
+      scanner.Open(datafilename,FileScanner::FastRandom,true);
+
+      FileOffset typeTableOffset;
+      uint32_t   typeCount;
+
+      scanner.ReadFileOffset(typeTableOffset);
+
+      scanner.SetPos(typeTableOffset);
+      scanner.ReadNumber(typeCount);
+
+      for (size_t i=0; i<typeCount; i++) {
+        TypeId type;
+
+        scanner.ReadNumber(type);
+
+        if (type>=typeData.size()) {
+          typeData.resize(type+1);
+        }
+
+        scanner.ReadFileOffset(typeData[type].rootOffset);
+        scanner.ReadNumber(typeData[type].entryCount);
+        scanner.ReadBox(typeData[type].boundingBox);
+      }
+
+      return !scanner.HasError();
+    }
+    catch (IOException& e) {
+      log.Error() << e.GetDescription();
+      scanner.CloseFailsafe();
+      return false;
+    }
+  }
+
+  void POIIndex::Close()
+  {
+    try {
+      if (scanner.IsOpen()) {
+        scanner.Close();
+      }
+    }
+    catch (IOException& e) {
+      log.Error() << e.GetDescription();
+      scanner.CloseFailsafe();
+    }
+  }
+
+  /**
+   * Read the node at the given offset using the scanner of the query
+   *
+   * @throws IOException
+   */
+  void POIIndex::ReadNode(FileScanner& queryScanner,
+                          FileOffset offset,
+                          bool& leaf,
+                          std::vector<NodeEntry>& entries) const
+  {
+    uint32_t count;
+
+    queryScanner.SetPos(offset);
+
+    queryScanner.Read(leaf);
+    queryScanner.ReadNumber(count);
+
+    entries.resize(count);
+
+    for (auto& entry : entries) {
+      queryScanner.ReadBox(entry.boundingBox);
+
+      if (leaf) {
+        queryScanner.Read(entry.object);
+        entry.childOffset=0;
+      }
+      else {
+        queryScanner.ReadFileOffset(entry.childOffset);
+      }
+    }
+  }
+
+  /**
+   * Return the minimum distance of the given coordinate to the given
+   * box in km.
+   */
+  double POIIndex::GetDistance(const GeoCoord& coord,
+                               const GeoBox& box)
+  {
+    GeoCoord nearest(std::max(box.GetMinLat(),std::min(box.GetMaxLat(),coord.GetLat())),
+                     std::max(box.GetMinLon(),std::min(box.GetMaxLon(),coord.GetLon())));
+
+    return GetSphericalDistance(coord,
+                                nearest);
+  }
+
+  /**
+   * Return the minimum distance of the given coordinate to the given path in km.
+   * Only the path chunks that include the coordinate are checked, if the
+   * coordinate is not within one of the chunks, infinity is returned.
+   */
+  double POIIndex::GetDistance(const GeoCoord& coord,
+                               const std::vector<GeoCoord>& path,
+                               const std::vector<PathChunk>& chunks,
+                               const GeoBox& coordBox)
+  {
+    double distance=std::numeric_limits<double>::infinity();
+
+    for (const auto& chunk : chunks) {
+      if (!BoxesIntersect(chunk.boundingBox,coordBox)) {
+        continue;
+      }
+
+      for (size_t i=chunk.start; i<chunk.end; i++) {
+        const GeoCoord& a=path[i];
+        const GeoCoord& b=path[std::min(i+1,path.size()-1)];
+
+        GeoCoord nearest;
+
+        distance=std::min(distance,
+                          GetSphericalDistanceToLineSegment(coord,
+                                                            a,
+                                                            b,
+                                                            nearest));
+      }
+    }
+
+    return distance;
+  }
+
+  /**
+   * Return all POIs of the given types within the given area
+   *
+   * @param boundingBox
+   *    The area to search in
+   * @param types
+   *    The types of the POIs
+   * @param entries
+   *    The resulting entries
+   * @return
+   *    False, if there was an error, else true
+   */
+  bool POIIndex::GetEntriesInArea(const GeoBox& boundingBox,
+                                  const TypeInfoSet& types,
+                                  std::vector<Entry>& entries) const
+  {
+    std::vector<FileOffset> stack;
+    std::vector<NodeEntry>  nodeEntries;
+
+    entries.clear();
+
+    FileScanner queryScanner;
+
+    try {
+      queryScanner.Open(scanner,
+                        FileScanner::FastRandom);
+
+      for (const auto& type : types) {
+        if (type->GetIndex()>=typeData.size() ||
+            typeData[type->GetIndex()].rootOffset==0 ||
+            !BoxesIntersect(typeData[type->GetIndex()].boundingBox,boundingBox)) {
+          continue;
+        }
+
+        stack.push_back(typeData[type->GetIndex()].rootOffset);
+
+        while (!stack.empty()) {
+          FileOffset offset=stack.back();
+          bool       leaf;
+
+          stack.pop_back();
+
+          ReadNode(queryScanner,
+                   offset,
+                   leaf,
+                   nodeEntries);
+
+          for (const auto& nodeEntry : nodeEntries) {
+            if (!BoxesIntersect(nodeEntry.boundingBox,boundingBox)) {
+              continue;
+            }
+
+            if (!leaf) {
+              stack.push_back(nodeEntry.childOffset);
+              continue;
+            }
+
+            Entry entry;
+
+            entry.object=nodeEntry.object;
+            entry.type=type;
+            entry.boundingBox=nodeEntry.boundingBox;
+            entry.distance=0.0;
+
+            entries.push_back(entry);
+          }
+        }
+      }
+
+      queryScanner.Close();
+    }
+    catch (IOException& e) {
+      log.Error() << e.GetDescription();
+      queryScanner.CloseFailsafe();
+      entries.clear();
+      return false;
+    }
+
+    return true;
+  }
+
+  /**
+   * Return the nearest POIs of the given types to the given coordinate
+   * sorted by increasing distance, using a best first search over the
+   * trees of all given types.
+   *
+   * @param coord
+   *    The reference coordinate
+   * @param types
+   *    The types of the POIs
+   * @param maxCount
+   *    The maximum number of returned entries
+   * @param maxDistance
+   *    The maximum distance of the returned entries in km
+   * @param entries
+   *    The resulting entries
+   * @return
+   *    False, if there was an error, else true
+   */
+  bool POIIndex::GetNearestEntries(const GeoCoord& coord,
+                                   const TypeInfoSet& types,
+                                   size_t maxCount,
+                                   double maxDistance,
+                                   std::vector<Entry>& entries) const
+  {
+    std::priority_queue<NearestCandidate> queue;
+    std::vector<TypeInfoRef>              candidateTypes;
+    std::vector<NodeEntry>                nodeEntries;
+
+    entries.clear();
+
+    FileScanner queryScanner;
+
+    try {
+      queryScanner.Open(scanner,
+                        FileScanner::FastRandom);
+
+      for (const auto& type : types) {
+        if (type->GetIndex()>=typeData.size() ||
+            typeData[type->GetIndex()].rootOffset==0) {
+          continue;
+        }
+
+        NearestCandidate candidate;
+
+        candidate.distance=GetDistance(coord,typeData[type->GetIndex()].boundingBox);
+        candidate.nodeOffset=typeData[type->GetIndex()].rootOffset;
+        candidate.typeIndex=candidateTypes.size();
+
+        if (candidate.distance<=maxDistance) {
+          candidateTypes.push_back(type);
+          queue.push(candidate);
+        }
+      }
+
+      while (!queue.empty() &&
+             entries.size()<maxCount) {
+        NearestCandidate candidate=queue.top();
+
+        queue.pop();
+
+        if (candidate.nodeOffset==0) {
+          Entry entry;
+
+          entry.object=candidate.object;
+          entry.type=candidateTypes[candidate.typeIndex];
+          entry.boundingBox=candidate.boundingBox;
+          entry.distance=candidate.distance;
+
+          entries.push_back(entry);
+          continue;
+        }
+
+        bool leaf;
+
+        ReadNode(queryScanner,
+                 candidate.nodeOffset,
+                 leaf,
+                 nodeEntries);
+
+        for (const auto& nodeEntry : nodeEntries) {
+          NearestCandidate child;
+
+          child.typeIndex=candidate.typeIndex;
+
+          if (leaf) {
+            child.distance=GetSphericalDistance(coord,
+                                                nodeEntry.boundingBox.GetCenter());
+            child.nodeOffset=0;
+            child.object=nodeEntry.object;
+            child.boundingBox=nodeEntry.boundingBox;
+          }
+          else {
+            child.distance=GetDistance(coord,
+                                       nodeEntry.boundingBox);
+            child.nodeOffset=nodeEntry.childOffset;
+          }
+
+          if (child.distance<=maxDistance) {
+            queue.push(child);
+          }
+        }
+      }
+
+      queryScanner.Close();
+    }
+    catch (IOException& e) {
+      log.Error() << e.GetDescription();
+      queryScanner.CloseFailsafe();
+      entries.clear();
+      return false;
+    }
+
+    return true;
+  }
+
+  /**
+   * Return all POIs of the given types with a maximum distance to the
+   * given path (e.g. the way points of a route), sorted by increasing
+   * distance to the path.
+   *
+   * @param path
+   *    The path
+   * @param maxDistance
+   *    The maximum distance of the returned entries to the path in km
+   * @param types
+   *    The types of the POIs
+   * @param entries
+   *    The resulting entries
+   * @return
+   *    False, if there was an error, else true
+   */
+  bool POIIndex::GetEntriesAlongPath(const std::vector<GeoCoord>& path,
+                                     double maxDistance,
+                                     const TypeInfoSet& types,
+                                     std::vector<Entry>& entries) const
+  {
+    std::vector<PathChunk>  chunks;
+    GeoBox                  pathBox;
+    std::vector<FileOffset> stack;
+    std::vector<NodeEntry>  nodeEntries;
+
+    entries.clear();
+
+    if (path.empty()) {
+      return true;
+    }
+
+    // Group the path segments into chunks and expand the bounding box of each chunk
+    // by the maximum distance. Nodes of the tree that do not intersect any of the
+    // chunks cannot contain any POI near to the path.
+
+    double latDelta=maxDistance/KM_PER_DEGREE;
+
+    for (size_t start=0; start<path.size(); start+=PATH_CHUNK_SIZE) {
+      PathChunk chunk;
+      double    minLat=path[start].GetLat();
+      double    maxLat=path[start].GetLat();
+      double    minLon=path[start].GetLon();
+      double    maxLon=path[start].GetLon();
+
+      chunk.start=start;
+      chunk.end=std::min(start+PATH_CHUNK_SIZE,path.size());
+
+      // The chunk includes the segment to the first point of the next chunk
+      for (size_t i=start; i<=std::min(chunk.end,path.size()-1); i++) {
+        minLat=std::min(minLat,path[i].GetLat());
+        maxLat=std::max(maxLat,path[i].GetLat());
+        minLon=std::min(minLon,path[i].GetLon());
+        maxLon=std::max(maxLon,path[i].GetLon());
+      }
+
+      double maxAbsLat=std::min(std::max(fabs(minLat),fabs(maxLat))+latDelta,89.0);
+      double lonDelta=latDelta/cos(maxAbsLat*M_PI/180.0);
+
+      chunk.boundingBox.Set(GeoCoord(minLat-latDelta,minLon-lonDelta),
+                            GeoCoord(maxLat+latDelta,maxLon+lonDelta));
+
+      if (pathBox.IsValid()) {
+        pathBox.Include(chunk.boundingBox);
+      }
+      else {
+        pathBox=chunk.boundingBox;
+      }
+
+      chunks.push_back(chunk);
+    }
+
+    FileScanner queryScanner;
+
+    try {
+      queryScanner.Open(scanner,
+                        FileScanner::FastRandom);
+
+      for (const auto& type : types) {
+        if (type->GetIndex()>=typeData.size() ||
+            typeData[type->GetIndex()].rootOffset==0 ||
+            !BoxesIntersect(typeData[type->GetIndex()].boundingBox,pathBox)) {
+          continue;
+        }
+
+        stack.push_back(typeData[type->GetIndex()].rootOffset);
+
+        while (!stack.empty()) {
+          FileOffset offset=stack.back();
+          bool       leaf;
+
+          stack.pop_back();
+
+          ReadNode(queryScanner,
+                   offset,
+                   leaf,
+                   nodeEntries);
+
+          for (const auto& nodeEntry : nodeEntries) {
+            if (!leaf) {
+              for (const auto& chunk : chunks) {
+                if (BoxesIntersect(chunk.boundingBox,nodeEntry.boundingBox)) {
+                  stack.push_back(nodeEntry.childOffset);
+                  break;
+                }
+              }
+
+              continue;
+            }
+
+            GeoCoord center=nodeEntry.boundingBox.GetCenter();
+            GeoBox   centerBox(center,center);
+
+            if (!BoxIncludes(pathBox,center)) {
+              continue;
+            }
+
+            double distance=GetDistance(center,
+                                        path,
+                                        chunks,
+                                        centerBox);
+
+            if (distance>maxDistance) {
+              continue;
+            }
+
+            Entry entry;
+
+            entry.object=nodeEntry.object;
+            entry.type=type;
+            entry.boundingBox=nodeEntry.boundingBox;
+            entry.distance=distance;
+
+            entries.push_back(entry);
+          }
+        }
+      }
+
+      queryScanner.Close();
+    }
+    catch (IOException& e) {
+      log.Error() << e.GetDescription();
+      queryScanner.CloseFailsafe();
+      entries.clear();
+      return false;
+    }
+
+    std::stable_sort(entries.begin(),
+                     entries.end(),
+                     [](const Entry& a, const Entry& b) {
+                       return a.distance<b.distance;
+                     });
+
+    return true;
+  }
+
+  void POIIndex::DumpStatistics() const
+  {
+    size_t types=0;
+    size_t entries=0;
+
+    for (const auto& data : typeData) {
+      if (data.rootOffset!=0) {
+        types++;
+        entries+=data.entryCount;
+      }
+    }
+
+    log.Info() << "POIIndex types " << types << ", entries " << entries;
+  }
+}
@@ -258,4 +258,125 @@ namespace osmscout {
 
     return true;
   }
+
+  /**
+   * Returns the POI index entries of all POIs in the given boundary that
+   * have one of the given types. In contrast to GetPOIsInArea() the objects
+   * are not loaded.
+   *
+   * @param boundingBox
+   *    Bounding box, objects must be in
+   * @param types
+   *    The resulting POIs must be of one of these types
+   * @param pois
+   *    Result of the query, in case the query succeeded. In case of errors
+   *    the result is empty.
+   * @return
+   *    True, if success, else false
+   */
+  bool POIService::GetPOIEntriesInArea(const GeoBox& boundingBox,
+                                       const TypeInfoSet& types,
+                                       std::vector<POIIndex::Entry>& pois) const
+  {
+    POIIndexRef poiIndex=database->GetPOIIndex();
+
+    pois.clear();
+
+    if (!poiIndex) {
+      return false;
+    }
+
+    if (!poiIndex->GetEntriesInArea(boundingBox,
+                                    types,
+                                    pois)) {
+      log.Error() << "Error getting POIs from POI index!";
+      return false;
+    }
+
+    return true;
+  }
+
+  /**
+   * Returns the nearest POIs to the given coordinate that have one of the
+   * given types, sorted by increasing distance.
+   *
+   * @param coord
+   *    The reference coordinate
+   * @param types
+   *    The resulting POIs must be of one of these types
+   * @param maxCount
+   *    Maximum number of returned POIs
+   * @param maxDistance
+   *    Maximum distance of the returned POIs in km
+   * @param pois
+   *    Result of the query, in case the query succeeded. In case of errors
+   *    the result is empty.
+   * @return
+   *    True, if success, else false
+   */
+  bool POIService::GetNearestPOIs(const GeoCoord& coord,
+                                  const TypeInfoSet& types,
+                                  size_t maxCount,
+                                  double maxDistance,
+                                  std::vector<POIIndex::Entry>& pois) const
+  {
+    POIIndexRef poiIndex=database->GetPOIIndex();
+
+    pois.clear();
+
+    if (!poiIndex) {
+      return false;
+    }
+
+    if (!poiIndex->GetNearestEntries(coord,
+                                     types,
+                                     maxCount,
+                                     maxDistance,
+                                     pois)) {
+      log.Error() << "Error getting nearest POIs from POI index!";
+      return false;
+    }
+
+    return true;
+  }
+
+  /**
+   * Returns all POIs with the given maximum distance to the given path that
+   * have one of the given types, sorted by increasing distance to the path.
+   *
+   * @param path
+   *    The path, e.g. the points of a route
+   * @param maxDistance
+   *    Maximum distance of the returned POIs to the path in km
+   * @param types
+   *    The resulting POIs must be of one of these types
+   * @param pois
+   *    Result of the query, in case the query succeeded. In case of errors
+   *    the result is empty.
+   * @return
+   *    True, if success, else false
+   */
+  bool POIService::GetPOIsAlongPath(const std::vector<GeoCoord>& path,
+                                    double maxDistance,
+                                    const TypeInfoSet& types,
+                                    std::vector<POIIndex::Entry>& pois) const
+  {
+    POIIndexRef poiIndex=database->GetPOIIndex();
+
+    pois.clear();
+
+    if (!poiIndex) {
+      return false;
+    }
+
+    if (!poiIndex->GetEntriesAlongPath(path,
+                                       maxDistance,
+                                       types,
+                                       pois)) {
+      log.Error() << "Error getting POIs along path from POI index!";
+      return false;
+    }
+
+    return true;
+  }
 }
@@ -156,6 +156,8 @@ namespace osmscout {
         //scanner.Read(paths[i].bearing);
         scanner.Read(paths[i].flags);
         scanner.ReadNumber(distanceValue);
+        scanner.ReadNumber(paths[i].ascent);
+        scanner.ReadNumber(paths[i].descent);
 
         paths[i].distance=distanceValue/(1000.0*100.0);
       }
@@ -222,6 +224,8 @@ namespace osmscout {
         //writer.Write(paths[i].bearing);
         writer.Write(path.flags);
         writer.WriteNumber((uint32_t)floor(path.distance*(1000.0*100.0)+0.5));
+        writer.WriteNumber(path.ascent);
+        writer.WriteNumber(path.descent);
       }
     }
 
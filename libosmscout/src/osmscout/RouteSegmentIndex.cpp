@@ -0,0 +1,328 @@
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2016  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <osmscout/RouteSegmentIndex.h>
+
+#include <queue>
+
+#include <osmscout/system/Math.h>
+
+#include <osmscout/util/File.h>
+#include <osmscout/util/Geometry.h>
+#include <osmscout/util/Logger.h>
+
+namespace osmscout {
+
+  const char* RouteSegmentIndex::ROUTESEGMENT_IDX="routesegment.idx";
+
+  const size_t RouteSegmentIndex::NODE_SIZE=16;
+
+  /**
+   * Candidate of the best first search for the nearest segments. Either a node
+   * of the R-tree (with the minimum possible distance of its segments) or a segment.
+   */
+  struct NearestSegmentCandidate
+  {
+    double                     distance;
+    FileOffset                 nodeOffset;
+    RouteSegmentIndex::Segment segment;
+
+    inline bool operator<(const NearestSegmentCandidate& other) const
+    {
+      // Inverted, to make std::priority_queue return the nearest candidate first
+      return distance>other.distance;
+    }
+  };
+
+  /**
+   * Kilometers per degree latitude (using the same earth radius as
+   * GetSphericalDistance())
+   */
+  static const double KM_PER_DEGREE=6371.01*M_PI/180.0;
+
+  /**
+   * Return a lower bound of the distance of the given coordinate to the given
+   * box in km, without trigonometric functions. Longitude differences are
+   * scaled by the given factor, that must not be bigger than the cosine of
+   * any latitude within the search distance (see GetLonScale()).
+   */
+  static inline double GetDistance(const GeoCoord& coord,
+                                   const GeoBox& box,
+                                   double lonScale)
+  {
+    double dLat=std::max(0.0,std::max(box.GetMinLat()-coord.GetLat(),coord.GetLat()-box.GetMaxLat()));
+    double dLon=std::max(0.0,std::max(box.GetMinLon()-coord.GetLon(),coord.GetLon()-box.GetMaxLon()))*lonScale;
+
+    return sqrt(dLat*dLat+dLon*dLon)*KM_PER_DEGREE;
+  }
+
+  /**
+   * Return the scale of longitude differences for GetDistance(), the cosine
+   * of the latitude nearest to the pole within the given distance of the
+   * coordinate. Boxes beyond this latitude are already too far away in
+   * latitude.
+   */
+  static double GetLonScale(const GeoCoord& coord,
+                            double maxDistance)
+  {
+    double maxLat=std::abs(coord.GetLat())+maxDistance/KM_PER_DEGREE;
+
+    if (maxLat>=90.0) {
+      return 0.0;
+    }
+
+    return cos(maxLat*M_PI/180.0);
+  }
+
+  size_t RouteSegmentIndex::Segment::GetNearestNodeIndex() const
+  {
+    if (GetSphericalDistance(coord,from)<=GetSphericalDistance(coord,to)) {
+      return fromNodeIndex;
+    }
+
+    return toNodeIndex;
+  }
+
+  RouteSegmentIndex::RouteSegmentIndex()
+  {
+    // no code
+  }
+
+  RouteSegmentIndex::~RouteSegmentIndex()
+  {
+    Close();
+  }
+
+  bool RouteSegmentIndex::Open(const std::string& path)
+  {
+    datafilename=AppendFileToDir(path,ROUTESEGMENT_IDX);
+
+    try {
+      scanner.Open(datafilename,FileScanner::FastRandom,true);
+
+      FileOffset vehicleTableOffset;
+      uint32_t   vehicleCount;
+
+      scanner.ReadFileOffset(vehicleTableOffset);
+
+      scanner.SetPos(vehicleTableOffset);
+      scanner.ReadNumber(vehicleCount);
+
+      vehicleData.resize(vehicleCount);
+
+      for (auto& data : vehicleData) {
+        uint8_t vehicle;
+
+        scanner.Read(vehicle);
+        scanner.ReadFileOffset(data.rootOffset);
+        scanner.ReadNumber(data.segmentCount);
+        scanner.ReadBox(data.boundingBox);
+
+        data.vehicle=(Vehicle)vehicle;
+      }
+
+      return !scanner.HasError();
+    }
+    catch (IOException& e) {
+      log.Error() << e.GetDescription();
+      scanner.CloseFailsafe();
+      return false;
+    }
+  }
+
+  void RouteSegmentIndex::Close()
+  {
+    try {
+      if (scanner.IsOpen()) {
+        scanner.Close();
+      }
+    }
+    catch (IOException& e) {
+      log.Error() << e.GetDescription();
+      scanner.CloseFailsafe();
+    }
+  }
+
+  /**
+   * Read the node at the given offset
+   *
+   * @throws IOException
+   */
+  void RouteSegmentIndex::ReadNode(FileScanner& queryScanner,
+                                   FileOffset offset,
+                                   bool& leaf,
+                                   std::vector<NodeEntry>& entries) const
+  {
+    uint32_t count;
+
+    queryScanner.SetPos(offset);
+
+    queryScanner.Read(leaf);
+    queryScanner.ReadNumber(count);
+
+    entries.resize(count);
+
+    for (auto& entry : entries) {
+      if (leaf) {
+        queryScanner.ReadCoord(entry.from);
+        queryScanner.ReadCoord(entry.to);
+        queryScanner.Read(entry.object);
+        queryScanner.ReadNumber(entry.fromNodeIndex);
+        queryScanner.ReadNumber(entry.toNodeIndex);
+        entry.childOffset=0;
+      }
+      else {
+        queryScanner.ReadBox(entry.boundingBox);
+        queryScanner.ReadFileOffset(entry.childOffset);
+      }
+    }
+  }
+
+  /**
+   * Return the nearest segments of objects routable by the given vehicle to
+   * the given coordinate sorted by increasing distance, using a best first
+   * search.
+   *
+   * @param coord
+   *    The reference coordinate
+   * @param vehicle
+   *    The vehicle
+   * @param maxCount
+   *    The maximum number of returned segments
+   * @param maxDistance
+   *    The maximum distance of the returned segments in km
+   * @param segments
+   *    The resulting segments
+   * @return
+   *    False, if there was an error, else true
+   */
+  bool RouteSegmentIndex::GetNearestSegments(const GeoCoord& coord,
+                                             Vehicle vehicle,
+                                             size_t maxCount,
+                                             double maxDistance,
+                                             std::vector<Segment>& segments) const
+  {
+    std::priority_queue<NearestSegmentCandidate> queue;
+    std::vector<NodeEntry>                       nodeEntries;
+    double                                       lonScale=GetLonScale(coord,maxDistance);
+
+    segments.clear();
+
+    FileScanner queryScanner;
+
+    try {
+      queryScanner.Open(scanner,
+                        FileScanner::FastRandom);
+
+      for (const auto& data : vehicleData) {
+        if (data.vehicle!=vehicle ||
+            data.rootOffset==0) {
+          continue;
+        }
+
+        NearestSegmentCandidate candidate;
+
+        candidate.distance=GetDistance(coord,
+                                       data.boundingBox,
+                                       lonScale);
+        candidate.nodeOffset=data.rootOffset;
+
+        if (candidate.distance<=maxDistance) {
+          queue.push(candidate);
+        }
+      }
+
+      while (!queue.empty() &&
+             segments.size()<maxCount) {
+        NearestSegmentCandidate candidate=queue.top();
+
+        queue.pop();
+
+        if (candidate.nodeOffset==0) {
+          segments.push_back(candidate.segment);
+          continue;
+        }
+
+        bool leaf;
+
+        ReadNode(queryScanner,
+                 candidate.nodeOffset,
+                 leaf,
+                 nodeEntries);
+
+        for (const auto& nodeEntry : nodeEntries) {
+          NearestSegmentCandidate child;
+
+          if (leaf) {
+            // Skip segments that are obviously too far away before
+            // calculating the exact distance
+            if (GetDistance(coord,
+                            GeoBox(nodeEntry.from,nodeEntry.to),
+                            lonScale)>maxDistance) {
+              continue;
+            }
+
+            Segment& segment=child.segment;
+
+            segment.object=nodeEntry.object;
+            segment.fromNodeIndex=nodeEntry.fromNodeIndex;
+            segment.toNodeIndex=nodeEntry.toNodeIndex;
+            segment.from=nodeEntry.from;
+            segment.to=nodeEntry.to;
+
+            segment.distance=GetSphericalDistanceToLineSegment(coord,
+                                                               segment.from,
+                                                               segment.to,
+                                                               segment.coord);
+
+            child.distance=segment.distance;
+            child.nodeOffset=0;
+          }
+          else {
+            child.distance=GetDistance(coord,
+                                       nodeEntry.boundingBox,
+                                       lonScale);
+            child.nodeOffset=nodeEntry.childOffset;
+          }
+
+          if (child.distance<=maxDistance) {
+            queue.push(child);
+          }
+        }
+      }
+
+      queryScanner.Close();
+    }
+    catch (IOException& e) {
+      log.Error() << e.GetDescription();
+      queryScanner.CloseFailsafe();
+      segments.clear();
+      return false;
+    }
+
+    return true;
+  }
+
+  void RouteSegmentIndex::DumpStatistics() const
+  {
+    for (const auto& data : vehicleData) {
+      log.Info() << "RouteSegmentIndex vehicle " << (size_t)data.vehicle << ", segments " << data.segmentCount;
+    }
+  }
+}
@@ -40,7 +40,8 @@ namespace osmscout {
      vehicleRouteNodeBit(RouteNode::usableByCar),
      minSpeed(0),
      maxSpeed(0),
-     vehicleMaxSpeed(std::numeric_limits<double>::max())
+     vehicleMaxSpeed(std::numeric_limits<double>::max()),
+     ascentCostFactor(0.0)
   {
     // no code
   }
@@ -67,6 +68,17 @@ namespace osmscout {
     vehicleMaxSpeed=maxSpeed;
   }
 
+  /**
+   * Set the additional costs for climbing, expressed as distance in km that is
+   * added to a path for every meter of ascent along the path. 0.0 (the default)
+   * ignores ascents. Ascents are only available, if elevation data was
+   * passed to the import.
+   */
+  void AbstractRoutingProfile::SetAscentCostFactor(double ascentCostFactor)
+  {
+    this->ascentCostFactor=ascentCostFactor;
+  }
+
   void AbstractRoutingProfile::ParametrizeForFoot(const TypeConfig& typeConfig,
                                                   double maxSpeed)
   {
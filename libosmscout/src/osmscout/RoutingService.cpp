@@ -1637,6 +1637,10 @@ namespace osmscout {
    * @note The actual object may not be within the given radius
    * due to internal search index resolution.
    *
+   * @note If the database has a route segment index, the object with the
+   * nearest segment is returned and the node index is the index of the
+   * nearer node of this segment.
+   *
    * @param lat
    *    Latitude value of the search center
    * @param lon
@@ -1663,6 +1667,31 @@ namespace osmscout {
     object.Invalidate();
     nodeIndex=std::numeric_limits<size_t>::max();
 
+    RouteSegmentIndexRef routeSegmentIndex=database->GetRouteSegmentIndex();
+
+    if (routeSegmentIndex) {
+      std::vector<RouteSegmentIndex::Segment> segments;
+
+      if (!routeSegmentIndex->GetNearestSegments(GeoCoord(lat,lon),
+                                                 vehicle,
+                                                 1,
+                                                 radius/1000.0,
+                                                 segments)) {
+        log.Error() << "Error getting nearest segment from route segment index!";
+        return false;
+      }
+
+      if (!segments.empty()) {
+        object=segments.front().object;
+        nodeIndex=segments.front().GetNearestNodeIndex();
+      }
+
+      return true;
+    }
+
+    // Fallback for databases without route segment index: load all routable
+    // objects in the area and check their nodes
+
     TypeConfigRef    typeConfig=database->GetTypeConfig();
     AreaAreaIndexRef areaAreaIndex=database->GetAreaAreaIndex();
     AreaWayIndexRef  areaWayIndex=database->GetAreaWayIndex();
@@ -1772,4 +1801,51 @@ namespace osmscout {
 
     return true;
   }
+
+  /**
+   * Return the segment of an object routable by the given vehicle that is
+   * nearest to the given coordinate, together with the nearest point on the
+   * segment. Requires the route segment index.
+   *
+   * @param coord
+   *    The coordinate
+   * @param vehicle
+   *    The vehicle
+   * @param radius
+   *    The maximum distance of the segment in meter
+   * @param segment
+   *    The resulting segment, the object is invalid, if no segment was found
+   * @return
+   *    False, if there was an error, else true
+   */
+  bool RoutingService::GetClosestRoutableSegment(const GeoCoord& coord,
+                                                 const Vehicle& vehicle,
+                                                 double radius,
+                                                 RouteSegmentIndex::Segment& segment) const
+  {
+    RouteSegmentIndexRef                    routeSegmentIndex=database->GetRouteSegmentIndex();
+    std::vector<RouteSegmentIndex::Segment> segments;
+
+    segment.object.Invalidate();
+
+    if (!routeSegmentIndex) {
+      log.Error() << "Route segment index is not available!";
+      return false;
+    }
+
+    if (!routeSegmentIndex->GetNearestSegments(coord,
+                                               vehicle,
+                                               1,
+                                               radius/1000.0,
+                                               segments)) {
+      log.Error() << "Error getting nearest segment from route segment index!";
+      return false;
+    }
+
+    if (!segments.empty()) {
+      segment=segments.front();
+    }
+
+    return true;
+  }
 }
@@ -25,10 +25,24 @@
  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
  */
 
+#include <osmscout/private/Config.h>
+
+#include <cerrno>
 #include <cstdlib>
-#include <ostream>
+#include <cstring>
+#include <fstream>
 #include <sstream>
 
+#if defined(HAVE_MMAP)
+  #include <unistd.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+#endif
+
+#if defined(HAVE_FCNTL_H)
+  #include <fcntl.h>
+#endif
+
 #include <osmscout/SRTM.h>
 
 #include <osmscout/util/Logger.h>
@@ -38,28 +52,163 @@
 
 namespace osmscout {
 
-    size_t SRTM::rows = SRTM3_GRID;
-    size_t SRTM::columns = SRTM3_GRID;
-    size_t SRTM::patchSize = 2*rows*columns;
+    /**
+     * Returns the number of rows and columns of a hgt file with the given size
+     * or 0, if the size does not match SRTM1 or SRTM3 data
+     */
+    static size_t GetGridForFileSize(size_t size)
+    {
+        if(size == SRTM1_FILESIZE){
+            return SRTM1_GRID;
+        } else if (size == SRTM3_FILESIZE){
+            return SRTM3_GRID;
+        } else {
+            return 0;
+        }
+    }
+
+    SRTM::Patch::Patch()
+    : grid(0),
+      heights(NULL),
+      size(0),
+      mapping(NULL),
+      loaded(false),
+      failed(false)
+    {
+        // no code
+    }
+
+    SRTM::Patch::~Patch()
+    {
+#if defined(HAVE_MMAP)
+        if(mapping!=NULL){
+            munmap(mapping,size);
+        }
+#endif
+    }
+
+    /**
+     * Map or, if mmap is not available, load the given hgt file. If the file does not
+     * exist or is not a valid hgt file, the patch has no heights. Returns false, if the
+     * file exists, but cannot be read.
+     */
+    bool SRTM::Patch::Load(const std::string& filename)
+    {
+#if defined(HAVE_MMAP)
+        int fd = open(filename.c_str(),O_RDONLY);
+
+        if(fd<0){
+            if(errno==ENOENT){
+                return true;
+            }
+
+            log.Error() << "Cannot open SRTM hgt file : " << filename << " (" << strerror(errno) << ")";
+            return false;
+        }
+
+        struct stat fileStat;
+
+        if(fstat(fd,&fileStat)!=0){
+            close(fd);
+            log.Error() << "Cannot get size of SRTM hgt file : " << filename;
+            return false;
+        }
+
+        size = (size_t)fileStat.st_size;
+        grid = GetGridForFileSize(size);
+
+        if(grid==0){
+            close(fd);
+            log.Error() << "Unexpected size of SRTM hgt file : " << filename;
+            return true;
+        }
+
+        void *data = mmap(NULL,size,PROT_READ,MAP_PRIVATE,fd,0);
+
+        close(fd);
+
+        if(data!=MAP_FAILED){
+            mapping = data;
+            heights = (const unsigned char*)data;
+            return true;
+        }
+
+        log.Error() << "Cannot mmap SRTM hgt file : " << filename;
+#endif
+
+        std::ifstream file(filename.c_str(), std::ios::in|std::ios::binary|std::ios::ate);
 
-    SRTM::SRTM(const std::string &path){
-        srtmPath = path;
-        currentFilename = "";
-        heights = NULL;
+        if(!file.good()){
+            return true;
+        }
+
+        size = (size_t)file.tellg();
+        grid = GetGridForFileSize(size);
+
+        if(grid==0){
+            log.Error() << "Unexpected size of SRTM hgt file : " << filename;
+            return true;
+        }
+
+        buffer.resize(size);
+        file.seekg(0, std::ios::beg);
+        file.read((char*)buffer.data(),size);
+
+        if(!file.good()){
+            log.Error() << "Cannot read SRTM hgt file : " << filename;
+            buffer.clear();
+            grid = 0;
+            return false;
+        }
+
+        heights = buffer.data();
+
+        return true;
     }
 
-    SRTM::~SRTM(){
-        if(heights){
-            delete heights;
+    /**
+     * Load the patch, if this has not been done yet. Concurrent callers wait for
+     * the first one to finish loading.
+     */
+    void SRTM::Patch::AssureLoaded(const std::string& filename)
+    {
+        std::lock_guard<std::mutex> lock(loadMutex);
+
+        if(loaded){
+            return;
+        }
+
+        if(Load(filename)){
+            if(heights!=NULL){
+                log.Debug() << "Open SRTM" << (grid==SRTM1_GRID ? "1" : "3") << " hgt file : " << filename;
+            }
+        } else {
+            failed = true;
         }
+
+        loaded = true;
+    }
+
+    SRTM::SRTM(const std::string &path,
+               size_t cacheSize)
+    : srtmPath(path),
+      cache(std::max(cacheSize,(size_t)1))
+    {
+        // no code
+    }
+
+    SRTM::~SRTM()
+    {
+        // no code
     }
 
     /**
      * generate SRTM3 filename like N43E006.hgt from integer part of latitude and longitude
      */
-    const std::string& SRTM::srtmFilename(int patchLat, int patchLon){
+    std::string SRTM::srtmFilename(int patchLat, int patchLon){
         std::ostringstream fileName;
-        if(patchLat>0){
+
+        if(patchLat>=0){
             fileName << "N";
         } else {
             fileName << "S";
@@ -69,7 +218,8 @@ namespace osmscout {
             fileName<<"0";
         }
         fileName << patchLat;
-        if(patchLon>0){
+
+        if(patchLon>=0){
             fileName << "E";
         } else {
             fileName << "W";
@@ -83,72 +233,237 @@ namespace osmscout {
         }
         fileName << patchLon << ".hgt";
 
-        return *(new std::string(fileName.str()));
+        return fileName.str();
     }
 
     /**
-     * return the height at (latitude,longitude) or SRTM::nodata if no data at the location
+     * Return the patch for the given integer latitude and longitude from the cache,
+     * loading it if necessary. Only the cache lookup is done under the cache lock,
+     * the patch is loaded afterwards, so callers of other patches are not blocked.
+     *
+     * Missing and invalid files are cached, too, as patches without heights, since
+     * there is no SRTM data for large areas. A patch that could not be read because
+     * of an I/O error is replaced and loaded again on the next access.
      */
-    int SRTM::heightAtLocation(double latitude, double longitude){
-        int patchLat = int(floor(latitude));
-        int patchLon = int(floor(longitude));
-        std::string patchFilename = srtmFilename(patchLat, patchLon);
-        size_t length;
-        if(currentFilename == "" || currentFilename != patchFilename){
-            currentFilename = patchFilename;
-            currentPatchLat = patchLat;
-            currentPatchLon = patchLon;
-	    if(heights){
-		delete heights;
-		heights = NULL;
+    SRTM::PatchRef SRTM::GetPatch(int patchLat, int patchLon){
+        uint32_t key = (uint32_t)((patchLat+90)*360+(patchLon+180));
+        PatchRef patch;
+
+        {
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            PatchCache::CacheRef        entry;
+
+            if(cache.GetEntry(key,entry) &&
+               !entry->value->failed){
+                patch = entry->value;
+            } else {
+                patch = std::make_shared<Patch>();
+                cache.SetEntry(PatchCache::CacheEntry(key,patch));
             }
-            if(currentFile.is_open()){
-		currentFile.close();
+        }
+
+        if(!patch->loaded){
+            patch->AssureLoaded(srtmPath+"/"+srtmFilename(patchLat, patchLon));
+        }
+
+        return patch;
+    }
+
+    /**
+     * Interpolate the height from the four surrounding samples, if some of them
+     * have no data. The samples without data are excluded from interpolation.
+     */
+    int SRTM::InterpolateVoidHeight(const int samples[4],
+                                    double fracLat,
+                                    double fracLon){
+        double weights[4] = {(1-fracLat)*(1-fracLon),
+                             (1-fracLat)*fracLon,
+                             fracLat*(1-fracLon),
+                             fracLat*fracLon};
+        double height = 0.0;
+        double weight = 0.0;
+
+        for(size_t s=0; s<4; s++){
+            if(samples[s]!=nodata){
+                height += samples[s]*weights[s];
+                weight += weights[s];
+            }
+        }
+
+        return weight>0.0 ? (int)floor(height/weight+0.5) : nodata;
+    }
+
+    /**
+     * Calculate the height of the given coordinate, which must be located in the
+     * given patch, using bilinear interpolation between the four surrounding samples.
+     */
+    int SRTM::InterpolateHeight(const Patch& patch,
+                                int patchLat,
+                                int patchLon,
+                                const GeoCoord& coord){
+        double scale = (double)(patch.grid-1);
+        // rows go from north to south, columns from west to east
+        double y = (patchLat+1-coord.GetLat())*scale;
+        double x = (coord.GetLon()-patchLon)*scale;
+        size_t row = std::min((size_t)std::max(y,0.0),patch.grid-2);
+        size_t column = std::min((size_t)std::max(x,0.0),patch.grid-2);
+        double fracLat = std::min(std::max(y-row,0.0),1.0);
+        double fracLon = std::min(std::max(x-column,0.0),1.0);
+
+        int samples[4] = {patch.GetHeight(row,column),
+                          patch.GetHeight(row,column+1),
+                          patch.GetHeight(row+1,column),
+                          patch.GetHeight(row+1,column+1)};
+
+        if(samples[0]==nodata || samples[1]==nodata || samples[2]==nodata || samples[3]==nodata){
+            return InterpolateVoidHeight(samples,fracLat,fracLon);
+        }
+
+        double north = samples[0]+(samples[1]-samples[0])*fracLon;
+        double south = samples[2]+(samples[3]-samples[2])*fracLon;
+
+        return (int)floor(north+(south-north)*fracLat+0.5);
+    }
+
+    /**
+     * Calculate the heights of the given coordinates, which must all be located
+     * in the given patch, using bilinear interpolation between the four surrounding samples.
+     *
+     * The coordinates are handled in blocks of INTERPOLATION_BLOCK_SIZE on the stack.
+     * The samples of a block are gathered first, then all heights are interpolated in
+     * one branch free loop, that can be vectorized by the compiler. Samples without data
+     * are excluded from interpolation.
+     */
+    void SRTM::InterpolateHeights(const Patch& patch,
+                                  int patchLat,
+                                  int patchLon,
+                                  const GeoCoord* coords,
+                                  size_t count,
+                                  int* heights){
+        double h00[INTERPOLATION_BLOCK_SIZE],h01[INTERPOLATION_BLOCK_SIZE];
+        double h10[INTERPOLATION_BLOCK_SIZE],h11[INTERPOLATION_BLOCK_SIZE];
+        double fracLat[INTERPOLATION_BLOCK_SIZE],fracLon[INTERPOLATION_BLOCK_SIZE];
+        double result[INTERPOLATION_BLOCK_SIZE];
+        bool   hasVoid[INTERPOLATION_BLOCK_SIZE];
+        double scale = (double)(patch.grid-1);
+
+        for(size_t start=0; start<count; start+=INTERPOLATION_BLOCK_SIZE){
+            size_t blockSize = count-start<INTERPOLATION_BLOCK_SIZE ? count-start : INTERPOLATION_BLOCK_SIZE;
+
+            for(size_t i=0; i<blockSize; i++){
+                const GeoCoord& coord = coords[start+i];
+                // rows go from north to south, columns from west to east
+                double y = (patchLat+1-coord.GetLat())*scale;
+                double x = (coord.GetLon()-patchLon)*scale;
+                size_t row = std::min((size_t)std::max(y,0.0),patch.grid-2);
+                size_t column = std::min((size_t)std::max(x,0.0),patch.grid-2);
+
+                fracLat[i] = std::min(std::max(y-row,0.0),1.0);
+                fracLon[i] = std::min(std::max(x-column,0.0),1.0);
+
+                int samples[4] = {patch.GetHeight(row,column),
+                                  patch.GetHeight(row,column+1),
+                                  patch.GetHeight(row+1,column),
+                                  patch.GetHeight(row+1,column+1)};
+
+                hasVoid[i] = samples[0]==nodata || samples[1]==nodata || samples[2]==nodata || samples[3]==nodata;
+
+                if(hasVoid[i]){
+                    heights[start+i] = InterpolateVoidHeight(samples,fracLat[i],fracLon[i]);
+                    h00[i] = h01[i] = h10[i] = h11[i] = 0.0;
+                    continue;
+                }
+
+                h00[i] = samples[0];
+                h01[i] = samples[1];
+                h10[i] = samples[2];
+                h11[i] = samples[3];
             }
-            currentFile.open((srtmPath+"/"+currentFilename).c_str(), std::ios::in|std::ios::binary|std::ios::ate);
-            if(currentFile.std::ios::good()){
-              length = currentFile.tellg();
-              currentFile.seekg (0, std::ios::beg);
-	    } else {
-	      return SRTM::nodata;
-	    }
-            if(length == SRTM1_FILESIZE){
-                rows = SRTM1_GRID;
-                columns = SRTM1_GRID;
-                patchSize = SRTM1_FILESIZE;
-                log.Info() << "Open SRTM1 hgt file : "<<(srtmPath+"/"+currentFilename).c_str();
-            } else if (length == SRTM3_FILESIZE){
-                rows = SRTM3_GRID;
-                columns = SRTM3_GRID;
-                patchSize = SRTM3_FILESIZE;
-                log.Info() << "Open SRTM3 hgt file : "<<(srtmPath+"/"+currentFilename).c_str();
+
+            for(size_t i=0; i<blockSize; i++){
+                double north = h00[i]+(h01[i]-h00[i])*fracLon[i];
+                double south = h10[i]+(h11[i]-h10[i])*fracLon[i];
+
+                result[i] = north+(south-north)*fracLat[i];
+            }
+
+            for(size_t i=0; i<blockSize; i++){
+                if(!hasVoid[i]){
+                    heights[start+i] = (int)floor(result[i]+0.5);
+                }
+            }
+        }
+    }
+
+    /**
+     * return the heights at the given coordinates, SRTM::nodata if there is no data at a location.
+     * Consecutive coordinates in the same patch, as usual for polylines, are handled together.
+     */
+    void SRTM::heightsAtLocations(const std::vector<GeoCoord>& coords,
+                                  std::vector<int>& heights){
+        heights.resize(coords.size());
+
+        size_t start = 0;
+
+        while(start<coords.size()){
+            int    patchLat = int(floor(coords[start].GetLat()));
+            int    patchLon = int(floor(coords[start].GetLon()));
+            size_t end = start+1;
+
+            while(end<coords.size() &&
+                  int(floor(coords[end].GetLat()))==patchLat &&
+                  int(floor(coords[end].GetLon()))==patchLon){
+                end++;
+            }
+
+            PatchRef patch = GetPatch(patchLat, patchLon);
+
+            if(patch->heights!=NULL){
+                InterpolateHeights(*patch,
+                                   patchLat,
+                                   patchLon,
+                                   coords.data()+start,
+                                   end-start,
+                                   heights.data()+start);
             } else {
-                return SRTM::nodata;
+                std::fill(heights.begin()+start,heights.begin()+end,nodata);
             }
-	    if(!heights){
-                heights = new unsigned char[SRTM::patchSize];
-	    }
-            currentFile.read((char *)heights,SRTM::patchSize);
-        }
-	if(currentFile.std::ios::good()){
-            double pixelSize = 1.0/(SRTM::rows-1);
-	    double fracLat = (1-pixelSize/2) - (latitude+pixelSize/2) + floor(latitude+pixelSize/2);
-	    double fracLon = longitude - floor(longitude+pixelSize/2);
-	    int col = int(floor(fracLon*SRTM::columns));
-	    int col2 = col << 1;
-	    int row = int(floor(fracLat*SRTM::rows));
-	    int h1 = (heights[2*row*SRTM::columns+col2]<<8)+(heights[2*row*SRTM::columns+col2+1]);
-	    int h2 = (heights[2*row*SRTM::columns+col2+2]<<8)+(heights[2*row*SRTM::columns+col2+3]);
-	    int h3 = (heights[2*(row+1)*SRTM::columns+col2]<<8)+(heights[2*(row+1)*SRTM::columns+col2+1]);
-	    int h4 = (heights[2*(row+1)*SRTM::columns+col2+2]<<8)+(heights[2*(row+1)*SRTM::columns+col2+3]);
-	    // bilinear interpolation
-	    double fLat = (fracLat-row*pixelSize)/pixelSize;
-	    double fLon = (fracLon-col*pixelSize)/pixelSize;
-	    double h = h1*(1-fLat)*(1-fLon) + h2*fLat*(1-fLon) + h3*(1-fLat)*fLon + h4*fLat*fLon;
-	    return (int)floor(h+0.5);
-        } else {
-	    return SRTM::nodata;
-	}
+
+            start = end;
+        }
     }
 
+    /**
+     * return the heights at the coordinates of the given points, SRTM::nodata if there is no data at a location
+     */
+    void SRTM::heightsAtPoints(const std::vector<Point>& points,
+                               std::vector<int>& heights){
+        std::vector<GeoCoord> coords;
+
+        coords.reserve(points.size());
+
+        for(const auto& point : points){
+            coords.push_back(point.GetCoord());
+        }
+
+        heightsAtLocations(coords,heights);
+    }
+
+    /**
+     * return the height at (latitude,longitude) or SRTM::nodata if no data at the location
+     */
+    int SRTM::heightAtLocation(double latitude, double longitude){
+        int      patchLat = int(floor(latitude));
+        int      patchLon = int(floor(longitude));
+        PatchRef patch = GetPatch(patchLat, patchLon);
+
+        if(patch->heights==NULL){
+            return nodata;
+        }
+
+        return InterpolateHeight(*patch,
+                                 patchLat,
+                                 patchLon,
+                                 GeoCoord(latitude,longitude));
+    }
 }
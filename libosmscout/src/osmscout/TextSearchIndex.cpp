@@ -1,5 +1,7 @@
 #include <osmscout/TextSearchIndex.h>
 
+#include <algorithm>
+
 #include <osmscout/util/File.h>
 #include <osmscout/util/String.h>
 #include <osmscout/util/Logger.h>
@@ -10,6 +12,97 @@ namespace osmscout
   const char* TextSearchIndex::TEXT_LOC_DAT="textloc.dat";
   const char* TextSearchIndex::TEXT_REGION_DAT="textregion.dat";
   const char* TextSearchIndex::TEXT_OTHER_DAT="textother.dat";
+  const char* TextSearchIndex::TEXT_IMPORTANCE_DAT="textimportance.dat";
+
+  TextSearchIndex::ResultQueue::ResultQueue(size_t queueLimit,
+                                            size_t producerCount)
+  : queueLimit(queueLimit),
+    producerCount(producerCount),
+    running(true)
+  {
+    // no code
+  }
+
+  /**
+   * Push a result, blocks while the queue is full. Returns false
+   * if the queue has been stopped and the producer should quit.
+   */
+  bool TextSearchIndex::ResultQueue::Push(SearchResult& result)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    pushCondition.wait(lock,[this]{return results.size()<queueLimit || !running;});
+
+    if (!running) {
+      return false;
+    }
+
+    results.push_back(std::move(result));
+
+    popCondition.notify_one();
+
+    return true;
+  }
+
+  void TextSearchIndex::ResultQueue::ProducerFinished()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    producerCount--;
+
+    popCondition.notify_all();
+  }
+
+  /**
+   * Pop a result, blocks while the queue is empty. Returns false if there
+   * are no more results, because all producers have finished or the
+   * queue has been stopped.
+   */
+  bool TextSearchIndex::ResultQueue::Pop(SearchResult& result)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    popCondition.wait(lock,[this]{return !results.empty() || producerCount==0 || !running;});
+
+    if (results.empty() ||
+        !running) {
+      return false;
+    }
+
+    result=std::move(results.front());
+    results.pop_front();
+
+    pushCondition.notify_one();
+
+    return true;
+  }
+
+  void TextSearchIndex::ResultQueue::Stop()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    running=false;
+
+    pushCondition.notify_all();
+    popCondition.notify_all();
+  }
+
+  TextSearchIndex::SearchGuard::SearchGuard(ResultQueue& queue,
+                                            std::vector<std::future<bool>>& results)
+  : queue(queue),
+    results(results)
+  {
+    // no code
+  }
+
+  TextSearchIndex::SearchGuard::~SearchGuard()
+  {
+    queue.Stop();
+
+    for (auto& result : results) {
+      result.wait();
+    }
+  }
 
   TextSearchIndex::TextSearchIndex()
   {
@@ -18,6 +111,12 @@ namespace osmscout
 
   TextSearchIndex::~TextSearchIndex()
   {
+    workerQueue.Stop();
+
+    for (auto& thread : workerThreads) {
+      thread.join();
+    }
+
     for(size_t i=0; i < tries.size(); i++) {
       tries[i].isAvail=false;
       if(tries[i].trie){
@@ -102,6 +201,80 @@ namespace osmscout
       }
     }
 
+    // Load the alphabet of each trie, it is used for the fuzzy search
+    for(size_t i=0; i < tries.size(); i++) {
+      if(tries[i].isAvail) {
+        // The alphabet is stored in a key starting with
+        // ASCII 0x05: ENQ
+        std::string alphabetQuery;
+        alphabetQuery.push_back(5);
+
+        marisa::Agent agent;
+        agent.set_query(alphabetQuery.c_str(),
+                        alphabetQuery.length());
+
+        if(tries[i].trie->predictive_search(agent)) {
+          tries[i].alphabet.assign(agent.key().ptr()+1,
+                                   agent.key().length()-1);
+        }
+      }
+    }
+
+    // The importance of the keys is optional, older databases do not have it
+    if(!LoadImportance(fixedPath)) {
+      log.Warn() << "Text search results will not be ranked by importance";
+    }
+
+    return true;
+  }
+
+  bool TextSearchIndex::LoadImportance(const std::string& path)
+  {
+    std::string filename=AppendFileToDir(path,TEXT_IMPORTANCE_DAT);
+    FileScanner scanner;
+
+    try {
+      scanner.Open(filename,
+                   FileScanner::Sequential,
+                   false);
+
+      for(size_t i=0; i < tries.size(); i++) {
+        uint32_t keyCount;
+
+        scanner.Read(keyCount);
+
+        std::vector<uint8_t> importance(keyCount);
+
+        if(keyCount>0) {
+          scanner.Read((char*)importance.data(),
+                       keyCount);
+        }
+
+        if(!tries[i].isAvail) {
+          continue;
+        }
+
+        if(keyCount!=tries[i].trie->num_keys()) {
+          log.Error() << "Number of keys in " << filename << " does not match " << tries[i].file;
+          scanner.CloseFailsafe();
+          return false;
+        }
+
+        tries[i].importance.swap(importance);
+
+        for(const auto value : tries[i].importance) {
+          tries[i].maxImportance=std::max(tries[i].maxImportance,value);
+        }
+      }
+
+      scanner.Close();
+    }
+    catch (IOException& e) {
+      log.Error() << e.GetDescription();
+      scanner.CloseFailsafe();
+      return false;
+    }
+
     return true;
   }
 
@@ -166,6 +339,177 @@ namespace osmscout
     return true;
   }
 
+  /**
+   * Worker of the streaming search, pushes all matches of one trie
+   * to the queue until the trie is exhausted, the queue is stopped
+   * or the breaker is triggered.
+   */
+  bool TextSearchIndex::SearchTrie(size_t trieIndex,
+                                   const std::string& query,
+                                   const BreakerRef& breaker,
+                                   ResultQueue& queue) const
+  {
+    bool success=true;
+
+    try {
+      marisa::Agent agent;
+
+      agent.set_query(query.c_str(),
+                      query.length());
+
+      while(tries[trieIndex].trie->predictive_search(agent)) {
+        if (breaker &&
+            breaker->IsAborted()) {
+          break;
+        }
+
+        SearchResult result;
+
+        if(!DecodeKey(agent.key(),
+                      result.object)) {
+          continue;
+        }
+
+        result.text.assign(agent.key().ptr(),
+                           agent.key().length()-offsetSizeBytes-1);
+
+        if(!queue.Push(result)) {
+          break;
+        }
+      }
+    }
+    catch(const marisa::Exception &ex) {
+      log.Error() << "Error searching for text: " << ex.what();
+      success=false;
+    }
+
+    queue.ProducerFinished();
+
+    return success;
+  }
+
+  /**
+   * Streaming variant of Search(). The selected tries are searched in parallel
+   * by a pool of worker threads, one per trie, that is started on the first
+   * streaming search. Results are passed to the callback on the calling thread
+   * as soon as they are found, so the caller can present first results while
+   * the search is still running. The order of the results is not defined.
+   *
+   * The search stops after limit results (0 means no limit), if the callback
+   * returns false or if the breaker is triggered. The callback must not start
+   * another streaming search on the same index, since the workers are still
+   * busy with the running one.
+   */
+  bool TextSearchIndex::Search(const std::string& query,
+                               bool searchPOIs,
+                               bool searchLocations,
+                               bool searchRegions,
+                               bool searchOther,
+                               size_t limit,
+                               const BreakerRef& breaker,
+                               const SearchResultCallback& callback) const
+  {
+    if(query.empty()) {
+      return true;
+    }
+
+    std::vector<bool> searchGroups;
+
+    searchGroups.push_back(searchPOIs);
+    searchGroups.push_back(searchLocations);
+    searchGroups.push_back(searchRegions);
+    searchGroups.push_back(searchOther);
+
+    std::vector<size_t> trieIndexes;
+
+    for(size_t i=0; i < tries.size(); i++) {
+      if(searchGroups[i] && tries[i].isAvail) {
+        trieIndexes.push_back(i);
+      }
+    }
+
+    if(trieIndexes.empty()) {
+      return true;
+    }
+
+    ResultQueue                    queue(STREAMING_QUEUE_SIZE,
+                                         trieIndexes.size());
+    std::vector<std::future<bool>> results;
+
+    std::call_once(workersStarted,[this]() {
+      StartWorkers();
+    });
+
+    {
+      SearchGuard guard(queue,
+                        results);
+
+      for (const auto trieIndex : trieIndexes) {
+        std::packaged_task<bool()> task([this,trieIndex,&query,&breaker,&queue]() {
+          return SearchTrie(trieIndex,
+                            query,
+                            breaker,
+                            queue);
+        });
+
+        results.push_back(task.get_future());
+
+        workerQueue.PushTask(task);
+      }
+
+      SearchResult result;
+      size_t       resultCount=0;
+
+      while(queue.Pop(result)) {
+        if (breaker &&
+            breaker->IsAborted()) {
+          break;
+        }
+
+        if (!callback(result)) {
+          break;
+        }
+
+        resultCount++;
+
+        if (limit>0 &&
+            resultCount>=limit) {
+          break;
+        }
+      }
+    }
+
+    bool success=true;
+
+    for (auto& result : results) {
+      if (!result.get()) {
+        success=false;
+      }
+    }
+
+    return success;
+  }
+
+  /**
+   * Start the worker pool of the streaming search, one thread per trie,
+   * so a streaming search does not pay for thread creation.
+   */
+  void TextSearchIndex::StartWorkers() const
+  {
+    for (size_t i=0; i<tries.size(); i++) {
+      workerThreads.push_back(std::thread(&TextSearchIndex::WorkerLoop,this));
+    }
+  }
+
+  void TextSearchIndex::WorkerLoop() const
+  {
+    std::packaged_task<bool()> task;
+
+    while (workerQueue.PopTask(task)) {
+      task();
+    }
+  }
+
   void TextSearchIndex::splitSearchResult(const std::string& result,
                                           std::string& text,
                                           ObjectFileRef& ref) const
@@ -194,4 +538,266 @@ namespace osmscout
     ref.Set(offset,reftype);
     text=result.substr(0,idx);
   }
+
+  bool TextSearchIndex::DecodeKey(const marisa::Key& key,
+                                  ObjectFileRef& ref) const
+  {
+    // Same layout as in splitSearchResult(), but decoded in place
+    if(key.length()<=offsetSizeBytes+1u) {
+      return false;
+    }
+
+    const unsigned char* tail=reinterpret_cast<const unsigned char*>(key.ptr())+key.length()-offsetSizeBytes-1;
+    RefType              reftype=static_cast<RefType>(tail[0]);
+    FileOffset           offset=0;
+
+    if(reftype!=refNode &&
+       reftype!=refArea &&
+       reftype!=refWay) {
+      return false;
+    }
+
+    for(size_t i=1; i <= offsetSizeBytes; i++) {
+      offset=(offset << 8) | tail[i];
+    }
+
+    ref.Set(offset,reftype);
+
+    return true;
+  }
+
+  /**
+   * Add all keys below the given trie node to the results using the given
+   * edit distance. Keys already found with a smaller distance are skipped.
+   */
+  void TextSearchIndex::CollectFuzzyMatches(size_t trieIndex,
+                                            const std::string& prefix,
+                                            size_t distance,
+                                            FuzzySearchState& state) const
+  {
+    const TrieInfo& trie=tries[trieIndex];
+    int             maxScore=trie.maxImportance-(int)distance*DISTANCE_PENALTY;
+
+    auto isBetter=[](const ScoredResult& a,
+                     const ScoredResult& b) {
+      return a.score>b.score;
+    };
+
+    // No result of this subtree can beat the worst result we already have
+    if(state.results.size()==state.limit &&
+       state.results.front().score>=maxScore) {
+      return;
+    }
+
+    marisa::Agent agent;
+
+    agent.set_query(prefix.c_str(),
+                    prefix.length());
+
+    while(trie.trie->predictive_search(agent)) {
+      size_t id=agent.key().id();
+
+      if(!state.seen[trieIndex].insert(id).second) {
+        continue;
+      }
+
+      ScoredResult result;
+
+      if(!DecodeKey(agent.key(),
+                    result.object)) {
+        continue;
+      }
+
+      result.distance=(uint8_t)distance;
+      result.score=(id<trie.importance.size() ? trie.importance[id] : 0)-(int)distance*DISTANCE_PENALTY;
+
+      if(state.results.size()<state.limit) {
+        state.results.push_back(result);
+        std::push_heap(state.results.begin(),
+                       state.results.end(),
+                       isBetter);
+      }
+      else if(result.score>state.results.front().score) {
+        std::pop_heap(state.results.begin(),
+                      state.results.end(),
+                      isBetter);
+        state.results.back()=result;
+        std::push_heap(state.results.begin(),
+                       state.results.end(),
+                       isBetter);
+
+        if(state.results.front().score>=maxScore) {
+          return;
+        }
+      }
+    }
+  }
+
+  /**
+   * Depth first traversal of the trie driven by a Levenshtein automaton,
+   * represented by the row of the edit distance matrix of the current prefix.
+   * Subtrees are only entered if they can still match the query with at most
+   * the given distance.
+   */
+  void TextSearchIndex::SearchFuzzyNode(size_t trieIndex,
+                                        std::string& prefix,
+                                        const std::vector<size_t>& row,
+                                        size_t distance,
+                                        FuzzySearchState& state) const
+  {
+    // The whole subtree has already been handled with a smaller distance
+    if(row.back()<distance) {
+      return;
+    }
+
+    if(row.back()==distance) {
+      CollectFuzzyMatches(trieIndex,
+                          prefix,
+                          distance,
+                          state);
+      return;
+    }
+
+    const TrieInfo&     trie=tries[trieIndex];
+    const std::string&  alphabet=trie.alphabet.empty() ? state.query : trie.alphabet;
+    std::vector<size_t> nextRow(row.size());
+    marisa::Agent       agent;
+
+    for(size_t c=0; c<alphabet.size(); c++) {
+      // The query is used as fallback alphabet and may contain duplicates
+      if(c>0 && alphabet.find(alphabet[c])<c) {
+        continue;
+      }
+
+      size_t minDistance;
+
+      nextRow[0]=row[0]+1;
+      minDistance=nextRow[0];
+
+      for(size_t j=1; j<row.size(); j++) {
+        size_t cost=state.query[j-1]==alphabet[c] ? 0 : 1;
+
+        nextRow[j]=std::min(std::min(nextRow[j-1]+1,
+                                     row[j]+1),
+                            row[j-1]+cost);
+        minDistance=std::min(minDistance,nextRow[j]);
+      }
+
+      if(minDistance>distance) {
+        continue;
+      }
+
+      prefix.push_back(alphabet[c]);
+
+      agent.set_query(prefix.c_str(),
+                      prefix.length());
+
+      if(trie.trie->predictive_search(agent)) {
+        SearchFuzzyNode(trieIndex,
+                        prefix,
+                        nextRow,
+                        distance,
+                        state);
+      }
+
+      prefix.pop_back();
+    }
+  }
+
+  /**
+   * Search for all objects with a name starting with a string within the
+   * given edit distance (based on bytes, not on characters) of the query.
+   *
+   * Results are scored by the importance of the object (see TextIndexGenerator)
+   * minus DISTANCE_PENALTY for each edit and only the best limit
+   * results are returned, best result first. The search increases the
+   * allowed distance step by step and stops early if no result of the
+   * next step could beat the results already found.
+   */
+  bool TextSearchIndex::SearchFuzzy(const std::string& query,
+                                    size_t maxDistance,
+                                    size_t limit,
+                                    bool searchPOIs,
+                                    bool searchLocations,
+                                    bool searchRegions,
+                                    bool searchOther,
+                                    std::vector<ScoredResult>& results) const
+  {
+    results.clear();
+
+    if(query.empty() ||
+       limit==0) {
+      return true;
+    }
+
+    // At least one byte of the query must match
+    maxDistance=std::min(maxDistance,query.length()-1);
+
+    std::vector<bool> searchGroups;
+
+    searchGroups.push_back(searchPOIs);
+    searchGroups.push_back(searchLocations);
+    searchGroups.push_back(searchRegions);
+    searchGroups.push_back(searchOther);
+
+    FuzzySearchState state;
+
+    state.query=query;
+    state.limit=limit;
+    state.maxImportance=0;
+    state.seen.resize(tries.size());
+
+    for(size_t i=0; i < tries.size(); i++) {
+      if(searchGroups[i] && tries[i].isAvail) {
+        state.maxImportance=std::max(state.maxImportance,(int)tries[i].maxImportance);
+      }
+    }
+
+    std::vector<size_t> row(query.length()+1);
+
+    for(size_t j=0; j<row.size(); j++) {
+      row[j]=j;
+    }
+
+    try {
+      for(size_t distance=0; distance<=maxDistance; distance++) {
+        // Results with a larger distance cannot beat the results found so far
+        if(state.results.size()==limit &&
+           state.results.front().score>=state.maxImportance-(int)distance*DISTANCE_PENALTY) {
+          break;
+        }
+
+        for(size_t i=0; i < tries.size(); i++) {
+          if(searchGroups[i] && tries[i].isAvail) {
+            std::string prefix;
+
+            SearchFuzzyNode(i,
+                            prefix,
+                            row,
+                            distance,
+                            state);
+          }
+        }
+      }
+    }
+    catch(const marisa::Exception &ex) {
+      log.Error() << "Error searching for text: " << ex.what();
+      return false;
+    }
+
+    results.swap(state.results);
+
+    std::sort(results.begin(),
+              results.end(),
+              [](const ScoredResult& a,
+                 const ScoredResult& b) {
+                if(a.score!=b.score) {
+                  return a.score>b.score;
+                }
+
+                return a.object<b.object;
+              });
+
+    return true;
+  }
 }
@@ -141,18 +141,36 @@ namespace osmscout {
 
   FeatureValueBuffer::FeatureValueBuffer()
   : featureBits(NULL),
-    featureValueBuffer(NULL)
+    featureValueBuffer(NULL),
+    arena(NULL)
   {
     // no code
   }
 
   FeatureValueBuffer::FeatureValueBuffer(const FeatureValueBuffer& other)
   : featureBits(NULL),
-    featureValueBuffer(NULL)
+    featureValueBuffer(NULL),
+    arena(NULL)
   {
     Set(other);
   }
 
+  /**
+   * Take over the feature bits and values of the other buffer (together
+   * with the arena they were allocated from), leaving the other buffer
+   * empty.
+   */
+  FeatureValueBuffer::FeatureValueBuffer(FeatureValueBuffer&& other)
+  : type(std::move(other.type)),
+    featureBits(other.featureBits),
+    featureValueBuffer(other.featureValueBuffer),
+    arena(other.arena)
+  {
+    other.type=NULL;
+    other.featureBits=NULL;
+    other.featureValueBuffer=NULL;
+  }
+
   FeatureValueBuffer::~FeatureValueBuffer()
   {
     if (type) {
@@ -208,12 +226,18 @@ namespace osmscout {
         }
       }
 
-      ::operator delete((void*)featureValueBuffer);
+      if (arena==NULL) {
+        ::operator delete((void*)featureValueBuffer);
+      }
+
       featureValueBuffer=NULL;
     }
 
     if (featureBits!=NULL) {
-      delete [] featureBits;
+      if (arena==NULL) {
+        delete [] featureBits;
+      }
+
       featureBits=NULL;
     }
 
@@ -223,7 +247,13 @@ namespace osmscout {
   void FeatureValueBuffer::AllocateBits()
   {
     if (type && type->HasFeatures()) {
-      featureBits=new uint8_t[type->GetFeatureMaskBytes()]();
+      if (arena!=NULL) {
+        featureBits=static_cast<uint8_t*>(arena->Allocate(type->GetFeatureMaskBytes(),1));
+        std::fill(featureBits,featureBits+type->GetFeatureMaskBytes(),0);
+      }
+      else {
+        featureBits=new uint8_t[type->GetFeatureMaskBytes()]();
+      }
     }
     else
     {
@@ -236,7 +266,12 @@ namespace osmscout {
     if (featureValueBuffer==NULL &&
         type &&
         type->HasFeatures()) {
-      featureValueBuffer=static_cast<char*>(::operator new(type->GetFeatureValueBufferSize()));
+      if (arena!=NULL) {
+        featureValueBuffer=static_cast<char*>(arena->Allocate(type->GetFeatureValueBufferSize()));
+      }
+      else {
+        featureValueBuffer=static_cast<char*>(::operator new(type->GetFeatureValueBufferSize()));
+      }
     }
   }
 
@@ -272,6 +307,25 @@ namespace osmscout {
     }
   }
 
+  /**
+   * Return the number of bytes allocated for feature bits and values. Memory
+   * allocated by the values themselves (like strings) is not included.
+   */
+  size_t FeatureValueBuffer::GetMemoryUsage() const
+  {
+    size_t memory=0;
+
+    if (featureBits!=NULL) {
+      memory+=type->GetFeatureMaskBytes();
+    }
+
+    if (featureValueBuffer!=NULL) {
+      memory+=type->GetFeatureValueBufferSize();
+    }
+
+    return memory;
+  }
+
   void FeatureValueBuffer::Parse(Progress& progress,
                                  const TypeConfig& typeConfig,
                                  const ObjectOSMRef& object,
@@ -518,6 +572,26 @@ namespace osmscout {
     return *this;
   }
 
+  FeatureValueBuffer& FeatureValueBuffer::operator=(FeatureValueBuffer&& other)
+  {
+    if (this!=&other) {
+      if (type) {
+        DeleteData();
+      }
+
+      type=std::move(other.type);
+      featureBits=other.featureBits;
+      featureValueBuffer=other.featureValueBuffer;
+      arena=other.arena;
+
+      other.type=NULL;
+      other.featureBits=NULL;
+      other.featureValueBuffer=NULL;
+    }
+
+    return *this;
+  }
+
   bool FeatureValueBuffer::operator==(const FeatureValueBuffer& other) const
   {
     if (this->type!=other.type) {
@@ -31,6 +31,8 @@ namespace osmscout {
 
   const char* WaterIndex::WATER_IDX="water.idx";
 
+  const uint32_t WaterIndex::BLOCK_SIZE=16;
+
   WaterIndex::WaterIndex()
   {
     // no code
@@ -108,129 +110,289 @@ namespace osmscout {
     }
   }
 
-  bool WaterIndex::GetRegions(const GeoBox& boundingBox,
-                              const Magnification& magnification,
-                              std::list<GroundTile>& tiles) const
+  /**
+   * Return the index of the level to use for the given magnification.
+   */
+  uint32_t WaterIndex::GetLevelIndex(const Magnification& magnification) const
   {
-    try {
-      uint32_t cx1,cx2,cy1,cy2;
-      uint32_t idx=magnification.GetLevel();
+    uint32_t idx=magnification.GetLevel();
 
-      if (levels.empty()) {
-        return true;
-      }
-
-      idx+=4;
+    idx+=4;
 
-      idx=std::max(waterIndexMinMag,idx);
-      idx=std::min(waterIndexMaxMag,idx);
+    idx=std::max(waterIndexMinMag,idx);
+    idx=std::min(waterIndexMaxMag,idx);
 
-      idx-=waterIndexMinMag;
+    idx-=waterIndexMinMag;
 
-      tiles.clear();
+    return idx;
+  }
 
-      cx1=(uint32_t)floor((boundingBox.GetMinLon()+180.0)/levels[idx].cellWidth);
-      cx2=(uint32_t)floor((boundingBox.GetMaxLon()+180.0)/levels[idx].cellWidth);
-      cy1=(uint32_t)floor((boundingBox.GetMinLat()+90.0)/levels[idx].cellHeight);
-      cy2=(uint32_t)floor((boundingBox.GetMaxLat()+90.0)/levels[idx].cellHeight);
+  /**
+   * Read the cells in the given (inclusive) cell range of the given level and
+   * append the resulting ground tiles to the given list.
+   *
+   * Full cell tiles of the same type are merged into rectangles spanning
+   * multiple cells. Tiles with coastline polygons are returned unchanged after
+   * the full cell tiles.
+   */
+  bool WaterIndex::ReadCells(uint32_t idx,
+                             uint32_t cx1,
+                             uint32_t cx2,
+                             uint32_t cy1,
+                             uint32_t cy2,
+                             std::list<GroundTile>& tiles) const
+  {
+    const Level&                    level=levels[idx];
+    size_t                          width=cx2-cx1+1;
+    size_t                          height=cy2-cy1+1;
+    std::vector<GroundTile::Type>   cellTypes(width*height,GroundTile::unknown);
+    std::list<GroundTile>           coastTiles;
+    GroundTile                      tile;
+
+    tile.cellWidth=level.cellWidth;
+    tile.cellHeight=level.cellHeight;
+
+    {
+      std::lock_guard<std::mutex> guard(lookupMutex);
+
+      for (uint32_t y=std::max(cy1,level.cellYStart); y<=std::min(cy2,level.cellYEnd); y++) {
+        for (uint32_t x=std::max(cx1,level.cellXStart); x<=std::min(cx2,level.cellXEnd); x++) {
+          uint32_t   cellId=(y-level.cellYStart)*level.cellXCount+x-level.cellXStart;
+          uint32_t   index=cellId*8;
+          FileOffset cell;
+
+          scanner.SetPos(level.offset+index);
+
+          scanner.Read(cell);
+
+          if (cell==(FileOffset)GroundTile::land ||
+              cell==(FileOffset)GroundTile::water ||
+              cell==(FileOffset)GroundTile::coast ||
+              cell==(FileOffset)GroundTile::unknown) {
+            cellTypes[(y-cy1)*width+x-cx1]=(GroundTile::Type)cell;
+            continue;
+          }
 
-      GroundTile tile;
+          uint32_t tileCount;
 
-      tile.coords.reserve(5);
-      tile.cellWidth=levels[idx].cellWidth;
-      tile.cellHeight=levels[idx].cellHeight;
+          cellTypes[(y-cy1)*width+x-cx1]=GroundTile::coast;
 
-      for (uint32_t y=cy1; y<=cy2; y++) {
-        for (uint32_t x=cx1; x<=cx2; x++) {
           tile.xAbs=x;
           tile.yAbs=y;
+          tile.xRel=x-level.cellXStart;
+          tile.yRel=y-level.cellYStart;
 
-          if (x>=levels[idx].cellXStart &&
-              y>=levels[idx].cellYStart) {
-            tile.xRel=x-levels[idx].cellXStart;
-            tile.yRel=y-levels[idx].cellYStart;
-          }
-          else {
-            tile.xRel=0;
-            tile.yRel=0;
-          }
+          scanner.SetPos(cell);
+          scanner.ReadNumber(tileCount);
 
-          if (x<levels[idx].cellXStart ||
-              x>levels[idx].cellXEnd ||
-              y<levels[idx].cellYStart ||
-              y>levels[idx].cellYEnd) {
-            tile.type=GroundTile::unknown;
-            tile.coords.clear();
+          for (size_t t=1; t<=tileCount; t++) {
+            uint8_t    tileType;
+            uint32_t   coordCount;
 
-            tiles.push_back(tile);
-          }
-          else {
-            std::lock_guard<std::mutex> guard(lookupMutex);
-            uint32_t                    cellId=(y-levels[idx].cellYStart)*levels[idx].cellXCount+x-levels[idx].cellXStart;
-            uint32_t                    index=cellId*8;
-            FileOffset                  cell;
+            scanner.Read(tileType);
+
+            tile.type=(GroundTile::Type)tileType;
 
-            scanner.SetPos(levels[idx].offset+index);
+            scanner.ReadNumber(coordCount);
 
-            scanner.Read(cell);
+            tile.coords.resize(coordCount);
 
-            if (cell==(FileOffset)GroundTile::land ||
-                cell==(FileOffset)GroundTile::water ||
-                cell==(FileOffset)GroundTile::coast ||
-                cell==(FileOffset)GroundTile::unknown) {
-              tile.type=(GroundTile::Type)cell;
-              tile.coords.clear();
+            for (size_t n=0; n<coordCount; n++) {
+              uint16_t cx;
+              uint16_t cy;
 
-              tiles.push_back(tile);
+              scanner.Read(cx);
+              scanner.Read(cy);
+
+              tile.coords[n].Set(cx & ~(1 << 15),
+                                 cy,
+                                 (cx & (1 << 15))!=0);
             }
-            else {
-              uint32_t tileCount;
 
-              tile.type=GroundTile::coast;
-              tile.coords.clear();
+            coastTiles.push_back(tile);
+          }
+        }
+      }
+    }
 
-              tiles.push_back(tile);
+    // Greedily merge cells of the same type into rectangles: first extend
+    // horizontally as far as possible, then add rows below as long as the
+    // complete row segment has the same type
 
-              scanner.SetPos(cell);
-              scanner.ReadNumber(tileCount);
+    std::vector<bool> done(width*height,false);
 
-              for (size_t t=1; t<=tileCount; t++) {
-                uint8_t    tileType;
-                uint32_t   coordCount;
+    tile.coords.clear();
 
-                scanner.Read(tileType);
+    for (size_t y=0; y<height; y++) {
+      for (size_t x=0; x<width; x++) {
+        if (done[y*width+x]) {
+          continue;
+        }
 
-                tile.type=(GroundTile::Type)tileType;
+        GroundTile::Type type=cellTypes[y*width+x];
+        size_t           w=1;
+        size_t           h=1;
 
-                scanner.ReadNumber(coordCount);
+        while (x+w<width &&
+               !done[y*width+x+w] &&
+               cellTypes[y*width+x+w]==type) {
+          w++;
+        }
 
-                tile.coords.resize(coordCount);
+        while (y+h<height) {
+          bool match=true;
 
-                for (size_t n=0; n<coordCount; n++) {
-                  uint16_t x;
-                  uint16_t y;
+          for (size_t i=x; i<x+w; i++) {
+            if (done[(y+h)*width+i] ||
+                cellTypes[(y+h)*width+i]!=type) {
+              match=false;
+              break;
+            }
+          }
 
-                  scanner.Read(x);
-                  scanner.Read(y);
+          if (!match) {
+            break;
+          }
 
-                  tile.coords[n].Set(x & ~(1 << 15),
-                                     y,
-                                     (x & (1 << 15))!=0);
-                }
+          h++;
+        }
 
-                tiles.push_back(tile);
-              }
-            }
+        for (size_t j=y; j<y+h; j++) {
+          for (size_t i=x; i<x+w; i++) {
+            done[j*width+i]=true;
           }
         }
+
+        tile.type=type;
+        tile.xAbs=cx1+x;
+        tile.yAbs=cy1+y;
+        tile.width=w;
+        tile.height=h;
+
+        if (tile.xAbs>=level.cellXStart &&
+            tile.yAbs>=level.cellYStart) {
+          tile.xRel=tile.xAbs-level.cellXStart;
+          tile.yRel=tile.yAbs-level.cellYStart;
+        }
+        else {
+          tile.xRel=0;
+          tile.yRel=0;
+        }
+
+        tiles.push_back(tile);
       }
     }
+
+    tiles.splice(tiles.end(),coastTiles);
+
+    return !scanner.HasError();
+  }
+
+  /**
+   * Return the ground tiles for the given area and magnification.
+   *
+   * Full cell tiles of the same type are merged into bigger rectangular tiles.
+   */
+  bool WaterIndex::GetRegions(const GeoBox& boundingBox,
+                              const Magnification& magnification,
+                              std::list<GroundTile>& tiles) const
+  {
+    tiles.clear();
+
+    if (levels.empty()) {
+      return true;
+    }
+
+    try {
+      uint32_t idx=GetLevelIndex(magnification);
+      uint32_t cx1,cx2,cy1,cy2;
+
+      cx1=(uint32_t)floor((boundingBox.GetMinLon()+180.0)/levels[idx].cellWidth);
+      cx2=(uint32_t)floor((boundingBox.GetMaxLon()+180.0)/levels[idx].cellWidth);
+      cy1=(uint32_t)floor((boundingBox.GetMinLat()+90.0)/levels[idx].cellHeight);
+      cy2=(uint32_t)floor((boundingBox.GetMaxLat()+90.0)/levels[idx].cellHeight);
+
+      return ReadCells(idx,
+                       cx1,cx2,
+                       cy1,cy2,
+                       tiles);
+    }
     catch (IOException& e) {
       log.Error() << e.GetDescription();
       return false;
     }
+  }
+
+  /**
+   * Return the ids of all blocks that are required to cover the given area
+   * for the given magnification.
+   */
+  void WaterIndex::GetBlocks(const GeoBox& boundingBox,
+                             const Magnification& magnification,
+                             std::vector<BlockId>& blocks) const
+  {
+    blocks.clear();
+
+    if (levels.empty()) {
+      return;
+    }
+
+    uint32_t idx=GetLevelIndex(magnification);
+    uint32_t cx1,cx2,cy1,cy2;
+
+    cx1=(uint32_t)floor((boundingBox.GetMinLon()+180.0)/levels[idx].cellWidth);
+    cx2=(uint32_t)floor((boundingBox.GetMaxLon()+180.0)/levels[idx].cellWidth);
+    cy1=(uint32_t)floor((boundingBox.GetMinLat()+90.0)/levels[idx].cellHeight);
+    cy2=(uint32_t)floor((boundingBox.GetMaxLat()+90.0)/levels[idx].cellHeight);
 
-    return true;
+    BlockId block;
+
+    block.level=idx;
+
+    for (uint32_t y=cy1/BLOCK_SIZE; y<=cy2/BLOCK_SIZE; y++) {
+      for (uint32_t x=cx1/BLOCK_SIZE; x<=cx2/BLOCK_SIZE; x++) {
+        block.x=x;
+        block.y=y;
+
+        blocks.push_back(block);
+      }
+    }
+  }
+
+  /**
+   * Return the merged ground tiles of the given block. Cells of the block
+   * beyond the border of the world are not returned.
+   */
+  bool WaterIndex::GetBlockRegions(const BlockId& block,
+                                   std::list<GroundTile>& tiles) const
+  {
+    tiles.clear();
+
+    if (block.level>=levels.size()) {
+      return false;
+    }
+
+    try {
+      const Level& level=levels[block.level];
+      uint32_t     maxX=(uint32_t)floor(360.0/level.cellWidth+0.5);
+      uint32_t     maxY=(uint32_t)floor(180.0/level.cellHeight+0.5);
+      uint32_t     cx1=block.x*BLOCK_SIZE;
+      uint32_t     cy1=block.y*BLOCK_SIZE;
+
+      // The world border itself is a valid cell coordinate
+      if (cx1>maxX || cy1>maxY) {
+        return true;
+      }
+
+      return ReadCells(block.level,
+                       cx1,std::min(cx1+BLOCK_SIZE-1,maxX),
+                       cy1,std::min(cy1+BLOCK_SIZE-1,maxY),
+                       tiles);
+    }
+    catch (IOException& e) {
+      log.Error() << e.GetDescription();
+      return false;
+    }
   }
 
   void WaterIndex::DumpStatistics()
@@ -30,24 +30,16 @@ namespace osmscout {
 
   bool Way::GetCenter(GeoCoord& center) const
   {
-    if (nodes.empty()) {
+    if (GetNodeCount()==0) {
       return false;
     }
 
-    double minLat=nodes[0].GetLat();
-    double minLon=nodes[0].GetLon();
-    double maxLat=nodes[0].GetLat();
-    double maxLon=nodes[0].GetLon();
+    GeoBox boundingBox;
 
-    for (size_t i=1; i<nodes.size(); i++) {
-      minLat=std::min(minLat,nodes[i].GetLat());
-      minLon=std::min(minLon,nodes[i].GetLon());
-      maxLat=std::max(maxLat,nodes[i].GetLat());
-      maxLon=std::max(maxLon,nodes[i].GetLon());
-    }
+    GetBoundingBox(boundingBox);
 
-    center.Set(minLat+(maxLat-minLat)/2,
-               minLon+(maxLon-minLon)/2);
+    center.Set(boundingBox.GetMinLat()+(boundingBox.GetMaxLat()-boundingBox.GetMinLat())/2,
+               boundingBox.GetMinLon()+(boundingBox.GetMaxLon()-boundingBox.GetMinLon())/2);
 
     return true;
   }
@@ -61,8 +53,8 @@ namespace osmscout {
   bool Way::GetNodeIndexByNodeId(Id id,
                                  size_t& index) const
   {
-    for (size_t i=0; i<nodes.size(); i++) {
-      if (nodes[i].GetId()==id) {
+    for (size_t i=0; i<GetNodeCount(); i++) {
+      if (GetId(i)==id) {
         index=i;
 
         return true;
@@ -72,6 +64,88 @@ namespace osmscout {
     return false;
   }
 
+  /**
+   * Move the nodes into the compact fixed-point representation (see
+   * CompactPoints), reducing the memory footprint of the nodes to about a
+   * third. Afterwards the nodes are only accessible via compactNodes and the
+   * accessor methods, the nodes vector is empty.
+   *
+   * Compact ways cannot be written, call Expand() before.
+   */
+  void Way::Compact()
+  {
+    if (IsCompact() ||
+        nodes.empty()) {
+      return;
+    }
+
+    compactNodes.Set(nodes);
+    std::vector<Point>().swap(nodes);
+  }
+
+  /**
+   * Move the nodes back from the compact representation into the
+   * nodes vector.
+   */
+  void Way::Expand()
+  {
+    if (!IsCompact()) {
+      return;
+    }
+
+    compactNodes.Get(nodes);
+    compactNodes.clear();
+  }
+
+  /**
+   * Read the features and the nodes of the way, following the header.
+   *
+   * @throws IOException
+   */
+  void Way::ReadData(const TypeInfoRef& type,
+                     FileScanner& scanner)
+  {
+    featureValueBuffer.SetType(type);
+
+    featureValueBuffer.Read(scanner);
+
+    scanner.Read(nodes,type->CanRoute() ||
+                       type->GetOptimizeLowZoom());
+  }
+
+  /**
+   * Read the header of the way at the current position of the given
+   * FileScanner (see Write()). Feature values and nodes are not read,
+   * afterwards the way can be either read completely by passing the header
+   * to Read() or skipped by continuing at header.nextOffset.
+   *
+   * @throws IOException
+   */
+  void Way::ReadHeader(const TypeConfig& typeConfig,
+                       FileScanner& scanner,
+                       ObjectHeader& header)
+  {
+    TypeId   typeId;
+    uint32_t dataSize;
+
+    header.fileOffset=scanner.GetPos();
+
+    scanner.ReadTypeId(typeId,
+                       typeConfig.GetWayTypeIdBytes());
+    scanner.ReadCompactBox(header.boundingBox);
+    scanner.Read(dataSize);
+
+    header.type=typeConfig.GetWayTypeInfo(typeId);
+    header.dataOffset=scanner.GetPos();
+    header.nextOffset=header.dataOffset+dataSize;
+
+    header.featureBits.resize(header.type->GetFeatureMaskBytes());
+
+    for (auto& bits : header.featureBits) {
+      scanner.Read(bits);
+    }
+  }
+
   /**
    * Read the data from the given FileScanner.
    *
@@ -80,21 +154,37 @@ namespace osmscout {
   void Way::Read(const TypeConfig& typeConfig,
                  FileScanner& scanner)
   {
-    TypeId typeId;
+    TypeId   typeId;
+    GeoBox   boundingBox;
+    uint32_t dataSize;
 
     fileOffset=scanner.GetPos();
 
     scanner.ReadTypeId(typeId,
                        typeConfig.GetWayTypeIdBytes());
+    scanner.ReadCompactBox(boundingBox);
+    scanner.Read(dataSize);
 
-    TypeInfoRef type=typeConfig.GetWayTypeInfo(typeId);
+    ReadData(typeConfig.GetWayTypeInfo(typeId),
+             scanner);
+  }
 
-    featureValueBuffer.SetType(type);
+  /**
+   * Read the data of the way with the given header, as returned by
+   * ReadHeader().
+   *
+   * @throws IOException
+   */
+  void Way::Read(const TypeConfig& /*typeConfig*/,
+                 const ObjectHeader& header,
+                 FileScanner& scanner)
+  {
+    fileOffset=header.fileOffset;
 
-    featureValueBuffer.Read(scanner);
+    scanner.SetPos(header.dataOffset);
 
-    scanner.Read(nodes,type->CanRoute() ||
-                       type->GetOptimizeLowZoom());
+    ReadData(header.type,
+             scanner);
   }
 
   /**
@@ -122,6 +212,10 @@ namespace osmscout {
   /**
    * Writes the data to the given FileWriter.
    *
+   * The type, the bounding box and the size of the following feature and
+   * node data are written first, so that ways can be filtered and skipped
+   * without decoding their data (see ReadHeader()).
+   *
    * @throws IOException
    */
   void Way::Write(const TypeConfig& typeConfig,
@@ -129,13 +223,28 @@ namespace osmscout {
   {
     assert(!nodes.empty());
 
+    GeoBox     boundingBox;
+    FileWriter dataWriter;
+
+    GetBoundingBox(boundingBox);
+
+    // Write the data to memory first, to write its size in front of it
+    // without seeking in the file
+    dataWriter.OpenMemory();
+
+    featureValueBuffer.Write(dataWriter);
+
+    dataWriter.Write(nodes,featureValueBuffer.GetType()->CanRoute() ||
+                           featureValueBuffer.GetType()->GetOptimizeLowZoom());
+
     writer.WriteTypeId(featureValueBuffer.GetType()->GetWayId(),
                        typeConfig.GetWayTypeIdBytes());
+    writer.WriteCompactBox(boundingBox);
+    writer.Write((uint32_t)dataWriter.GetMemory().size());
+    writer.Write(dataWriter.GetMemory().data(),
+                 dataWriter.GetMemory().size());
 
-    featureValueBuffer.Write(writer);
-
-    writer.Write(nodes,featureValueBuffer.GetType()->CanRoute() ||
-                       featureValueBuffer.GetType()->GetOptimizeLowZoom());
+    dataWriter.Close();
   }
 
   /**
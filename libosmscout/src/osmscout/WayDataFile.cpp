@@ -29,5 +29,16 @@ namespace osmscout {
   {
     // no code
   }
+
+  /**
+   * Return the memory of the way including its nodes and features
+   */
+  size_t WayDataFile::GetValueMemory(const Way& way) const
+  {
+    return sizeof(Way)+
+           way.nodes.capacity()*sizeof(Point)+
+           way.compactNodes.GetMemoryUsage()+
+           way.GetFeatureValueBuffer().GetMemoryUsage();
+  }
 }
 
@@ -25,10 +25,14 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <algorithm>
 #include <limits>
 
-#if defined(HAVE_MMAP)
+#if defined(HAVE_MMAP) || defined(HAVE_PREAD)
   #include <unistd.h>
+#endif
+
+#if defined(HAVE_MMAP)
   #include <sys/mman.h>
 #endif
 
@@ -44,6 +48,11 @@
   #endif
 #endif
 
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define OSMSCOUT_SIMD_DELTA_DECODER
+#include <immintrin.h>
+#endif
+
 #include <osmscout/system/Assert.h>
 
 #include <osmscout/util/Exception.h>
@@ -59,8 +68,11 @@ namespace osmscout {
      buffer(NULL),
      size(0),
      offset(0),
+     memoryBuffer(false),
+     bufferOffset(0),
      byteBuffer(NULL),
-     byteBufferSize(0)
+     byteBufferSize(0),
+     deltaDecoder(decoderAuto)
 #if defined(__WIN32__) || defined(WIN32)
      ,mmfHandle((HANDLE)0)
 #endif
@@ -93,6 +105,15 @@ namespace osmscout {
 
   void FileScanner::FreeBuffer()
   {
+    if (memoryBuffer) {
+      // The memory is owned by the caller
+      buffer=NULL;
+      memoryBuffer=false;
+      bufferOffset=0;
+
+      return;
+    }
+
 #if defined(HAVE_MMAP)
     if (buffer!=NULL) {
       if (munmap(buffer,size)!=0) {
@@ -252,6 +273,66 @@ namespace osmscout {
     hasError=false;
   }
 
+  /**
+   * Opens the scanner on a range of the file, that has already been read
+   * into memory (see ReadAt()). Positions are still file offsets, but the
+   * scanner can only be positioned inside the range starting at the given
+   * offset. The data is not copied, it must stay valid until the scanner
+   * is closed.
+   *
+   * throws IOException on error
+   */
+  void FileScanner::Open(const std::string& filename,
+                         FileOffset offset,
+                         char* data,
+                         size_t size)
+  {
+    if (IsOpen()) {
+      throw IOException(filename,"Error opening file for reading","File already opened");
+    }
+
+    if (data==NULL ||
+        size==0) {
+      throw IOException(filename,"Error opening file for reading","No data");
+    }
+
+    this->filename=filename;
+
+    buffer=data;
+    this->size=(FileOffset)size;
+    this->offset=0;
+    memoryBuffer=true;
+    bufferOffset=offset;
+
+    hasError=false;
+  }
+
+  /**
+   * Opens the scanner on the file of the given, open scanner, with its own
+   * read position. If the given scanner is memory mapped, its mapping is
+   * shared and must stay valid until this scanner is closed, else the file
+   * is opened again using the given mode.
+   *
+   * Allows concurrent reads of a file that is kept open, without locking.
+   *
+   * throws IOException on error
+   */
+  void FileScanner::Open(const FileScanner& scanner,
+                         Mode mode)
+  {
+    if (scanner.IsMemoryMapped()) {
+      Open(scanner.filename,
+           0,
+           scanner.buffer,
+           (size_t)scanner.size);
+    }
+    else {
+      Open(scanner.filename,
+           mode,
+           false);
+    }
+  }
+
   /**
    * Closes the file.
    *
@@ -261,12 +342,16 @@ namespace osmscout {
    */
   void FileScanner::Close()
   {
-    if (file==NULL) {
+    if (!IsOpen()) {
       throw IOException(filename,"Cannot close file","File already closed");
     }
 
     FreeBuffer();
 
+    if (file==NULL) {
+      return;
+    }
+
     if (fclose(file)!=0) {
       file=NULL;
       throw IOException(filename,"Cannot close file");
@@ -284,12 +369,12 @@ namespace osmscout {
    */
   void FileScanner::CloseFailsafe()
   {
+    FreeBuffer();
+
     if (file==NULL) {
       return;
     }
 
-    FreeBuffer();
-
     fclose(file);
 
     file=NULL;
@@ -305,11 +390,9 @@ namespace osmscout {
       return true;
     }
 
-#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
     if (buffer!=NULL) {
       return offset>=size;
     }
-#endif
 
     return feof(file)!=0;
   }
@@ -340,18 +423,17 @@ namespace osmscout {
       throw IOException(filename,"Cannot set position in file","File already in error state");
     }
 
-#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
     if (buffer!=NULL) {
-      if (pos>=size) {
+      if (pos<bufferOffset ||
+          pos-bufferOffset>=size) {
         hasError=true;
         throw IOException(filename,"Cannot set position in file to "+NumberToString(pos),"Position beyond file end");
       }
 
-      offset=pos;
+      offset=pos-bufferOffset;
 
       return;
     }
-#endif
 
     clearerr(file);
 
@@ -377,11 +459,9 @@ namespace osmscout {
       throw IOException(filename,"Cannot read position in file","File already in error state");
     }
 
-#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
     if (buffer!=NULL) {
-      return offset;
+      return bufferOffset+offset;
     }
-#endif
 
 #if defined(HAVE_FSEEKO)
     off_t filepos=ftello(file);
@@ -404,13 +484,85 @@ namespace osmscout {
 #endif
   }
 
+  /**
+   * Tell the operating system, that the given range of the file will be
+   * read soon, so that it can be loaded into the page cache in the
+   * background. The current position is not changed. The range is clipped
+   * to the file size.
+   *
+   * This is only a hint, errors are logged but otherwise ignored. On
+   * platforms without the required system calls, the method does nothing.
+   */
+  void FileScanner::Prefetch(FileOffset pos,
+                             FileOffset bytes) const
+  {
+    if (HasError() ||
+        memoryBuffer ||
+        pos>=size ||
+        bytes==0) {
+      return;
+    }
+
+    bytes=std::min(bytes,size-pos);
+
+#if defined(HAVE_MMAP) && defined(HAVE_POSIX_MADVISE)
+    if (buffer!=NULL) {
+      // The address passed to posix_madvise() must be page aligned
+      FileOffset pageSize=(FileOffset)sysconf(_SC_PAGESIZE);
+      FileOffset start=pos-pos%pageSize;
+
+      if (posix_madvise(buffer+start,(size_t)(pos+bytes-start),POSIX_MADV_WILLNEED)<0) {
+        log.Error() << "Cannot set mmaped file access advice for file '" << filename << "' (" << strerror(errno) << ")";
+      }
+
+      return;
+    }
+#endif
+
+#if defined(HAVE_POSIX_FADVISE)
+    if (buffer==NULL) {
+      if (posix_fadvise(fileno(file),(off_t)pos,(off_t)bytes,POSIX_FADV_WILLNEED)<0) {
+        log.Error() << "Cannot set file access advice for file '" << filename << "' (" << strerror(errno) << ")";
+      }
+    }
+#endif
+  }
+
+  /**
+   * Lock the memory mapping of the file into RAM, so that its pages are
+   * loaded now and never paged out while the file is open. The lock is
+   * released on closing the file.
+   *
+   * Returns false, if the file is not memory mapped or the pages could not
+   * be locked (for example because of the RLIMIT_MEMLOCK limit of the
+   * process).
+   */
+  bool FileScanner::Lock() const
+  {
+    if (HasError()) {
+      return false;
+    }
+
+#if defined(HAVE_MMAP)
+    if (IsMemoryMapped()) {
+      if (mlock(buffer,(size_t)size)<0) {
+        log.Warn() << "Cannot lock mmaped file '" << filename << "' into memory (" << strerror(errno) << ")";
+        return false;
+      }
+
+      return true;
+    }
+#endif
+
+    return false;
+  }
+
   void FileScanner::Read(char* buffer, size_t bytes)
   {
     if (HasError()) {
       throw IOException(filename,"Cannot read byte array","File already in error state");
     }
 
-#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
     if (this->buffer!=NULL) {
       if (offset+(FileOffset)bytes-1>=size) {
         hasError=true;
@@ -423,7 +575,6 @@ namespace osmscout {
 
       return;
     }
-#endif
 
     hasError=fread(buffer,1,bytes,file)!=bytes;
 
@@ -432,6 +583,70 @@ namespace osmscout {
     }
   }
 
+  /**
+   * Reads the given number of bytes starting at the given file position
+   * into the buffer. The current position is not changed.
+   *
+   * If the system offers pread(), the file is read without moving the
+   * position of the underlying file handle, so the method can be called
+   * concurrently with other calls of ReadAt(). Else the method is not
+   * thread-safe.
+   *
+   * throws IOException on error
+   */
+  void FileScanner::ReadAt(FileOffset pos,
+                           char* buffer,
+                           size_t bytes)
+  {
+    if (HasError()) {
+      throw IOException(filename,"Cannot read byte array","File already in error state");
+    }
+
+    if (bytes==0) {
+      return;
+    }
+
+    if (this->buffer!=NULL) {
+      if (pos<bufferOffset ||
+          pos-bufferOffset+(FileOffset)bytes>size) {
+        throw IOException(filename,"Cannot read byte array","Cannot read beyond end of file");
+      }
+
+      memcpy(buffer,&this->buffer[pos-bufferOffset],bytes);
+
+      return;
+    }
+
+#if defined(HAVE_PREAD)
+    size_t done=0;
+
+    while (done<bytes) {
+      ssize_t result=pread(fileno(file),
+                           buffer+done,
+                           bytes-done,
+                           (off_t)(pos+done));
+
+      if (result<0 &&
+          errno==EINTR) {
+        continue;
+      }
+
+      if (result<=0) {
+        hasError=true;
+        throw IOException(filename,"Cannot read byte array at position "+NumberToString(pos));
+      }
+
+      done+=(size_t)result;
+    }
+#else
+    FileOffset currentPos=GetPos();
+
+    SetPos(pos);
+    Read(buffer,bytes);
+    SetPos(currentPos);
+#endif
+  }
+
   void FileScanner::Read(std::string& value)
   {
     if (HasError()) {
@@ -440,7 +655,6 @@ namespace osmscout {
 
     value.clear();
 
-#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
     if (buffer!=NULL) {
       if (offset>=size) {
         hasError=true;
@@ -465,7 +679,6 @@ namespace osmscout {
 
       return;
     }
-#endif
 
     char character;
 
@@ -492,7 +705,6 @@ namespace osmscout {
       throw IOException(filename,"Cannot read bool","File already in error state");
     }
 
-#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
     if (buffer!=NULL) {
       if (offset>=size) {
         hasError=true;
@@ -505,7 +717,6 @@ namespace osmscout {
 
       return;
     }
-#endif
 
     char value;
 
@@ -526,7 +737,6 @@ namespace osmscout {
 
     number=0;
 
-#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
     if (buffer!=NULL) {
       if (offset>=size) {
         hasError=true;
@@ -539,7 +749,6 @@ namespace osmscout {
 
       return;
     }
-#endif
 
     hasError=fread(&number,1,1,file)!=1;
 
@@ -556,7 +765,6 @@ namespace osmscout {
 
     number=0;
 
-#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
     if (buffer!=NULL) {
       if (offset+2-1>=size) {
         hasError=true;
@@ -579,7 +787,6 @@ namespace osmscout {
 
       return;
     }
-#endif
 
     unsigned char buffer[2];
 
@@ -610,7 +817,6 @@ namespace osmscout {
 
     number=0;
 
-#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
     if (buffer!=NULL) {
       if (offset+4-1>=size) {
         hasError=true;
@@ -643,7 +849,6 @@ namespace osmscout {
 
       return;
     }
-#endif
 
     unsigned char buffer[4];
 
@@ -684,7 +889,6 @@ namespace osmscout {
 
     number=0;
 
-#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
     if (buffer!=NULL) {
       if (offset+8-1>=size) {
         hasError=true;
@@ -737,7 +941,6 @@ namespace osmscout {
 
       return;
     }
-#endif
 
     unsigned char buffer[8];
 
@@ -798,7 +1001,6 @@ namespace osmscout {
 
     number=0;
 
-#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
     if (buffer!=NULL) {
       if (offset>=size) {
         hasError=true;
@@ -811,7 +1013,6 @@ namespace osmscout {
 
       return;
     }
-#endif
 
     hasError=fread(&number,1,1,file)!=1;
 
@@ -828,7 +1029,6 @@ namespace osmscout {
 
     number=0;
 
-#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
     if (buffer!=NULL) {
       if (offset+2-1>=size) {
         hasError=true;
@@ -851,7 +1051,6 @@ namespace osmscout {
 
       return;
     }
-#endif
 
     unsigned char buffer[2];
 
@@ -882,7 +1081,6 @@ namespace osmscout {
 
     number=0;
 
-#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
     if (buffer!=NULL) {
       if (offset+4-1>=size) {
         hasError=true;
@@ -915,7 +1113,6 @@ namespace osmscout {
 
       return;
     }
-#endif
 
     unsigned char buffer[4];
 
@@ -956,7 +1153,6 @@ namespace osmscout {
 
     number=0;
 
-#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
     if (buffer!=NULL) {
       if (offset+8-1>=size) {
         hasError=true;
@@ -1009,7 +1205,6 @@ namespace osmscout {
 
       return;
     }
-#endif
 
     unsigned char buffer[8];
 
@@ -1071,7 +1266,6 @@ namespace osmscout {
 
     number=0;
 
-#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
     if (buffer!=NULL) {
       if (offset+bytes-1>=size) {
         hasError=true;
@@ -1096,7 +1290,6 @@ namespace osmscout {
 
       return;
     }
-#endif
 
     unsigned char buffer[2];
 
@@ -1130,7 +1323,6 @@ namespace osmscout {
 
     number=0;
 
-#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
     if (buffer!=NULL) {
       if (offset+bytes-1>=size) {
         hasError=true;
@@ -1169,7 +1361,6 @@ namespace osmscout {
 
       return;
     }
-#endif
 
     unsigned char buffer[4];
 
@@ -1217,7 +1408,6 @@ namespace osmscout {
 
     number=0;
 
-#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
     if (buffer!=NULL) {
       if (offset+bytes-1>=size) {
         hasError=true;
@@ -1284,7 +1474,6 @@ namespace osmscout {
 
       return;
     }
-#endif
 
     unsigned char buffer[8];
 
@@ -1370,7 +1559,6 @@ namespace osmscout {
 
     fileOffset=0;
 
-#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
     if (buffer!=NULL) {
       if (offset+8-1>=size) {
         hasError=true;
@@ -1423,7 +1611,6 @@ namespace osmscout {
 
       return;
     }
-#endif
 
     unsigned char buffer[8];
 
@@ -1487,7 +1674,6 @@ namespace osmscout {
 
     fileOffset=0;
 
-#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
     if (buffer!=NULL) {
       if (offset+bytes-1>=size) {
         hasError=true;
@@ -1554,7 +1740,6 @@ namespace osmscout {
 
       return;
     }
-#endif
 
     unsigned char buffer[8];
 
@@ -1629,7 +1814,6 @@ namespace osmscout {
 
     number=0;
 
-#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
     if (buffer!=NULL) {
       if (offset>=size) {
         hasError=true;
@@ -1642,7 +1826,6 @@ namespace osmscout {
 
       return;
     }
-#endif
 
     char buffer;
 
@@ -1709,7 +1892,6 @@ namespace osmscout {
 
     number=0;
 
-#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
     if (buffer!=NULL) {
       if (offset>=size) {
         hasError=true;
@@ -1722,7 +1904,6 @@ namespace osmscout {
 
       return;
     }
-#endif
 
     char buffer;
 
@@ -1790,7 +1971,6 @@ namespace osmscout {
 
     number=0;
 
-#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
     if (buffer!=NULL) {
       if (offset>=size) {
         hasError=true;
@@ -1803,7 +1983,6 @@ namespace osmscout {
 
       return;
     }
-#endif
 
     char buffer;
 
@@ -1870,7 +2049,6 @@ namespace osmscout {
 
     number=0;
 
-#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
     if (buffer!=NULL) {
       unsigned int shift=0;
 
@@ -1888,7 +2066,6 @@ namespace osmscout {
       hasError=true;
       throw IOException(filename,"Cannot read uint16_t number","Cannot read beyond end of file");
     }
-#endif
 
     char buffer;
 
@@ -1923,7 +2100,6 @@ namespace osmscout {
 
     number=0;
 
-#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
     if (buffer!=NULL) {
       unsigned int shift=0;
 
@@ -1941,7 +2117,6 @@ namespace osmscout {
       hasError=true;
       throw IOException(filename,"Cannot read uint32_t number","Cannot read beyond end of file");
     }
-#endif
 
     char buffer;
 
@@ -1976,7 +2151,6 @@ namespace osmscout {
 
     number=0;
 
-#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
     if (buffer!=NULL) {
       unsigned int shift=0;
 
@@ -1994,7 +2168,6 @@ namespace osmscout {
       hasError=true;
       throw IOException(filename,"Cannot read uint64_t number","Cannot read beyond end of file");
     }
-#endif
 
     char buffer;
 
@@ -2030,7 +2203,6 @@ namespace osmscout {
     uint32_t latDat;
     uint32_t lonDat;
 
-#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
     if (buffer!=NULL) {
       if (offset+coordByteSize-1>=size) {
         hasError=true;
@@ -2057,7 +2229,6 @@ namespace osmscout {
 
       return;
     }
-#endif
 
     unsigned char buffer[coordByteSize];
 
@@ -2091,7 +2262,6 @@ namespace osmscout {
     uint32_t latDat;
     uint32_t lonDat;
 
-#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
     if (buffer!=NULL) {
       if (offset+coordByteSize-1>=size) {
         hasError=true;
@@ -2125,7 +2295,6 @@ namespace osmscout {
 
       return;
     }
-#endif
 
     unsigned char buffer[coordByteSize];
 
@@ -2156,6 +2325,301 @@ namespace osmscout {
     }
   }
 
+  /**
+   * Scalar decoder for delta encoded coordinates. Decodes count coordinates
+   * of coordBitSize/8 bytes each (lat and lon delta), starting at the given
+   * fixed-point values. The fixed-point values of the last decoded coordinate
+   * are returned in latValue and lonValue.
+   */
+  static void DecodeDeltasScalar(const uint8_t* buffer,
+                                 size_t coordBitSize,
+                                 size_t count,
+                                 uint32_t& latValue,
+                                 uint32_t& lonValue,
+                                 Point* nodes)
+  {
+    if (coordBitSize==16) {
+      for (size_t i=0; i<count; i++) {
+        int32_t latDelta=(int8_t)buffer[0];
+        int32_t lonDelta=(int8_t)buffer[1];
+
+        latValue+=latDelta;
+        lonValue+=lonDelta;
+
+        nodes[i].SetCoord(GeoCoord(latValue/latConversionFactor-90.0,
+                                   lonValue/lonConversionFactor-180.0));
+
+        buffer+=2;
+      }
+    }
+    else if (coordBitSize==32) {
+      for (size_t i=0; i<count; i++) {
+        uint32_t latUDelta=buffer[0] | (buffer[1]<<8);
+        uint32_t lonUDelta=buffer[2] | (buffer[3]<<8);
+        int32_t  latDelta;
+        int32_t  lonDelta;
+
+        if (latUDelta & 0x8000) {
+          latDelta=(int32_t)(latUDelta | 0xffff0000);
+        }
+        else {
+          latDelta=(int32_t)latUDelta;
+        }
+
+        latValue+=latDelta;
+
+        if (lonUDelta & 0x8000) {
+          lonDelta=(int32_t)(lonUDelta | 0xffff0000);
+        }
+        else {
+          lonDelta=(int32_t)lonUDelta;
+        }
+
+        lonValue+=lonDelta;
+
+        nodes[i].SetCoord(GeoCoord(latValue/latConversionFactor-90.0,
+                                   lonValue/lonConversionFactor-180.0));
+
+        buffer+=4;
+      }
+    }
+    else {
+      for (size_t i=0; i<count; i++) {
+        uint32_t latUDelta=(buffer[0]) | (buffer[1]<<8) | (buffer[2]<<16);
+        uint32_t lonUDelta=(buffer[3]) | (buffer[4]<<8) | (buffer[5]<<16);
+        int32_t  latDelta;
+        int32_t  lonDelta;
+
+        if (latUDelta & 0x800000) {
+          latDelta=(int32_t)(latUDelta | 0xff000000);
+        }
+        else {
+          latDelta=(int32_t)latUDelta;
+        }
+
+        latValue+=latDelta;
+
+        if (lonUDelta & 0x800000) {
+          lonDelta=(int32_t)(lonUDelta | 0xff000000);
+        }
+        else {
+          lonDelta=(int32_t)lonUDelta;
+        }
+
+        lonValue+=lonDelta;
+
+        nodes[i].SetCoord(GeoCoord(latValue/latConversionFactor-90.0,
+                                   lonValue/lonConversionFactor-180.0));
+
+        buffer+=6;
+      }
+    }
+  }
+
+#ifdef OSMSCOUT_SIMD_DELTA_DECODER
+
+  /**
+   * SSE4.1 decoder, decodes two coordinates at once: The lat/lon deltas are
+   * sign extended to 32 bit, summed up (prefix sum) and converted to doubles.
+   * Since all steps are exact or IEEE conform, the result is identical to the
+   * scalar decoder.
+   *
+   * Returns the number of decoded coordinates, the remaining coordinates must
+   * be decoded by the scalar decoder.
+   */
+  __attribute__((target("sse4.1")))
+  static size_t DecodeDeltasSSE4(const uint8_t* buffer,
+                                 size_t coordBitSize,
+                                 size_t count,
+                                 uint32_t& latValue,
+                                 uint32_t& lonValue,
+                                 Point* nodes)
+  {
+    const size_t  coordBytes=coordBitSize/8;
+    const size_t  bufferSize=count*coordBytes;
+    const __m128d factor=_mm_set_pd(lonConversionFactor,latConversionFactor);
+    const __m128d offset=_mm_set_pd(180.0,90.0);
+    // Move 3 byte values into the upper bytes of 32 bit values, so an arithmetic shift sign extends them
+    const __m128i shuffle24=_mm_setr_epi8(-1,0,1,2,-1,3,4,5,-1,6,7,8,-1,9,10,11);
+
+    __m128i value=_mm_setr_epi32((int32_t)latValue,(int32_t)lonValue,
+                                 (int32_t)latValue,(int32_t)lonValue);
+    double  coords[4];
+    size_t  i=0;
+
+    for (; i+2<=count; i+=2) {
+      const uint8_t* pos=buffer+i*coordBytes;
+      __m128i        delta;
+
+      if (coordBitSize==16) {
+        int32_t bytes;
+
+        memcpy(&bytes,pos,sizeof(bytes));
+        delta=_mm_cvtepi8_epi32(_mm_cvtsi32_si128(bytes));
+      }
+      else if (coordBitSize==32) {
+        delta=_mm_cvtepi16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pos)));
+      }
+      else {
+        // We load 16 bytes, but only use 12
+        if (i*coordBytes+16>bufferSize) {
+          break;
+        }
+
+        delta=_mm_srai_epi32(_mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos)),
+                                              shuffle24),
+                             8);
+      }
+
+      // Prefix sum: [d0,d0+d1]
+      delta=_mm_add_epi32(delta,_mm_slli_si128(delta,8));
+      value=_mm_add_epi32(value,delta);
+
+      _mm_storeu_pd(&coords[0],_mm_sub_pd(_mm_div_pd(_mm_cvtepi32_pd(value),factor),offset));
+      _mm_storeu_pd(&coords[2],_mm_sub_pd(_mm_div_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(value,value)),factor),offset));
+
+      nodes[i].SetCoord(GeoCoord(coords[0],coords[1]));
+      nodes[i+1].SetCoord(GeoCoord(coords[2],coords[3]));
+
+      // Broadcast the last coordinate as start for the next step
+      value=_mm_shuffle_epi32(value,_MM_SHUFFLE(3,2,3,2));
+    }
+
+    latValue=(uint32_t)_mm_cvtsi128_si32(value);
+    lonValue=(uint32_t)_mm_extract_epi32(value,1);
+
+    return i;
+  }
+
+  /**
+   * AVX2 decoder, like the SSE4.1 decoder but decodes four coordinates at once.
+   */
+  __attribute__((target("avx2")))
+  static size_t DecodeDeltasAVX2(const uint8_t* buffer,
+                                 size_t coordBitSize,
+                                 size_t count,
+                                 uint32_t& latValue,
+                                 uint32_t& lonValue,
+                                 Point* nodes)
+  {
+    const size_t  coordBytes=coordBitSize/8;
+    const size_t  bufferSize=count*coordBytes;
+    const __m256d factor=_mm256_set_pd(lonConversionFactor,latConversionFactor,
+                                       lonConversionFactor,latConversionFactor);
+    const __m256d offset=_mm256_set_pd(180.0,90.0,
+                                       180.0,90.0);
+    const __m256i shuffle24=_mm256_setr_epi8(-1,0,1,2,-1,3,4,5,-1,6,7,8,-1,9,10,11,
+                                             -1,0,1,2,-1,3,4,5,-1,6,7,8,-1,9,10,11);
+
+    __m256i value=_mm256_setr_epi32((int32_t)latValue,(int32_t)lonValue,
+                                    (int32_t)latValue,(int32_t)lonValue,
+                                    (int32_t)latValue,(int32_t)lonValue,
+                                    (int32_t)latValue,(int32_t)lonValue);
+    double  coords[8];
+    size_t  i=0;
+
+    for (; i+4<=count; i+=4) {
+      const uint8_t* pos=buffer+i*coordBytes;
+      __m256i        delta;
+
+      if (coordBitSize==16) {
+        delta=_mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pos)));
+      }
+      else if (coordBitSize==32) {
+        delta=_mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos)));
+      }
+      else {
+        // We load 12+16 bytes, but only use 24
+        if (i*coordBytes+28>bufferSize) {
+          break;
+        }
+
+        __m128i low=_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        __m128i high=_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos+12));
+
+        delta=_mm256_srai_epi32(_mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(low),high,1),
+                                                    shuffle24),
+                                8);
+      }
+
+      // Prefix sum within the 128 bit lanes: [d0,d0+d1|d2,d2+d3]
+      delta=_mm256_add_epi32(delta,_mm256_slli_si256(delta,8));
+      // Add the sum of the lower lane to the upper lane
+      delta=_mm256_add_epi32(delta,
+                             _mm256_blend_epi32(_mm256_setzero_si256(),
+                                                _mm256_permute4x64_epi64(delta,_MM_SHUFFLE(1,1,1,1)),
+                                                0xf0));
+      value=_mm256_add_epi32(value,delta);
+
+      _mm256_storeu_pd(&coords[0],_mm256_sub_pd(_mm256_div_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(value)),factor),offset));
+      _mm256_storeu_pd(&coords[4],_mm256_sub_pd(_mm256_div_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(value,1)),factor),offset));
+
+      nodes[i].SetCoord(GeoCoord(coords[0],coords[1]));
+      nodes[i+1].SetCoord(GeoCoord(coords[2],coords[3]));
+      nodes[i+2].SetCoord(GeoCoord(coords[4],coords[5]));
+      nodes[i+3].SetCoord(GeoCoord(coords[6],coords[7]));
+
+      // Broadcast the last coordinate as start for the next step
+      value=_mm256_permute4x64_epi64(value,_MM_SHUFFLE(3,3,3,3));
+    }
+
+    __m128i last=_mm256_castsi256_si128(value);
+
+    latValue=(uint32_t)_mm_cvtsi128_si32(last);
+    lonValue=(uint32_t)_mm_extract_epi32(last,1);
+
+    return i;
+  }
+
+  static bool HasSSE4Support()
+  {
+    static const bool hasSSE4=__builtin_cpu_supports("sse4.1")!=0;
+
+    return hasSSE4;
+  }
+
+  static bool HasAVX2Support()
+  {
+    static const bool hasAVX2=__builtin_cpu_supports("avx2")!=0;
+
+    return hasAVX2;
+  }
+
+#endif
+
+  bool FileScanner::IsDeltaDecoderSupported(DeltaDecoder decoder)
+  {
+    switch (decoder) {
+    case decoderAuto:
+    case decoderScalar:
+      return true;
+    case decoderSSE4:
+#ifdef OSMSCOUT_SIMD_DELTA_DECODER
+      return HasSSE4Support();
+#else
+      return false;
+#endif
+    case decoderAVX2:
+#ifdef OSMSCOUT_SIMD_DELTA_DECODER
+      return HasAVX2Support();
+#else
+      return false;
+#endif
+    }
+
+    return false;
+  }
+
+  /**
+   * Set the decoder to use for delta encoded coordinates in
+   * Read(std::vector<Point>&,bool). If the given decoder is not
+   * supported on the current platform, the scalar decoder is used.
+   */
+  void FileScanner::SetDeltaDecoder(DeltaDecoder decoder)
+  {
+    deltaDecoder=decoder;
+  }
+
   void FileScanner::Read(std::vector<Point>& nodes,bool readIds)
   {
     size_t  coordBitSize;
@@ -2243,87 +2707,37 @@ namespace osmscout {
 
     Read((char*)byteBuffer,byteBufferSize);
 
-    if (coordBitSize==16) {
-      size_t currentCoordPos=1;
-
-      for (size_t i=0; i<byteBufferSize; i+=2) {
-        int32_t latDelta=(int8_t)byteBuffer[i];
-        int32_t lonDelta=(int8_t)byteBuffer[i+1];
-
-        latValue+=latDelta;
-        lonValue+=lonDelta;
-
-        nodes[currentCoordPos].SetCoord(GeoCoord(latValue/latConversionFactor-90.0,
-                                                 lonValue/lonConversionFactor-180.0));
-
-        currentCoordPos++;
-      }
+    size_t deltaCount=nodeCount-1;
+    size_t decoded=0;
+
+#ifdef OSMSCOUT_SIMD_DELTA_DECODER
+    if ((deltaDecoder==decoderAuto || deltaDecoder==decoderAVX2) &&
+        HasAVX2Support()) {
+      decoded=DecodeDeltasAVX2(byteBuffer,
+                               coordBitSize,
+                               deltaCount,
+                               latValue,
+                               lonValue,
+                               nodes.data()+1);
+    }
+    else if ((deltaDecoder==decoderAuto || deltaDecoder==decoderSSE4) &&
+             HasSSE4Support()) {
+      decoded=DecodeDeltasSSE4(byteBuffer,
+                               coordBitSize,
+                               deltaCount,
+                               latValue,
+                               lonValue,
+                               nodes.data()+1);
     }
-    else if (coordBitSize==32) {
-      size_t currentCoordPos=1;
-
-      for (size_t i=0; i<byteBufferSize; i+=4) {
-        uint32_t latUDelta=byteBuffer[i+0] | (byteBuffer[i+1]<<8);
-        uint32_t lonUDelta=byteBuffer[i+2] | (byteBuffer[i+3]<<8);
-        int32_t  latDelta;
-        int32_t  lonDelta;
-
-        if (latUDelta & 0x8000) {
-          latDelta=(int32_t)(latUDelta | 0xffff0000);
-        }
-        else {
-          latDelta=(int32_t)latUDelta;
-        }
-
-        latValue+=latDelta;
-
-        if (lonUDelta & 0x8000) {
-          lonDelta=(int32_t)(lonUDelta | 0xffff0000);
-        }
-        else {
-          lonDelta=(int32_t)lonUDelta;
-        }
-
-        lonValue+=lonDelta;
-
-        nodes[currentCoordPos].SetCoord(GeoCoord(latValue/latConversionFactor-90.0,
-                                                 lonValue/lonConversionFactor-180.0));
-        currentCoordPos++;
-      }
-    }
-    else {
-      size_t currentCoordPos=1;
-
-      for (size_t i=0; i<byteBufferSize; i+=6) {
-        uint32_t latUDelta=(byteBuffer[i+0]) | (byteBuffer[i+1]<<8) | (byteBuffer[i+2]<<16);
-        uint32_t lonUDelta=(byteBuffer[i+3]) | (byteBuffer[i+4]<<8) | (byteBuffer[i+5]<<16);
-        int32_t  latDelta;
-        int32_t  lonDelta;
-
-        if (latUDelta & 0x800000) {
-          latDelta=(int32_t)(latUDelta | 0xff000000);
-        }
-        else {
-          latDelta=(int32_t)latUDelta;
-        }
-
-        latValue+=latDelta;
-
-        if (lonUDelta & 0x800000) {
-          lonDelta=(int32_t)(lonUDelta | 0xff000000);
-        }
-        else {
-          lonDelta=(int32_t)lonUDelta;
-        }
-
-        lonValue+=lonDelta;
+#endif
 
-        nodes[currentCoordPos].SetCoord(GeoCoord(latValue/latConversionFactor-90.0,
-                                                 lonValue/lonConversionFactor-180.0));
-
-        currentCoordPos++;
-      }
-    }
+    // Decode all (remaining) coordinates
+    DecodeDeltasScalar(byteBuffer+decoded*coordBitSize/8,
+                       coordBitSize,
+                       deltaCount-decoded,
+                       latValue,
+                       lonValue,
+                       nodes.data()+1+decoded);
 
     if (hasNodes) {
       size_t idCurrent=0;
@@ -2375,6 +2789,26 @@ namespace osmscout {
             maxCoord);
   }
 
+  /**
+   * Read a box as written by FileWriter::WriteCompactBox().
+   *
+   * @throws IOException
+   */
+  void FileScanner::ReadCompactBox(GeoBox& box)
+  {
+    GeoCoord minCoord;
+    uint32_t latExtent;
+    uint32_t lonExtent;
+
+    ReadCoord(minCoord);
+    ReadNumber(latExtent);
+    ReadNumber(lonExtent);
+
+    box.Set(minCoord,
+            GeoCoord(minCoord.GetLat()+latExtent/latConversionFactor,
+                     minCoord.GetLon()+lonExtent/lonConversionFactor));
+  }
+
   void FileScanner::ReadTypeId(TypeId& id,
                                uint8_t maxBytes)
   {
@@ -39,7 +39,9 @@ namespace osmscout {
 
   FileWriter::FileWriter()
    : file(NULL),
-     hasError(true)
+     hasError(true),
+     memoryBuffer(false),
+     memoryPos(0)
   {
     // no code
   }
@@ -58,7 +60,7 @@ namespace osmscout {
    */
   void FileWriter::Open(const std::string& filename)
   {
-    if (file!=NULL) {
+    if (IsOpen()) {
       throw IOException(filename,"Error opening file for writing","File already opened");
     }
 
@@ -74,12 +76,41 @@ namespace osmscout {
     hasError=false;
   }
 
+  /**
+   * Open the writer for writing to a buffer in memory instead of to a file.
+   * This allows writing data, whose size must be known before the data itself
+   * (as for example required by Way::Write()), without seeking in the file.
+   *
+   * The data written can be accessed by calling GetMemory() until the writer is
+   * closed.
+   *
+   * @throws IOException
+   */
+  void FileWriter::OpenMemory()
+  {
+    if (IsOpen()) {
+      throw IOException(filename,"Error opening memory for writing","File already opened");
+    }
+
+    filename.clear();
+    memory.clear();
+    memoryPos=0;
+    memoryBuffer=true;
+    hasError=false;
+  }
+
   /**
    *
    * @throws IOException
    */
   void FileWriter::Close()
   {
+    if (memoryBuffer) {
+      memoryBuffer=false;
+      memory.clear();
+      return;
+    }
+
     if (file==NULL) {
       throw IOException(filename,"Cannot close file","File already closed");
     }
@@ -94,6 +125,12 @@ namespace osmscout {
 
   void FileWriter::CloseFailsafe()
   {
+    if (memoryBuffer) {
+      memoryBuffer=false;
+      memory.clear();
+      return;
+    }
+
     if (file==NULL) {
       return;
     }
@@ -119,6 +156,10 @@ namespace osmscout {
       throw IOException(filename,"Cannot read position in file","File already in error state");
     }
 
+    if (memoryBuffer) {
+      return (FileOffset)memoryPos;
+    }
+
 #if defined(HAVE_FSEEKO)
     off_t filepos=ftello(file);
 
@@ -151,6 +192,18 @@ namespace osmscout {
       throw IOException(filename,"Cannot read position in file","File already in error state");
     }
 
+    if (memoryBuffer) {
+      hasError=pos>memory.size();
+
+      if (hasError) {
+        throw IOException(filename,"Cannot set position in memory");
+      }
+
+      memoryPos=(size_t)pos;
+
+      return;
+    }
+
 #if defined(HAVE_FSEEKO)
     hasError=fseeko(file,(off_t)pos,SEEK_SET)!=0;
 #else
@@ -172,6 +225,28 @@ namespace osmscout {
     return SetPos(0);
   }
 
+  /**
+   * Write the given bytes at the current position, either to the file or to
+   * the memory buffer
+   */
+  bool FileWriter::WriteData(const void* data,
+                             size_t bytes)
+  {
+    if (memoryBuffer) {
+      const char* bytesData=(const char*)data;
+      size_t      overwrite=std::min(bytes,memory.size()-memoryPos);
+
+      std::copy(bytesData,bytesData+overwrite,memory.begin()+memoryPos);
+      memory.insert(memory.end(),bytesData+overwrite,bytesData+bytes);
+
+      memoryPos+=bytes;
+
+      return true;
+    }
+
+    return fwrite(data,1,bytes,file)==bytes;
+  }
+
   /**
    *
    * @throws IOException
@@ -182,7 +257,7 @@ namespace osmscout {
       throw IOException(filename,"Cannot write char*","File already in error state");
     }
 
-    hasError=fwrite(buffer,sizeof(char),bytes,file)!=bytes;
+    hasError=!WriteData(buffer,bytes);
 
     if (hasError) {
       throw IOException(filename,"Cannot write char*");
@@ -201,7 +276,7 @@ namespace osmscout {
 
     size_t length=value.length()+1;
 
-    hasError=fwrite(value.c_str(),sizeof(char),length,file)!=length;
+    hasError=!WriteData(value.c_str(),length);
 
     if (hasError) {
       throw IOException(filename,"Cannot write std::string");
@@ -220,7 +295,7 @@ namespace osmscout {
 
     char value=boolean ? 1 : 0;
 
-    hasError=fwrite((const char*)&value,sizeof(char),1,file)!=1;
+    hasError=!WriteData((const char*)&value,1);
 
     if (hasError) {
       throw IOException(filename,"Cannot write bool");
@@ -237,7 +312,7 @@ namespace osmscout {
       throw IOException(filename,"Cannot write int8_t","File already in error state");
     }
 
-    hasError=fwrite(&number,sizeof(char),sizeof(int8_t),file)!=sizeof(int8_t);
+    hasError=!WriteData(&number,sizeof(int8_t));
 
     if (hasError) {
       throw IOException(filename,"Cannot write int8_t");
@@ -259,7 +334,7 @@ namespace osmscout {
     buffer[0]=((number >> 0) & 0xff);
     buffer[1]=((number >> 8) & 0xff);
 
-    hasError=fwrite(buffer,1,2,file)!=2;
+    hasError=!WriteData(buffer,2);
 
     if (hasError) {
       throw IOException(filename,"Cannot write int16_t");
@@ -283,7 +358,7 @@ namespace osmscout {
     buffer[2]=((number >> 16) & 0xff);
     buffer[3]=((number >> 24) & 0xff);
 
-    hasError=fwrite(buffer,1,4,file)!=4;
+    hasError=!WriteData(buffer,4);
 
     if (hasError) {
       throw IOException(filename,"Cannot write int32_t");
@@ -311,7 +386,7 @@ namespace osmscout {
     buffer[6]=((number >> 48) & 0xff);
     buffer[7]=((number >> 56) & 0xff);
 
-    hasError=fwrite(buffer,1,8,file)!=8;
+    hasError=!WriteData(buffer,8);
 
     if (hasError) {
       throw IOException(filename,"Cannot write int64_t");
@@ -328,7 +403,7 @@ namespace osmscout {
       throw IOException(filename,"Cannot write uint8_t","File already in error state");
     }
 
-    hasError=fwrite(&number,1,1,file)!=1;
+    hasError=!WriteData(&number,1);
 
     if (hasError) {
       throw IOException(filename,"Cannot write uint8_t");
@@ -350,7 +425,7 @@ namespace osmscout {
     buffer[0]=((number >> 0) & 0xff);
     buffer[1]=((number >> 8) & 0xff);
 
-    hasError=fwrite(buffer,1,2,file)!=2;
+    hasError=!WriteData(buffer,2);
 
     if (hasError) {
       throw IOException(filename,"Cannot write uint16_t");
@@ -374,7 +449,7 @@ namespace osmscout {
     buffer[2]=((number >> 16) & 0xff);
     buffer[3]=((number >> 24) & 0xff);
 
-    hasError=fwrite(buffer,1,4,file)!=4;
+    hasError=!WriteData(buffer,4);
 
     if (hasError) {
       throw IOException(filename,"Cannot write uint32_t");
@@ -402,7 +477,7 @@ namespace osmscout {
     buffer[6]=((number >> 48) & 0xff);
     buffer[7]=((number >> 56) & 0xff);
 
-    hasError=fwrite(buffer,1,8,file)!=8;
+    hasError=!WriteData(buffer,8);
 
     if (hasError) {
       throw IOException(filename,"Cannot write uint64_t");
@@ -424,7 +499,7 @@ namespace osmscout {
     buffer[0]=((number >> 0) & 0xff);
     buffer[1]=((number >> 8) & 0xff);
 
-    hasError=fwrite(buffer,1,bytes,file)!=bytes;
+    hasError=!WriteData(buffer,bytes);
 
     if (hasError) {
       throw IOException(filename,"Cannot write size restricted uint16_t");
@@ -448,7 +523,7 @@ namespace osmscout {
     buffer[2]=((number >> 16) & 0xff);
     buffer[3]=((number >> 24) & 0xff);
 
-    hasError=fwrite(buffer,1,bytes,file)!=bytes;
+    hasError=!WriteData(buffer,bytes);
 
     if (hasError) {
       throw IOException(filename,"Cannot write size restricted uint32_t");
@@ -476,7 +551,7 @@ namespace osmscout {
     buffer[6]=((number >> 48) & 0xff);
     buffer[7]=((number >> 56) & 0xff);
 
-    hasError=fwrite(buffer,1,bytes,file)!=bytes;
+    hasError=!WriteData(buffer,bytes);
 
     if (hasError) {
       throw IOException(filename,"Cannot write size restricted uint64_t");
@@ -514,7 +589,7 @@ namespace osmscout {
     buffer[6]=((fileOffset >> 48) & 0xff);
     buffer[7]=((fileOffset >> 56) & 0xff);
 
-    hasError=fwrite(buffer,1,8,file)!=8;
+    hasError=!WriteData(buffer,8);
 
     if (hasError) {
       throw IOException(filename,"Cannot write FileOffset");
@@ -545,7 +620,7 @@ namespace osmscout {
     buffer[6]=((fileOffset >> 48) & 0xff);
     buffer[7]=((fileOffset >> 56) & 0xff);
 
-    hasError=fwrite(buffer,1,bytes,file)!=bytes;
+    hasError=!WriteData(buffer,bytes);
 
     if (HasError()) {
       throw IOException(filename,"Cannot write size limited FileOffset");
@@ -570,7 +645,7 @@ namespace osmscout {
 
     bytes=EncodeNumber(number,buffer);
 
-    hasError=fwrite(buffer,sizeof(unsigned char),bytes,file)!=bytes;
+    hasError=!WriteData(buffer,bytes);
 
     if (hasError) {
       throw IOException(filename,"Cannot write int16_t number");
@@ -595,7 +670,7 @@ namespace osmscout {
 
     bytes=EncodeNumber(number,buffer);
 
-    hasError=fwrite(buffer,sizeof(unsigned char),bytes,file)!=bytes;
+    hasError=!WriteData(buffer,bytes);
 
     if (hasError) {
       throw IOException(filename,"Cannot write int32_t number");
@@ -620,7 +695,7 @@ namespace osmscout {
 
     bytes=EncodeNumber(number,buffer);
 
-    hasError=fwrite(buffer,sizeof(unsigned char),bytes,file)!=bytes;
+    hasError=!WriteData(buffer,bytes);
 
     if (hasError) {
       throw IOException(filename,"Cannot write int64_t number");
@@ -645,7 +720,7 @@ namespace osmscout {
 
     bytes=EncodeNumber(number,buffer);
 
-    hasError=fwrite(buffer,sizeof(unsigned char),bytes,file)!=bytes;
+    hasError=!WriteData(buffer,bytes);
 
     if (hasError) {
       throw IOException(filename,"Cannot write uint16_t number");
@@ -670,7 +745,7 @@ namespace osmscout {
 
     bytes=EncodeNumber(number,buffer);
 
-    hasError=fwrite(buffer,sizeof(unsigned char),bytes,file)!=bytes;
+    hasError=!WriteData(buffer,bytes);
 
     if (hasError) {
       throw IOException(filename,"Cannot write uint32_t number");
@@ -695,7 +770,7 @@ namespace osmscout {
 
     bytes=EncodeNumber(number,buffer);
 
-    hasError=fwrite(buffer,sizeof(unsigned char),bytes,file)!=bytes;
+    hasError=!WriteData(buffer,bytes);
 
     if (hasError) {
       throw IOException(filename,"Cannot write uint64_t number");
@@ -727,7 +802,7 @@ namespace osmscout {
 
     buffer[6]=((latValue >> 24) & 0x07) | ((lonValue >> 20) & 0x70);
 
-    hasError=fwrite(buffer,1,coordByteSize,file)!=coordByteSize;
+    hasError=!WriteData(buffer,coordByteSize);
 
     if (hasError) {
       throw IOException(filename,"Cannot write coordinate");
@@ -756,13 +831,34 @@ namespace osmscout {
 
     buffer[6]=0xff;
 
-    hasError=fwrite(buffer,1,coordByteSize,file)!=coordByteSize;
+    hasError=!WriteData(buffer,coordByteSize);
 
     if (hasError) {
       throw IOException(filename,"Cannot write coordinate");
     }
   }
 
+  /**
+   * Write the given box as its minimum coordinate followed by the extent of
+   * the box in latitude and longitude, both as variable length encoded
+   * fixed-point values. For small boxes (which is the typical case for the
+   * bounding box of a way or area) this is about half the size of writing
+   * both coordinates.
+   *
+   * @throws IOException
+   */
+  void FileWriter::WriteCompactBox(const GeoBox& box)
+  {
+    uint32_t minLatValue=(uint32_t)round((box.GetMinLat()+90.0)*latConversionFactor);
+    uint32_t minLonValue=(uint32_t)round((box.GetMinLon()+180.0)*lonConversionFactor);
+    uint32_t maxLatValue=(uint32_t)round((box.GetMaxLat()+90.0)*latConversionFactor);
+    uint32_t maxLonValue=(uint32_t)round((box.GetMaxLon()+180.0)*lonConversionFactor);
+
+    WriteCoord(box.GetMinCoord());
+    WriteNumber(maxLatValue-minLatValue);
+    WriteNumber(maxLonValue-minLonValue);
+  }
+
   void FileWriter::Write(const std::vector<Point>& nodes, bool writeIds)
   {
     // Quick exit for empty vector arrays
@@ -1058,6 +1154,10 @@ namespace osmscout {
       throw IOException(filename,"Cannot flush file","File already in error state");
     }
 
+    if (memoryBuffer) {
+      return;
+    }
+
     hasError=fflush(file)!=0;
 
     if (hasError) {
@@ -1090,7 +1190,7 @@ namespace osmscout {
 
     memset(buffer,0,bytesToWrite);
 
-    hasError=fwrite(buffer,sizeof(char),bytesToWrite,file)!=bytesToWrite;
+    hasError=!WriteData(buffer,bytesToWrite);
 
     delete [] buffer;
 
@@ -110,11 +110,10 @@ namespace osmscout {
     double dLat=(bLat-aLat)*M_PI/180;
     double dLon=(bLon-aLon)*M_PI/180;
 
-    double sindLonDiv2;
-    double cosdLonDiv2;
-    sincos(dLon/2, sindLonDiv2, cosdLonDiv2);
+    double sindLatDiv2=sin(dLat/2);
+    double sindLonDiv2=sin(dLon/2);
 
-    double a = sin(dLat/2)*sin(dLat/2)+cosdLonDiv2*cosdLonDiv2*sindLonDiv2*sindLonDiv2;
+    double a = sindLatDiv2*sindLatDiv2+cos(aLat*M_PI/180)*cos(bLat*M_PI/180)*sindLonDiv2*sindLonDiv2;
 
     double c = 2*atan2(sqrt(a),sqrt(1-a));
 
@@ -132,17 +131,49 @@ namespace osmscout {
     double dLat=(b.GetLat()-a.GetLat())*M_PI/180;
     double dLon=(b.GetLon()-a.GetLon())*M_PI/180;
 
-    double sindLonDiv2;
-    double cosdLonDiv2;
-    sincos(dLon/2, sindLonDiv2, cosdLonDiv2);
+    double sindLatDiv2=sin(dLat/2);
+    double sindLonDiv2=sin(dLon/2);
 
-    double aa = sin(dLat/2)*sin(dLat/2)+cosdLonDiv2*cosdLonDiv2*sindLonDiv2*sindLonDiv2;
+    double aa = sindLatDiv2*sindLatDiv2+cos(a.GetLat()*M_PI/180)*cos(b.GetLat()*M_PI/180)*sindLonDiv2*sindLonDiv2;
 
     double c = 2*atan2(sqrt(aa),sqrt(1-aa));
 
     return r*c;
   }
 
+  /**
+   * Calculates the point on the line segment a-b that is nearest to p and returns
+   * the spherical distance between p and this point in km.
+   *
+   * The point is projected in an equirectangular frame centered at p, with
+   * longitudes scaled by the cosine of the latitude of p. For the short segments
+   * of ways and routes this frame is locally metric, so the projected point is
+   * the nearest one on the sphere, too.
+   */
+  double GetSphericalDistanceToLineSegment(const GeoCoord& p,
+                                           const GeoCoord& a,
+                                           const GeoCoord& b,
+                                           GeoCoord& nearest)
+  {
+    double lonScale=cos(p.GetLat()*M_PI/180);
+    double ax=(a.GetLon()-p.GetLon())*lonScale;
+    double ay=a.GetLat()-p.GetLat();
+    double dx=(b.GetLon()-a.GetLon())*lonScale;
+    double dy=b.GetLat()-a.GetLat();
+    double length=dx*dx+dy*dy;
+    double fraction=0.0;
+
+    if (length>0.0) {
+      fraction=std::max(0.0,std::min(1.0,-(ax*dx+ay*dy)/length));
+    }
+
+    nearest.Set(a.GetLat()+fraction*dy,
+                a.GetLon()+fraction*(b.GetLon()-a.GetLon()));
+
+    return GetSphericalDistance(p,
+                                nearest);
+  }
+
   /**
     Calculating Vincenty's inverse for getting the ellipsoidal distance
     of two points on earth.
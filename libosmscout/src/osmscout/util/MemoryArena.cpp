@@ -0,0 +1,88 @@
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2016  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <osmscout/util/MemoryArena.h>
+
+#include <cstdint>
+
+#include <osmscout/system/Assert.h>
+
+namespace osmscout {
+
+  const size_t MemoryArena::DEFAULT_CHUNK_SIZE=64*1024;
+
+  MemoryArena::MemoryArena(size_t chunkSize)
+  : chunkSize(chunkSize),
+    current(NULL),
+    available(0),
+    allocated(0)
+  {
+    // no code
+  }
+
+  MemoryArena::~MemoryArena()
+  {
+    for (auto chunk : chunks) {
+      ::operator delete(chunk);
+    }
+  }
+
+  /**
+   * Return a block of the given size with the given alignment (which must
+   * be a power of two and not larger than alignof(std::max_align_t)).
+   * Requests larger than a quarter of the chunk size get their own chunk,
+   * so that the free space in the current chunk is not wasted.
+   */
+  void* MemoryArena::Allocate(size_t size,
+                              size_t alignment)
+  {
+    assert(alignment>0 &&
+           (alignment & (alignment-1))==0 &&
+           alignment<=alignof(std::max_align_t));
+
+    size_t padding=(alignment-(reinterpret_cast<uintptr_t>(current) & (alignment-1))) & (alignment-1);
+
+    if (current==NULL ||
+        padding+size>available) {
+      if (size>chunkSize/4) {
+        // Memory returned by operator new is suitably aligned for any standard type
+        char* chunk=static_cast<char*>(::operator new(size));
+
+        chunks.push_back(chunk);
+        allocated+=size;
+
+        return chunk;
+      }
+
+      current=static_cast<char*>(::operator new(chunkSize));
+      available=chunkSize;
+      padding=0;
+
+      chunks.push_back(current);
+    }
+
+    void* result=current+padding;
+
+    current+=padding+size;
+    available-=padding+size;
+    allocated+=size;
+
+    return result;
+  }
+}
@@ -20,6 +20,7 @@
 #include <osmscout/util/Projection.h>
 
 #include <algorithm>
+#include <limits>
 
 #include <osmscout/system/Assert.h>
 #include <osmscout/system/Math.h>
@@ -30,6 +31,11 @@
 
 #include <osmscout/util/Tiling.h>
 
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define OSMSCOUT_MERCATOR_AVX2_KERNEL
+#include <immintrin.h>
+#endif
+
 #include <iostream>
 namespace osmscout {
 
@@ -79,6 +85,54 @@ namespace osmscout {
     // no code
   }
 
+  void Projection::BatchGeoToPixel(const Point* nodes,
+                                   size_t count,
+                                   double* x,
+                                   double* y,
+                                   size_t stride,
+                                   double& xMin, double& yMin,
+                                   double& xMax, double& yMax) const
+  {
+    if (count==0) {
+      return;
+    }
+
+    {
+      BatchTransformer batchTransformer(*this);
+      char*            xPos=reinterpret_cast<char*>(x);
+      char*            yPos=reinterpret_cast<char*>(y);
+
+      for (size_t i=0; i<count; i++) {
+        batchTransformer.GeoToPixel(nodes[i].GetLon(),
+                                    nodes[i].GetLat(),
+                                    *reinterpret_cast<double*>(xPos),
+                                    *reinterpret_cast<double*>(yPos));
+        xPos+=stride;
+        yPos+=stride;
+      }
+
+      // Destructor flushes pending coordinates
+    }
+
+    const char* xPos=reinterpret_cast<const char*>(x);
+    const char* yPos=reinterpret_cast<const char*>(y);
+
+    xMin=*reinterpret_cast<const double*>(xPos);
+    xMax=xMin;
+    yMin=*reinterpret_cast<const double*>(yPos);
+    yMax=yMin;
+
+    for (size_t i=1; i<count; i++) {
+      xPos+=stride;
+      yPos+=stride;
+
+      xMin=std::min(xMin,*reinterpret_cast<const double*>(xPos));
+      xMax=std::max(xMax,*reinterpret_cast<const double*>(xPos));
+      yMin=std::min(yMin,*reinterpret_cast<const double*>(yPos));
+      yMax=std::max(yMax,*reinterpret_cast<const double*>(yPos));
+    }
+  }
+
   MercatorProjectionOld::MercatorProjectionOld()
     : valid(false),
       latOffset(0.0),
@@ -304,7 +358,8 @@ namespace osmscout {
   : valid(false),
     latOffset(0.0),
     scale(1),
-    scaleGradtorad(0)
+    scaleGradtorad(0),
+    batchKernel(kernelAuto)
   {
     // no code
   }
@@ -494,6 +549,362 @@ namespace osmscout {
     assert(false); //should not be called
   }
 
+  /**
+   * Parameter of the MercatorProjection as required by the batch kernels.
+   */
+  struct MercatorKernelParameter
+  {
+    double lon;
+    double latOffset;
+    double scale;
+    double scaleGradtorad;
+    double angleNegSin;
+    double angleNegCos;
+    double halfWidth;
+    double halfHeight;
+    bool   rotate;
+  };
+
+  /**
+   * Scalar kernel, does exactly the same calculation as MercatorProjection::GeoToPixel().
+   */
+  static void MercatorScalarKernel(const MercatorKernelParameter& p,
+                                   const Point* nodes,
+                                   size_t count,
+                                   char* xPos,
+                                   char* yPos,
+                                   size_t stride,
+                                   double& xMin, double& yMin,
+                                   double& xMax, double& yMax)
+  {
+    for (size_t i=0; i<count; i++) {
+      double x=(nodes[i].GetLon()-p.lon)*p.scaleGradtorad;
+      double y=(atanh(sin(nodes[i].GetLat()*gradtorad))-p.latOffset)*p.scale;
+
+      if (p.rotate) {
+        double xn=x*p.angleNegCos-y*p.angleNegSin;
+        double yn=x*p.angleNegSin+y*p.angleNegCos;
+
+        x=xn;
+        y=yn;
+      }
+
+      y=p.halfHeight-y;
+      x+=p.halfWidth;
+
+      *reinterpret_cast<double*>(xPos)=x;
+      *reinterpret_cast<double*>(yPos)=y;
+
+      xMin=std::min(xMin,x);
+      xMax=std::max(xMax,x);
+      yMin=std::min(yMin,y);
+      yMax=std::max(yMax,y);
+
+      xPos+=stride;
+      yPos+=stride;
+    }
+  }
+
+#ifdef OSMSCOUT_MERCATOR_AVX2_KERNEL
+
+  /*
+   * Polynomial and reduction constants for sin() and log() as used by the
+   * Cephes math library. Both are precise up to a few ulp, so results differ
+   * from the scalar kernel far below pixel precision.
+   */
+  static const double avx2SinCoeff[]={ 1.58962301576546568060E-10,
+                                      -2.50507477628578072866E-8,
+                                       2.75573136213857245213E-6,
+                                      -1.98412698295895385996E-4,
+                                       8.33333333332211858878E-3,
+                                      -1.66666666666666307295E-1};
+  static const double avx2CosCoeff[]={-1.13585365213876817300E-11,
+                                       2.08757008419747316778E-9,
+                                      -2.75573141792967388112E-7,
+                                       2.48015872888517045348E-5,
+                                      -1.38888888888730564116E-3,
+                                       4.16666666666665929218E-2};
+  static const double avx2LogP[]={1.01875663804580931796E-4,
+                                  4.97494994976747001425E-1,
+                                  4.70579119878881725854E0,
+                                  1.44989225341610930846E1,
+                                  1.79368678507819816313E1,
+                                  7.70838733755885391666E0};
+  static const double avx2LogQ[]={1.12873587189167450590E1,
+                                  4.52279145837532221105E1,
+                                  8.29875266912776603211E1,
+                                  7.11544750618563894466E1,
+                                  2.31251620126765340583E1};
+
+  __attribute__((target("avx2")))
+  static inline __m256d AVX2Poly(__m256d x,
+                                 const double* coeff,
+                                 size_t count)
+  {
+    __m256d y=_mm256_set1_pd(coeff[0]);
+
+    for (size_t i=1; i<count; i++) {
+      y=_mm256_add_pd(_mm256_mul_pd(y,x),_mm256_set1_pd(coeff[i]));
+    }
+
+    return y;
+  }
+
+  /**
+   * sin(x) for x in [-PI/2,PI/2]
+   */
+  __attribute__((target("avx2")))
+  static inline __m256d AVX2Sin(__m256d x)
+  {
+    const __m256d signMask=_mm256_set1_pd(-0.0);
+    __m256d       sign=_mm256_and_pd(x,signMask);
+    __m256d       ax=_mm256_andnot_pd(signMask,x);
+
+    // Values above PI/4 are reduced to [-PI/4,0] and evaluated using the cosine polynomial
+    __m256d useCos=_mm256_cmp_pd(ax,_mm256_set1_pd(M_PI/4),_CMP_GE_OQ);
+    __m256d j=_mm256_and_pd(useCos,_mm256_set1_pd(2.0));
+    __m256d z=_mm256_sub_pd(ax,_mm256_mul_pd(j,_mm256_set1_pd(7.85398125648498535156E-1)));
+
+    z=_mm256_sub_pd(z,_mm256_mul_pd(j,_mm256_set1_pd(3.77489470793079817668E-8)));
+    z=_mm256_sub_pd(z,_mm256_mul_pd(j,_mm256_set1_pd(2.69515142907905952645E-15)));
+
+    __m256d zz=_mm256_mul_pd(z,z);
+
+    __m256d sinValue=_mm256_add_pd(z,
+                                   _mm256_mul_pd(_mm256_mul_pd(z,zz),
+                                                 AVX2Poly(zz,avx2SinCoeff,6)));
+    __m256d cosValue=_mm256_add_pd(_mm256_sub_pd(_mm256_set1_pd(1.0),
+                                                 _mm256_mul_pd(_mm256_set1_pd(0.5),zz)),
+                                   _mm256_mul_pd(_mm256_mul_pd(zz,zz),
+                                                 AVX2Poly(zz,avx2CosCoeff,6)));
+
+    return _mm256_xor_pd(_mm256_blendv_pd(sinValue,cosValue,useCos),sign);
+  }
+
+  /**
+   * Natural logarithm for positive, normalized x
+   */
+  __attribute__((target("avx2")))
+  static inline __m256d AVX2Log(__m256d x)
+  {
+    // Split x into mantissa [0.5,1[ and exponent
+    __m256i bits=_mm256_castpd_si256(x);
+    __m256i exponentBits=_mm256_srli_epi64(bits,52);
+    __m256d e=_mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(exponentBits,
+                                                                _mm256_set1_epi64x(0x4330000000000000LL))),
+                            _mm256_set1_pd(4503599627370496.0+1022.0));
+    __m256d m=_mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits,
+                                                                   _mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL)),
+                                                  _mm256_set1_epi64x(0x3FE0000000000000LL)));
+
+    // m<sqrt(0.5): e-=1, m=2*m-1, else m=m-1
+    __m256d small=_mm256_cmp_pd(m,_mm256_set1_pd(M_SQRT1_2),_CMP_LT_OQ);
+
+    e=_mm256_sub_pd(e,_mm256_and_pd(small,_mm256_set1_pd(1.0)));
+    m=_mm256_sub_pd(_mm256_add_pd(m,_mm256_and_pd(small,m)),_mm256_set1_pd(1.0));
+
+    __m256d z=_mm256_mul_pd(m,m);
+    __m256d y;
+
+    // Q is monic: m^5+Q[0]*m^4+...
+    __m256d q=_mm256_add_pd(m,_mm256_set1_pd(avx2LogQ[0]));
+    for (size_t i=1; i<5; i++) {
+      q=_mm256_add_pd(_mm256_mul_pd(q,m),_mm256_set1_pd(avx2LogQ[i]));
+    }
+
+    y=_mm256_mul_pd(m,_mm256_div_pd(_mm256_mul_pd(z,AVX2Poly(m,avx2LogP,6)),q));
+    y=_mm256_sub_pd(y,_mm256_mul_pd(e,_mm256_set1_pd(2.121944400546905827679e-4)));
+    y=_mm256_sub_pd(y,_mm256_mul_pd(_mm256_set1_pd(0.5),z));
+
+    return _mm256_add_pd(_mm256_add_pd(m,y),
+                         _mm256_mul_pd(e,_mm256_set1_pd(0.693359375)));
+  }
+
+  /**
+   * AVX2 kernel, transforms four coordinates at once. The remaining coordinates
+   * are padded by repeating the last one.
+   */
+  __attribute__((target("avx2")))
+  static void MercatorAVX2Kernel(const MercatorKernelParameter& p,
+                                 const Point* nodes,
+                                 size_t count,
+                                 char* xPos,
+                                 char* yPos,
+                                 size_t stride,
+                                 double& xMin, double& yMin,
+                                 double& xMax, double& yMax)
+  {
+    const __m256d lon=_mm256_set1_pd(p.lon);
+    const __m256d latOffset=_mm256_set1_pd(p.latOffset);
+    const __m256d scale=_mm256_set1_pd(p.scale);
+    const __m256d scaleGradtorad=_mm256_set1_pd(p.scaleGradtorad);
+    const __m256d gradtoradValue=_mm256_set1_pd(gradtorad);
+    const __m256d negSin=_mm256_set1_pd(p.angleNegSin);
+    const __m256d negCos=_mm256_set1_pd(p.angleNegCos);
+    const __m256d halfWidth=_mm256_set1_pd(p.halfWidth);
+    const __m256d halfHeight=_mm256_set1_pd(p.halfHeight);
+    const __m256d one=_mm256_set1_pd(1.0);
+    const __m256d half=_mm256_set1_pd(0.5);
+
+    __m256d minX=_mm256_set1_pd(xMin);
+    __m256d maxX=_mm256_set1_pd(xMax);
+    __m256d minY=_mm256_set1_pd(yMin);
+    __m256d maxY=_mm256_set1_pd(yMax);
+
+    double  xValues[4];
+    double  yValues[4];
+
+    for (size_t i=0; i<count; i+=4) {
+      const Point& n0=nodes[i];
+      const Point& n1=nodes[std::min(i+1,count-1)];
+      const Point& n2=nodes[std::min(i+2,count-1)];
+      const Point& n3=nodes[std::min(i+3,count-1)];
+
+      __m256d nodeLon=_mm256_set_pd(n3.GetLon(),n2.GetLon(),n1.GetLon(),n0.GetLon());
+      __m256d nodeLat=_mm256_set_pd(n3.GetLat(),n2.GetLat(),n1.GetLat(),n0.GetLat());
+
+      __m256d x=_mm256_mul_pd(_mm256_sub_pd(nodeLon,lon),scaleGradtorad);
+
+      // atanh(sin(lat))=0.5*log((1+sin(lat))/(1-sin(lat)))
+      __m256d s=AVX2Sin(_mm256_mul_pd(nodeLat,gradtoradValue));
+      __m256d y=_mm256_mul_pd(half,AVX2Log(_mm256_div_pd(_mm256_add_pd(one,s),
+                                                         _mm256_sub_pd(one,s))));
+
+      y=_mm256_mul_pd(_mm256_sub_pd(y,latOffset),scale);
+
+      if (p.rotate) {
+        __m256d xn=_mm256_sub_pd(_mm256_mul_pd(x,negCos),_mm256_mul_pd(y,negSin));
+        __m256d yn=_mm256_add_pd(_mm256_mul_pd(x,negSin),_mm256_mul_pd(y,negCos));
+
+        x=xn;
+        y=yn;
+      }
+
+      y=_mm256_sub_pd(halfHeight,y);
+      x=_mm256_add_pd(x,halfWidth);
+
+      // Padding repeats the last coordinate, so it does not change the bounding box
+      minX=_mm256_min_pd(minX,x);
+      maxX=_mm256_max_pd(maxX,x);
+      minY=_mm256_min_pd(minY,y);
+      maxY=_mm256_max_pd(maxY,y);
+
+      _mm256_storeu_pd(xValues,x);
+      _mm256_storeu_pd(yValues,y);
+
+      size_t valid=std::min((size_t)4,count-i);
+
+      for (size_t v=0; v<valid; v++) {
+        *reinterpret_cast<double*>(xPos)=xValues[v];
+        *reinterpret_cast<double*>(yPos)=yValues[v];
+
+        xPos+=stride;
+        yPos+=stride;
+      }
+    }
+
+    _mm256_storeu_pd(xValues,minX);
+    xMin=std::min(std::min(xValues[0],xValues[1]),std::min(xValues[2],xValues[3]));
+    _mm256_storeu_pd(xValues,maxX);
+    xMax=std::max(std::max(xValues[0],xValues[1]),std::max(xValues[2],xValues[3]));
+    _mm256_storeu_pd(yValues,minY);
+    yMin=std::min(std::min(yValues[0],yValues[1]),std::min(yValues[2],yValues[3]));
+    _mm256_storeu_pd(yValues,maxY);
+    yMax=std::max(std::max(yValues[0],yValues[1]),std::max(yValues[2],yValues[3]));
+  }
+
+  static bool HasAVX2Support()
+  {
+    static const bool hasAVX2=__builtin_cpu_supports("avx2")!=0;
+
+    return hasAVX2;
+  }
+
+#endif
+
+  bool MercatorProjection::IsBatchKernelSupported(BatchKernel kernel)
+  {
+    switch (kernel) {
+    case kernelAuto:
+    case kernelScalar:
+      return true;
+    case kernelAVX2:
+#ifdef OSMSCOUT_MERCATOR_AVX2_KERNEL
+      return HasAVX2Support();
+#else
+      return false;
+#endif
+    }
+
+    return false;
+  }
+
+  /**
+   * Set the kernel to use for BatchGeoToPixel(). If the given kernel is not
+   * supported on the current platform, the scalar kernel is used.
+   */
+  void MercatorProjection::SetBatchKernel(BatchKernel kernel)
+  {
+    batchKernel=kernel;
+  }
+
+  void MercatorProjection::BatchGeoToPixel(const Point* nodes,
+                                           size_t count,
+                                           double* x,
+                                           double* y,
+                                           size_t stride,
+                                           double& xMin, double& yMin,
+                                           double& xMax, double& yMax) const
+  {
+    assert(valid);
+
+    if (count==0) {
+      return;
+    }
+
+    MercatorKernelParameter parameter;
+
+    parameter.lon=lon;
+    parameter.latOffset=latOffset;
+    parameter.scale=scale;
+    parameter.scaleGradtorad=scaleGradtorad;
+    parameter.angleNegSin=angleNegSin;
+    parameter.angleNegCos=angleNegCos;
+    parameter.halfWidth=(double)(width/2);
+    parameter.halfHeight=(double)(height/2);
+    parameter.rotate=angle!=0.0;
+
+    xMin=std::numeric_limits<double>::max();
+    yMin=std::numeric_limits<double>::max();
+    xMax=-std::numeric_limits<double>::max();
+    yMax=-std::numeric_limits<double>::max();
+
+#ifdef OSMSCOUT_MERCATOR_AVX2_KERNEL
+    if ((batchKernel==kernelAuto || batchKernel==kernelAVX2) &&
+        HasAVX2Support()) {
+      MercatorAVX2Kernel(parameter,
+                         nodes,
+                         count,
+                         reinterpret_cast<char*>(x),
+                         reinterpret_cast<char*>(y),
+                         stride,
+                         xMin,yMin,
+                         xMax,yMax);
+
+      return;
+    }
+#endif
+
+    MercatorScalarKernel(parameter,
+                         nodes,
+                         count,
+                         reinterpret_cast<char*>(x),
+                         reinterpret_cast<char*>(y),
+                         stride,
+                         xMin,yMin,
+                         xMax,yMax);
+  }
+
   bool MercatorProjection::Move(double horizPixel,
                                 double vertPixel)
   {
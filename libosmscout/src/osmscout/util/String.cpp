@@ -249,6 +249,35 @@ namespace osmscout {
     }
   }
 
+  void TolowerUmlaut(std::string& s)
+  {
+    for (std::string::iterator it=s.begin();
+         it!=s.end();
+         ++it)
+    {
+      /* this filter matches all character from the table
+       * http://en.wikipedia.org/wiki/Latin-1_Supplement_%28Unicode_block%29#Compact_table
+       * beginning at U+0x00C0 to U+0x00DE
+       */
+      if((uint8_t)*it == 0xC3)
+      {
+        ++it;
+
+        if (it==s.end()) {
+          break;
+        }
+
+        if((uint8_t)*it>=0x80 && (uint8_t)*it<=0x9E) {
+          // 0x9F is german "sz" which is already small caps.
+          *it+=0x20;
+        }
+      }
+      else {
+        *it=tolower(*it);
+      }
+    }
+  }
+
   void GroupStringListToStrings(std::list<std::string>::const_iterator token,
                                 size_t listSize,
                                 size_t parts,
@@ -19,6 +19,7 @@
 
 #include <osmscout/util/Transformation.h>
 
+#include <algorithm>
 #include <limits>
 
 namespace osmscout {
@@ -121,50 +122,48 @@ namespace osmscout {
     return sqrt(xdelta*xdelta + ydelta*ydelta);
   }
 
-  static void SimplifyPolyLineDouglasPeucker(TransPolygon::TransPoint* points,
-                                             size_t beginIndex,
-                                             size_t endIndex,
-                                             size_t endValueIndex,
-                                             double optimizeErrorToleranceSquared)
-  {
-    LineSegment lineSegment(points[beginIndex], points[endValueIndex]);
-
-    double maxDistanceSquared=0;
-    size_t maxDistanceIndex=beginIndex;
+  /**
+   * Number of nodes transformed at once, before the transformed points are
+   * post processed. Keeps the points to post process in the CPU cache.
+   */
+  static const size_t transformBlockSize=1024;
 
-    for(size_t i=beginIndex+1; i<endIndex; ++i){
-      if (points[i].draw) {
-        double distanceSquared=lineSegment.CalculateDistanceSquared(points[i]);
+  /**
+   * Margin around the visible area in mm. Area outline points outside the visible
+   * area (including the margin) are dropped, as long as the outline does not
+   * enter the visible area in between. The margin makes sure that borders of areas
+   * are still drawn correctly.
+   */
+  static const double offscreenMarginMM=10.0;
+
+  static const unsigned int outLeft  =1;
+  static const unsigned int outRight =2;
+  static const unsigned int outTop   =4;
+  static const unsigned int outBottom=8;
+
+  static inline unsigned int GetOutCode(const TransPolygon::TransPoint& point,
+                                        double xMin,
+                                        double yMin,
+                                        double xMax,
+                                        double yMax)
+  {
+    unsigned int code=0;
 
-        if (distanceSquared>maxDistanceSquared) {
-          maxDistanceSquared=distanceSquared;
-          maxDistanceIndex=i;
-        }
-      }
+    if (point.x<xMin) {
+      code|=outLeft;
     }
-
-    if (maxDistanceSquared<=optimizeErrorToleranceSquared) {
-
-      //we don't need to draw any extra points
-      for(size_t i=beginIndex+1; i<endIndex; ++i){
-        points[i].draw=false;
-      }
-
-      return;
+    else if (point.x>xMax) {
+      code|=outRight;
     }
 
-    //we need to split this line in two pieces
-    SimplifyPolyLineDouglasPeucker(points,
-                                   beginIndex,
-                                   maxDistanceIndex,
-                                   maxDistanceIndex,
-                                   optimizeErrorToleranceSquared);
+    if (point.y<yMin) {
+      code|=outTop;
+    }
+    else if (point.y>yMax) {
+      code|=outBottom;
+    }
 
-    SimplifyPolyLineDouglasPeucker(points,
-                                   maxDistanceIndex,
-                                   endIndex,
-                                   endValueIndex,
-                                   optimizeErrorToleranceSquared);
+    return code;
   }
 
   TransPolygon::TransPolygon()
@@ -172,6 +171,11 @@ namespace osmscout {
     length(0),
     start(0),
     end(0),
+    optimized(false),
+    xMin(0.0),
+    yMin(0.0),
+    xMax(0.0),
+    yMax(0.0),
     points(NULL)
   {
     // no code
@@ -182,94 +186,180 @@ namespace osmscout {
     delete [] points;
   }
 
-  void TransPolygon::TransformGeoToPixel(const Projection& projection,
-                                         const std::vector<Point>& nodes)
+  const Point* TransPolygon::GetPointBlock(const std::vector<Point>& nodes,
+                                           size_t start,
+                                           size_t /*count*/)
   {
-    Projection::BatchTransformer batchTransformer(projection);
+    return &nodes[start];
+  }
 
-    if (!nodes.empty()) {
-      start=0;
-      length=nodes.size();
-      end=length-1;
-
-      for (size_t i=start; i<=end; i++) {
-         batchTransformer.GeoToPixel(nodes[i].GetLon(),
-                                     nodes[i].GetLat(),
-                                     points[i].x,
-                                     points[i].y);
-        points[i].draw=true;
-      }
+  /**
+   * Decodes the given block of fixed-point coordinates into a buffer, that
+   * is reused between blocks and calls, so the projection can be fed without
+   * expanding all points of the object.
+   */
+  const Point* TransPolygon::GetPointBlock(const CompactPoints& nodes,
+                                           size_t start,
+                                           size_t count)
+  {
+    if (pointBlock.size()<count) {
+      pointBlock.resize(count);
     }
-    else {
+
+    nodes.GetPoints(start,
+                    count,
+                    pointBlock.data());
+
+    return pointBlock.data();
+  }
+
+  /**
+   * Transforms the nodes block wise and optionally drops - in the same pass - every
+   * point (except the last one) that is within the error tolerance of the last
+   * drawn point.
+   */
+  template<class N>
+  void TransPolygon::TransformGeoToPixel(const Projection& projection,
+                                         const N& nodes,
+                                         bool dropSimilarPoints,
+                                         double optimizeErrorTolerance)
+  {
+    optimized=false;
+
+    if (nodes.empty()) {
       start=0;
       end=0;
       length=0;
+
+      return;
+    }
+
+    start=0;
+    length=nodes.size();
+    end=length-1;
+
+    size_t lastDrawn=0;
+
+    for (size_t blockStart=0; blockStart<length; blockStart+=transformBlockSize) {
+      size_t blockEnd=std::min(blockStart+transformBlockSize,length);
+      double blockXMin,blockYMin,blockXMax,blockYMax;
+
+      // Transform directly into the points array and calculate the bounding box on the way
+      projection.BatchGeoToPixel(GetPointBlock(nodes,
+                                               blockStart,
+                                               blockEnd-blockStart),
+                                 blockEnd-blockStart,
+                                 &points[blockStart].x,
+                                 &points[blockStart].y,
+                                 sizeof(TransPoint),
+                                 blockXMin,blockYMin,
+                                 blockXMax,blockYMax);
+
+      if (blockStart==0) {
+        xMin=blockXMin;
+        yMin=blockYMin;
+        xMax=blockXMax;
+        yMax=blockYMax;
+      }
+      else {
+        xMin=std::min(xMin,blockXMin);
+        yMin=std::min(yMin,blockYMin);
+        xMax=std::max(xMax,blockXMax);
+        yMax=std::max(yMax,blockYMax);
+      }
+
+      for (size_t i=blockStart; i<blockEnd; i++) {
+        if (dropSimilarPoints &&
+            i>0 &&
+            i<end &&
+            std::fabs(points[i].x-points[lastDrawn].x)<=optimizeErrorTolerance &&
+            std::fabs(points[i].y-points[lastDrawn].y)<=optimizeErrorTolerance) {
+          points[i].draw=false;
+        }
+        else {
+          points[i].draw=true;
+          lastDrawn=i;
+        }
+      }
     }
   }
 
-  void TransPolygon::DropSimilarPoints(double optimizeErrorTolerance)
+  void TransPolygon::CollectDrawnPoints()
   {
+    drawn.clear();
+
     for (size_t i=0; i<length; i++) {
       if (points[i].draw) {
-        size_t j=i+1;
-        while (j<length-1) {
-          if (points[j].draw)
-          {
-            if (std::fabs(points[j].x-points[i].x)<=optimizeErrorTolerance &&
-                std::fabs(points[j].y-points[i].y)<=optimizeErrorTolerance) {
-              points[j].draw=false;
-            }
-            else {
-              break;
-            }
-          }
-
-          j++;
-        }
+        drawn.push_back(i);
       }
     }
   }
 
-  void TransPolygon::DropRedundantPointsFast(double optimizeErrorTolerance)
+  /**
+   * Drop every drawn point, that is - together with the previous drawn and the next
+   * point - on the outer side of the same edge of the visible area (including a
+   * margin). The resulting outline does not differ within the visible area.
+   */
+  void TransPolygon::DropOffscreenPoints(const Projection& projection)
   {
-    // Drop every point that is (more or less) on direct line between two points A and B
-    size_t prev=0;
-    while (prev<length) {
+    if (drawn.size()<3) {
+      return;
+    }
 
-      while (prev<length && !points[prev].draw) {
-        prev++;
-      }
+    double margin=projection.ConvertWidthToPixel(offscreenMarginMM);
+    double visibleXMin=-margin;
+    double visibleYMin=-margin;
+    double visibleXMax=projection.GetWidth()+margin;
+    double visibleYMax=projection.GetHeight()+margin;
 
-      if (prev>=length) {
-        break;
-      }
+    // Everything visible, nothing to do
+    if (xMin>=visibleXMin &&
+        xMax<=visibleXMax &&
+        yMin>=visibleYMin &&
+        yMax<=visibleYMax) {
+      return;
+    }
 
-      size_t cur=prev+1;
+    size_t       kept=1;
+    unsigned int prevCode=GetOutCode(points[drawn[0]],visibleXMin,visibleYMin,visibleXMax,visibleYMax);
+    unsigned int currentCode=GetOutCode(points[drawn[1]],visibleXMin,visibleYMin,visibleXMax,visibleYMax);
 
-      while (cur<length && !points[cur].draw) {
-        cur++;
-      }
+    for (size_t i=1; i+1<drawn.size(); i++) {
+      unsigned int nextCode=GetOutCode(points[drawn[i+1]],visibleXMin,visibleYMin,visibleXMax,visibleYMax);
 
-      if (cur>=length) {
-        break;
+      if ((prevCode & currentCode & nextCode)!=0) {
+        points[drawn[i]].draw=false;
+      }
+      else {
+        drawn[kept]=drawn[i];
+        kept++;
+        prevCode=currentCode;
       }
 
-      size_t next=cur+1;
+      currentCode=nextCode;
+    }
 
-      while (next<length && !points[next].draw) {
-        next++;
-      }
+    drawn[kept]=drawn.back();
+    kept++;
 
-      if (next>=length) {
-        break;
-      }
+    drawn.resize(kept);
+  }
 
-      double distance=CalculateDistancePointToLineSegment(points[cur],
-                                                          points[prev],
-                                                          points[next]);
+  void TransPolygon::DropRedundantPointsFast(double optimizeErrorTolerance)
+  {
+    // Drop every point that is (more or less) on direct line between two points A and B
+    size_t prev=0;
+
+    while (prev+2<drawn.size()) {
+      size_t cur=prev+1;
+      size_t next=prev+2;
+
+      double distance=CalculateDistancePointToLineSegment(points[drawn[cur]],
+                                                          points[drawn[prev]],
+                                                          points[drawn[next]]);
 
       if (distance<=optimizeErrorTolerance) {
-        points[cur].draw=false;
+        points[drawn[cur]].draw=false;
 
         prev=next;
       }
@@ -285,14 +375,8 @@ namespace osmscout {
     // An implementation of Douglas-Peuker algorithm http://softsurfer.com/Archive/algorithm_0205/algorithm_0205.htm
 
     double optimizeErrorToleranceSquared=optimizeErrorTolerance*optimizeErrorTolerance;
-    size_t begin=0;
 
-    while (begin<length &&
-           !points[begin].draw) {
-      begin++;
-    }
-
-    if (begin>=length) {
+    if (drawn.empty()) {
       return; //we found no single point that is drawn.
     }
 
@@ -300,59 +384,134 @@ namespace osmscout {
     if (isArea) {
 
       double maxDist=0.0;
-      size_t maxDistIndex=begin;
+      size_t maxDistIndex=0;
 
-      for(size_t i=begin; i<length; ++i) {
-        if (points[i].draw) {
-          double dist=CalculateDistancePointToPoint(points[begin], points[i]);
+      for (size_t i=0; i<drawn.size(); ++i) {
+        double dist=CalculateDistancePointToPoint(points[drawn[0]],
+                                                  points[drawn[i]]);
 
-          if (dist>maxDist) {
-            maxDist=dist;
-            maxDistIndex=i;
-          }
+        if (dist>maxDist) {
+          maxDist=dist;
+          maxDistIndex=i;
         }
       }
 
-      if (maxDistIndex==begin) {
+      if (maxDistIndex==0) {
         return; //we only found 1 point to draw
       }
 
-      SimplifyPolyLineDouglasPeucker(points,
-                                     begin,
-                                     maxDistIndex,
-                                     maxDistIndex,
-                                     optimizeErrorToleranceSquared);
-      SimplifyPolyLineDouglasPeucker(points,
-                                     maxDistIndex,
-                                     length,
-                                     begin,
-                                     optimizeErrorToleranceSquared);
+      SimplifyDouglasPeucker(0,
+                             maxDistIndex,
+                             maxDistIndex,
+                             optimizeErrorToleranceSquared);
+      SimplifyDouglasPeucker(maxDistIndex,
+                             drawn.size(),
+                             0,
+                             optimizeErrorToleranceSquared);
     }
     else {
       //not an area but polyline
-      //find last drawable point;
-      size_t end=length-1;
-      while (end>begin &&
-          !points[end].draw) {
-        end--;
-      }
+      size_t last=drawn.size()-1;
 
-      if (end<=begin) {
+      if (last==0) {
         return; //we only found 1 drawable point;
       }
 
-      SimplifyPolyLineDouglasPeucker(points,
-                                     begin,
-                                     end,
-                                     end,
-                                     optimizeErrorToleranceSquared);
+      SimplifyDouglasPeucker(0,
+                             last,
+                             last,
+                             optimizeErrorToleranceSquared);
     }
   }
 
-  void TransPolygon::TransformArea(const Projection& projection,
-                                   OptimizeMethod optimize,
-                                   const std::vector<Point>& nodes,
-                                   double optimizeErrorTolerance)
+  /**
+   * Simplifies the drawn points between the given positions (in the list of
+   * drawn points). Uses an explicit stack instead of recursion.
+   */
+  void TransPolygon::SimplifyDouglasPeucker(size_t begin,
+                                            size_t end,
+                                            size_t endValue,
+                                            double optimizeErrorToleranceSquared)
+  {
+    SimplifySegment segment;
+
+    segment.begin=begin;
+    segment.end=end;
+    segment.endValue=endValue;
+
+    simplifyStack.clear();
+    simplifyStack.push_back(segment);
+
+    while (!simplifyStack.empty()) {
+      segment=simplifyStack.back();
+      simplifyStack.pop_back();
+
+      LineSegment lineSegment(points[drawn[segment.begin]],
+                              points[drawn[segment.endValue]]);
+
+      double maxDistanceSquared=0;
+      size_t maxDistanceIndex=segment.begin;
+
+      for (size_t i=segment.begin+1; i<segment.end; ++i) {
+        double distanceSquared=lineSegment.CalculateDistanceSquared(points[drawn[i]]);
+
+        if (distanceSquared>maxDistanceSquared) {
+          maxDistanceSquared=distanceSquared;
+          maxDistanceIndex=i;
+        }
+      }
+
+      if (maxDistanceSquared<=optimizeErrorToleranceSquared) {
+        //we don't need to draw any extra points
+        for (size_t i=segment.begin+1; i<segment.end; ++i) {
+          points[drawn[i]].draw=false;
+        }
+
+        continue;
+      }
+
+      //we need to split this line in two pieces
+      SimplifySegment second;
+
+      second.begin=maxDistanceIndex;
+      second.end=segment.end;
+      second.endValue=segment.endValue;
+
+      segment.end=maxDistanceIndex;
+      segment.endValue=maxDistanceIndex;
+
+      simplifyStack.push_back(second);
+      simplifyStack.push_back(segment);
+    }
+  }
+
+  /**
+   * Calculate start, end and length from the remaining drawn points
+   */
+  void TransPolygon::CalculateRange(size_t nodeCount)
+  {
+    length=0;
+    start=nodeCount;
+    end=0;
+
+    for (size_t index : drawn) {
+      if (points[index].draw) {
+        length++;
+
+        if (index<start) {
+          start=index;
+        }
+
+        end=index;
+      }
+    }
+  }
+
+  template<class N>
+  void TransPolygon::TransformAreaNodes(const Projection& projection,
+                                        OptimizeMethod optimize,
+                                        const N& nodes,
+                                        double optimizeErrorTolerance)
   {
     if (nodes.size()<2) {
       length=0;
@@ -369,44 +528,59 @@ namespace osmscout {
 
     if (optimize!=none) {
       TransformGeoToPixel(projection,
-                          nodes);
+                          nodes,
+                          optimize==fast,
+                          optimizeErrorTolerance);
+
+      optimized=true;
 
+      CollectDrawnPoints();
+      DropOffscreenPoints(projection);
 
       if (optimize==fast) {
-        DropSimilarPoints(optimizeErrorTolerance);
         DropRedundantPointsFast(optimizeErrorTolerance);
       }
       else {
         DropRedundantPointsDouglasPeucker(optimizeErrorTolerance,true);
       }
 
-      length=0;
-      start=nodes.size();
-      end=0;
-
-      // Calculate start, end and length
-      for (size_t i=0; i<nodes.size(); i++) {
-        if (points[i].draw) {
-          length++;
-
-          if (i<start) {
-            start=i;
-          }
-
-          end=i;
-        }
-      }
+      CalculateRange(nodes.size());
     }
     else {
       TransformGeoToPixel(projection,
-                          nodes);
+                          nodes,
+                          false,
+                          optimizeErrorTolerance);
     }
   }
 
-  void TransPolygon::TransformWay(const Projection& projection,
-                                  OptimizeMethod optimize,
-                                  const std::vector<Point>& nodes,
-                                  double optimizeErrorTolerance)
+  void TransPolygon::TransformArea(const Projection& projection,
+                                   OptimizeMethod optimize,
+                                   const std::vector<Point>& nodes,
+                                   double optimizeErrorTolerance)
+  {
+    TransformAreaNodes(projection,
+                       optimize,
+                       nodes,
+                       optimizeErrorTolerance);
+  }
+
+  void TransPolygon::TransformArea(const Projection& projection,
+                                   OptimizeMethod optimize,
+                                   const CompactPoints& nodes,
+                                   double optimizeErrorTolerance)
+  {
+    TransformAreaNodes(projection,
+                       optimize,
+                       nodes,
+                       optimizeErrorTolerance);
+  }
+
+  template<class N>
+  void TransPolygon::TransformWayNodes(const Projection& projection,
+                                       OptimizeMethod optimize,
+                                       const N& nodes,
+                                       double optimizeErrorTolerance)
   {
     if (nodes.empty()) {
       length=0;
@@ -423,9 +597,13 @@ namespace osmscout {
 
     if (optimize!=none) {
       TransformGeoToPixel(projection,
-                          nodes);
+                          nodes,
+                          true,
+                          optimizeErrorTolerance);
 
-      DropSimilarPoints(optimizeErrorTolerance);
+      optimized=true;
+
+      CollectDrawnPoints();
 
       if (optimize==fast) {
         DropRedundantPointsFast(optimizeErrorTolerance);
@@ -434,28 +612,38 @@ namespace osmscout {
         DropRedundantPointsDouglasPeucker(optimizeErrorTolerance,false);
       }
 
-      length=0;
-      start=nodes.size();
-      end=0;
-
-      // Calculate start & end
-      for (size_t i=0; i<nodes.size(); i++) {
-        if (points[i].draw) {
-          length++;
-
-          if (i<start) {
-            start=i;
-          }
-          end=i;
-        }
-      }
+      CalculateRange(nodes.size());
     }
     else {
       TransformGeoToPixel(projection,
-                          nodes);
+                          nodes,
+                          false,
+                          optimizeErrorTolerance);
     }
   }
 
+  void TransPolygon::TransformWay(const Projection& projection,
+                                  OptimizeMethod optimize,
+                                  const std::vector<Point>& nodes,
+                                  double optimizeErrorTolerance)
+  {
+    TransformWayNodes(projection,
+                      optimize,
+                      nodes,
+                      optimizeErrorTolerance);
+  }
+
+  void TransPolygon::TransformWay(const Projection& projection,
+                                  OptimizeMethod optimize,
+                                  const CompactPoints& nodes,
+                                  double optimizeErrorTolerance)
+  {
+    TransformWayNodes(projection,
+                      optimize,
+                      nodes,
+                      optimizeErrorTolerance);
+  }
+
   bool TransPolygon::GetBoundingBox(double& xmin, double& ymin,
                                     double& xmax, double& ymax) const
   {
@@ -463,6 +651,17 @@ namespace osmscout {
       return false;
     }
 
+    // Without optimization all points are drawn, so we can reuse
+    // the bounding box calculated during transformation
+    if (!optimized) {
+      xmin=xMin;
+      ymin=yMin;
+      xmax=xMax;
+      ymax=yMax;
+
+      return true;
+    }
+
     size_t pos=start;
 
     while (!points[pos].draw) {
@@ -527,6 +726,25 @@ namespace osmscout {
     buffer->Reset();
   }
 
+  /**
+   * Push all drawn points of the last transformation to the buffer.
+   */
+  void TransBuffer::PushDrawnPoints(size_t& start, size_t &end)
+  {
+    bool isStart=true;
+    for (size_t i=transPolygon.GetStart(); i<=transPolygon.GetEnd(); i++) {
+      if (transPolygon.points[i].draw) {
+        end=buffer->PushCoord(transPolygon.points[i].x,
+                              transPolygon.points[i].y);
+
+        if (isStart) {
+          start=end;
+          isStart=false;
+        }
+      }
+    }
+  }
+
   void TransBuffer::TransformArea(const Projection& projection,
                                   TransPolygon::OptimizeMethod optimize,
                                   const std::vector<Point>& nodes,
@@ -540,18 +758,23 @@ namespace osmscout {
 
     assert(!transPolygon.IsEmpty());
 
-    bool isStart=true;
-    for (size_t i=transPolygon.GetStart(); i<=transPolygon.GetEnd(); i++) {
-      if (transPolygon.points[i].draw) {
-        end=buffer->PushCoord(transPolygon.points[i].x,
-                              transPolygon.points[i].y);
+    PushDrawnPoints(start,end);
+  }
 
-        if (isStart) {
-          start=end;
-          isStart=false;
-        }
-      }
-    }
+  void TransBuffer::TransformArea(const Projection& projection,
+                                  TransPolygon::OptimizeMethod optimize,
+                                  const CompactPoints& nodes,
+                                  size_t& start, size_t &end,
+                                  double optimizeErrorTolerance)
+  {
+    transPolygon.TransformArea(projection,
+                               optimize,
+                               nodes,
+                               optimizeErrorTolerance);
+
+    assert(!transPolygon.IsEmpty());
+
+    PushDrawnPoints(start,end);
   }
 
   bool TransBuffer::TransformWay(const Projection& projection,
@@ -566,19 +789,25 @@ namespace osmscout {
       return false;
     }
 
-    bool isStart=true;
-    for (size_t i=transPolygon.GetStart(); i<=transPolygon.GetEnd(); i++) {
-      if (transPolygon.points[i].draw) {
-        end=buffer->PushCoord(transPolygon.points[i].x,
-                              transPolygon.points[i].y);
+    PushDrawnPoints(start,end);
 
-        if (isStart) {
-          start=end;
-          isStart=false;
-        }
-      }
+    return true;
+  }
+
+  bool TransBuffer::TransformWay(const Projection& projection,
+                                 TransPolygon::OptimizeMethod optimize,
+                                 const CompactPoints& nodes,
+                                 size_t& start, size_t &end,
+                                 double optimizeErrorTolerance)
+  {
+    transPolygon.TransformWay(projection, optimize, nodes, optimizeErrorTolerance);
+
+    if (transPolygon.IsEmpty()) {
+      return false;
     }
 
+    PushDrawnPoints(start,end);
+
     return true;
   }
 }
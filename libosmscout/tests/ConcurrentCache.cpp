@@ -0,0 +1,137 @@
+#include <iostream>
+
+#include <osmscout/util/ConcurrentCache.h>
+
+typedef osmscout::ConcurrentCache<size_t,size_t> Cache;
+
+int errors=0;
+
+static bool HasEntry(Cache& cache,
+                     size_t key)
+{
+  size_t value;
+
+  return cache.GetEntry(key,value);
+}
+
+static void TestEvictionOrder()
+{
+  Cache cache(3,[](const size_t& /*value*/) {return (size_t)1;},1);
+
+  cache.SetEntry(1,1);
+  cache.SetEntry(2,2);
+  cache.SetEntry(3,3);
+
+  // Make 1 the most recently used entry, so 2 is the least recently used one
+  if (!HasEntry(cache,1)) {
+    std::cerr << "1 not found in cache!" << std::endl;
+    errors++;
+  }
+
+  cache.SetEntry(4,4);
+
+  if (HasEntry(cache,2)) {
+    std::cerr << "2 not evicted from cache!" << std::endl;
+    errors++;
+  }
+
+  if (!HasEntry(cache,1) ||
+      !HasEntry(cache,3) ||
+      !HasEntry(cache,4)) {
+    std::cerr << "Wrong entry evicted from cache!" << std::endl;
+    errors++;
+  }
+
+  if (cache.GetEvictions()!=1) {
+    std::cerr << "Expected 1 eviction, got " << cache.GetEvictions() << "!" << std::endl;
+    errors++;
+  }
+
+  if (cache.GetHits()!=4 ||
+      cache.GetMisses()!=1) {
+    std::cerr << "Expected 4 hits and 1 miss, got " << cache.GetHits() << " and " << cache.GetMisses() << "!" << std::endl;
+    errors++;
+  }
+}
+
+static void TestSizeAccounting()
+{
+  // Each value is charged by itself
+  Cache cache(10,[](const size_t& value) {return value;},1);
+
+  cache.SetEntry(1,4);
+  cache.SetEntry(2,4);
+
+  if (cache.GetSize()!=8) {
+    std::cerr << "Expected size 8, got " << cache.GetSize() << "!" << std::endl;
+    errors++;
+  }
+
+  cache.SetEntry(3,4);
+
+  if (cache.GetSize()!=8 ||
+      cache.GetEntryCount()!=2 ||
+      HasEntry(cache,1)) {
+    std::cerr << "Expected 1 to be evicted, size " << cache.GetSize() << "!" << std::endl;
+    errors++;
+  }
+
+  // Replacing a value replaces its size
+  cache.SetEntry(2,1);
+
+  if (cache.GetSize()!=5) {
+    std::cerr << "Expected size 5 after update, got " << cache.GetSize() << "!" << std::endl;
+    errors++;
+  }
+
+  cache.Remove(3);
+
+  if (cache.GetSize()!=1 ||
+      cache.GetEntryCount()!=1) {
+    std::cerr << "Expected size 1 after remove, got " << cache.GetSize() << "!" << std::endl;
+    errors++;
+  }
+
+  cache.Flush();
+
+  if (cache.GetSize()!=0 ||
+      cache.GetEntryCount()!=0) {
+    std::cerr << "Cache not empty after flush!" << std::endl;
+    errors++;
+  }
+}
+
+static void TestSmallCache()
+{
+  // Less units than the default shard count
+  Cache cache(5);
+
+  for (size_t i=0; i<100; i++) {
+    cache.SetEntry(i,i);
+  }
+
+  if (cache.GetEntryCount()!=5 ||
+      cache.GetSize()!=5) {
+    std::cerr << "Expected 5 entries in small cache, got " << cache.GetEntryCount() << "!" << std::endl;
+    errors++;
+  }
+
+  if (!HasEntry(cache,99)) {
+    std::cerr << "Last entry not found in small cache!" << std::endl;
+    errors++;
+  }
+}
+
+int main()
+{
+  TestEvictionOrder();
+  TestSizeAccounting();
+  TestSmallCache();
+
+  if (errors!=0) {
+    return 1;
+  }
+  else {
+    return 0;
+  }
+}
@@ -407,6 +407,48 @@ int main()
       std::cout << std::endl;
       errors++;
     }
+
+    scanner.Close();
+
+    // Write to memory, overwriting data at the start
+
+    osmscout::FileWriter memoryWriter;
+
+    memoryWriter.OpenMemory();
+
+    memoryWriter.Write(out32u3);
+    memoryWriter.WriteCoord(outCoord1);
+    memoryWriter.SetPos(0);
+    memoryWriter.Write(out32u2);
+
+    if (memoryWriter.GetPos()!=4 ||
+        memoryWriter.GetMemory().size()!=4+osmscout::coordByteSize) {
+      std::cerr << "OpenMemory(): Expected position 4 and size " << 4+osmscout::coordByteSize << ", got " << memoryWriter.GetPos() << " and " << memoryWriter.GetMemory().size() << std::endl;
+      errors++;
+    }
+
+    writer.Open("test.dat");
+    writer.Write(memoryWriter.GetMemory().data(),
+                 memoryWriter.GetMemory().size());
+    writer.Close();
+
+    memoryWriter.Close();
+
+    scanner.Open("test.dat",osmscout::FileScanner::Normal,false);
+
+    scanner.Read(in32u);
+    if (in32u!=out32u2) {
+      std::cerr << "OpenMemory(): Expected " << out32u2 << ", got " << in32u << std::endl;
+      errors++;
+    }
+
+    scanner.ReadCoord(inCoord1);
+    if (inCoord1.GetDisplayText()!=outCoord1.GetDisplayText()) {
+      std::cerr << "OpenMemory(): Expected " << outCoord1.GetDisplayText() << ", got " << inCoord1.GetDisplayText() << std::endl;
+      errors++;
+    }
+
+    scanner.Close();
   }
   catch (osmscout::IOException& e) {
     std::cerr << e.GetDescription() << std::endl;
@@ -0,0 +1,432 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include <osmscout/POIIndex.h>
+
+#include <osmscout/util/FileWriter.h>
+#include <osmscout/util/Geometry.h>
+
+struct TestPOI
+{
+  osmscout::TypeInfoRef   type;
+  osmscout::ObjectFileRef object;
+  osmscout::GeoCoord      coord;
+};
+
+int errors=0;
+
+/**
+ * Write the R-tree of the given POIs in the format of the POI index, grouping
+ * the entries in the given order
+ */
+static osmscout::FileOffset WriteTree(osmscout::FileWriter& writer,
+                                      const std::vector<TestPOI>& pois,
+                                      osmscout::GeoBox& boundingBox)
+{
+  struct TreeEntry
+  {
+    osmscout::GeoBox        boundingBox;
+    osmscout::ObjectFileRef object;
+    osmscout::FileOffset    childOffset;
+  };
+
+  std::vector<TreeEntry> entries;
+  bool                   leaf=true;
+
+  for (const auto& poi : pois) {
+    TreeEntry entry;
+
+    entry.boundingBox.Set(poi.coord,poi.coord);
+    entry.object=poi.object;
+    entry.childOffset=0;
+
+    entries.push_back(entry);
+  }
+
+  while (true) {
+    std::vector<TreeEntry> parents;
+
+    for (size_t start=0; start<entries.size(); start+=osmscout::POIIndex::NODE_SIZE) {
+      size_t    end=std::min(start+osmscout::POIIndex::NODE_SIZE,entries.size());
+      TreeEntry parent;
+
+      parent.childOffset=writer.GetPos();
+      parent.boundingBox=entries[start].boundingBox;
+
+      writer.Write(leaf);
+      writer.WriteNumber((uint32_t)(end-start));
+
+      for (size_t i=start; i<end; i++) {
+        writer.WriteCoord(entries[i].boundingBox.GetMinCoord());
+        writer.WriteCoord(entries[i].boundingBox.GetMaxCoord());
+
+        if (leaf) {
+          writer.Write(entries[i].object);
+        }
+        else {
+          writer.WriteFileOffset(entries[i].childOffset);
+        }
+
+        parent.boundingBox.Include(entries[i].boundingBox);
+      }
+
+      parents.push_back(parent);
+    }
+
+    if (parents.size()==1) {
+      boundingBox=parents.front().boundingBox;
+
+      return parents.front().childOffset;
+    }
+
+    entries.swap(parents);
+    leaf=false;
+  }
+}
+
+static bool WriteIndex(const osmscout::TypeConfig& typeConfig,
+                       const std::vector<TestPOI>& pois)
+{
+  osmscout::FileWriter writer;
+
+  try {
+    writer.Open(osmscout::POIIndex::POI_IDX);
+
+    writer.WriteFileOffset(0);
+
+    std::vector<osmscout::FileOffset> rootOffsets(typeConfig.GetTypeCount(),0);
+    std::vector<uint32_t>             entryCounts(typeConfig.GetTypeCount(),0);
+    std::vector<osmscout::GeoBox>     boundingBoxes(typeConfig.GetTypeCount());
+    uint32_t                          typeCount=0;
+
+    for (const auto& type : typeConfig.GetTypes()) {
+      std::vector<TestPOI> typePOIs;
+
+      for (const auto& poi : pois) {
+        if (poi.type==type) {
+          typePOIs.push_back(poi);
+        }
+      }
+
+      if (typePOIs.empty()) {
+        continue;
+      }
+
+      rootOffsets[type->GetIndex()]=WriteTree(writer,
+                                              typePOIs,
+                                              boundingBoxes[type->GetIndex()]);
+      entryCounts[type->GetIndex()]=(uint32_t)typePOIs.size();
+      typeCount++;
+    }
+
+    osmscout::FileOffset typeTableOffset=writer.GetPos();
+
+    writer.WriteNumber(typeCount);
+
+    for (size_t i=0; i<rootOffsets.size(); i++) {
+      if (rootOffsets[i]==0) {
+        continue;
+      }
+
+      writer.WriteNumber((osmscout::TypeId)i);
+      writer.WriteFileOffset(rootOffsets[i]);
+      writer.WriteNumber(entryCounts[i]);
+      writer.WriteCoord(boundingBoxes[i].GetMinCoord());
+      writer.WriteCoord(boundingBoxes[i].GetMaxCoord());
+    }
+
+    writer.SetPos(0);
+    writer.WriteFileOffset(typeTableOffset);
+
+    writer.Close();
+  }
+  catch (osmscout::IOException& e) {
+    std::cerr << e.GetDescription() << std::endl;
+    writer.CloseFailsafe();
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Distance of the coordinate to the path, by sampling each segment densely on the
+ * sphere, independent of any projection
+ */
+static double GetSampledDistance(const osmscout::GeoCoord& coord,
+                                 const std::vector<osmscout::GeoCoord>& path)
+{
+  double distance=std::numeric_limits<double>::infinity();
+
+  for (size_t i=0; i+1<path.size(); i++) {
+    for (size_t s=0; s<=20000; s++) {
+      double             fraction=s/20000.0;
+      osmscout::GeoCoord sample(path[i].GetLat()+fraction*(path[i+1].GetLat()-path[i].GetLat()),
+                                path[i].GetLon()+fraction*(path[i+1].GetLon()-path[i].GetLon()));
+
+      distance=std::min(distance,
+                        osmscout::GetSphericalDistance(coord,sample));
+    }
+  }
+
+  return distance;
+}
+
+static bool Contains(const std::vector<osmscout::POIIndex::Entry>& entries,
+                     const osmscout::ObjectFileRef& object)
+{
+  for (const auto& entry : entries) {
+    if (entry.object==object) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static void TestNearest(osmscout::POIIndex& index,
+                        const osmscout::TypeConfig& typeConfig,
+                        const osmscout::TypeInfoRef& typeA,
+                        const std::vector<TestPOI>& pois)
+{
+  osmscout::TypeInfoSet                types(typeConfig);
+  std::vector<osmscout::POIIndex::Entry> entries;
+
+  types.Set(typeA);
+
+  // At 60 degrees north a degree of longitude is half as long as a degree of latitude
+  if (!index.GetNearestEntries(osmscout::GeoCoord(60.0,10.0),
+                               types,
+                               1,
+                               10.0,
+                               entries) ||
+      entries.size()!=1 ||
+      entries.front().object!=pois[0].object ||
+      std::fabs(entries.front().distance-1.112)>0.01) {
+    std::cerr << "GetNearestEntries(): Expected the eastern POI at 60N as nearest one!" << std::endl;
+    errors++;
+  }
+
+  if (!index.GetNearestEntries(osmscout::GeoCoord(60.0,10.0),
+                               types,
+                               10,
+                               1.5,
+                               entries) ||
+      entries.size()!=1) {
+    std::cerr << "GetNearestEntries(): Expected 1 entry within 1.5 km, got " << entries.size() << "!" << std::endl;
+    errors++;
+  }
+}
+
+static void TestQueries(osmscout::POIIndex& index,
+                        const osmscout::TypeConfig& typeConfig,
+                        const osmscout::TypeInfoRef& typeA,
+                        const osmscout::TypeInfoRef& typeB,
+                        const std::vector<TestPOI>& pois)
+{
+  osmscout::TypeInfoSet                  allTypes(typeConfig);
+  osmscout::TypeInfoSet                  bTypes(typeConfig);
+  std::vector<osmscout::POIIndex::Entry> entries;
+
+  allTypes.Set(typeA);
+  allTypes.Set(typeB);
+  bTypes.Set(typeB);
+
+  // Area query, filtered by type
+
+  osmscout::GeoBox area(osmscout::GeoCoord(60.05,10.1),osmscout::GeoCoord(60.15,10.3));
+  size_t           expectedCount=0;
+
+  for (const auto& poi : pois) {
+    if (poi.type==typeB &&
+        area.Includes(poi.coord)) {
+      expectedCount++;
+    }
+  }
+
+  if (!index.GetEntriesInArea(area,
+                              bTypes,
+                              entries) ||
+      entries.size()!=expectedCount) {
+    std::cerr << "GetEntriesInArea(): Expected " << expectedCount << " entries, got " << entries.size() << "!" << std::endl;
+    errors++;
+  }
+
+  for (const auto& entry : entries) {
+    if (entry.type!=typeB) {
+      std::cerr << "GetEntriesInArea(): Entry of filtered type returned!" << std::endl;
+      errors++;
+      break;
+    }
+  }
+
+  // Nearest entries, compared to brute force
+
+  for (size_t q=0; q<20; q++) {
+    osmscout::GeoCoord  coord(60.0+0.01*q,10.0+0.02*q);
+    const auto&         types=q%2==0 ? allTypes : bTypes;
+    std::vector<double> distances;
+
+    for (const auto& poi : pois) {
+      if (types.IsSet(poi.type)) {
+        double distance=osmscout::GetSphericalDistance(coord,poi.coord);
+
+        if (distance<=5.0) {
+          distances.push_back(distance);
+        }
+      }
+    }
+
+    std::sort(distances.begin(),distances.end());
+
+    if (distances.size()>10) {
+      distances.resize(10);
+    }
+
+    if (!index.GetNearestEntries(coord,
+                                 types,
+                                 10,
+                                 5.0,
+                                 entries) ||
+        entries.size()!=distances.size()) {
+      std::cerr << "GetNearestEntries(): Expected " << distances.size() << " entries, got " << entries.size() << "!" << std::endl;
+      errors++;
+      continue;
+    }
+
+    for (size_t i=0; i<entries.size(); i++) {
+      if (std::fabs(entries[i].distance-distances[i])>1e-4 ||
+          !types.IsSet(entries[i].type)) {
+        std::cerr << "GetNearestEntries(): Wrong entry " << i << " at " << coord.GetDisplayText() << "!" << std::endl;
+        errors++;
+        break;
+      }
+    }
+  }
+
+  // Entries along a path with diagonal segments, compared to sampling
+
+  std::vector<osmscout::GeoCoord> path;
+  double                          maxDistance=1.0;
+
+  path.push_back(osmscout::GeoCoord(60.02,10.05));
+  path.push_back(osmscout::GeoCoord(60.12,10.30));
+  path.push_back(osmscout::GeoCoord(60.18,10.10));
+
+  if (!index.GetEntriesAlongPath(path,
+                                 maxDistance,
+                                 bTypes,
+                                 entries)) {
+    std::cerr << "GetEntriesAlongPath(): Failed!" << std::endl;
+    errors++;
+    return;
+  }
+
+  size_t checked=0;
+
+  for (const auto& poi : pois) {
+    double distance=GetSampledDistance(poi.coord,path);
+
+    // Skip entries too close to the border of the corridor
+    if (std::fabs(distance-maxDistance)<0.01) {
+      continue;
+    }
+
+    bool expected=poi.type==typeB && distance<maxDistance;
+
+    if (expected!=Contains(entries,poi.object)) {
+      std::cerr << "GetEntriesAlongPath(): POI at " << poi.coord.GetDisplayText() << " with distance " << distance << " " << (expected ? "missing" : "unexpected") << "!" << std::endl;
+      errors++;
+    }
+
+    if (expected) {
+      checked++;
+    }
+  }
+
+  for (size_t i=0; i<entries.size(); i++) {
+    for (const auto& poi : pois) {
+      if (poi.object==entries[i].object &&
+          std::fabs(GetSampledDistance(poi.coord,path)-entries[i].distance)>0.005) {
+        std::cerr << "GetEntriesAlongPath(): Wrong distance " << entries[i].distance << " of POI at " << poi.coord.GetDisplayText() << "!" << std::endl;
+        errors++;
+      }
+    }
+
+    if (i>0 &&
+        entries[i-1].distance>entries[i].distance) {
+      std::cerr << "GetEntriesAlongPath(): Entries not sorted by distance!" << std::endl;
+      errors++;
+    }
+  }
+
+  if (checked==0) {
+    std::cerr << "GetEntriesAlongPath(): No POIs within the corridor!" << std::endl;
+    errors++;
+  }
+}
+
+int main()
+{
+  osmscout::TypeConfig  typeConfig;
+  osmscout::TypeInfoRef typeA=typeConfig.RegisterType(std::make_shared<osmscout::TypeInfo>("test_poi_a"));
+  osmscout::TypeInfoRef typeB=typeConfig.RegisterType(std::make_shared<osmscout::TypeInfo>("test_poi_b"));
+  std::vector<TestPOI>  pois;
+  osmscout::POIIndex    index;
+
+  typeA->CanBeNode(true).SetIndexAsPOI(true);
+  typeB->CanBeNode(true).SetIndexAsPOI(true);
+
+  // About 1.1 km east and 1.7 km north of 60N 10E
+  pois.push_back(TestPOI{typeA,osmscout::ObjectFileRef(1,osmscout::refNode),osmscout::GeoCoord(60.0,10.02)});
+  pois.push_back(TestPOI{typeA,osmscout::ObjectFileRef(2,osmscout::refNode),osmscout::GeoCoord(60.015,10.0)});
+
+  if (!WriteIndex(typeConfig,pois) ||
+      !index.Open(".")) {
+    std::cerr << "Cannot write and open POI index!" << std::endl;
+    return 1;
+  }
+
+  TestNearest(index,typeConfig,typeA,pois);
+
+  index.Close();
+
+  // Pseudo random POIs of both types around 60 degrees north
+  pois.clear();
+
+  uint32_t random=1;
+
+  for (size_t i=0; i<1000; i++) {
+    random=random*1103515245+12345;
+
+    double lat=60.0+(random%10000)/50000.0;
+
+    random=random*1103515245+12345;
+
+    double lon=10.0+(random%10000)/25000.0;
+
+    pois.push_back(TestPOI{i%2==0 ? typeA : typeB,
+                           osmscout::ObjectFileRef(i+1,osmscout::refNode),
+                           osmscout::GeoCoord(lat,lon)});
+  }
+
+  if (!WriteIndex(typeConfig,pois) ||
+      !index.Open(".")) {
+    std::cerr << "Cannot write and open POI index!" << std::endl;
+    return 1;
+  }
+
+  TestQueries(index,typeConfig,typeA,typeB,pois);
+
+  index.Close();
+
+  if (errors!=0) {
+    return 1;
+  }
+  else {
+    return 0;
+  }
+}
@@ -0,0 +1,319 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include <osmscout/RouteSegmentIndex.h>
+
+#include <osmscout/util/FileWriter.h>
+#include <osmscout/util/Geometry.h>
+
+struct TestSegment
+{
+  osmscout::ObjectFileRef object;
+  osmscout::GeoCoord      from;
+  osmscout::GeoCoord      to;
+};
+
+int errors=0;
+
+/**
+ * Write the R-tree of the given segments in the format of the route segment
+ * index, grouping the entries in the given order
+ */
+static osmscout::FileOffset WriteTree(osmscout::FileWriter& writer,
+                                      const std::vector<TestSegment>& segments,
+                                      osmscout::GeoBox& boundingBox)
+{
+  struct TreeEntry
+  {
+    osmscout::GeoBox     boundingBox;
+    const TestSegment*   segment;
+    osmscout::FileOffset childOffset;
+  };
+
+  std::vector<TreeEntry> entries;
+  bool                   leaf=true;
+
+  for (const auto& segment : segments) {
+    TreeEntry entry;
+
+    entry.boundingBox.Set(segment.from,segment.to);
+    entry.segment=&segment;
+    entry.childOffset=0;
+
+    entries.push_back(entry);
+  }
+
+  while (true) {
+    std::vector<TreeEntry> parents;
+
+    for (size_t start=0; start<entries.size(); start+=osmscout::RouteSegmentIndex::NODE_SIZE) {
+      size_t    end=std::min(start+osmscout::RouteSegmentIndex::NODE_SIZE,entries.size());
+      TreeEntry parent;
+
+      parent.childOffset=writer.GetPos();
+      parent.boundingBox=entries[start].boundingBox;
+      parent.segment=NULL;
+
+      writer.Write(leaf);
+      writer.WriteNumber((uint32_t)(end-start));
+
+      for (size_t i=start; i<end; i++) {
+        if (leaf) {
+          writer.WriteCoord(entries[i].segment->from);
+          writer.WriteCoord(entries[i].segment->to);
+          writer.Write(entries[i].segment->object);
+          writer.WriteNumber((uint32_t)0);
+          writer.WriteNumber((uint32_t)1);
+        }
+        else {
+          writer.WriteCoord(entries[i].boundingBox.GetMinCoord());
+          writer.WriteCoord(entries[i].boundingBox.GetMaxCoord());
+          writer.WriteFileOffset(entries[i].childOffset);
+        }
+
+        parent.boundingBox.Include(entries[i].boundingBox);
+      }
+
+      parents.push_back(parent);
+    }
+
+    if (parents.size()==1) {
+      boundingBox=parents.front().boundingBox;
+
+      return parents.front().childOffset;
+    }
+
+    entries.swap(parents);
+    leaf=false;
+  }
+}
+
+/**
+ * Write an index holding the given segments for cars only
+ */
+static bool WriteIndex(const std::vector<TestSegment>& segments)
+{
+  osmscout::FileWriter writer;
+
+  try {
+    writer.Open(osmscout::RouteSegmentIndex::ROUTESEGMENT_IDX);
+
+    writer.WriteFileOffset(0);
+
+    osmscout::GeoBox     boundingBox;
+    osmscout::FileOffset rootOffset=WriteTree(writer,
+                                              segments,
+                                              boundingBox);
+    osmscout::FileOffset vehicleTableOffset=writer.GetPos();
+
+    writer.WriteNumber((uint32_t)1);
+
+    writer.Write((uint8_t)osmscout::vehicleCar);
+    writer.WriteFileOffset(rootOffset);
+    writer.WriteNumber((uint32_t)segments.size());
+    writer.WriteCoord(boundingBox.GetMinCoord());
+    writer.WriteCoord(boundingBox.GetMaxCoord());
+
+    writer.SetPos(0);
+    writer.WriteFileOffset(vehicleTableOffset);
+
+    writer.Close();
+  }
+  catch (osmscout::IOException& e) {
+    std::cerr << e.GetDescription() << std::endl;
+    writer.CloseFailsafe();
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Distance of the coordinate to the segment, by sampling the segment densely on
+ * the sphere, independent of any projection
+ */
+static double GetSampledDistance(const osmscout::GeoCoord& coord,
+                                 const TestSegment& segment,
+                                 osmscout::GeoCoord& nearest)
+{
+  double distance=std::numeric_limits<double>::infinity();
+
+  for (size_t s=0; s<=2000; s++) {
+    double             fraction=s/2000.0;
+    osmscout::GeoCoord sample(segment.from.GetLat()+fraction*(segment.to.GetLat()-segment.from.GetLat()),
+                              segment.from.GetLon()+fraction*(segment.to.GetLon()-segment.from.GetLon()));
+    double             sampleDistance=osmscout::GetSphericalDistance(coord,sample);
+
+    if (sampleDistance<distance) {
+      distance=sampleDistance;
+      nearest=sample;
+    }
+  }
+
+  return distance;
+}
+
+static void TestNearest(osmscout::RouteSegmentIndex& index,
+                        const std::vector<TestSegment>& segments)
+{
+  osmscout::GeoCoord                                coord(60.0,10.01);
+  std::vector<osmscout::RouteSegmentIndex::Segment> result;
+
+  if (!index.GetNearestSegments(coord,
+                                osmscout::vehicleCar,
+                                1,
+                                10.0,
+                                result) ||
+      result.size()!=1) {
+    std::cerr << "GetNearestSegments(): Expected one segment!" << std::endl;
+    errors++;
+    return;
+  }
+
+  osmscout::GeoCoord nearest;
+  double             distance=GetSampledDistance(coord,segments[0],nearest);
+
+  // At 60 degrees north a projection in degrees places the nearest point of the
+  // diagonal segment wrongly and overstates its distance beyond the one of the
+  // vertical segment
+  if (result.front().object!=segments[0].object) {
+    std::cerr << "GetNearestSegments(): Expected the diagonal segment as nearest one!" << std::endl;
+    errors++;
+  }
+
+  if (std::fabs(result.front().distance-distance)>0.001) {
+    std::cerr << "GetNearestSegments(): Wrong distance " << result.front().distance << ", expected " << distance << "!" << std::endl;
+    errors++;
+  }
+
+  if (osmscout::GetSphericalDistance(result.front().coord,nearest)>0.002) {
+    std::cerr << "GetNearestSegments(): Wrong nearest point " << result.front().coord.GetDisplayText() << ", expected " << nearest.GetDisplayText() << "!" << std::endl;
+    errors++;
+  }
+
+  if (!index.GetNearestSegments(coord,
+                                osmscout::vehicleFoot,
+                                1,
+                                10.0,
+                                result) ||
+      !result.empty()) {
+    std::cerr << "GetNearestSegments(): Expected no segments for foot!" << std::endl;
+    errors++;
+  }
+}
+
+static void TestQueries(osmscout::RouteSegmentIndex& index,
+                        const std::vector<TestSegment>& segments)
+{
+  std::vector<osmscout::RouteSegmentIndex::Segment> result;
+
+  for (size_t q=0; q<20; q++) {
+    osmscout::GeoCoord  coord(60.0+0.01*q,10.0+0.02*q);
+    std::vector<double> distances;
+
+    for (const auto& segment : segments) {
+      osmscout::GeoCoord nearest;
+      double             distance=GetSampledDistance(coord,segment,nearest);
+
+      if (distance<=2.0) {
+        distances.push_back(distance);
+      }
+    }
+
+    std::sort(distances.begin(),distances.end());
+
+    if (distances.size()>5) {
+      distances.resize(5);
+    }
+
+    if (!index.GetNearestSegments(coord,
+                                  osmscout::vehicleCar,
+                                  5,
+                                  2.0,
+                                  result) ||
+        result.size()!=distances.size()) {
+      std::cerr << "GetNearestSegments(): Expected " << distances.size() << " segments, got " << result.size() << "!" << std::endl;
+      errors++;
+      continue;
+    }
+
+    for (size_t i=0; i<result.size(); i++) {
+      if (std::fabs(result[i].distance-distances[i])>0.001) {
+        std::cerr << "GetNearestSegments(): Wrong segment " << i << " at " << coord.GetDisplayText() << "!" << std::endl;
+        errors++;
+        break;
+      }
+    }
+  }
+}
+
+int main()
+{
+  std::vector<TestSegment>    segments;
+  osmscout::RouteSegmentIndex index;
+
+  // A diagonal segment about 0.39 km and a vertical segment 0.42 km away from 60N 10.01E
+  segments.push_back(TestSegment{osmscout::ObjectFileRef(1,osmscout::refWay),
+                                 osmscout::GeoCoord(59.99,9.98),
+                                 osmscout::GeoCoord(60.01,10.02)});
+  segments.push_back(TestSegment{osmscout::ObjectFileRef(2,osmscout::refWay),
+                                 osmscout::GeoCoord(59.995,10.01755),
+                                 osmscout::GeoCoord(60.005,10.01755)});
+
+  if (!WriteIndex(segments) ||
+      !index.Open(".")) {
+    std::cerr << "Cannot write and open route segment index!" << std::endl;
+    return 1;
+  }
+
+  TestNearest(index,segments);
+
+  index.Close();
+
+  // Pseudo random short segments in all directions around 60 degrees north
+  segments.clear();
+
+  uint32_t random=1;
+
+  for (size_t i=0; i<500; i++) {
+    random=random*1103515245+12345;
+
+    double lat=60.0+(random%10000)/50000.0;
+
+    random=random*1103515245+12345;
+
+    double lon=10.0+(random%10000)/25000.0;
+
+    random=random*1103515245+12345;
+
+    double dLat=((int)(random%2001)-1000)/100000.0;
+
+    random=random*1103515245+12345;
+
+    double dLon=((int)(random%2001)-1000)/50000.0;
+
+    segments.push_back(TestSegment{osmscout::ObjectFileRef(i+1,osmscout::refWay),
+                                   osmscout::GeoCoord(lat,lon),
+                                   osmscout::GeoCoord(lat+dLat,lon+dLon)});
+  }
+
+  if (!WriteIndex(segments) ||
+      !index.Open(".")) {
+    std::cerr << "Cannot write and open route segment index!" << std::endl;
+    return 1;
+  }
+
+  TestQueries(index,segments);
+
+  index.Close();
+
+  if (errors!=0) {
+    return 1;
+  }
+  else {
+    return 0;
+  }
+}